@@ -0,0 +1,144 @@
+//===- odla_batching.h ----------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef _ODLA_BATCHING_H_
+#define _ODLA_BATCHING_H_
+
+#include <ODLA/odla_common.h>
+
+/*! \file
+ * \details This file defines the dynamic batching APIs. A batcher serves
+ * single-sample requests with a model function generated by HALO with
+ * `-emit-inference-func-sig`. Requests are coalesced into batches that run
+ * the model function once each.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! \brief Batcher object
+typedef struct _odla_batcher* odla_batcher;
+
+//! \brief Model function generated with `-emit-inference-func-sig`
+typedef void (*odla_batch_model_func)(int num_inputs, const void* inputs[],
+                                      int num_outputs, void* outputs[]);
+
+//! \brief Model function generated with `-emit-inference-func-sig` and
+//! `-batch-size=-1`
+typedef void (*odla_dynamic_batch_model_func)(int num_inputs,
+                                              const void* inputs[],
+                                              int num_outputs,
+                                              void* outputs[], int batch_size);
+
+//! \brief Callback of a completed request
+typedef void (*odla_request_callback)(odla_status status, odla_void* user_data);
+
+//! \brief Batcher configuration
+typedef struct {
+  odla_int32 num_inputs;           /**< number of model inputs */
+  const odla_size_t* input_sizes;  /**< bytes of each input per sample */
+  odla_int32 num_outputs;          /**< number of model outputs */
+  const odla_size_t* output_sizes; /**< bytes of each output per sample */
+  //! The batch size of the model. Partial batches of a model with a fixed
+  //! batch size are padded with zeros. It bounds the batches of a dynamic
+  //! batch model.
+  odla_int32 max_batch_size;
+  //! The longest time in microseconds that a request waits for others to
+  //! join its batch.
+  odla_int32 max_latency_us;
+  //! The number of batches that run concurrently.
+  odla_int32 num_workers;
+  odla_batch_model_func model_func;                 /**< fixed batch model */
+  odla_dynamic_batch_model_func dynamic_model_func; /**< dynamic batch model */
+} odla_batcher_config;
+
+//! \brief Batcher statistics
+typedef struct {
+  odla_uint64 num_requests; /**< number of completed requests */
+  odla_uint64 num_batches;  /**< number of executed batches */
+} odla_batcher_stats;
+
+//! \brief Create a batcher
+/*!
+  Exactly one of `model_func` and `dynamic_model_func` is set. The sizes are
+  copied.
+
+  \param config the configuration
+  \param batcher the pointer to the created batcher
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL odla_CreateBatcher(
+    const odla_batcher_config* config, odla_batcher* batcher);
+
+//! \brief Submit a request
+/*!
+  The input and output buffers hold one sample each and must stay valid until
+  the callback is called.
+
+  \param batcher the batcher
+  \param inputs the input buffers
+  \param outputs the output buffers
+  \param callback the callback called by a worker thread when the outputs are
+  written (can be NULL)
+  \param user_data the data passed to the callback
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL odla_SubmitRequest(
+    odla_batcher batcher, const odla_void* inputs[], odla_void* outputs[],
+    odla_request_callback callback, odla_void* user_data);
+
+//! \brief Run a request and wait for its outputs
+/*!
+  \param batcher the batcher
+  \param inputs the input buffers
+  \param outputs the output buffers
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL
+odla_RunRequest(odla_batcher batcher, const odla_void* inputs[],
+                odla_void* outputs[]);
+
+//! \brief Get the statistics of a batcher
+/*!
+  \param batcher the batcher
+  \param stats the pointer to the retrieved statistics
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL
+odla_GetBatcherStats(odla_batcher batcher, odla_batcher_stats* stats);
+
+//! \brief Destroy a batcher
+/*!
+  Pending requests are completed first.
+
+  \param batcher the batcher
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL
+odla_DestroyBatcher(odla_batcher batcher);
+
+#ifdef __cplusplus
+} // C extern
+#endif
+
+#endif // _ODLA_BATCHING_H_
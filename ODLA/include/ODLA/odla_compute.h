@@ -44,6 +44,8 @@ typedef enum {
   ODLA_MAX_BATCH_SIZE,
   ODLA_OPT_BATCH_SIZE,
   ODLA_RUN_BATCH_SIZE,
+  ODLA_ASYNC_QUEUE_DEPTH,
+  ODLA_NUM_THREADS,
 } odla_item_type;
 
 //! \brief Computation object
@@ -61,6 +63,10 @@ typedef struct _odla_item_value* odla_item_value;
 //! \brief Constants array object
 typedef struct _odla_constants_array* odla_constants_array;
 
+//! \brief Callback invoked when an asynchronous execution completes
+typedef void (*odla_async_callback)(odla_context context, odla_status status,
+                                    odla_void* user_data);
+
 //! \brief Create a computation object
 /*!
   \param computation the pointer to the created computation object
@@ -124,6 +130,9 @@ extern ODLA_API_EXPORT odla_status ODLA_API_CALL odla_ExecuteComputation(
 
 //! \brief Asynchronously execute a computation
 /*!
+  The data bound to the context is captured when the execution is submitted,
+  so the next execution can be bound right away. The call blocks while
+  ODLA_ASYNC_QUEUE_DEPTH executions of the context are in flight.
   \param computation the computation object
   \param context the context object
   \param mode the compute mode
@@ -135,6 +144,34 @@ extern ODLA_API_EXPORT odla_status ODLA_API_CALL odla_AsyncExecuteComputation(
     const odla_computation computation, const odla_context context,
     const odla_compute_mode mode, odla_device device);
 
+//! \brief Wait for the asynchronous executions of a context
+/*!
+  Block until all executions submitted to the context by
+  odla_AsyncExecuteComputation or odla_AsyncLaunchExecutable complete.
+  \param context the context object
+
+  \return the first failure of the completed executions, or ODLA_SUCCESS
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL
+odla_WaitContext(odla_context context);
+
+//! \brief Set the completion callback for asynchronous executions
+/*!
+  The callback is invoked on a runtime thread after each asynchronous
+  execution of the context completes. The bound output buffers are valid
+  when it is invoked. The completed execution no longer counts against
+  ODLA_ASYNC_QUEUE_DEPTH, so the callback may submit another execution to
+  the context.
+  \param context the context object
+  \param callback the callback (can be NULL)
+  \param user_data the data passed to the callback
+
+  \return odla_status
+*/
+extern ODLA_API_EXPORT odla_status ODLA_API_CALL
+odla_SetAsyncCallback(odla_context context, odla_async_callback callback,
+                      odla_void* user_data);
+
 //! \brief Get the number of arguments from a computation
 /*!
   \param computation the computation object
@@ -241,6 +278,24 @@ extern ODLA_API_EXPORT odla_status ODLA_API_CALL odla_StoreConstantsArray(
 extern ODLA_API_EXPORT odla_status ODLA_API_CALL
 odla_DestroyConstantsArray(odla_constants_array constants_array);
 
+//! \brief Create a constant value that refers to an entry of a constants array
+/*!
+  The data is used in place without copying, so the constants array must
+  outlive the computation that uses the value.
+
+  \param constants_array the constants array object
+  \param value_type the value type
+  \param name the name of the entry in the constants array
+  \param value_id a unique value id (can be NULL)
+
+  \return odla_value, or NULL if the entry is not found or its size does not
+  match the value type
+*/
+extern ODLA_API_EXPORT odla_value ODLA_API_CALL odla_CreateConstantFromArray(
+    const odla_constants_array constants_array,
+    const odla_value_type value_type, const odla_char* name,
+    const odla_value_id value_id);
+
 //! \brief Create an executable object
 /*!
   \param executable the pointer to the created executable object
@@ -56,6 +56,14 @@ typedef enum {
   ODLA_RNN_HIDDEN_CELL_STATE, /*!< output both hidden and cell states */
 } odla_rnn_outputs;
 
+//! \brief Activation fused into the result of an operator
+typedef enum {
+  ODLA_ACTIVATION_NONE,       /*!< no activation */
+  ODLA_ACTIVATION_RELU,       /*!< y = max(x, 0) */
+  ODLA_ACTIVATION_RELU6,      /*!< y = min(max(x, 0), 6) */
+  ODLA_ACTIVATION_LEAKY_RELU, /*!< y = x < 0 ? alpha * x : x */
+} odla_activation;
+
 //! \brief Avgerage pooling
 /*!
   AveragePool computes the average pooling across the \p input according to
@@ -157,6 +165,61 @@ odla_Conv(odla_value input, odla_memory_layout input_layout, odla_uint32 group,
           odla_value bias, odla_value_shape output_dims,
           const odla_value_id value_id);
 
+//! \brief N-dimensional Convolution with fused activation
+/*!
+  FusedConv computes convolution of \p input and \p kernel like odla_Conv,
+  adds \p bias optionally and applies \p activation to the result.
+
+  \param input the input value
+  \param input_layout the memory layout of input
+  \param group number of groups input and output channels are divided into
+  \param kernel the kernel value
+  \param kernel_layout the memory layout of kernel
+  \param strides the stride along each spatial axis
+  \param dilations dilations (same number of values as `strides`)
+  \param paddings_front paddings applied to the start of each spatial dim
+  \param paddings_back paddings applied to the end of each spatial dim
+  \param bias optional bias. NULL if not needed.
+  \param activation the activation applied to the result
+  \param activation_alpha the coefficient of the activation
+  \param output_dims the optional output shape (can be undefined)
+  \param value_id a unique value id (can be NULL)
+
+  \return odla_value
+*/
+extern ODLA_API_EXPORT odla_value ODLA_API_CALL odla_FusedConv(
+    odla_value input, odla_memory_layout input_layout, odla_uint32 group,
+    odla_value kernel, odla_memory_layout kernel_layout,
+    const odla_uint32* strides, const odla_uint32* dilations,
+    const odla_uint32* paddings_front, const odla_uint32* paddings_back,
+    odla_value bias, odla_activation activation, odla_float32 activation_alpha,
+    odla_value_shape output_dims, const odla_value_id value_id);
+
+//! \brief General Matrix Multiplication with fused activation
+/*!
+  FusedGemm computes \p alpha * \p A * \p B + \p beta * \p C like odla_Gemm
+  and applies \p activation to the result.
+
+  \param A the matrix A
+  \param A_transpose indicates if A needs to be transposed or not
+  \param B the matrix B
+  \param B_transpose indicates if B needs to be transposed or not
+  \param alpha the alpha value
+  \param beta the beta value
+  \param C the optional matrix (can be NULL)
+  \param activation the activation applied to the result
+  \param activation_alpha the coefficient of the activation
+  \param output_dims the optional output shape (can be undefined)
+  \param value_id a unique value id (can be NULL)
+
+  \return odla_value
+*/
+extern ODLA_API_EXPORT odla_value ODLA_API_CALL odla_FusedGemm(
+    odla_value A, odla_bool A_transpose, odla_value B, odla_bool B_transpose,
+    odla_float32 alpha, odla_float32 beta, odla_value C,
+    odla_activation activation, odla_float32 activation_alpha,
+    odla_value_shape output_dims, const odla_value_id value_id);
+
 //! \brief N-dimensional Deconvolution
 /*!
   DeConv computes the deconvolution (transposed convolution) based on the
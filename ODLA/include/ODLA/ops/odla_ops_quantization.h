@@ -29,6 +29,44 @@
 extern "C" {
 #endif
 
+//! \brief Quantize a floating-point value
+/*!
+  Quantize computes \p clamp(round(input / scale) + zero_point) in the range
+  of \p element_type.
+
+  \param input the input value
+  \param scale the quantization scale
+  \param zero_point the quantized value of zero
+  \param element_type the quantized element type (ODLA_INT8 or ODLA_UINT8)
+  \param value_id a unique value id (can be NULL)
+
+  \return odla_value
+*/
+extern ODLA_API_EXPORT odla_value ODLA_API_CALL
+odla_Quantize(odla_value input, odla_float32 scale, odla_int32 zero_point,
+              odla_element_type element_type, const odla_value_id value_id);
+
+//! \brief Dequantize a quantized value
+/*!
+  Dequantize computes \p input * \p scale into an ODLA_FLOAT32 value. With
+  one scale, it applies to all elements. Otherwise, there is one scale per
+  element along \p axis. The input is an ODLA_INT8 value, or an ODLA_INT32
+  value like the result of odla_Conv or odla_Gemm on ODLA_INT8 operands,
+  which accumulates into ODLA_INT32 with an ODLA_INT32 bias.
+
+  \param input the input value
+  \param num_of_scales the number of scales
+  \param scales the scales
+  \param axis the axis of the scales
+  \param value_id a unique value id (can be NULL)
+
+  \return odla_value
+*/
+extern ODLA_API_EXPORT odla_value ODLA_API_CALL
+odla_Dequantize(odla_value input, odla_size_t num_of_scales,
+                const odla_float32* scales, odla_int32 axis,
+                const odla_value_id value_id);
+
 #ifdef __cplusplus
 } // C extern
 #endif
@@ -0,0 +1,232 @@
+//===- odla_async_queue.h ---------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef ODLA_PLATFORMS_ODLA_ASYNC_QUEUE_H_
+#define ODLA_PLATFORMS_ODLA_ASYNC_QUEUE_H_
+
+// The context-side machinery shared by the CPU platforms.
+
+#include <ODLA/odla.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Data bound to a computation, which is applied when the computation is
+// executed.
+struct Bindings {
+  std::unordered_map<odla_value, void*> values;
+  std::unordered_map<std::string, void*> inputs;
+  std::unordered_map<std::string, void*> outputs;
+  // The number of samples of a dynamic batch computation, set by
+  // ODLA_RUN_BATCH_SIZE. Zero runs the maximum batch size.
+  int batch_size = 0;
+};
+
+// A dynamic batch computation is built for its maximum batch size. When it
+// runs fewer samples, the bound inputs are copied into zero-padded buffers and
+// the outputs are written to buffers whose leading samples are copied to the
+// bound ones by CopyOutputs(). The inputs and outputs hold the batch in their
+// first dimension.
+class PaddedBatch {
+ public:
+  using Values = std::unordered_map<std::string, odla_value>;
+  // Returns the size in bytes of a value at the maximum batch size.
+  using SizeOf = std::function<size_t(odla_value)>;
+
+  // Returns the bindings to execute, which are `bindings` if no padding is
+  // needed, or nullptr if the batch size exceeds the maximum one.
+  const Bindings* Pad(const Bindings& bindings, int max_batch_size,
+                      const Values& inputs, const Values& outputs,
+                      const SizeOf& size_of) {
+    const int batch_size = bindings.batch_size;
+    copies_.clear();
+    if (max_batch_size <= 0 || batch_size <= 0 ||
+        batch_size == max_batch_size) {
+      return &bindings;
+    }
+    if (batch_size > max_batch_size) {
+      return nullptr;
+    }
+    std::unordered_set<odla_value> output_values;
+    for (const auto& output : outputs) {
+      output_values.insert(output.second);
+    }
+    size_t num_buffers = 0;
+    auto stage = [&](odla_value value, void* ptr) -> void* {
+      size_t size = size_of(value);
+      size_t used = size / max_batch_size * batch_size;
+      if (num_buffers == buffers_.size()) {
+        buffers_.emplace_back();
+      }
+      std::vector<char>& buffer = buffers_[num_buffers++];
+      buffer.resize(size);
+      if (output_values.count(value) != 0) {
+        copies_.push_back({ptr, buffer.data(), used});
+      } else {
+        std::memcpy(buffer.data(), ptr, used);
+        std::memset(buffer.data() + used, 0, size - used);
+      }
+      return buffer.data();
+    };
+    padded_ = Bindings();
+    for (const auto& binding : bindings.values) {
+      padded_.values[binding.first] = stage(binding.first, binding.second);
+    }
+    // Unknown names are left to the executor to report.
+    for (const auto& binding : bindings.inputs) {
+      auto it = inputs.find(binding.first);
+      padded_.inputs[binding.first] = it == inputs.end()
+                                          ? binding.second
+                                          : stage(it->second, binding.second);
+    }
+    for (const auto& binding : bindings.outputs) {
+      auto it = outputs.find(binding.first);
+      padded_.outputs[binding.first] =
+          it == outputs.end() ? binding.second
+                              : stage(it->second, binding.second);
+    }
+    return &padded_;
+  }
+
+  // Copies the samples of the last padded execution to the bound outputs.
+  void CopyOutputs() const {
+    for (const auto& copy : copies_) {
+      std::memcpy(copy.dst, copy.src, copy.size);
+    }
+  }
+
+ private:
+  struct Copy {
+    void* dst;
+    const void* src;
+    size_t size;
+  };
+
+  Bindings padded_;
+  std::vector<std::vector<char>> buffers_;
+  std::vector<Copy> copies_;
+};
+
+// Executions submitted by odla_AsyncExecuteComputation() run in submission
+// order on a worker thread owned by the context. Each request carries a copy
+// of the bindings, so the caller can bind the next request while the current
+// one is computed, and the callback it was submitted with.
+class AsyncQueue {
+ public:
+  // Runs `comp` with `bindings` on the context that owns the queue.
+  using Executor =
+      std::function<odla_status(odla_computation comp, const Bindings&)>;
+
+  AsyncQueue(odla_context context, Executor execute)
+      : context_(context), execute_(std::move(execute)) {
+    worker_ = std::thread([this] { Run(); });
+  }
+
+  // Pending requests are drained before the worker exits.
+  ~AsyncQueue() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  AsyncQueue(const AsyncQueue&) = delete;
+  AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+  // Queues an execution, blocking the caller while `depth` executions are in
+  // flight.
+  void Submit(odla_computation comp, const Bindings& bindings, size_t depth,
+              odla_async_callback callback, odla_void* user_data) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, depth] { return in_flight_ < depth; });
+    requests_.push_back({comp, bindings, callback, user_data});
+    ++in_flight_;
+    cv_.notify_all();
+  }
+
+  // Blocks until all submitted executions and their callbacks complete,
+  // including the executions submitted by the callbacks. Returns the first
+  // failure since the last call, or ODLA_SUCCESS.
+  odla_status Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return in_flight_ == 0 && !in_callback_; });
+    odla_status status = status_;
+    status_ = ODLA_SUCCESS;
+    return status;
+  }
+
+ private:
+  struct Request {
+    odla_computation comp;
+    Bindings bindings;
+    odla_async_callback callback;
+    odla_void* user_data;
+  };
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+      if (requests_.empty()) {
+        return;
+      }
+      Request request = std::move(requests_.front());
+      requests_.pop_front();
+      lock.unlock();
+      odla_status status = execute_(request.comp, request.bindings);
+      lock.lock();
+      if (status_ == ODLA_SUCCESS) {
+        status_ = status;
+      }
+      --in_flight_;
+      // The slot is released first, so the callback may submit the next
+      // request without blocking on a full queue.
+      if (request.callback != nullptr) {
+        in_callback_ = true;
+        cv_.notify_all();
+        lock.unlock();
+        request.callback(context_, status, request.user_data);
+        lock.lock();
+        in_callback_ = false;
+      }
+      cv_.notify_all();
+    }
+  }
+
+  odla_context context_;
+  Executor execute_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> requests_;
+  size_t in_flight_ = 0;
+  bool in_callback_ = false;
+  bool stop_ = false;
+  odla_status status_ = ODLA_SUCCESS;
+  std::thread worker_;
+};
+
+#endif // ODLA_PLATFORMS_ODLA_ASYNC_QUEUE_H_
@@ -0,0 +1,228 @@
+//===- odla_batching.cc ---------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Dynamic batching on top of the model function of the generated code. It only
+// calls the model function, so it works with any ODLA platform. The generated
+// code is thread-safe, so each worker runs its batches with its own context.
+
+#include <ODLA/odla_batching.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Request {
+  std::vector<const odla_void*> inputs;
+  std::vector<odla_void*> outputs;
+  odla_request_callback callback;
+  odla_void* user_data;
+  std::chrono::steady_clock::time_point arrival;
+};
+
+struct _odla_batcher {
+  std::vector<size_t> input_sizes;
+  std::vector<size_t> output_sizes;
+  size_t max_batch_size;
+  std::chrono::microseconds max_latency;
+  odla_batch_model_func model_func;
+  odla_dynamic_batch_model_func dynamic_model_func;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Request> requests;
+  bool stop = false;
+  odla_batcher_stats stats = {0, 0};
+};
+
+// Takes the next batch from the queue. A batch is taken when it is full or
+// when its first request has waited for the maximum latency. Returns false
+// when the batcher is stopped and the queue is drained.
+static bool takeBatch(odla_batcher batcher, std::vector<Request>* batch) {
+  std::unique_lock<std::mutex> lock(batcher->mutex);
+  batcher->cv.wait(lock, [batcher] {
+    return batcher->stop || !batcher->requests.empty();
+  });
+  if (batcher->requests.empty()) {
+    return false;
+  }
+  auto deadline = batcher->requests.front().arrival + batcher->max_latency;
+  batcher->cv.wait_until(lock, deadline, [batcher] {
+    return batcher->stop || batcher->requests.empty() ||
+           batcher->requests.size() >= batcher->max_batch_size;
+  });
+  // Another worker may have taken the requests meanwhile.
+  size_t n = std::min(batcher->requests.size(), batcher->max_batch_size);
+  batch->assign(std::make_move_iterator(batcher->requests.begin()),
+                std::make_move_iterator(batcher->requests.begin() + n));
+  batcher->requests.erase(batcher->requests.begin(),
+                          batcher->requests.begin() + n);
+  return true;
+}
+
+static void runBatches(odla_batcher batcher) {
+  size_t num_inputs = batcher->input_sizes.size();
+  size_t num_outputs = batcher->output_sizes.size();
+  std::vector<std::vector<char>> inputs(num_inputs);
+  std::vector<std::vector<char>> outputs(num_outputs);
+  std::vector<const void*> input_ptrs(num_inputs);
+  std::vector<void*> output_ptrs(num_outputs);
+  for (size_t i = 0; i < num_inputs; ++i) {
+    inputs[i].resize(batcher->input_sizes[i] * batcher->max_batch_size);
+    input_ptrs[i] = inputs[i].data();
+  }
+  for (size_t i = 0; i < num_outputs; ++i) {
+    outputs[i].resize(batcher->output_sizes[i] * batcher->max_batch_size);
+    output_ptrs[i] = outputs[i].data();
+  }
+
+  std::vector<Request> batch;
+  while (takeBatch(batcher, &batch)) {
+    if (batch.empty()) {
+      continue;
+    }
+    size_t n = batch.size();
+    for (size_t i = 0; i < num_inputs; ++i) {
+      size_t size = batcher->input_sizes[i];
+      for (size_t j = 0; j < n; ++j) {
+        memcpy(&inputs[i][j * size], batch[j].inputs[i], size);
+      }
+      if (batcher->model_func != nullptr) {
+        std::fill(inputs[i].begin() + n * size, inputs[i].end(), 0);
+      }
+    }
+    if (batcher->model_func != nullptr) {
+      batcher->model_func(num_inputs, input_ptrs.data(), num_outputs,
+                          output_ptrs.data());
+    } else {
+      batcher->dynamic_model_func(num_inputs, input_ptrs.data(), num_outputs,
+                                  output_ptrs.data(), n);
+    }
+    for (size_t i = 0; i < num_outputs; ++i) {
+      size_t size = batcher->output_sizes[i];
+      for (size_t j = 0; j < n; ++j) {
+        memcpy(batch[j].outputs[i], &outputs[i][j * size], size);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(batcher->mutex);
+      batcher->stats.num_requests += n;
+      ++batcher->stats.num_batches;
+    }
+    for (const auto& request : batch) {
+      if (request.callback != nullptr) {
+        request.callback(ODLA_SUCCESS, request.user_data);
+      }
+    }
+  }
+}
+
+odla_status odla_CreateBatcher(const odla_batcher_config* config,
+                               odla_batcher* batcher) {
+  if (config->max_batch_size <= 0 || config->num_workers <= 0 ||
+      (config->model_func == nullptr) ==
+          (config->dynamic_model_func == nullptr)) {
+    return ODLA_FAILURE;
+  }
+  odla_batcher b = new _odla_batcher();
+  b->input_sizes.assign(config->input_sizes,
+                        config->input_sizes + config->num_inputs);
+  b->output_sizes.assign(config->output_sizes,
+                         config->output_sizes + config->num_outputs);
+  b->max_batch_size = config->max_batch_size;
+  b->max_latency = std::chrono::microseconds(config->max_latency_us);
+  b->model_func = config->model_func;
+  b->dynamic_model_func = config->dynamic_model_func;
+  for (int i = 0; i < config->num_workers; ++i) {
+    b->workers.emplace_back(runBatches, b);
+  }
+  *batcher = b;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SubmitRequest(odla_batcher batcher, const odla_void* inputs[],
+                               odla_void* outputs[],
+                               odla_request_callback callback,
+                               odla_void* user_data) {
+  {
+    std::lock_guard<std::mutex> lock(batcher->mutex);
+    if (batcher->stop) {
+      return ODLA_FAILURE;
+    }
+    batcher->requests.push_back(
+        {std::vector<const odla_void*>(
+             inputs, inputs + batcher->input_sizes.size()),
+         std::vector<odla_void*>(outputs,
+                                 outputs + batcher->output_sizes.size()),
+         callback, user_data, std::chrono::steady_clock::now()});
+  }
+  batcher->cv.notify_all();
+  return ODLA_SUCCESS;
+}
+
+struct Completion {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  odla_status status = ODLA_SUCCESS;
+};
+
+static void complete(odla_status status, odla_void* user_data) {
+  auto* completion = static_cast<Completion*>(user_data);
+  std::lock_guard<std::mutex> lock(completion->mutex);
+  completion->status = status;
+  completion->done = true;
+  completion->cv.notify_one();
+}
+
+odla_status odla_RunRequest(odla_batcher batcher, const odla_void* inputs[],
+                            odla_void* outputs[]) {
+  Completion completion;
+  odla_status status =
+      odla_SubmitRequest(batcher, inputs, outputs, complete, &completion);
+  if (status != ODLA_SUCCESS) {
+    return status;
+  }
+  std::unique_lock<std::mutex> lock(completion.mutex);
+  completion.cv.wait(lock, [&completion] { return completion.done; });
+  return completion.status;
+}
+
+odla_status odla_GetBatcherStats(odla_batcher batcher,
+                                 odla_batcher_stats* stats) {
+  std::lock_guard<std::mutex> lock(batcher->mutex);
+  *stats = batcher->stats;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_DestroyBatcher(odla_batcher batcher) {
+  {
+    std::lock_guard<std::mutex> lock(batcher->mutex);
+    batcher->stop = true;
+  }
+  batcher->cv.notify_all();
+  for (auto& worker : batcher->workers) {
+    worker.join();
+  }
+  delete batcher;
+  return ODLA_SUCCESS;
+}
@@ -0,0 +1,246 @@
+//===- odla_constants_array.c ---------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Constants arrays backed by the memory-mapped weights files written by
+// halo::WeightsFileWriter. The entries are handed to the backend's
+// odla_CreateConstant() in place, so this file is shared by all platforms.
+
+#include <ODLA/odla.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = "HALOWTS";
+static const uint32_t kVersion = 1;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_entries;
+  uint64_t index_offset;
+  uint64_t data_offset;
+} WeightsHeader;
+
+typedef struct {
+  const char* name;
+  const unsigned char* data;
+  uint64_t size;
+} ConstantEntry;
+
+struct _odla_constants_array {
+  void* base;
+  size_t size;
+  uint32_t num_entries;
+  ConstantEntry* entries; // Sorted by name.
+};
+
+static size_t GetElementSize(odla_element_type type) {
+  switch (type) {
+    case ODLA_INT8:
+    case ODLA_UINT8:
+    case ODLA_QINT8:
+    case ODLA_QUINT8:
+    case ODLA_BOOL:
+      return 1;
+    case ODLA_INT16:
+    case ODLA_UINT16:
+    case ODLA_QINT16:
+    case ODLA_QUINT16:
+    case ODLA_FLOAT16:
+    case ODLA_BFLOAT16:
+      return 2;
+    case ODLA_INT32:
+    case ODLA_UINT32:
+    case ODLA_QINT32:
+    case ODLA_QUINT32:
+    case ODLA_FLOAT32:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+static uint64_t AlignTo(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+static int CompareEntries(const void* lhs, const void* rhs) {
+  return strcmp(((const ConstantEntry*)lhs)->name,
+                ((const ConstantEntry*)rhs)->name);
+}
+
+static int CompareNameToEntry(const void* name, const void* entry) {
+  return strcmp((const char*)name, ((const ConstantEntry*)entry)->name);
+}
+
+// Parses the index of a mapped file and sorts the entries by name. Returns 0
+// on success.
+static int ParseIndex(odla_constants_array constants_array) {
+  const unsigned char* base = (const unsigned char*)constants_array->base;
+  size_t size = constants_array->size;
+  WeightsHeader header;
+  if (size < sizeof(header)) {
+    return -1;
+  }
+  memcpy(&header, base, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.index_offset > size ||
+      header.data_offset > size) {
+    return -1;
+  }
+  constants_array->num_entries = header.num_entries;
+  constants_array->entries = (ConstantEntry*)calloc(
+      header.num_entries == 0 ? 1 : header.num_entries, sizeof(ConstantEntry));
+  if (constants_array->entries == NULL) {
+    return -1;
+  }
+  uint64_t pos = header.index_offset;
+  for (uint32_t i = 0; i < header.num_entries; ++i) {
+    uint64_t offset = 0;
+    uint64_t data_size = 0;
+    uint32_t data_type = 0;
+    uint32_t rank = 0;
+    uint32_t name_size = 0;
+    // The checks subtract from `size` so that corrupted offsets and counts
+    // cannot wrap around.
+    if (pos > size || size - pos < 24) {
+      return -1;
+    }
+    memcpy(&offset, base + pos, sizeof(offset));
+    memcpy(&data_size, base + pos + 8, sizeof(data_size));
+    memcpy(&data_type, base + pos + 16, sizeof(data_type));
+    memcpy(&rank, base + pos + 20, sizeof(rank));
+    if (rank > (size - pos - 24) / sizeof(int64_t)) {
+      return -1;
+    }
+    pos += 24 + (uint64_t)rank * sizeof(int64_t);
+    if (size - pos < sizeof(name_size)) {
+      return -1;
+    }
+    memcpy(&name_size, base + pos, sizeof(name_size));
+    pos += sizeof(name_size);
+    if (name_size == 0 || name_size > size - pos ||
+        base[pos + name_size - 1] != '\0' || offset > size ||
+        data_size > size - offset) {
+      return -1;
+    }
+    constants_array->entries[i].name = (const char*)(base + pos);
+    constants_array->entries[i].data = base + offset;
+    constants_array->entries[i].size = data_size;
+    pos = AlignTo(pos + name_size, sizeof(uint64_t));
+  }
+  qsort(constants_array->entries, header.num_entries, sizeof(ConstantEntry),
+        CompareEntries);
+  // A name must identify one entry.
+  for (uint32_t i = 1; i < header.num_entries; ++i) {
+    if (CompareEntries(&constants_array->entries[i - 1],
+                       &constants_array->entries[i]) == 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+odla_status odla_CreateConstantsArray(odla_constants_array* constants_array) {
+  *constants_array = (odla_constants_array)calloc(
+      1, sizeof(struct _odla_constants_array));
+  return *constants_array == NULL ? ODLA_FAILURE : ODLA_SUCCESS;
+}
+
+odla_status odla_LoadConstantsArray(const odla_char* file_name,
+                                    odla_constants_array* constants_array) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    return ODLA_FAILURE;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return ODLA_FAILURE;
+  }
+  // A private writable mapping lets backends that modify constants in place
+  // do so on their own copy-on-write pages.
+  void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return ODLA_FAILURE;
+  }
+  odla_constants_array array = (odla_constants_array)calloc(
+      1, sizeof(struct _odla_constants_array));
+  if (array == NULL) {
+    munmap(base, (size_t)st.st_size);
+    return ODLA_FAILURE;
+  }
+  array->base = base;
+  array->size = (size_t)st.st_size;
+  if (ParseIndex(array) != 0) {
+    odla_DestroyConstantsArray(array);
+    return ODLA_FAILURE;
+  }
+  *constants_array = array;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_StoreConstantsArray(
+    const odla_char* file_name, const odla_constants_array constants_array) {
+  if (constants_array->base == NULL) {
+    return ODLA_FAILURE;
+  }
+  FILE* fp = fopen(file_name, "wb");
+  if (fp == NULL) {
+    return ODLA_FAILURE;
+  }
+  size_t written =
+      fwrite(constants_array->base, 1, constants_array->size, fp);
+  return (fclose(fp) == 0 && written == constants_array->size) ? ODLA_SUCCESS
+                                                               : ODLA_FAILURE;
+}
+
+odla_status odla_DestroyConstantsArray(odla_constants_array constants_array) {
+  if (constants_array == NULL) {
+    return ODLA_FAILURE;
+  }
+  if (constants_array->base != NULL) {
+    munmap(constants_array->base, constants_array->size);
+  }
+  free(constants_array->entries);
+  free(constants_array);
+  return ODLA_SUCCESS;
+}
+
+odla_value odla_CreateConstantFromArray(
+    const odla_constants_array constants_array,
+    const odla_value_type value_type, const odla_char* name,
+    const odla_value_id value_id) {
+  uint64_t size = GetElementSize(value_type.element_type);
+  for (int i = 0; i < value_type.shape.size; ++i) {
+    size *= (uint64_t)value_type.shape.dims[i];
+  }
+  const ConstantEntry* entry = (const ConstantEntry*)bsearch(
+      name, constants_array->entries, constants_array->num_entries,
+      sizeof(ConstantEntry), CompareNameToEntry);
+  if (entry == NULL || entry->size != size) {
+    return NULL;
+  }
+  return odla_CreateConstant(value_type, entry->data, value_id);
+}
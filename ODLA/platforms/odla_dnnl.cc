@@ -17,16 +17,26 @@
 
 #include <ODLA/odla.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "ODLA/odla_compute.h"
 #include "dnnl.hpp"
+#include "odla_async_queue.h"
 
 #if !defined(ODLA_VERSION_NUMBER) || (ODLA_VERSION_NUMBER < 50)
 #error This library requires minimum ODLA version 0.5
@@ -37,6 +47,8 @@ struct _odla_value {
   bool is_const;
   odla_value_shape shape;
   std::string name;
+  // The index of the value in its computation.
+  size_t index = 0;
   _odla_value(const dnnl::memory& m, const odla_value_shape& shape,
               const std::string& id)
       : mem(m), is_const(false), shape(shape), name(id) {}
@@ -54,13 +66,47 @@ struct _odla_computation {
   std::unordered_map<std::string, odla_value> inputs;
   std::unordered_map<std::string, odla_value> outputs;
   target_opts opts;
+  // For computations loaded from files, the mapping that holds the constants
+  // and the buffers that the primitive arguments were created with.
+  std::shared_ptr<void> mapped_file;
+  std::vector<dnnl::memory> buffers;
+  // A dynamic batch computation is built for its maximum batch size, and
+  // smaller batches are padded to it.
+  bool is_dynamic_batch = false;
+  int max_batch_size = 0;
+  // Unique for the lifetime of the process, unlike the address, which may be
+  // reused by a computation created after this one is destroyed.
+  uint64_t generation = 0;
 
   _odla_computation() : eng(dnnl::engine::kind::cpu, 0), opts({false}) {}
 };
 
+// A computation is immutable once built and can be executed by many contexts
+// concurrently. Each context owns its stream and the buffers that are written
+// at runtime or bound by the user; constants are shared.
 struct _odla_context {
-  odla_computation comp;
+  // The computation that `args` and `buffers` were set up for.
+  odla_computation comp = nullptr;
+  uint64_t comp_generation = 0;
   std::unique_ptr<dnnl::stream> stream;
+  // The arguments of each primitive, using the buffers of this context.
+  std::vector<std::unordered_map<int, dnnl::memory>> args;
+  // A runtime buffer of this context: the scratch memory allocated for it and
+  // the memories that alias it, which a run may rebind to user data.
+  struct Buffer {
+    void* scratch = nullptr;
+    std::vector<dnnl::memory> memories;
+  };
+  // The runtime buffers keyed by the buffer's data handle in the computation.
+  std::unordered_map<void*, Buffer> buffers;
+  std::vector<dnnl::memory> scratch;
+  Bindings bindings;
+  // The maximum number of asynchronous executions in flight.
+  size_t async_depth = 2;
+  odla_async_callback async_callback = nullptr;
+  odla_void* async_user_data = nullptr;
+  std::unique_ptr<AsyncQueue> async;
+  PaddedBatch padded_batch;
 };
 
 static dnnl::memory::format_tag getFormatTag(const odla_value_shape& od) {
@@ -124,6 +170,15 @@ static dnnl::memory::data_type getDataType(const odla_element_type ty) {
     case ODLA_BFLOAT16:
       dt = dnnl::memory::data_type::bf16;
       break;
+    case ODLA_FLOAT16:
+      dt = dnnl::memory::data_type::f16;
+      break;
+    case ODLA_INT8:
+      dt = dnnl::memory::data_type::s8;
+      break;
+    case ODLA_UINT8:
+      dt = dnnl::memory::data_type::u8;
+      break;
     default:
       dt = dnnl::memory::data_type::undef;
   }
@@ -154,8 +209,12 @@ void odla_ConfigTargetOptions(odla_computation comp, target_opts opts) {
   comp->opts.enable_bf16 = opts.enable_bf16;
 }
 
+// The computation being built by the current thread.
 thread_local odla_computation g_comp;
 static std::vector<std::unique_ptr<_odla_computation>> g_comps;
+static std::mutex g_comps_mutex;
+// The generation of the last computation created. Guarded by g_comps_mutex.
+static uint64_t g_comp_generation = 0;
 thread_local bool g_interpret_mode = false;
 
 #ifdef ODLA_DNNL_BUILD_AS_INTERPRETER
@@ -168,18 +227,31 @@ struct Initializer {
 static Initializer interpreter_initializer;
 #endif
 
+// Replaces the dynamic batch dimension of the computation being built with its
+// maximum batch size.
+static odla_value_shape ResolveBatch(odla_value_shape shape) {
+  if (g_comp != nullptr && g_comp->is_dynamic_batch && shape.size > 0 &&
+      shape.dims[0] < 0) {
+    shape.dims[0] = g_comp->max_batch_size;
+  }
+  return shape;
+}
+
 static odla_value CreateValue(const dnnl::memory& mem,
                               const odla_value_shape shape,
                               const odla_value_id id) {
   std::string name = id == nullptr ? "" : std::string((const char*)id);
   auto v = std::make_unique<_odla_value>(mem, shape, name);
   auto ret = v.get();
+  ret->index = g_comp->vals.size();
   g_comp->vals.push_back(std::move(v));
   return ret;
 }
 
 odla_status odla_CreateComputation(odla_computation* computation) {
+  std::lock_guard<std::mutex> lock(g_comps_mutex);
   g_comps.push_back(std::make_unique<_odla_computation>());
+  g_comps.back()->generation = ++g_comp_generation;
   g_comp = g_comps.back().get();
   if (computation != nullptr) {
     *computation = g_comp;
@@ -193,31 +265,870 @@ odla_status odla_SetActiveComputation(odla_computation computation) {
 }
 
 odla_status odla_DestroyComputation(odla_computation computation) {
-  // TODO:
+  std::lock_guard<std::mutex> lock(g_comps_mutex);
+  auto it = std::find_if(g_comps.begin(), g_comps.end(),
+                         [computation](const auto& comp) {
+                           return comp.get() == computation;
+                         });
+  if (it == g_comps.end()) {
+    return ODLA_FAILURE;
+  }
+  if (g_comp == computation) {
+    g_comp = nullptr;
+  }
+  g_comps.erase(it);
   return ODLA_SUCCESS;
 }
 
 odla_status odla_CreateContext(odla_context* ctx) {
   *ctx = new _odla_context();
-  (*ctx)->comp = g_comp;
   return ODLA_SUCCESS;
 }
 
+odla_status odla_WaitContext(odla_context context) {
+  return context->async == nullptr ? ODLA_SUCCESS : context->async->Wait();
+}
+
 odla_status odla_DestroyContext(odla_context ctx) {
+  // Pending requests are drained before the worker exits.
+  ctx->async.reset();
   delete (ctx);
   return ODLA_SUCCESS;
 }
 
+odla_status odla_SetComputationItem(odla_computation computation,
+                                    odla_item_type type,
+                                    odla_item_value value) {
+  switch (type) {
+    case ODLA_DYNAMIC_BATCH:
+      if (!computation->vals.empty()) {
+        // The values created so far have the batch size unresolved.
+        return ODLA_FAILURE;
+      }
+      computation->is_dynamic_batch = *(reinterpret_cast<bool*>(value));
+      break;
+    case ODLA_MAX_BATCH_SIZE: {
+      int max_batch_size = *(reinterpret_cast<int*>(value));
+      if (max_batch_size <= 0 || !computation->vals.empty()) {
+        return ODLA_FAILURE;
+      }
+      computation->max_batch_size = max_batch_size;
+      break;
+    }
+    case ODLA_MIN_BATCH_SIZE:
+    case ODLA_OPT_BATCH_SIZE:
+      // Every batch size runs the computation built for the maximum one.
+      break;
+    default:
+      std::cerr << "Unsupported property type: " << type << std::endl;
+      return ODLA_FAILURE;
+  }
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetContextItem(odla_context context, odla_item_type type,
+                                odla_item_value value) {
+  switch (type) {
+    case ODLA_ASYNC_QUEUE_DEPTH: {
+      int depth = *(reinterpret_cast<int*>(value));
+      if (depth <= 0) {
+        return ODLA_FAILURE;
+      }
+      context->async_depth = depth;
+      break;
+    }
+    case ODLA_RUN_BATCH_SIZE: {
+      int batch_size = *(reinterpret_cast<int*>(value));
+      if (batch_size < 0) {
+        return ODLA_FAILURE;
+      }
+      context->bindings.batch_size = batch_size;
+      break;
+    }
+    default:
+      std::cerr << "Unsupported property type: " << type << std::endl;
+      return ODLA_FAILURE;
+  }
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetAsyncCallback(odla_context context,
+                                  odla_async_callback callback,
+                                  odla_void* user_data) {
+  odla_status status = odla_WaitContext(context);
+  context->async_callback = callback;
+  context->async_user_data = user_data;
+  return status;
+}
+
+static bool isOutputArg(int arg) {
+  return (arg >= DNNL_ARG_DST_0 && arg <= DNNL_ARG_DST_2) ||
+         arg == DNNL_ARG_WORKSPACE;
+}
+
+// Returns the sizes of the buffers that are written at runtime or hold the
+// inputs, keyed by data handle. Different memories may alias one buffer. All
+// other buffers of the computation hold constants.
+static std::unordered_map<void*, size_t> getRuntimeBuffers(
+    odla_computation comp) {
+  std::unordered_map<void*, size_t> sizes;
+  auto add = [&sizes](const dnnl::memory& mem) {
+    void* handle = mem.get_data_handle();
+    if (handle != nullptr) {
+      size_t& size = sizes[handle];
+      size = std::max(size, mem.get_desc().get_size());
+    }
+  };
+  for (const auto& args : comp->args) {
+    for (const auto& arg : args) {
+      if (isOutputArg(arg.first)) {
+        add(arg.second);
+      }
+    }
+  }
+  for (const auto& input : comp->inputs) {
+    add(input.second->mem);
+  }
+  for (const auto& args : comp->args) {
+    for (const auto& arg : args) {
+      if (sizes.count(arg.second.get_data_handle()) != 0) {
+        add(arg.second);
+      }
+    }
+  }
+  return sizes;
+}
+
+// Allocates the runtime buffers of `ctx` and rewrites the primitive arguments
+// of `comp` to use them.
+static void initContext(odla_context ctx, odla_computation comp) {
+  ctx->comp = comp;
+  ctx->comp_generation = comp->generation;
+  ctx->stream = std::make_unique<dnnl::stream>(comp->eng);
+  ctx->args.clear();
+  ctx->buffers.clear();
+  ctx->scratch.clear();
+
+  // Buffers written by primitives and the inputs are per context.
+  std::unordered_map<void*, size_t> sizes = getRuntimeBuffers(comp);
+
+  std::unordered_map<void*, void*> handles;
+  for (const auto& buffer : sizes) {
+    dnnl::memory::desc md({static_cast<dnnl::memory::dim>(buffer.second)},
+                          dnnl::memory::data_type::u8,
+                          dnnl::memory::format_tag::a);
+    ctx->scratch.emplace_back(md, comp->eng);
+    void* scratch = ctx->scratch.back().get_data_handle();
+    handles[buffer.first] = scratch;
+    ctx->buffers[buffer.first].scratch = scratch;
+  }
+
+  ctx->args.reserve(comp->args.size());
+  for (const auto& args : comp->args) {
+    std::unordered_map<int, dnnl::memory> ctx_args;
+    for (const auto& arg : args) {
+      void* handle = arg.second.get_data_handle();
+      auto it = handles.find(handle);
+      if (it == handles.end()) {
+        ctx_args.emplace(arg.first, arg.second);
+        continue;
+      }
+      dnnl::memory mem(arg.second.get_desc(), comp->eng, it->second);
+      ctx->buffers[handle].memories.push_back(mem);
+      ctx_args.emplace(arg.first, mem);
+    }
+    ctx->args.push_back(std::move(ctx_args));
+  }
+}
+
+static void bindValue(odla_context ctx, odla_value value, void* data_ptr) {
+  // Handle the case of output is constant due to compile-time optimization.
+  if (value->is_const) {
+    memcpy(data_ptr, value->mem.get_data_handle(),
+           value->mem.get_desc().get_size());
+    return;
+  }
+  auto it = ctx->buffers.find(value->mem.get_data_handle());
+  if (it != ctx->buffers.end()) {
+    for (auto& mem : it->second.memories) {
+      mem.set_data_handle(data_ptr);
+    }
+  }
+}
+
+// Points every runtime buffer of `ctx` back to its scratch memory, so a value
+// bound in an earlier run does not leak into a run that does not bind it.
+static void resetBindings(odla_context ctx) {
+  for (auto& buffer : ctx->buffers) {
+    for (auto& mem : buffer.second.memories) {
+      mem.set_data_handle(buffer.second.scratch);
+    }
+  }
+}
+
+static odla_status execute(odla_computation comp, odla_context context,
+                           const Bindings& run_bindings) {
+  if (context->comp != comp || context->comp_generation != comp->generation) {
+    initContext(context, comp);
+  }
+  const Bindings* padded = context->padded_batch.Pad(
+      run_bindings, comp->is_dynamic_batch ? comp->max_batch_size : 0,
+      comp->inputs, comp->outputs,
+      [](odla_value v) { return v->mem.get_desc().get_size(); });
+  if (padded == nullptr) {
+    return ODLA_FAILURE;
+  }
+  const Bindings& bindings = *padded;
+  resetBindings(context);
+  for (const auto& binding : bindings.values) {
+    bindValue(context, binding.first, binding.second);
+  }
+  for (const auto& binding : bindings.inputs) {
+    auto it = comp->inputs.find(binding.first);
+    if (it == comp->inputs.end()) {
+      return ODLA_FAILURE;
+    }
+    bindValue(context, it->second, binding.second);
+  }
+  for (const auto& binding : bindings.outputs) {
+    auto it = comp->outputs.find(binding.first);
+    if (it == comp->outputs.end()) {
+      return ODLA_FAILURE;
+    }
+    bindValue(context, it->second, binding.second);
+  }
+  for (size_t i = 0, e = comp->primitives.size(); i < e; ++i) {
+    comp->primitives[i].execute(*context->stream, context->args[i]);
+  }
+  context->stream->wait();
+  context->padded_batch.CopyOutputs();
+  return ODLA_SUCCESS;
+}
+
 odla_status odla_ExecuteComputation(odla_computation comp, odla_context context,
                                     odla_compute_mode mode,
                                     odla_device device) {
-  if (context->stream == nullptr) {
-    context->stream = std::make_unique<dnnl::stream>(comp->eng);
+  // Keep the submission order with the pending asynchronous executions.
+  odla_status status = odla_WaitContext(context);
+  if (status != ODLA_SUCCESS) {
+    return status;
+  }
+  return execute(comp, context, context->bindings);
+}
+
+odla_status odla_AsyncExecuteComputation(odla_computation comp,
+                                         odla_context context,
+                                         odla_compute_mode mode,
+                                         odla_device device) {
+  if (context->async == nullptr) {
+    context->async = std::make_unique<AsyncQueue>(
+        context, [context](odla_computation comp, const Bindings& bindings) {
+          return execute(comp, context, bindings);
+        });
+  }
+  context->async->Submit(comp, context->bindings, context->async_depth,
+                         context->async_callback, context->async_user_data);
+  return ODLA_SUCCESS;
+}
+
+// A computation is stored with its execution plan and its constants, which
+// include the weights reordered into blocked layouts, so loading it skips the
+// graph construction. The file is only loaded by the DNNL version and the CPU
+// ISA it was stored with. The layout is:
+//   header:     char magic[8], uint32 format version, uint32 DNNL version,
+//               char isa[16], int32 maximum batch size of a dynamic batch
+//               computation or 0, uint64 offset of the constants.
+//   buffers:    uint32 count, then for each buffer, uint64 size, uint8 is
+//               constant, uint64 offset of the data in the constants.
+//   primitives: uint32 count, then for each primitive, int32 kind, the
+//               arguments (uint32 count, then int32 arg, uint32 buffer,
+//               dnnl_memory_desc_t), the operation descriptor (int32 concat
+//               axis for concat, nothing for reorder, otherwise uint32 size
+//               and the bytes), the post-ops, the output scales and the
+//               destination zero points.
+//   values:     uint32 count, then for each input or output value, uint8 is
+//               output, uint8 is constant, the name, uint32 buffer,
+//               dnnl_memory_desc_t and odla_value_shape.
+//   constants:  the data of the constant buffers, aligned to 64 bytes.
+static const char kCacheMagic[8] = "HALOEXE";
+static const uint32_t kCacheVersion = 3;
+static const size_t kCacheAlignment = 64;
+
+static uint32_t getDNNLVersion() {
+  const dnnl_version_t* version = dnnl_version();
+  return version->major * 10000 + version->minor * 100 + version->patch;
+}
+
+static std::string getCpuIsa() {
+  __builtin_cpu_init();
+  for (const char* isa : {"avx512f", "avx2", "avx", "sse4.2"}) {
+    if (__builtin_cpu_supports(isa)) {
+      return isa;
+    }
+  }
+  return "generic";
+}
+
+static size_t getOpDescSize(dnnl::primitive::kind kind) {
+  switch (kind) {
+    case dnnl::primitive::kind::convolution:
+    case dnnl::primitive::kind::deconvolution:
+      return sizeof(dnnl_convolution_desc_t);
+    case dnnl::primitive::kind::eltwise:
+      return sizeof(dnnl_eltwise_desc_t);
+    case dnnl::primitive::kind::softmax:
+      return sizeof(dnnl_softmax_desc_t);
+    case dnnl::primitive::kind::pooling:
+      return sizeof(dnnl_pooling_desc_t);
+    case dnnl::primitive::kind::lrn:
+      return sizeof(dnnl_lrn_desc_t);
+    case dnnl::primitive::kind::batch_normalization:
+      return sizeof(dnnl_batch_normalization_desc_t);
+    case dnnl::primitive::kind::binary:
+      return sizeof(dnnl_binary_desc_t);
+    case dnnl::primitive::kind::matmul:
+      return sizeof(dnnl_matmul_desc_t);
+    default:
+      return 0;
+  }
+}
+
+class CacheWriter {
+ public:
+  template <typename T>
+  void Put(const T& value) {
+    PutBytes(&value, sizeof(T));
+  }
+  void PutBytes(const void* data, size_t size) {
+    buf_.append(static_cast<const char*>(data), size);
+  }
+  void PutString(const std::string& str) {
+    Put(static_cast<uint32_t>(str.size()));
+    buf_.append(str);
+  }
+  void Align(size_t alignment) {
+    buf_.resize((buf_.size() + alignment - 1) / alignment * alignment, '\0');
+  }
+  size_t Size() const { return buf_.size(); }
+  const std::string& Buffer() const { return buf_; }
+
+ private:
+  std::string buf_;
+};
+
+class CacheReader {
+ public:
+  CacheReader(const char* data, size_t size) : pos_(data), end_(data + size) {}
+  template <typename T>
+  bool Get(T* value) {
+    return GetBytes(value, sizeof(T));
+  }
+  bool GetBytes(void* data, size_t size) {
+    if (static_cast<size_t>(end_ - pos_) < size) {
+      return false;
+    }
+    memcpy(data, pos_, size);
+    pos_ += size;
+    return true;
+  }
+  bool GetString(std::string* str) {
+    uint32_t size = 0;
+    if (!Get(&size) || static_cast<size_t>(end_ - pos_) < size) {
+      return false;
+    }
+    str->assign(pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  const char* pos_;
+  const char* end_;
+};
+
+// Maps each buffer of the computation to an index in the stored file.
+struct CacheBuffers {
+  std::unordered_map<void*, uint32_t> indices;
+  std::vector<void*> handles;
+  std::vector<size_t> sizes;
+  std::vector<bool> is_const;
+
+  uint32_t Add(const dnnl::memory& mem,
+               const std::unordered_map<void*, size_t>& runtime) {
+    void* handle = mem.get_data_handle();
+    size_t size = mem.get_desc().get_size();
+    auto it = indices.find(handle);
+    if (it != indices.end()) {
+      sizes[it->second] = std::max(sizes[it->second], size);
+      return it->second;
+    }
+    uint32_t idx = handles.size();
+    indices[handle] = idx;
+    handles.push_back(handle);
+    sizes.push_back(size);
+    is_const.push_back(runtime.count(handle) == 0);
+    return idx;
+  }
+};
+
+static void putMemory(CacheWriter* writer, CacheBuffers* buffers,
+                      const std::unordered_map<void*, size_t>& runtime,
+                      const dnnl::memory& mem) {
+  writer->Put(buffers->Add(mem, runtime));
+  writer->Put(mem.get_desc().data);
+}
+
+static void putPostOps(CacheWriter* writer, const_dnnl_primitive_desc_t pd) {
+  const_dnnl_primitive_attr_t attr = nullptr;
+  const_dnnl_post_ops_t post_ops = nullptr;
+  int len = 0;
+  if (dnnl_primitive_desc_get_attr(pd, &attr) == dnnl_success &&
+      dnnl_primitive_attr_get_post_ops(attr, &post_ops) == dnnl_success) {
+    len = dnnl_post_ops_len(post_ops);
+  }
+  writer->Put(static_cast<uint32_t>(len));
+  for (int i = 0; i < len; ++i) {
+    dnnl_primitive_kind_t kind = dnnl_post_ops_get_kind(post_ops, i);
+    writer->Put(static_cast<int32_t>(kind));
+    float scale = 1;
+    if (kind == dnnl_eltwise) {
+      dnnl_alg_kind_t alg;
+      float alpha = 0;
+      float beta = 0;
+      dnnl_post_ops_get_params_eltwise(post_ops, i, &scale, &alg, &alpha,
+                                       &beta);
+      writer->Put(scale);
+      writer->Put(static_cast<int32_t>(alg));
+      writer->Put(alpha);
+      writer->Put(beta);
+    } else if (kind == dnnl_sum) {
+      dnnl_post_ops_get_params_sum(post_ops, i, &scale);
+      writer->Put(scale);
+    }
+  }
+}
+
+static bool getPostOps(CacheReader* reader, dnnl::primitive_attr* attr) {
+  uint32_t len = 0;
+  if (!reader->Get(&len)) {
+    return false;
+  }
+  dnnl::post_ops ops;
+  for (uint32_t i = 0; i < len; ++i) {
+    int32_t kind = 0;
+    float scale = 1;
+    if (!reader->Get(&kind) || !reader->Get(&scale)) {
+      return false;
+    }
+    if (kind == dnnl_eltwise) {
+      int32_t alg = 0;
+      float alpha = 0;
+      float beta = 0;
+      if (!reader->Get(&alg) || !reader->Get(&alpha) || !reader->Get(&beta)) {
+        return false;
+      }
+      ops.append_eltwise(scale, static_cast<dnnl::algorithm>(alg), alpha,
+                         beta);
+    } else if (kind == dnnl_sum) {
+      ops.append_sum(scale);
+    } else {
+      return false;
+    }
+  }
+  attr->set_post_ops(ops);
+  return true;
+}
+
+// The output scales and the destination zero points of quantized primitives.
+static void putScales(CacheWriter* writer, const_dnnl_primitive_desc_t pd) {
+  const_dnnl_primitive_attr_t attr = nullptr;
+  dnnl_dim_t num_scales = 0;
+  int scales_mask = 0;
+  const float* scales = nullptr;
+  dnnl_dim_t num_zero_points = 0;
+  int zero_points_mask = 0;
+  const int32_t* zero_points = nullptr;
+  if (dnnl_primitive_desc_get_attr(pd, &attr) == dnnl_success) {
+    dnnl_primitive_attr_get_output_scales(attr, &num_scales, &scales_mask,
+                                          &scales);
+    dnnl_primitive_attr_get_zero_points(attr, DNNL_ARG_DST, &num_zero_points,
+                                        &zero_points_mask, &zero_points);
+  }
+  writer->Put(static_cast<int32_t>(scales_mask));
+  writer->Put(static_cast<uint32_t>(num_scales));
+  writer->PutBytes(scales, num_scales * sizeof(float));
+  writer->Put(static_cast<int32_t>(zero_points_mask));
+  writer->Put(static_cast<uint32_t>(num_zero_points));
+  writer->PutBytes(zero_points, num_zero_points * sizeof(int32_t));
+}
+
+static bool getScales(CacheReader* reader, dnnl::primitive_attr* attr) {
+  int32_t scales_mask = 0;
+  uint32_t num_scales = 0;
+  if (!reader->Get(&scales_mask) || !reader->Get(&num_scales)) {
+    return false;
+  }
+  std::vector<float> scales(num_scales);
+  if (!reader->GetBytes(scales.data(), num_scales * sizeof(float))) {
+    return false;
+  }
+  int32_t zero_points_mask = 0;
+  uint32_t num_zero_points = 0;
+  if (!reader->Get(&zero_points_mask) || !reader->Get(&num_zero_points)) {
+    return false;
   }
+  std::vector<int32_t> zero_points(num_zero_points);
+  if (!reader->GetBytes(zero_points.data(),
+                        num_zero_points * sizeof(int32_t))) {
+    return false;
+  }
+  if (num_scales != 0) {
+    attr->set_output_scales(scales_mask, scales);
+  }
+  if (num_zero_points != 0) {
+    attr->set_zero_points(DNNL_ARG_DST, zero_points_mask, zero_points);
+  }
+  return true;
+}
+
+// Returns the concatenation axis, the only dimension in which a source
+// differs from the destination.
+static int getConcatAxis(const std::unordered_map<int, dnnl::memory>& args) {
+  dnnl::memory::desc dst = args.at(DNNL_ARG_DST).get_desc();
+  dnnl::memory::desc src = args.at(DNNL_ARG_MULTIPLE_SRC).get_desc();
+  for (int i = 0; i < dst.data.ndims; ++i) {
+    if (src.data.dims[i] != dst.data.dims[i]) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+odla_status odla_StoreComputation(const odla_char* file_name,
+                                  const odla_computation comp) {
+  std::unordered_map<void*, size_t> runtime = getRuntimeBuffers(comp);
+  CacheBuffers buffers;
+  CacheWriter body;
+
+  body.Put(static_cast<uint32_t>(comp->primitives.size()));
   for (size_t i = 0, e = comp->primitives.size(); i < e; ++i) {
-    comp->primitives[i].execute(*context->stream, comp->args[i]);
+    const dnnl::primitive& prim = comp->primitives[i];
+    const auto& args = comp->args[i];
+    auto kind = prim.get_kind();
+    body.Put(static_cast<int32_t>(kind));
+    body.Put(static_cast<uint32_t>(args.size()));
+    for (const auto& arg : args) {
+      body.Put(static_cast<int32_t>(arg.first));
+      putMemory(&body, &buffers, runtime, arg.second);
+    }
+    const_dnnl_primitive_desc_t pd = prim.get_primitive_desc();
+    if (kind == dnnl::primitive::kind::concat) {
+      body.Put(static_cast<int32_t>(getConcatAxis(args)));
+    } else if (kind != dnnl::primitive::kind::reorder) {
+      size_t size = getOpDescSize(kind);
+      const_dnnl_op_desc_t op_desc = nullptr;
+      if (size == 0 || dnnl_primitive_desc_query(pd, dnnl_query_op_d, 0,
+                                                 &op_desc) != dnnl_success) {
+        return ODLA_FAILURE;
+      }
+      body.Put(static_cast<uint32_t>(size));
+      body.PutBytes(op_desc, size);
+    }
+    putPostOps(&body, pd);
+    putScales(&body, pd);
   }
-  context->stream->wait();
+
+  body.Put(static_cast<uint32_t>(comp->inputs.size() + comp->outputs.size()));
+  for (const auto* values : {&comp->inputs, &comp->outputs}) {
+    for (const auto& kv : *values) {
+      body.Put(static_cast<uint8_t>(values == &comp->outputs));
+      body.Put(static_cast<uint8_t>(kv.second->is_const));
+      body.PutString(kv.first);
+      putMemory(&body, &buffers, runtime, kv.second->mem);
+      body.Put(kv.second->shape);
+    }
+  }
+
+  CacheWriter header;
+  header.PutBytes(kCacheMagic, sizeof(kCacheMagic));
+  header.Put(kCacheVersion);
+  header.Put(getDNNLVersion());
+  char isa[16] = {0};
+  strncpy(isa, getCpuIsa().c_str(), sizeof(isa) - 1);
+  header.PutBytes(isa, sizeof(isa));
+  header.Put(static_cast<int32_t>(comp->is_dynamic_batch ? comp->max_batch_size
+                                                         : 0));
+  size_t buffers_size = sizeof(uint32_t) +
+                        buffers.handles.size() * (2 * sizeof(uint64_t) + 1);
+  uint64_t data_offset = header.Size() + sizeof(uint64_t) + buffers_size +
+                         body.Size();
+  data_offset = (data_offset + kCacheAlignment - 1) / kCacheAlignment *
+                kCacheAlignment;
+  header.Put(data_offset);
+
+  CacheWriter data;
+  header.Put(static_cast<uint32_t>(buffers.handles.size()));
+  for (size_t i = 0, e = buffers.handles.size(); i < e; ++i) {
+    header.Put(static_cast<uint64_t>(buffers.sizes[i]));
+    header.Put(static_cast<uint8_t>(buffers.is_const[i]));
+    header.Put(static_cast<uint64_t>(data.Size()));
+    if (buffers.is_const[i]) {
+      data.PutBytes(buffers.handles[i], buffers.sizes[i]);
+      data.Align(kCacheAlignment);
+    }
+  }
+
+  // Written to a temporary file first so that concurrent loaders never see a
+  // partial file.
+  std::string tmp_name = std::string(file_name) + ".tmp." +
+                         std::to_string(static_cast<long>(getpid()));
+  FILE* fp = fopen(tmp_name.c_str(), "wb");
+  if (fp == nullptr) {
+    return ODLA_FAILURE;
+  }
+  const std::string padding(data_offset - header.Size() - body.Size(), '\0');
+  bool ok =
+      fwrite(header.Buffer().data(), 1, header.Size(), fp) == header.Size() &&
+      fwrite(body.Buffer().data(), 1, body.Size(), fp) == body.Size() &&
+      fwrite(padding.data(), 1, padding.size(), fp) == padding.size() &&
+      fwrite(data.Buffer().data(), 1, data.Size(), fp) == data.Size();
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmp_name.c_str(), file_name) != 0) {
+    remove(tmp_name.c_str());
+    return ODLA_FAILURE;
+  }
+  return ODLA_SUCCESS;
+}
+
+static bool getMemory(CacheReader* reader, odla_computation comp,
+                      const std::vector<void*>& handles, dnnl::memory* mem) {
+  uint32_t idx = 0;
+  dnnl_memory_desc_t md;
+  if (!reader->Get(&idx) || !reader->Get(&md) || idx >= handles.size()) {
+    return false;
+  }
+  *mem = dnnl::memory(dnnl::memory::desc(md), comp->eng, handles[idx]);
+  return true;
+}
+
+static bool loadComputation(const char* base, size_t size,
+                            odla_computation comp) {
+  CacheReader reader(base, size);
+  char magic[sizeof(kCacheMagic)];
+  uint32_t version = 0;
+  uint32_t dnnl_version = 0;
+  char isa[16];
+  int32_t max_batch_size = 0;
+  uint64_t data_offset = 0;
+  if (!reader.GetBytes(magic, sizeof(magic)) || !reader.Get(&version) ||
+      !reader.Get(&dnnl_version) || !reader.GetBytes(isa, sizeof(isa)) ||
+      !reader.Get(&max_batch_size) || !reader.Get(&data_offset)) {
+    return false;
+  }
+  isa[sizeof(isa) - 1] = '\0';
+  if (memcmp(magic, kCacheMagic, sizeof(magic)) != 0 ||
+      version != kCacheVersion || dnnl_version != getDNNLVersion() ||
+      getCpuIsa() != isa || max_batch_size < 0 || data_offset > size) {
+    return false;
+  }
+  comp->is_dynamic_batch = max_batch_size > 0;
+  comp->max_batch_size = max_batch_size;
+
+  // Constants are used in place; runtime buffers only serve as templates for
+  // the buffers of each context.
+  uint32_t num_buffers = 0;
+  if (!reader.Get(&num_buffers)) {
+    return false;
+  }
+  std::vector<void*> handles;
+  std::vector<dnnl::memory> runtime_buffers;
+  for (uint32_t i = 0; i < num_buffers; ++i) {
+    uint64_t buffer_size = 0;
+    uint8_t is_const = 0;
+    uint64_t offset = 0;
+    if (!reader.Get(&buffer_size) || !reader.Get(&is_const) ||
+        !reader.Get(&offset)) {
+      return false;
+    }
+    if (is_const) {
+      if (data_offset + offset + buffer_size > size) {
+        return false;
+      }
+      handles.push_back(const_cast<char*>(base) + data_offset + offset);
+      continue;
+    }
+    dnnl::memory::desc md({static_cast<dnnl::memory::dim>(buffer_size)},
+                          dnnl::memory::data_type::u8,
+                          dnnl::memory::format_tag::a);
+    runtime_buffers.emplace_back(md, comp->eng);
+    handles.push_back(runtime_buffers.back().get_data_handle());
+  }
+  comp->buffers = std::move(runtime_buffers);
+
+  uint32_t num_prims = 0;
+  if (!reader.Get(&num_prims)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_prims; ++i) {
+    int32_t kind = 0;
+    uint32_t num_args = 0;
+    if (!reader.Get(&kind) || !reader.Get(&num_args)) {
+      return false;
+    }
+    std::unordered_map<int, dnnl::memory> args;
+    for (uint32_t j = 0; j < num_args; ++j) {
+      int32_t arg = 0;
+      dnnl::memory mem;
+      if (!reader.Get(&arg) || !getMemory(&reader, comp, handles, &mem)) {
+        return false;
+      }
+      args[arg] = mem;
+    }
+    auto prim_kind = static_cast<dnnl::primitive::kind>(kind);
+    int32_t axis = 0;
+    std::vector<char> op_desc;
+    if (prim_kind == dnnl::primitive::kind::concat) {
+      if (!reader.Get(&axis)) {
+        return false;
+      }
+    } else if (prim_kind != dnnl::primitive::kind::reorder) {
+      uint32_t op_desc_size = 0;
+      if (!reader.Get(&op_desc_size) ||
+          op_desc_size != getOpDescSize(prim_kind)) {
+        return false;
+      }
+      op_desc.resize(op_desc_size);
+      if (!reader.GetBytes(op_desc.data(), op_desc_size)) {
+        return false;
+      }
+    }
+    dnnl::primitive_attr attr;
+    if (!getPostOps(&reader, &attr) || !getScales(&reader, &attr)) {
+      return false;
+    }
+
+    if (prim_kind == dnnl::primitive::kind::reorder) {
+      comp->primitives.push_back(dnnl::reorder(
+          args.at(DNNL_ARG_FROM), args.at(DNNL_ARG_TO), attr));
+    } else if (prim_kind == dnnl::primitive::kind::concat) {
+      std::vector<dnnl::memory::desc> srcs;
+      for (size_t j = 0; args.count(DNNL_ARG_MULTIPLE_SRC + j) != 0; ++j) {
+        srcs.push_back(args.at(DNNL_ARG_MULTIPLE_SRC + j).get_desc());
+      }
+      comp->primitives.push_back(dnnl::concat(dnnl::concat::primitive_desc(
+          args.at(DNNL_ARG_DST).get_desc(), axis, srcs, comp->eng, attr)));
+    } else {
+      dnnl_primitive_desc_t pd = nullptr;
+      if (dnnl_primitive_desc_create(&pd, op_desc.data(), attr.get(),
+                                     comp->eng.get(),
+                                     nullptr) != dnnl_success) {
+        return false;
+      }
+      comp->primitives.push_back(dnnl::primitive(pd));
+      dnnl_primitive_desc_destroy(pd);
+    }
+    comp->args.push_back(std::move(args));
+  }
+
+  uint32_t num_values = 0;
+  if (!reader.Get(&num_values)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_values; ++i) {
+    uint8_t is_output = 0;
+    uint8_t is_const = 0;
+    std::string name;
+    dnnl::memory mem;
+    odla_value_shape shape;
+    if (!reader.Get(&is_output) || !reader.Get(&is_const) ||
+        !reader.GetString(&name) || !getMemory(&reader, comp, handles, &mem) ||
+        !reader.Get(&shape)) {
+      return false;
+    }
+    odla_value v = CreateValue(mem, shape, (const odla_value_id)name.c_str());
+    v->is_const = is_const;
+    (is_output ? comp->outputs : comp->inputs)[name] = v;
+  }
+  return true;
+}
+
+odla_status odla_LoadComputation(const odla_char* file_name,
+                                 odla_computation* computation) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    return ODLA_FAILURE;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return ODLA_FAILURE;
+  }
+  size_t size = st.st_size;
+  // Backends never write to constants, but DNNL takes non-const handles.
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return ODLA_FAILURE;
+  }
+  odla_computation comp = nullptr;
+  odla_CreateComputation(&comp);
+  comp->mapped_file.reset(base, [size](void* p) { munmap(p, size); });
+  if (!loadComputation(static_cast<const char*>(base), size, comp)) {
+    odla_DestroyComputation(comp);
+    return ODLA_FAILURE;
+  }
+  *computation = comp;
+  return ODLA_SUCCESS;
+}
+
+// Computations are compiled when they are built, so an executable is the
+// computation it was compiled from.
+struct _odla_executable {
+  odla_computation comp;
+  bool owns_comp;
+};
+
+odla_status odla_CompileComputation(const odla_computation computation,
+                                    odla_executable* executable) {
+  *executable = new _odla_executable{computation, false};
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_LoadExecutable(const odla_char* file_name,
+                                odla_executable* executable) {
+  odla_computation comp = nullptr;
+  odla_status status = odla_LoadComputation(file_name, &comp);
+  if (status == ODLA_SUCCESS) {
+    *executable = new _odla_executable{comp, true};
+  }
+  return status;
+}
+
+odla_status odla_StoreExecutable(const odla_char* file_name,
+                                 const odla_executable executable) {
+  return odla_StoreComputation(file_name, executable->comp);
+}
+
+odla_status odla_LaunchExecutable(const odla_executable executable,
+                                  const odla_constants_array constants_array,
+                                  const odla_context context,
+                                  const odla_compute_mode mode,
+                                  odla_device device) {
+  return odla_ExecuteComputation(executable->comp, context, mode, device);
+}
+
+odla_status odla_AsyncLaunchExecutable(
+    const odla_executable executable,
+    const odla_constants_array constants_array, const odla_context context,
+    const odla_compute_mode mode, odla_device device) {
+  return odla_AsyncExecuteComputation(executable->comp, context, mode, device);
+}
+
+odla_status odla_DestroyExecutable(odla_executable executable) {
+  if (executable->owns_comp) {
+    odla_DestroyComputation(executable->comp);
+  }
+  delete executable;
   return ODLA_SUCCESS;
 }
 
@@ -243,6 +1154,7 @@ static void InterpretIfNeeded() {
 }
 
 odla_value odla_CreateArgument(odla_value_type type, const odla_value_id id) {
+  type.shape = ResolveBatch(type.shape);
   const char* name = (const char*)id;
   dnnl::memory::desc md = getMemoryDesc(type.shape, ODLA_FLOAT32);
   dnnl::memory mem = dnnl::memory(md, g_comp->eng);
@@ -252,6 +1164,7 @@ odla_value odla_CreateArgument(odla_value_type type, const odla_value_id id) {
 }
 
 odla_value odla_CreateValue(odla_value_type type, const odla_value_id id) {
+  type.shape = ResolveBatch(type.shape);
   assert(g_interpret_mode);
   auto v = odla_CreateArgument(type, id);
   return v;
@@ -266,7 +1179,26 @@ odla_status odla_GetValueType(const odla_value value,
 
 odla_status odla_BindToArgument(odla_value value, const odla_void* data_ptr,
                                 odla_context context) {
-  value->mem.set_data_handle(const_cast<void*>(data_ptr));
+  context->bindings.values[value] = const_cast<void*>(data_ptr);
+  return ODLA_SUCCESS;
+}
+
+// Only the values created in the interpreter mode can be released; the others
+// are owned by their computations.
+odla_status odla_ReleaseValue(odla_value value) {
+  if (!g_interpret_mode || value == nullptr ||
+      value->index >= g_comp->vals.size() ||
+      g_comp->vals[value->index].get() != value) {
+    return ODLA_FAILURE;
+  }
+  auto it = g_comp->inputs.find(value->name);
+  if (it != g_comp->inputs.end() && it->second == value) {
+    g_comp->inputs.erase(it);
+  }
+  size_t index = value->index;
+  std::swap(g_comp->vals[index], g_comp->vals.back());
+  g_comp->vals[index]->index = index;
+  g_comp->vals.pop_back();
   return ODLA_SUCCESS;
 }
 
@@ -285,9 +1217,8 @@ odla_status odla_GetValueData(const odla_value value, odla_void* data_ptr) {
 odla_status odla_BindToArgumentById(const odla_value_id value_id,
                                     const odla_void* data_ptr,
                                     odla_context context) {
-  std::string name((const char*)value_id);
-  odla_value value = context->comp->inputs[name];
-  return odla_BindToArgument(value, data_ptr, context);
+  context->bindings.inputs[(const char*)value_id] = const_cast<void*>(data_ptr);
+  return ODLA_SUCCESS;
 }
 
 odla_value odla_CreateConstant(odla_value_type type, const void* ptr,
@@ -309,21 +1240,14 @@ odla_status odla_SetValueAsOutput(const odla_value val) {
 
 odla_status odla_BindToOutput(odla_value value, odla_void* data_ptr,
                               odla_context context) {
-  // Handle the case of output is constant due to compile-time optimization.
-  if (value->is_const) {
-    memcpy(data_ptr, value->mem.get_data_handle(),
-           value->mem.get_desc().get_size());
-  } else {
-    value->mem.set_data_handle(data_ptr);
-  }
+  context->bindings.values[value] = data_ptr;
   return ODLA_SUCCESS;
 }
 
 odla_status odla_BindToOutputById(const odla_value_id value_id,
                                   odla_void* data_ptr, odla_context context) {
-  std::string name((const char*)value_id);
-  auto val = context->comp->outputs[name];
-  return odla_BindToOutput(val, data_ptr, context);
+  context->bindings.outputs[(const char*)value_id] = data_ptr;
+  return ODLA_SUCCESS;
 }
 
 static odla_value binary_eltwise(dnnl::algorithm algo, odla_value lhs,
@@ -464,6 +1388,7 @@ static odla_value_shape getGOIHWDims(const odla_value_shape& src_dims,
 odla_value odla_Transpose(odla_value input, odla_value_shape permutations,
                           odla_value_shape output_dims,
                           const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& input_dims = input->shape;
   auto strides = getStrides(input_dims);
   auto new_strides = strides;
@@ -484,23 +1409,84 @@ odla_value odla_Transpose(odla_value input, odla_value_shape permutations,
 
 odla_value odla_Reshape(odla_value input, odla_value_shape output_dims,
                         const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   return CreateValue(input->mem, output_dims, id);
 }
 
-odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
-                     odla_uint32 group, odla_value kernel,
-                     odla_memory_layout kernel_layout,
-                     const odla_uint32* strides, const odla_uint32* dilations,
-                     const odla_uint32* paddings_front,
-                     const odla_uint32* paddings_back, odla_value bias,
-                     odla_value_shape output_dims, const odla_value_id id) {
+// Returns the attribute that applies `activation` to the result of a primitive
+// as a post-op.
+static dnnl::primitive_attr getActivationAttr(odla_activation activation,
+                                              odla_float32 alpha) {
+  dnnl::post_ops ops;
+  switch (activation) {
+    case ODLA_ACTIVATION_RELU:
+      ops.append_eltwise(1.0F, dnnl::algorithm::eltwise_relu, 0.0F, 0.0F);
+      break;
+    case ODLA_ACTIVATION_RELU6:
+      ops.append_eltwise(1.0F, dnnl::algorithm::eltwise_clip, 0.0F, 6.0F);
+      break;
+    case ODLA_ACTIVATION_LEAKY_RELU:
+      ops.append_eltwise(1.0F, dnnl::algorithm::eltwise_relu, alpha, 0.0F);
+      break;
+    default:
+      break;
+  }
+  dnnl::primitive_attr attr;
+  attr.set_post_ops(ops);
+  return attr;
+}
+
+// Applies `activation` by a separate primitive.
+static odla_value applyActivation(odla_value input, odla_activation activation,
+                                  odla_float32 alpha, const odla_value_id id) {
+  switch (activation) {
+    case ODLA_ACTIVATION_RELU:
+      return odla_Relu(input, id);
+    case ODLA_ACTIVATION_RELU6:
+      return odla_Clamp(input, 0, 6, id);
+    case ODLA_ACTIVATION_LEAKY_RELU:
+      return odla_LeakyRelu(input, alpha, id);
+    default:
+      return input;
+  }
+}
+
+// Adds a bias that could not be fused and applies `activation`. The result
+// keeps `id`, so the intermediate sum gets an id derived from it.
+static odla_value addBiasAndActivate(odla_value input, odla_value bias,
+                                     odla_activation activation,
+                                     odla_float32 alpha,
+                                     const odla_value_id id) {
+  if (activation != ODLA_ACTIVATION_RELU &&
+      activation != ODLA_ACTIVATION_RELU6 &&
+      activation != ODLA_ACTIVATION_LEAKY_RELU) {
+    return odla_Add(input, bias, id);
+  }
+  std::string sum_name =
+      (id == nullptr ? "" : std::string((const char*)id)) + "_bias";
+  odla_value sum = odla_Add(input, bias, (const odla_value_id)sum_name.c_str());
+  return applyActivation(sum, activation, alpha, id);
+}
+
+static odla_value conv(odla_value input, odla_memory_layout input_layout,
+                       odla_uint32 group, odla_value kernel,
+                       odla_memory_layout kernel_layout,
+                       const odla_uint32* strides, const odla_uint32* dilations,
+                       const odla_uint32* paddings_front,
+                       const odla_uint32* paddings_back, odla_value bias,
+                       odla_activation activation, odla_float32 alpha,
+                       odla_value_shape output_dims, const odla_value_id id) {
   auto input_dims = input->shape;
   auto kernel_dims = kernel->shape;
   auto dt = input->mem.get_desc().data_type();
   dnnl::memory::dims stride_dims{strides[0], strides[1]};
   dnnl::memory::dims paddings_before{paddings_front[0], paddings_front[1]};
   dnnl::memory::dims paddings_after{paddings_back[0], paddings_back[1]};
-  auto dt_dst = g_comp->opts.enable_bf16 ? getDataType(ODLA_BFLOAT16) : dt;
+  // INT8 convolutions accumulate into INT32 with an INT32 bias.
+  bool is_int8 = dt == dnnl::memory::data_type::s8;
+  bool use_bf16 = g_comp->opts.enable_bf16 && !is_int8;
+  auto dt_dst = use_bf16 ? getDataType(ODLA_BFLOAT16) : dt;
+  auto dt_ret = is_int8 ? dnnl::memory::data_type::s32 : dt;
 
   odla_value_shape orig_output_dims = output_dims;
   if (input_layout == ODLA_CHANNELS_LAST) {
@@ -520,15 +1506,16 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
   }
 
   dnnl::memory::desc ret_md;
-  if (g_comp->opts.enable_bf16) {
+  if (use_bf16) {
     ret_md = dnnl::memory::desc(getDims(output_dims), dt_dst,
                                 dnnl::memory::format_tag::any);
   } else {
-    ret_md = dnnl::memory::desc(getDims(output_dims), dt,
+    ret_md = dnnl::memory::desc(getDims(output_dims), dt_ret,
                                 getFormatTag(input_layout));
   }
-  auto ret_md_any = dnnl::memory::desc(getDims(output_dims), dt_dst,
-                                       dnnl::memory::format_tag::any);
+  auto ret_md_any =
+      dnnl::memory::desc(getDims(output_dims), is_int8 ? dt_ret : dt_dst,
+                         dnnl::memory::format_tag::any);
   auto input_md_any = dnnl::memory::desc(getDims(input_dims), dt_dst,
                                          dnnl::memory::format_tag::any);
   auto input_md_src =
@@ -540,11 +1527,27 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
                                           getFormatTag(kernel_layout, group));
 
   assert(dilations[0] == 1 && dilations[1] == 1);
-  auto conv_desc = dnnl::convolution_forward::desc(
-      dnnl::prop_kind::forward, dnnl::algorithm::convolution_direct,
-      input_md_any, kernel_md_any, ret_md_any, stride_dims, paddings_before,
-      paddings_after);
-  auto pd = dnnl::convolution_forward::primitive_desc(conv_desc, g_comp->eng);
+  // A per-channel bias and the activation are computed by the convolution
+  // primitive. Otherwise they are separate primitives.
+  long oc = output_dims.dims[1];
+  bool fuse = bias == nullptr || GetTotalElements(bias->shape) == oc;
+  bool fuse_bias = fuse && bias != nullptr;
+  auto bias_md =
+      dnnl::memory::desc({oc}, dt_ret, dnnl::memory::format_tag::a);
+  auto conv_desc =
+      fuse_bias
+          ? dnnl::convolution_forward::desc(
+                dnnl::prop_kind::forward, dnnl::algorithm::convolution_direct,
+                input_md_any, kernel_md_any, bias_md, ret_md_any, stride_dims,
+                paddings_before, paddings_after)
+          : dnnl::convolution_forward::desc(
+                dnnl::prop_kind::forward, dnnl::algorithm::convolution_direct,
+                input_md_any, kernel_md_any, ret_md_any, stride_dims,
+                paddings_before, paddings_after);
+  auto pd = dnnl::convolution_forward::primitive_desc(
+      conv_desc,
+      getActivationAttr(fuse ? activation : ODLA_ACTIVATION_NONE, alpha),
+      g_comp->eng);
 
   auto ret_mem = dnnl::memory(pd.dst_desc(), g_comp->eng);
 
@@ -580,11 +1583,15 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
   g_comp->args.push_back({{DNNL_ARG_SRC, input->mem},
                           {DNNL_ARG_WEIGHTS, kernel->mem},
                           {DNNL_ARG_DST, ret_mem}});
+  if (fuse_bias) {
+    g_comp->args.back()[DNNL_ARG_BIAS] =
+        dnnl::memory(bias_md, g_comp->eng, bias->mem.get_data_handle());
+  }
   if (needs_reorder_input) {
     input->mem = orig_mem;
   }
-  auto ret_md_exp =
-      dnnl::memory::desc(getDims(output_dims), dt, getFormatTag(input_layout));
+  auto ret_md_exp = dnnl::memory::desc(getDims(output_dims), dt_ret,
+                                       getFormatTag(input_layout));
   if (pd.dst_desc() != ret_md_exp) {
     auto reordered_mem = dnnl::memory(ret_md_exp, g_comp->eng);
     auto r = dnnl::reorder(ret_mem, reordered_mem);
@@ -595,7 +1602,40 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
   }
   InterpretIfNeeded();
 
-  return bias ? odla_Add(v, bias, id) : v;
+  if (fuse) {
+    return v;
+  }
+  return addBiasAndActivate(v, bias, activation, alpha, id);
+}
+
+odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
+                     odla_uint32 group, odla_value kernel,
+                     odla_memory_layout kernel_layout,
+                     const odla_uint32* strides, const odla_uint32* dilations,
+                     const odla_uint32* paddings_front,
+                     const odla_uint32* paddings_back, odla_value bias,
+                     odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
+  return conv(input, input_layout, group, kernel, kernel_layout, strides,
+              dilations, paddings_front, paddings_back, bias,
+              ODLA_ACTIVATION_NONE, 0, output_dims, id);
+}
+
+odla_value odla_FusedConv(odla_value input, odla_memory_layout input_layout,
+                          odla_uint32 group, odla_value kernel,
+                          odla_memory_layout kernel_layout,
+                          const odla_uint32* strides,
+                          const odla_uint32* dilations,
+                          const odla_uint32* paddings_front,
+                          const odla_uint32* paddings_back, odla_value bias,
+                          odla_activation activation,
+                          odla_float32 activation_alpha,
+                          odla_value_shape output_dims,
+                          const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
+  return conv(input, input_layout, group, kernel, kernel_layout, strides,
+              dilations, paddings_front, paddings_back, bias, activation,
+              activation_alpha, output_dims, id);
 }
 
 odla_value odla_DeConv(odla_value input, odla_memory_layout input_layout,
@@ -605,6 +1645,7 @@ odla_value odla_DeConv(odla_value input, odla_memory_layout input_layout,
                        const odla_uint32* paddings_front,
                        const odla_uint32* paddings_back, odla_value bias,
                        odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   auto input_dims = input->shape;
   auto kernel_dims = kernel->shape;
 
@@ -711,6 +1752,7 @@ odla_value odla_DeConv(odla_value input, odla_memory_layout input_layout,
 
 odla_value odla_Concat(odla_values inputs, odla_int32 axis,
                        odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   auto num = inputs.size;
   auto type = inputs.values[0]->mem.get_desc().data_type();
   auto ret_md = getMemoryDesc(output_dims, type);
@@ -786,6 +1828,7 @@ odla_value odla_MaxPool(odla_value input, odla_memory_layout input_layout,
                         const odla_uint32* paddings_back,
                         odla_value_shape output_dims,
                         const odla_value_id value_id) {
+  output_dims = ResolveBatch(output_dims);
   return BasePool(input, input_layout, window_dims, strides, paddings_front,
                   paddings_back, output_dims, value_id,
                   dnnl::algorithm::pooling_max);
@@ -798,6 +1841,7 @@ odla_value odla_AveragePool(odla_value input, odla_memory_layout input_layout,
                             const odla_uint32* paddings_back,
                             odla_value_shape output_dims,
                             const odla_value_id value_id) {
+  output_dims = ResolveBatch(output_dims);
   return BasePool(input, input_layout, window_dims, strides, paddings_front,
                   paddings_back, output_dims, value_id,
                   dnnl::algorithm::pooling_avg);
@@ -914,6 +1958,7 @@ odla_value odla_ReduceMean(odla_value input, odla_size_t num_of_axes,
                            const odla_uint32* axes, odla_bool keep_dims,
                            odla_value_shape output_dims,
                            const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& dims = input->shape;
   assert(num_of_axes == 2 &&
          dims.size == 4); // TODO: handle more generic cases.
@@ -962,10 +2007,12 @@ odla_value odla_ReduceMean(odla_value input, odla_size_t num_of_axes,
   return CreateValue(ret_mem, orig_output_dims, id);
 }
 
-odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
-                     odla_bool transpose_rhs, odla_float32 alpha,
-                     odla_float32 beta, odla_value bias,
-                     odla_value_shape output_dims, const odla_value_id id) {
+static odla_value gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
+                       odla_bool transpose_rhs, odla_float32 alpha,
+                       odla_float32 beta, odla_value bias,
+                       odla_activation activation,
+                       odla_float32 activation_alpha,
+                       odla_value_shape output_dims, const odla_value_id id) {
   const auto& lhs_dims = lhs->shape;
   const auto& rhs_dims = rhs->shape;
   auto dt = lhs->mem.get_desc().data_type();
@@ -983,27 +2030,72 @@ odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
       {K, N}, dt,
       transpose_rhs ? dnnl::memory::dims{1, ldb} : dnnl::memory::dims{ldb, 1});
 
-  dnnl::memory::desc ret_md({M, N}, dt, {ldc, 1});
+  // INT8 matrix multiplications accumulate into INT32 with an INT32 bias.
+  auto dt_ret = dt == dnnl::memory::data_type::s8
+                    ? dnnl::memory::data_type::s32
+                    : dt;
+  dnnl::memory::desc ret_md({M, N}, dt_ret, {ldc, 1});
   auto ret_mem = dnnl::memory(ret_md, g_comp->eng);
   auto lhs_mem = dnnl::memory(lhs_md, g_comp->eng, lhs->mem.get_data_handle());
   auto rhs_mem = dnnl::memory(rhs_md, g_comp->eng, rhs->mem.get_data_handle());
 
-  dnnl::matmul::desc md(lhs_md, rhs_md, ret_md);
-  dnnl::matmul::primitive_desc pd(md, g_comp->eng);
+  // A bias of N or M x N elements and the activation are computed by the
+  // matmul primitive. Otherwise they are separate primitives.
+  long bias_elems = bias == nullptr ? 0 : GetTotalElements(bias->shape);
+  bool fuse = bias == nullptr || bias_elems == N || bias_elems == M * N;
+  bool fuse_bias = fuse && bias != nullptr;
+  dnnl::memory::desc bias_md({bias_elems == N ? 1 : M, N}, dt_ret, {N, 1});
+  dnnl::matmul::desc md =
+      fuse_bias ? dnnl::matmul::desc(lhs_md, rhs_md, bias_md, ret_md)
+                : dnnl::matmul::desc(lhs_md, rhs_md, ret_md);
+  dnnl::matmul::primitive_desc pd(
+      md,
+      getActivationAttr(fuse ? activation : ODLA_ACTIVATION_NONE,
+                        activation_alpha),
+      g_comp->eng);
   dnnl::primitive prim = dnnl::matmul(pd);
 
   g_comp->primitives.push_back(prim);
   g_comp->args.push_back({{DNNL_ARG_SRC, lhs->mem},
                           {DNNL_ARG_WEIGHTS, rhs->mem},
                           {DNNL_ARG_DST, ret_mem}});
+  if (fuse_bias) {
+    g_comp->args.back()[DNNL_ARG_BIAS] =
+        dnnl::memory(bias_md, g_comp->eng, bias->mem.get_data_handle());
+  }
 
-  odla_value v = CreateValue(ret_mem, output_dims, bias ? nullptr : id);
-  return bias ? odla_Add(v, bias, id) : v;
+  odla_value v = CreateValue(ret_mem, output_dims, fuse ? id : nullptr);
+  if (fuse) {
+    return v;
+  }
+  return addBiasAndActivate(v, bias, activation, activation_alpha, id);
+}
+
+odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
+                     odla_bool transpose_rhs, odla_float32 alpha,
+                     odla_float32 beta, odla_value bias,
+                     odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
+  return gemm(lhs, transpose_lhs, rhs, transpose_rhs, alpha, beta, bias,
+              ODLA_ACTIVATION_NONE, 0, output_dims, id);
+}
+
+odla_value odla_FusedGemm(odla_value lhs, odla_bool transpose_lhs,
+                          odla_value rhs, odla_bool transpose_rhs,
+                          odla_float32 alpha, odla_float32 beta,
+                          odla_value bias, odla_activation activation,
+                          odla_float32 activation_alpha,
+                          odla_value_shape output_dims,
+                          const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
+  return gemm(lhs, transpose_lhs, rhs, transpose_rhs, alpha, beta, bias,
+              activation, activation_alpha, output_dims, id);
 }
 
 odla_value odla_Slice(odla_value input, const odla_uint32* start,
                       const odla_uint32* strides, odla_value_shape output_dims,
                       const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& input_dims = input->shape;
   int dims = input_dims.size;
   auto offsets = dnnl::memory::dims(start, start + dims);
@@ -1027,4 +2119,47 @@ odla_value odla_Slice(odla_value input, const odla_uint32* start,
   return CreateValue(dst_mem, output_dims, id);
 }
 
+// Converts `input` into `dt` by a reorder that multiplies it by the scales
+// along the dimensions of `mask` and adds the zero point.
+static odla_value scaledReorder(odla_value input, dnnl::memory::data_type dt,
+                                int mask, const std::vector<float>& scales,
+                                int32_t zero_point, const odla_value_id id) {
+  const auto& dims = input->shape;
+  auto src_md = getMemoryDesc(dims, input->mem.get_desc().data_type());
+  auto dst_mem = dnnl::memory(getMemoryDesc(dims, dt), g_comp->eng);
+  dnnl::primitive_attr attr;
+  attr.set_output_scales(mask, scales);
+  if (zero_point != 0) {
+    attr.set_zero_points(DNNL_ARG_DST, 0, {zero_point});
+  }
+  auto src_mem = dnnl::memory(src_md, g_comp->eng, nullptr);
+  auto prim = dnnl::reorder(src_mem, dst_mem, attr);
+  g_comp->primitives.push_back(prim);
+  g_comp->args.push_back({{DNNL_ARG_FROM, input->mem}, {DNNL_ARG_TO, dst_mem}});
+  InterpretIfNeeded();
+  return CreateValue(dst_mem, dims, id);
+}
+
+odla_value odla_Cast(odla_value input, odla_element_type target_type,
+                     const odla_value_id id) {
+  return scaledReorder(input, getDataType(target_type), 0, {1.0F}, 0, id);
+}
+
+odla_value odla_Quantize(odla_value input, odla_float32 scale,
+                         odla_int32 zero_point, odla_element_type element_type,
+                         const odla_value_id id) {
+  assert(element_type == ODLA_INT8 || element_type == ODLA_UINT8);
+  return scaledReorder(input, getDataType(element_type), 0, {1.0F / scale},
+                       zero_point, id);
+}
+
+odla_value odla_Dequantize(odla_value input, odla_size_t num_of_scales,
+                           const odla_float32* scales, odla_int32 axis,
+                           const odla_value_id id) {
+  int mask = num_of_scales == 1 ? 0 : 1 << axis;
+  return scaledReorder(input, dnnl::memory::data_type::f32, mask,
+                       std::vector<float>(scales, scales + num_of_scales), 0,
+                       id);
+}
+
 } // C extern
@@ -19,10 +19,20 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <numeric>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #if __cplusplus < 201103L
@@ -38,33 +48,90 @@
 #define EIGEN_NO_DEBUG
 #endif
 //#define EIGEN_USE_MKL_ALL
+#define EIGEN_USE_THREADS
 #include <ODLA/odla.h>
 
 #include "Eigen/Core"
 #include "Eigen/Dense"
+#include "odla_async_queue.h"
 #include "unsupported/Eigen/CXX11/Tensor"
 
 #if !defined(ODLA_VERSION_NUMBER) || (ODLA_VERSION_NUMBER < 50)
 #error This library requires minimum ODLA version 0.5
 #endif
 
+// Ops are recorded into the active computation when it is built and run by
+// odla_ExecuteComputation() for each context. Without an active computation
+// (the interpreter mode), ops are executed eagerly as they are created.
+
 struct _odla_value {
-  _odla_value(const odla_value_type& type, void* p)
-      : type(type), ptr(p), needs_free(false) {}
-  _odla_value(const odla_value_type& type, size_t t)
-      : type(type), ptr(new char[t]), needs_free(true) {}
-
-  ~_odla_value() {
-    if (needs_free) {
-      delete[](char*) ptr;
-    }
-  }
+  _odla_value(const odla_value_type& type, void* p, const std::string& name)
+      : type(type), ptr(p), name(name) {}
+
   odla_value_type type;
+  // The data of constants. When executing eagerly, the data of all values.
   void* ptr;
-  bool needs_free;
+  std::unique_ptr<char[]> buffer;
+  std::string name;
+  // The index of the value in its computation.
+  size_t index = 0;
+  // True if the value is produced by an op.
+  bool is_result = false;
+  // The value whose data is shared, e.g. the input of a reshape.
+  odla_value alias = nullptr;
+};
+
+struct Op {
+  std::vector<odla_value> inputs;
+  odla_value output;
+  std::function<void(odla_context)> run;
+};
+
+struct _odla_computation {
+  std::vector<std::unique_ptr<_odla_value>> vals;
+  std::vector<Op> ops;
+  std::unordered_map<std::string, odla_value> inputs;
+  std::unordered_map<std::string, odla_value> outputs;
+  // A dynamic batch computation is built for its maximum batch size, and
+  // smaller batches are padded to it.
+  bool is_dynamic_batch = false;
+  int max_batch_size = 0;
+  // Unique for the lifetime of the process, unlike the address, which may be
+  // reused by a computation created after this one is destroyed.
+  uint64_t generation = 0;
+};
+
+// A computation is immutable once built and can be executed by many contexts
+// concurrently. Each context owns the buffers of the intermediate results and
+// the thread pool that evaluates the tensor expressions.
+struct _odla_context {
+  // The computation that the buffers were planned for.
+  odla_computation comp = nullptr;
+  uint64_t comp_generation = 0;
+  int num_threads = std::max(1U, std::thread::hardware_concurrency());
+  std::unique_ptr<Eigen::ThreadPool> pool;
+  std::unique_ptr<Eigen::ThreadPoolDevice> device;
+  // The data of each value of the computation, as planned and as bound.
+  std::vector<void*> planned_data;
+  std::vector<void*> data;
+  // Intermediate results whose lifetimes do not overlap share a buffer.
+  // The buffers are reused across executions.
+  std::vector<std::unique_ptr<char[]>> buffers;
+  Bindings bindings;
+  // The maximum number of asynchronous executions in flight.
+  size_t async_depth = 2;
+  odla_async_callback async_callback = nullptr;
+  odla_void* async_user_data = nullptr;
+  std::unique_ptr<AsyncQueue> async;
+  PaddedBatch padded_batch;
 };
 
-std::vector<std::unique_ptr<_odla_value>> Vals;
+// The computation being built by the current thread.
+thread_local odla_computation g_comp;
+static std::vector<std::unique_ptr<_odla_computation>> g_comps;
+static std::mutex g_comps_mutex;
+// The generation of the last computation created. Guarded by g_comps_mutex.
+static uint64_t g_comp_generation = 0;
 
 static int64_t GetTotalElements(const odla_value_shape& dims) {
   return std::accumulate(dims.dims, dims.dims + dims.size, 1,
@@ -80,6 +147,7 @@ static unsigned GetElementSize(odla_element_type type) {
     case ODLA_INT32:
       return sizeof(int32_t);
     case ODLA_INT8:
+    case ODLA_UINT8:
       return 1;
     default:
       return 0;
@@ -95,16 +163,68 @@ static size_t GetValueSize(odla_value_type type) {
   return GetElementSize(type.element_type) * GetTotalElements(type.shape);
 }
 
-static odla_value GetValue(const odla_value_type& type, void* ptr) {
-  auto v = std::make_unique<_odla_value>(type, ptr);
-  Vals.push_back(std::move(v));
-  return Vals.back().get();
+// Replaces the dynamic batch dimension of the computation being built with its
+// maximum batch size.
+static odla_value_shape ResolveBatch(odla_value_shape shape) {
+  if (g_comp != nullptr && g_comp->is_dynamic_batch && shape.size > 0 &&
+      shape.dims[0] < 0) {
+    shape.dims[0] = g_comp->max_batch_size;
+  }
+  return shape;
+}
+
+// Values created in the interpreter mode are owned by this computation until
+// they are released by odla_ReleaseValue().
+static odla_computation GetEagerComputation() {
+  thread_local _odla_computation comp;
+  return &comp;
+}
+
+static odla_value CreateValue(const odla_value_type& type,
+                              const odla_value_id id, void* ptr) {
+  odla_computation comp = g_comp != nullptr ? g_comp : GetEagerComputation();
+  std::string name = id == nullptr ? "" : std::string((const char*)id);
+  auto v = std::make_unique<_odla_value>(
+      odla_value_type{type.element_type, ResolveBatch(type.shape)}, ptr, name);
+  v->index = comp->vals.size();
+  comp->vals.push_back(std::move(v));
+  return comp->vals.back().get();
 }
 
-static odla_value GetValue(const odla_value_type& type) {
-  auto v = std::make_unique<_odla_value>(type, GetValueSize(type));
-  Vals.push_back(std::move(v));
-  return Vals.back().get();
+// Creates the result of an op. The buffer is allocated right away only when
+// executing eagerly.
+static odla_value CreateResult(const odla_value_type& type,
+                               const odla_value_id id) {
+  odla_value v = CreateValue(type, id, nullptr);
+  v->is_result = true;
+  if (g_comp == nullptr) {
+    v->buffer.reset(new char[GetValueSize(type)]);
+    v->ptr = v->buffer.get();
+  }
+  return v;
+}
+
+static void AddOp(std::vector<odla_value> inputs, odla_value output,
+                  std::function<void(odla_context)> run) {
+  if (g_comp == nullptr) {
+    run(nullptr);
+    return;
+  }
+  g_comp->ops.push_back({std::move(inputs), output, std::move(run)});
+}
+
+static void* Data(odla_context ctx, odla_value v) {
+  return ctx == nullptr ? v->ptr : ctx->data[v->index];
+}
+
+static const Eigen::ThreadPoolDevice& GetDevice(odla_context ctx) {
+  if (ctx != nullptr) {
+    return *ctx->device;
+  }
+  static Eigen::ThreadPool pool(
+      std::max(1U, std::thread::hardware_concurrency()));
+  static Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  return device;
 }
 
 template <typename T, int RANK>
@@ -148,23 +268,587 @@ struct EigenTensorHelper<T, 1> {
   }
 };
 
+// The ranges of the values seen by the executions, which calibrate the INT8
+// post-training quantization of HALO. They are recorded when the environment
+// variable ODLA_CALIBRATION_FILE is set and written to that file at exit. The
+// ranges of an existing file are extended, so calibration can take several
+// runs. Each line of the file is "<value id> <min> <max>".
+struct Calibration {
+  std::string file;
+  std::mutex mutex;
+  std::map<std::string, std::pair<float, float>> ranges;
+
+  ~Calibration() {
+    std::ofstream ofs(file);
+    ofs.precision(std::numeric_limits<float>::max_digits10);
+    for (const auto& range : ranges) {
+      ofs << range.first << " " << range.second.first << " "
+          << range.second.second << "\n";
+    }
+  }
+
+  void Record(odla_value v, const void* data) {
+    if (v->type.element_type != ODLA_FLOAT32 || v->name.empty()) {
+      return;
+    }
+    const float* begin = static_cast<const float*>(data);
+    const float* end = begin + GetTotalElements(v->type.shape);
+    if (begin == end) {
+      return;
+    }
+    auto min_max = std::minmax_element(begin, end);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ranges.emplace(v->name, std::make_pair(*min_max.first,
+                                                     *min_max.second));
+    if (!it.second) {
+      auto& range = it.first->second;
+      range.first = std::min(range.first, *min_max.first);
+      range.second = std::max(range.second, *min_max.second);
+    }
+  }
+};
+
+// Returns the calibration, or nullptr if it is disabled.
+static Calibration* GetCalibration() {
+  static std::unique_ptr<Calibration> calibration = [] {
+    const char* file = std::getenv("ODLA_CALIBRATION_FILE");
+    if (file == nullptr || *file == '\0') {
+      return std::unique_ptr<Calibration>();
+    }
+    auto c = std::make_unique<Calibration>();
+    c->file = file;
+    std::ifstream ifs(file);
+    std::string name;
+    float lo;
+    float hi;
+    while (ifs >> name >> lo >> hi) {
+      c->ranges[name] = {lo, hi};
+    }
+    return c;
+  }();
+  return calibration.get();
+}
+
+// Assigns the buffers of the intermediate results of `comp` for `ctx`. A
+// buffer is released after the last use of its value and reused by the
+// results created later.
+static void initContext(odla_context ctx, odla_computation comp) {
+  ctx->comp = comp;
+  ctx->comp_generation = comp->generation;
+  if (ctx->device == nullptr) {
+    ctx->pool = std::make_unique<Eigen::ThreadPool>(ctx->num_threads);
+    ctx->device = std::make_unique<Eigen::ThreadPoolDevice>(ctx->pool.get(),
+                                                            ctx->num_threads);
+  }
+  size_t num_vals = comp->vals.size();
+  ctx->planned_data.assign(num_vals, nullptr);
+  ctx->buffers.clear();
+
+  auto root = [](odla_value v) {
+    while (v->alias != nullptr) {
+      v = v->alias;
+    }
+    return v;
+  };
+  constexpr size_t live_out = std::numeric_limits<size_t>::max();
+  std::vector<size_t> last_use(num_vals, 0);
+  for (size_t i = 0, e = comp->ops.size(); i < e; ++i) {
+    for (odla_value v : comp->ops[i].inputs) {
+      last_use[root(v)->index] = i;
+    }
+    size_t& out_use = last_use[root(comp->ops[i].output)->index];
+    out_use = std::max(out_use, i);
+  }
+  for (const auto& output : comp->outputs) {
+    last_use[root(output.second)->index] = live_out;
+  }
+
+  for (const auto& v : comp->vals) {
+    ctx->planned_data[v->index] = v->ptr;
+  }
+  std::multimap<size_t, char*> free_buffers;
+  std::vector<size_t> capacities(num_vals, 0);
+  std::vector<std::vector<odla_value>> released(comp->ops.size());
+  for (size_t i = 0, e = comp->ops.size(); i < e; ++i) {
+    odla_value v = comp->ops[i].output;
+    if (v->is_result && v->alias == nullptr &&
+        ctx->planned_data[v->index] == nullptr) {
+      size_t size = GetValueSize(v->type);
+      auto it = free_buffers.lower_bound(size);
+      if (it != free_buffers.end()) {
+        capacities[v->index] = it->first;
+        ctx->planned_data[v->index] = it->second;
+        free_buffers.erase(it);
+      } else {
+        ctx->buffers.emplace_back(new char[size]);
+        capacities[v->index] = size;
+        ctx->planned_data[v->index] = ctx->buffers.back().get();
+      }
+      if (last_use[v->index] != live_out) {
+        released[last_use[v->index]].push_back(v);
+      }
+    }
+    for (odla_value dead : released[i]) {
+      free_buffers.emplace(capacities[dead->index],
+                           static_cast<char*>(ctx->planned_data[dead->index]));
+    }
+  }
+}
+
+static odla_status execute(odla_computation comp, odla_context ctx,
+                           const Bindings& run_bindings) {
+  if (ctx->comp != comp || ctx->comp_generation != comp->generation) {
+    initContext(ctx, comp);
+  }
+  const Bindings* padded = ctx->padded_batch.Pad(
+      run_bindings, comp->is_dynamic_batch ? comp->max_batch_size : 0,
+      comp->inputs, comp->outputs,
+      [](odla_value v) { return GetValueSize(v->type); });
+  if (padded == nullptr) {
+    return ODLA_FAILURE;
+  }
+  const Bindings& bindings = *padded;
+  ctx->data = ctx->planned_data;
+  // Outputs that share data with other values are copied after execution.
+  std::vector<std::pair<odla_value, void*>> copies;
+  auto bind = [ctx, &copies](odla_value v, void* ptr) {
+    bool is_arg = !v->is_result && v->alias == nullptr && v->ptr == nullptr;
+    if (is_arg || (v->is_result && v->alias == nullptr)) {
+      ctx->data[v->index] = ptr;
+    } else {
+      copies.emplace_back(v, ptr);
+    }
+  };
+  for (const auto& binding : bindings.values) {
+    bind(binding.first, binding.second);
+  }
+  for (const auto& binding : bindings.inputs) {
+    auto it = comp->inputs.find(binding.first);
+    if (it == comp->inputs.end()) {
+      return ODLA_FAILURE;
+    }
+    bind(it->second, binding.second);
+  }
+  for (const auto& binding : bindings.outputs) {
+    auto it = comp->outputs.find(binding.first);
+    if (it == comp->outputs.end()) {
+      return ODLA_FAILURE;
+    }
+    bind(it->second, binding.second);
+  }
+  // Aliases are created after the values they alias.
+  for (const auto& v : comp->vals) {
+    if (v->alias != nullptr) {
+      ctx->data[v->index] = ctx->data[v->alias->index];
+    }
+  }
+  Calibration* calibration = GetCalibration();
+  for (const auto& op : comp->ops) {
+    if (calibration != nullptr) {
+      // The data of the inputs is valid until the op runs. Activations are
+      // applied in-place, so the op's own output is seen by its consumers.
+      for (odla_value input : op.inputs) {
+        if (input != op.output && (input->is_result || input->ptr == nullptr)) {
+          calibration->Record(input, ctx->data[input->index]);
+        }
+      }
+    }
+    op.run(ctx);
+  }
+  if (calibration != nullptr) {
+    for (const auto& output : comp->outputs) {
+      calibration->Record(output.second, ctx->data[output.second->index]);
+    }
+  }
+  for (const auto& copy : copies) {
+    memcpy(copy.second, ctx->data[copy.first->index],
+           GetValueSize(copy.first->type));
+  }
+  ctx->padded_batch.CopyOutputs();
+  return ODLA_SUCCESS;
+}
+
+// The shapes of a convolution.
+struct ConvShape {
+  odla_memory_layout input_layout;
+  odla_value_shape input_dims;
+  odla_value_shape kernel_dims;
+  odla_value_shape output_dims;
+  int k_h;
+  int k_w;
+  int stride_h;
+  int stride_w;
+  int pad_t;
+  int pad_b;
+  int pad_l;
+  int pad_r;
+  int in_ch;
+  int out_ch;
+  int batch;
+  int out_h;
+  int out_w;
+};
+
+// Computes a convolution of T elements that accumulates into AccT elements,
+// with an optional per-channel bias of AccT elements.
+template <typename T, typename AccT>
+static void Convolution(const ConvShape& s,
+                        const Eigen::ThreadPoolDevice& device, void* input,
+                        void* kernel, void* bias, void* output) {
+  auto in = EigenTensorHelper<T, 4>::GetEigenTensorMap(input, s.input_dims)
+                .template cast<AccT>();
+  auto kn = EigenTensorHelper<T, 4>::GetEigenTensorMap(kernel, s.kernel_dims)
+                .template cast<AccT>();
+  auto ret =
+      EigenTensorHelper<AccT, 4>::GetEigenTensorMap(output, s.output_dims);
+  int in_ch = s.in_ch;
+  int out_ch = s.out_ch;
+  int batch = s.batch;
+  int out_h = s.out_h;
+  int out_w = s.out_w;
+  int k_h = s.k_h;
+  int k_w = s.k_w;
+  if (s.input_layout == ODLA_CHANNELS_FIRST && k_h == 1 && k_w == 1 &&
+      s.stride_h == 1 && s.stride_w == 1) {
+    Eigen::array<int, 2> perm{1, 0};
+    auto out =
+        in.reshape(Eigen::array<int, 2>{in_ch, out_h * out_w})
+            .contract(kn.reshape(Eigen::array<int, 2>({out_ch, in_ch})),
+                      Eigen::array<Eigen::IndexPair<int>, 1>{
+                          Eigen::IndexPair<int>(0, 1)})
+            .shuffle(perm)
+            .reshape(Eigen::array<int, 4>{batch, out_ch, out_h, out_w});
+    ret.device(device) = out;
+  } else if (s.input_layout == ODLA_CHANNELS_LAST) { // NHWC
+    auto out =
+        in.extract_image_patches(k_w, k_h, s.stride_h, s.stride_w, 1, 1, 1, 1,
+                                 s.pad_l, s.pad_r, s.pad_t, s.pad_b, 0)
+            .reshape(Eigen::array<int, 2>{out_h * out_w * batch,
+                                          in_ch * k_w * k_h})
+            .contract(
+                kn.reshape(Eigen::array<int, 2>({in_ch * k_w * k_h, out_ch})),
+                Eigen::array<Eigen::IndexPair<int>, 1>{
+                    Eigen::IndexPair<int>(1, 0)})
+            .reshape(Eigen::array<int, 4>{batch, out_h, out_w, out_ch});
+
+    ret.device(device) = out;
+  } else {
+    Eigen::array<int, 4> kernel_shuffles{2, 3, 1, 0};
+    Eigen::array<int, 4> input_shuffles{0, 2, 3, 1};
+    Eigen::array<int, 4> output_shuffles{0, 3, 1, 2};
+    auto out =
+        in.shuffle(input_shuffles)
+            .extract_image_patches(k_w, k_h, s.stride_h, s.stride_w, 1, 1, 1,
+                                   1, s.pad_l, s.pad_r, s.pad_t, s.pad_b, 0)
+            .reshape(Eigen::array<int, 2>{out_h * out_w * batch,
+                                          in_ch * k_w * k_h})
+            .contract(kn.shuffle(kernel_shuffles)
+                          .reshape(Eigen::array<int, 2>(
+                              {in_ch * k_w * k_h, out_ch})),
+                      Eigen::array<Eigen::IndexPair<int>, 1>{
+                          Eigen::IndexPair<int>(1, 0)})
+            .reshape(Eigen::array<int, 4>{batch, out_h, out_w, out_ch});
+    ret.device(device) = out.shuffle(output_shuffles);
+  }
+  if (bias == nullptr) {
+    return;
+  }
+  auto b = EigenTensorHelper<AccT, 1>::GetEigenTensorMap(bias, out_ch);
+  if (s.input_layout == ODLA_CHANNELS_LAST) {
+    ret.device(device) =
+        ret + b.reshape(Eigen::array<int, 4>{1, 1, 1, out_ch})
+                  .broadcast(Eigen::array<int, 4>{batch, out_h, out_w, 1});
+  } else {
+    ret.device(device) =
+        ret + b.reshape(Eigen::array<int, 4>{1, out_ch, 1, 1})
+                  .broadcast(Eigen::array<int, 4>{batch, 1, out_h, out_w});
+  }
+}
+
+// Multiplies matrices of T elements into AccT elements. The bias of AccT
+// elements is either a full matrix or a row broadcast to each row.
+template <typename T, typename AccT>
+static void MatMul(const Eigen::ThreadPoolDevice& device, void* lhs,
+                   const odla_value_shape& lhs_dims, void* rhs,
+                   const odla_value_shape& rhs_dims,
+                   const Eigen::array<Eigen::IndexPair<int>, 1>& dims,
+                   void* bias, int64_t bias_size, void* output,
+                   const odla_value_shape& output_dims) {
+  auto A = EigenTensorHelper<T, 2>::GetEigenTensorMap(lhs, lhs_dims)
+               .template cast<AccT>();
+  auto B = EigenTensorHelper<T, 2>::GetEigenTensorMap(rhs, rhs_dims)
+               .template cast<AccT>();
+  auto ret = EigenTensorHelper<AccT, 2>::GetEigenTensorMap(output, output_dims);
+  int rows = output_dims.dims[0];
+  int cols = output_dims.dims[1];
+  if (bias == nullptr) {
+    ret.device(device) = A.contract(B, dims);
+  } else if (bias_size == cols && rows != 1) {
+    auto C = EigenTensorHelper<AccT, 1>::GetEigenTensorMap(bias, bias_size);
+    ret.device(device) =
+        A.contract(B, dims) + C.reshape(Eigen::array<int, 2>{1, cols})
+                                  .broadcast(Eigen::array<int, 2>{rows, 1});
+  } else {
+    auto C = EigenTensorHelper<AccT, 2>::GetEigenTensorMap(bias, output_dims);
+    ret.device(device) = A.contract(B, dims) + C;
+  }
+}
+
+template <typename T>
+static void Activate(odla_context ctx, odla_value v, T lo, T hi, float slope) {
+  auto data = EigenTensorHelper<T, 1>::GetEigenTensorMap(Data(ctx, v),
+                                                         v->type.shape);
+  T zero = 0;
+  data.device(GetDevice(ctx)) =
+      (data.cwiseMax(zero) +
+       (data.cwiseMin(zero).template cast<float>() * slope).template cast<T>())
+          .cwiseMax(lo)
+          .cwiseMin(hi);
+}
+
+template <typename T>
+static void Quantize(const Eigen::ThreadPoolDevice& device, const void* input,
+                     void* output, int64_t n, float scale, int zero_point) {
+  auto in = EigenTensorHelper<float, 1>::GetEigenTensorMap(
+      const_cast<void*>(input), n);
+  auto ret = EigenTensorHelper<T, 1>::GetEigenTensorMap(output, n);
+  float lo = std::numeric_limits<T>::lowest();
+  float hi = std::numeric_limits<T>::max();
+  ret.device(device) = ((in / scale).round() + static_cast<float>(zero_point))
+                           .cwiseMax(lo)
+                           .cwiseMin(hi)
+                           .template cast<T>();
+}
+
+// Scales the elements of `input`, whose channels along an axis are
+// `inner` elements apart.
+template <typename T>
+static void Dequantize(const void* input, float* output, int64_t n,
+                       const std::vector<float>& scales, int64_t inner) {
+  const T* in = static_cast<const T*>(input);
+  int64_t channels = scales.size();
+  for (int64_t i = 0; i < n; ++i) {
+    output[i] = in[i] * scales[i / inner % channels];
+  }
+}
+
 extern "C" {
+odla_status odla_CreateComputation(odla_computation* computation) {
+  std::lock_guard<std::mutex> lock(g_comps_mutex);
+  g_comps.push_back(std::make_unique<_odla_computation>());
+  g_comps.back()->generation = ++g_comp_generation;
+  g_comp = g_comps.back().get();
+  if (computation != nullptr) {
+    *computation = g_comp;
+  }
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetActiveComputation(odla_computation computation) {
+  g_comp = computation;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_DestroyComputation(odla_computation computation) {
+  std::lock_guard<std::mutex> lock(g_comps_mutex);
+  auto it = std::find_if(g_comps.begin(), g_comps.end(),
+                         [computation](const auto& comp) {
+                           return comp.get() == computation;
+                         });
+  if (it == g_comps.end()) {
+    return ODLA_FAILURE;
+  }
+  if (g_comp == computation) {
+    g_comp = nullptr;
+  }
+  g_comps.erase(it);
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_CreateContext(odla_context* ctx) {
+  *ctx = new _odla_context();
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_WaitContext(odla_context context) {
+  return context->async == nullptr ? ODLA_SUCCESS : context->async->Wait();
+}
+
+odla_status odla_DestroyContext(odla_context ctx) {
+  // Pending requests are drained before the worker exits.
+  ctx->async.reset();
+  delete (ctx);
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetComputationItem(odla_computation computation,
+                                    odla_item_type type,
+                                    odla_item_value value) {
+  switch (type) {
+    case ODLA_DYNAMIC_BATCH:
+      if (!computation->vals.empty()) {
+        // The values created so far have the batch size unresolved.
+        return ODLA_FAILURE;
+      }
+      computation->is_dynamic_batch = *(reinterpret_cast<bool*>(value));
+      break;
+    case ODLA_MAX_BATCH_SIZE: {
+      int n = *(reinterpret_cast<int*>(value));
+      if (n <= 0 || !computation->vals.empty()) {
+        return ODLA_FAILURE;
+      }
+      computation->max_batch_size = n;
+      break;
+    }
+    case ODLA_MIN_BATCH_SIZE:
+    case ODLA_OPT_BATCH_SIZE:
+      // Every batch size runs the computation built for the maximum one.
+      break;
+    default:
+      std::cerr << "Unsupported property type: " << type << std::endl;
+      return ODLA_FAILURE;
+  }
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetContextItem(odla_context context, odla_item_type type,
+                                odla_item_value value) {
+  int n = *(reinterpret_cast<int*>(value));
+  switch (type) {
+    case ODLA_RUN_BATCH_SIZE:
+      if (n < 0) {
+        return ODLA_FAILURE;
+      }
+      context->bindings.batch_size = n;
+      break;
+    case ODLA_ASYNC_QUEUE_DEPTH:
+      if (n <= 0) {
+        return ODLA_FAILURE;
+      }
+      context->async_depth = n;
+      break;
+    case ODLA_NUM_THREADS:
+      if (n <= 0 || context->device != nullptr) {
+        return ODLA_FAILURE;
+      }
+      context->num_threads = n;
+      break;
+    default:
+      std::cerr << "Unsupported property type: " << type << std::endl;
+      return ODLA_FAILURE;
+  }
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_SetAsyncCallback(odla_context context,
+                                  odla_async_callback callback,
+                                  odla_void* user_data) {
+  odla_status status = odla_WaitContext(context);
+  context->async_callback = callback;
+  context->async_user_data = user_data;
+  return status;
+}
+
+odla_status odla_ExecuteComputation(odla_computation comp, odla_context context,
+                                    odla_compute_mode mode,
+                                    odla_device device) {
+  // Keep the submission order with the pending asynchronous executions.
+  odla_status status = odla_WaitContext(context);
+  if (status != ODLA_SUCCESS) {
+    return status;
+  }
+  return execute(comp, context, context->bindings);
+}
+
+odla_status odla_AsyncExecuteComputation(odla_computation comp,
+                                         odla_context context,
+                                         odla_compute_mode mode,
+                                         odla_device device) {
+  if (context->async == nullptr) {
+    context->async = std::make_unique<AsyncQueue>(
+        context, [context](odla_computation comp, const Bindings& bindings) {
+          return execute(comp, context, bindings);
+        });
+  }
+  context->async->Submit(comp, context->bindings, context->async_depth,
+                         context->async_callback, context->async_user_data);
+  return ODLA_SUCCESS;
+}
+
+odla_value odla_CreateArgument(odla_value_type type, const odla_value_id id) {
+  odla_value v = CreateValue(type, id, nullptr);
+  if (g_comp != nullptr) {
+    g_comp->inputs[v->name] = v;
+  }
+  return v;
+}
+
 odla_value odla_CreateValue(odla_value_type type, const odla_value_id id) {
-  return GetValue(type, nullptr);
+  return CreateValue(type, id, nullptr);
 }
+
+// Only the values created in the interpreter mode can be released; the others
+// are owned by their computations. Values aliasing `value` must not be used
+// afterwards.
+odla_status odla_ReleaseValue(odla_value value) {
+  odla_computation comp = GetEagerComputation();
+  if (value == nullptr || value->index >= comp->vals.size() ||
+      comp->vals[value->index].get() != value) {
+    return ODLA_FAILURE;
+  }
+  size_t index = value->index;
+  std::swap(comp->vals[index], comp->vals.back());
+  comp->vals[index]->index = index;
+  comp->vals.pop_back();
+  return ODLA_SUCCESS;
+}
+
 odla_status odla_SetValueData(odla_value val, const void* ptr) {
   val->ptr = const_cast<void*>(ptr); // FIXME
   return ODLA_SUCCESS;
 }
 
+odla_status odla_SetValueAsOutput(const odla_value val) {
+  if (g_comp == nullptr) {
+    return ODLA_FAILURE;
+  }
+  g_comp->outputs[val->name] = val;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_BindToArgument(odla_value value, const odla_void* data_ptr,
+                                odla_context context) {
+  context->bindings.values[value] = const_cast<void*>(data_ptr);
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_BindToArgumentById(const odla_value_id value_id,
+                                    const odla_void* data_ptr,
+                                    odla_context context) {
+  context->bindings.inputs[(const char*)value_id] = const_cast<void*>(data_ptr);
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_BindToOutput(odla_value value, odla_void* data_ptr,
+                              odla_context context) {
+  context->bindings.values[value] = data_ptr;
+  return ODLA_SUCCESS;
+}
+
+odla_status odla_BindToOutputById(const odla_value_id value_id,
+                                  odla_void* data_ptr, odla_context context) {
+  context->bindings.outputs[(const char*)value_id] = data_ptr;
+  return ODLA_SUCCESS;
+}
+
 static odla_value DepthwiseConvolution(
     odla_element_type type, odla_value_shape& input_dims,
     odla_memory_layout input_layout, odla_value input,
     odla_value_shape kernel_dims, odla_memory_layout kernel_layout,
     odla_value kernel, const unsigned* strides, const unsigned* dilations,
     const unsigned* paddings_front, const unsigned* paddings_back,
-    unsigned group, odla_value_shape& output_dims) {
-  auto v = GetValue({type, output_dims});
+    unsigned group, odla_value_shape& output_dims, const odla_value_id id) {
+  auto v = CreateResult({type, output_dims}, id);
   int data_ch_idx = (input_layout == ODLA_CHANNELS_LAST) ? 3 : 1;
   // assert(input_layout == ODLA_CHANNELS_FIRST && kernel_layout == ODLA_OIS);
 
@@ -188,68 +872,73 @@ static odla_value DepthwiseConvolution(
   // assert(kernel_dims.dims[(kernel_layout == ODLA_SIO) ? 2 : 1] == 1);
   assert(in_ch == out_ch);
 
-  float* in_ptr = static_cast<float*>(input->ptr);
-  float* out_ptr = static_cast<float*>(v->ptr);
   if (input_layout == ODLA_CHANNELS_LAST) { // NHWC
-    auto in =
-        EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, input_dims);
-    auto kn = EigenTensorHelper<float, 4>::GetEigenTensorMap(kernel->ptr,
-                                                             kernel_dims);
-    auto ret =
-        EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, output_dims);
-
-    auto out = in.extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1, 1,
-                                        1, pad_l, pad_r, pad_t, pad_b, 0)
-                   .reshape(Eigen::array<long, 2>{out_h * out_w * batch,
-                                                  k_w * k_h * in_ch});
-    // Element wise multplication with kernel
-    auto out_elt_mul =
-        out * ((kn.reshape(Eigen::array<long, 2>{1, k_w * k_w * in_ch}))
-                   .broadcast(Eigen::array<long, 2>{out_h * out_w * batch, 1}));
-    // Reduced sum on every kernel spatial dims
-    auto out_reduce =
-        out_elt_mul
-            .reshape(
-                Eigen::array<long, 3>{out_h * out_w * batch, k_w * k_h, in_ch})
-            .sum(Eigen::array<int, 1>{1})
-            .reshape(Eigen::array<long, 4>{batch, out_h, out_w, out_ch});
-    ret = out_reduce;
-    return Vals.back().get();
-  }
-
-  odla_value_shape local_output_dims{.size = 2, {out_h, out_w}};
-  odla_value_shape local_input_dims{.size = 4, {1, h, w, 1}};
-  odla_value_shape local_kernel_dims{.size = 2, {k_h * k_w, 1}};
-
-  for (int b = 0; b < batch; ++b) {
-    float* kn_ptr = static_cast<float*>(kernel->ptr);
-    //#pragma omp parallel
-    for (int c = 0; c < in_ch; ++c) {
-      auto ret = EigenTensorHelper<float, 2>::GetEigenTensorMap(
-          out_ptr, local_output_dims);
+    AddOp({input, kernel}, v, [=](odla_context ctx) {
       auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(
-          in_ptr, local_input_dims);
-      auto kn = EigenTensorHelper<float, 2>::GetEigenTensorMap(
-          kn_ptr, local_kernel_dims);
-
-      ret = in.extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1, 1, 1,
-                                     pad_l, pad_r, pad_t, pad_b, 0)
-                .reshape(Eigen::array<int, 2>{
-                    static_cast<int>(out_h) * static_cast<int>(out_w),
-                    static_cast<int>(k_w) * static_cast<int>(k_h)})
-                .contract(kn,
-                          Eigen::array<Eigen::IndexPair<int>, 1>{
-                              Eigen::IndexPair<int>(1, 0)})
-                .reshape(Eigen::array<int, 2>{static_cast<int>(out_h),
-                                              static_cast<int>(out_w)});
-      kn_ptr += k_h * k_w;
-      in_ptr += h * w;
-      out_ptr += out_h * out_w;
-    }
+          Data(ctx, input), input_dims);
+      auto kn = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+          Data(ctx, kernel), kernel_dims);
+      auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v),
+                                                                output_dims);
+
+      auto out = in.extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1,
+                                          1, 1, pad_l, pad_r, pad_t, pad_b, 0)
+                     .reshape(Eigen::array<long, 2>{out_h * out_w * batch,
+                                                    k_w * k_h * in_ch});
+      // Element wise multplication with kernel
+      auto out_elt_mul =
+          out *
+          ((kn.reshape(Eigen::array<long, 2>{1, k_w * k_w * in_ch}))
+               .broadcast(Eigen::array<long, 2>{out_h * out_w * batch, 1}));
+      // Reduced sum on every kernel spatial dims
+      auto out_reduce =
+          out_elt_mul
+              .reshape(Eigen::array<long, 3>{out_h * out_w * batch, k_w * k_h,
+                                             in_ch})
+              .sum(Eigen::array<int, 1>{1})
+              .reshape(Eigen::array<long, 4>{batch, out_h, out_w, out_ch});
+      ret.device(GetDevice(ctx)) = out_reduce;
+    });
+    return v;
   }
 
-  return Vals.back().get();
+  AddOp({input, kernel}, v, [=](odla_context ctx) {
+    odla_value_shape local_output_dims{.size = 2, {out_h, out_w}};
+    odla_value_shape local_input_dims{.size = 4, {1, h, w, 1}};
+    odla_value_shape local_kernel_dims{.size = 2, {k_h * k_w, 1}};
+
+    float* in_ptr = static_cast<float*>(Data(ctx, input));
+    float* out_ptr = static_cast<float*>(Data(ctx, v));
+    for (int b = 0; b < batch; ++b) {
+      float* kn_ptr = static_cast<float*>(Data(ctx, kernel));
+      //#pragma omp parallel
+      for (int c = 0; c < in_ch; ++c) {
+        auto ret = EigenTensorHelper<float, 2>::GetEigenTensorMap(
+            out_ptr, local_output_dims);
+        auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+            in_ptr, local_input_dims);
+        auto kn = EigenTensorHelper<float, 2>::GetEigenTensorMap(
+            kn_ptr, local_kernel_dims);
+
+        ret = in.extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1, 1,
+                                       1, pad_l, pad_r, pad_t, pad_b, 0)
+                  .reshape(Eigen::array<int, 2>{
+                      static_cast<int>(out_h) * static_cast<int>(out_w),
+                      static_cast<int>(k_w) * static_cast<int>(k_h)})
+                  .contract(kn,
+                            Eigen::array<Eigen::IndexPair<int>, 1>{
+                                Eigen::IndexPair<int>(1, 0)})
+                  .reshape(Eigen::array<int, 2>{static_cast<int>(out_h),
+                                                static_cast<int>(out_w)});
+        kn_ptr += k_h * k_w;
+        in_ptr += h * w;
+        out_ptr += out_h * out_w;
+      }
+    }
+  });
+  return v;
 }
+
 odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
                      odla_uint32 group, odla_value kernel,
                      odla_memory_layout kernel_layout,
@@ -257,6 +946,7 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
                      const odla_uint32* paddings_front,
                      const odla_uint32* paddings_back, odla_value bias,
                      odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   kernel_layout = (input_layout == odla_memory_layout::ODLA_CHANNELS_FIRST)
                       ? odla_memory_layout::ODLA_OIS
                       : odla_memory_layout::ODLA_SIO;
@@ -267,108 +957,92 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
     return DepthwiseConvolution(input->type.element_type, input_dims,
                                 input_layout, input, kernel_dims, kernel_layout,
                                 kernel, strides, dilations, paddings_front,
-                                paddings_back, group, output_dims);
+                                paddings_back, group, output_dims, id);
   }
-  auto v = GetValue({input->type.element_type, output_dims});
+  // INT8 convolutions accumulate into INT32.
+  bool is_int8 = input->type.element_type == ODLA_INT8;
+  auto v = CreateResult({is_int8 ? ODLA_INT32 : input->type.element_type,
+                         output_dims},
+                        id);
   int data_ch_idx = (input_layout == ODLA_CHANNELS_LAST) ? 3 : 1;
   // assert(input_layout == ODLA_CHANNELS_LAST && kernel_layout == SIO);
 
-  auto in =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, input_dims);
-  auto kn =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(kernel->ptr, kernel_dims);
-  int k_h = kernel_dims.dims[(kernel_layout == ODLA_SIO) ? 0 : 2];
-  int k_w = kernel_dims.dims[(kernel_layout == ODLA_SIO) ? 1 : 3];
-  int stride_h = strides[0];
-  int stride_w = strides[1];
-  int pad_t = paddings_front[0];
-  int pad_b = paddings_back[0];
-  int pad_l = paddings_front[1];
-  int pad_r = paddings_back[1];
-  int in_ch = input_dims.dims[data_ch_idx];
-  int out_ch = output_dims.dims[data_ch_idx];
-  int batch = input_dims.dims[0];
-  int out_h = output_dims.dims[(input_layout == ODLA_CHANNELS_LAST) ? 1 : 2];
-  int out_w = output_dims.dims[(input_layout == ODLA_CHANNELS_LAST) ? 2 : 3];
-
-  auto ret =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, output_dims);
-  if (input_layout == ODLA_CHANNELS_FIRST && k_h == 1 && k_w == 1 &&
-      stride_h == 1 && stride_w == 1) {
-    Eigen::array<int, 2> perm{1, 0};
-    auto out = in.reshape(Eigen::array<int, 2>{in_ch, out_h * out_w})
-                   .contract(kn.reshape(Eigen::array<int, 2>({out_ch, in_ch})),
-                             Eigen::array<Eigen::IndexPair<int>, 1>{
-                                 Eigen::IndexPair<int>(0, 1)})
-                   .shuffle(perm)
-                   .reshape(Eigen::array<int, 4>{batch, out_ch, out_h, out_w});
-    ret = out;
-    return Vals.back().get();
-  }
-  if (input_layout == ODLA_CHANNELS_LAST) { // NHWC
-    auto out =
-        in.extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1, 1, 1,
-                                 pad_l, pad_r, pad_t, pad_b, 0)
-            .reshape(
-                Eigen::array<int, 2>{out_h * out_w * batch, in_ch * k_w * k_h})
-            .contract(
-                kn.reshape(Eigen::array<int, 2>({in_ch * k_w * k_h, out_ch})),
-                Eigen::array<Eigen::IndexPair<int>, 1>{
-                    Eigen::IndexPair<int>(1, 0)})
-            .reshape(Eigen::array<int, 4>{batch, out_h, out_w, out_ch});
-
-    ret = out;
-  } else {
-    Eigen::array<int, 4> kernel_shuffles{2, 3, 1, 0};
-    Eigen::array<int, 4> input_shuffles{0, 2, 3, 1};
-    Eigen::array<int, 4> output_shuffles{0, 3, 1, 2};
-    auto out =
-        in.shuffle(input_shuffles)
-            .extract_image_patches(k_w, k_h, stride_h, stride_w, 1, 1, 1, 1,
-                                   pad_l, pad_r, pad_t, pad_b, 0)
-            .reshape(
-                Eigen::array<int, 2>{out_h * out_w * batch, in_ch * k_w * k_h})
-            .contract(
-                kn.shuffle(kernel_shuffles)
-                    .reshape(Eigen::array<int, 2>({in_ch * k_w * k_h, out_ch})),
-                Eigen::array<Eigen::IndexPair<int>, 1>{
-                    Eigen::IndexPair<int>(1, 0)})
-            .reshape(Eigen::array<int, 4>{batch, out_h, out_w, out_ch});
-    ret = out.shuffle(output_shuffles);
+  ConvShape shape;
+  shape.input_layout = input_layout;
+  shape.input_dims = input_dims;
+  shape.kernel_dims = kernel_dims;
+  shape.output_dims = output_dims;
+  shape.k_h = kernel_dims.dims[(kernel_layout == ODLA_SIO) ? 0 : 2];
+  shape.k_w = kernel_dims.dims[(kernel_layout == ODLA_SIO) ? 1 : 3];
+  shape.stride_h = strides[0];
+  shape.stride_w = strides[1];
+  shape.pad_t = paddings_front[0];
+  shape.pad_b = paddings_back[0];
+  shape.pad_l = paddings_front[1];
+  shape.pad_r = paddings_back[1];
+  shape.in_ch = input_dims.dims[data_ch_idx];
+  shape.out_ch = output_dims.dims[data_ch_idx];
+  shape.batch = input_dims.dims[0];
+  shape.out_h = output_dims.dims[(input_layout == ODLA_CHANNELS_LAST) ? 1 : 2];
+  shape.out_w = output_dims.dims[(input_layout == ODLA_CHANNELS_LAST) ? 2 : 3];
+  assert(bias == nullptr || GetTotalElements(bias->type.shape) == shape.out_ch);
+
+  std::vector<odla_value> inputs{input, kernel};
+  if (bias != nullptr) {
+    inputs.push_back(bias);
   }
-
-  return Vals.back().get();
+  AddOp(inputs, v, [=](odla_context ctx) {
+    void* bias_data = bias == nullptr ? nullptr : Data(ctx, bias);
+    if (is_int8) {
+      Convolution<int8_t, int32_t>(shape, GetDevice(ctx), Data(ctx, input),
+                                   Data(ctx, kernel), bias_data, Data(ctx, v));
+    } else {
+      Convolution<float, float>(shape, GetDevice(ctx), Data(ctx, input),
+                                Data(ctx, kernel), bias_data, Data(ctx, v));
+    }
+  });
+  return v;
 }
 
 odla_value odla_Clamp(odla_value input, odla_float32 lo, odla_float32 hi,
                       const odla_value_id id) {
   const auto& dims = input->type.shape;
-  auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, dims);
-  auto v = GetValue(input->type);
-
-  auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, dims);
-  ret = in.cwiseMax(static_cast<float>(lo)).cwiseMin(static_cast<float>(hi));
+  auto v = CreateResult(input->type, id);
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, input),
+                                                             dims);
+    auto ret =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v), dims);
+    ret.device(GetDevice(ctx)) =
+        in.cwiseMax(static_cast<float>(lo)).cwiseMin(static_cast<float>(hi));
+  });
   return v;
 }
 
 odla_value odla_Relu(odla_value input, const odla_value_id id) {
   const auto& dims = input->type.shape;
-  auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, dims);
-  auto v = GetValue(input->type);
-
-  auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, dims);
-  ret = in.cwiseMax(static_cast<float>(0));
+  auto v = CreateResult(input->type, id);
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, input),
+                                                             dims);
+    auto ret =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v), dims);
+    ret.device(GetDevice(ctx)) = in.cwiseMax(static_cast<float>(0));
+  });
   return v;
 }
 
 odla_value odla_LeakyRelu(odla_value input, odla_float32 alpha,
                           const odla_value_id id) {
   const auto& dims = input->type.shape;
-  auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, dims);
-  auto v = GetValue(input->type);
-
-  auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, dims);
-  ret = in.cwiseMax(in * alpha);
+  auto v = CreateResult(input->type, id);
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, input),
+                                                             dims);
+    auto ret =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v), dims);
+    ret.device(GetDevice(ctx)) = in.cwiseMax(in * alpha);
+  });
   return v;
 }
 
@@ -376,25 +1050,33 @@ odla_value odla_Add(odla_value lhs, odla_value rhs, const odla_value_id id) {
   const auto& dims_lhs = lhs->type.shape;
   const auto& dims_rhs = rhs->type.shape;
 
-  auto v = GetValue(lhs->type);
-  auto l = EigenTensorHelper<float, 4>::GetEigenTensorMap(lhs->ptr, dims_lhs);
-  auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, dims_lhs);
-
-  if (GetTotalElements(dims_lhs) != GetTotalElements(dims_rhs)) {
-    assert(dims_lhs.size == 4);
-    assert(dims_rhs.size == 1);
-
-    auto r = EigenTensorHelper<float, 1>::GetEigenTensorMap(rhs->ptr, dims_rhs);
-    int d0 = dims_lhs.dims[0];
-    int d1 = dims_lhs.dims[1];
-    int d2 = dims_lhs.dims[2];
-    int d3 = dims_lhs.dims[3];
-    ret = l + r.reshape(Eigen::array<int, 4>{1, 1, 1, d3})
+  auto v = CreateResult(lhs->type, id);
+  AddOp({lhs, rhs}, v, [=](odla_context ctx) {
+    auto l = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, lhs),
+                                                            dims_lhs);
+    auto ret =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v), dims_lhs);
+    const auto& device = GetDevice(ctx);
+
+    if (GetTotalElements(dims_lhs) != GetTotalElements(dims_rhs)) {
+      assert(dims_lhs.size == 4);
+      assert(dims_rhs.size == 1);
+
+      auto r = EigenTensorHelper<float, 1>::GetEigenTensorMap(Data(ctx, rhs),
+                                                              dims_rhs);
+      int d0 = dims_lhs.dims[0];
+      int d1 = dims_lhs.dims[1];
+      int d2 = dims_lhs.dims[2];
+      int d3 = dims_lhs.dims[3];
+      ret.device(device) =
+          l + r.reshape(Eigen::array<int, 4>{1, 1, 1, d3})
                   .broadcast(Eigen::array<int, 4>{d0, d1, d2, 1});
-  } else {
-    auto r = EigenTensorHelper<float, 4>::GetEigenTensorMap(rhs->ptr, dims_lhs);
-    ret = l + r;
-  }
+    } else {
+      auto r = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, rhs),
+                                                              dims_lhs);
+      ret.device(device) = l + r;
+    }
+  });
   return v;
 }
 
@@ -412,11 +1094,7 @@ odla_value odla_BatchNormalization(odla_value input,
   int d2 = input_dims.dims[2];
   int d3 = input_dims.dims[3];
 
-  auto v = GetValue(input->type);
-  auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, input_dims);
-
-  auto input_v =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, input_dims);
+  auto v = CreateResult(input->type, value_id);
 
   Eigen::DSizes<int, 4> bd_s(d0, d1, d2, 1);
   odla_value_shape dim{.size = 4, .dims = {1, 1, 1, input_dims.dims[3]}};
@@ -424,23 +1102,37 @@ odla_value odla_BatchNormalization(odla_value input,
     bd_s = Eigen::DSizes<int, 4>(d0, 1, d2, d3);
     dim = odla_value_shape{.size = 4, .dims = {1, input_dims.dims[1], 1, 1}};
   }
-
-  auto mean_v = EigenTensorHelper<float, 4>::GetEigenTensorMap(mean->ptr, dim);
-
-  auto var_v = EigenTensorHelper<float, 4>::GetEigenTensorMap(var->ptr, dim);
-  auto r = (input_v - mean_v.broadcast(bd_s)) *
-           ((var_v + epsilon).rsqrt().broadcast(bd_s));
   assert(scale);
   assert(offset);
+  std::vector<odla_value> inputs{input, mean, var};
   if (scale) {
-    auto scale_v =
-        EigenTensorHelper<float, 4>::GetEigenTensorMap(scale->ptr, dim);
-    auto offset_v =
-        EigenTensorHelper<float, 4>::GetEigenTensorMap(offset->ptr, dim);
-    ret = r * scale_v.broadcast(bd_s) + offset_v.broadcast(bd_s);
-  } else {
-    ret = r * scalar_scale + scalar_offset;
+    inputs.push_back(scale);
+    inputs.push_back(offset);
   }
+
+  AddOp(inputs, v, [=](odla_context ctx) {
+    auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v),
+                                                              input_dims);
+    auto input_v = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+        Data(ctx, input), input_dims);
+    auto mean_v =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, mean), dim);
+    auto var_v =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, var), dim);
+    auto r = (input_v - mean_v.broadcast(bd_s)) *
+             ((var_v + epsilon).rsqrt().broadcast(bd_s));
+    const auto& device = GetDevice(ctx);
+    if (scale) {
+      auto scale_v =
+          EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, scale), dim);
+      auto offset_v = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+          Data(ctx, offset), dim);
+      ret.device(device) =
+          r * scale_v.broadcast(bd_s) + offset_v.broadcast(bd_s);
+    } else {
+      ret.device(device) = r * scalar_scale + scalar_offset;
+    }
+  });
   return v;
 }
 
@@ -449,13 +1141,9 @@ static odla_value odla_Pooling(
     const odla_uint32* window_dims, const odla_uint32* strides,
     const odla_uint32* paddings_front, const odla_uint32* paddings_back,
     odla_value_shape output_dims, const odla_value_id value_id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& input_dims = input->type.shape;
-  auto v = GetValue({input->type.element_type, output_dims});
-  auto ret =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, output_dims);
-
-  auto input_v =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, input_dims);
+  auto v = CreateResult({input->type.element_type, output_dims}, value_id);
 
   int win_h = window_dims[0];
   int win_w = window_dims[1];
@@ -465,77 +1153,77 @@ static odla_value odla_Pooling(
   int pad_b = paddings_back[0];
   int pad_l = paddings_front[1];
   int pad_r = paddings_back[1];
-  int chs = input_dims.dims[3];
-  int batch = input_dims.dims[0];
-  int out_h = output_dims.dims[1];
-  int out_w = output_dims.dims[2];
 
-  if (input_layout == ODLA_CHANNELS_LAST) {
-    auto t = input_v
-                 .extract_image_patches(win_w, win_h, stride_w, stride_h, 1, 1,
-                                        1, 1, pad_l, pad_r, pad_top, pad_b,
-                                        std::numeric_limits<float>::lowest())
-                 .reshape(Eigen::array<int, 5>{batch, out_h, out_w,
-                                               win_h * win_w, chs});
-    if (is_max) {
-      ret = t.maximum(Eigen::array<int, 1>{3});
-    } else {
-      ret = t.mean(Eigen::array<int, 1>{3});
-    }
-  } else {
-    chs = input_dims.dims[1];
-    int h = input_dims.dims[2];
-    int w = input_dims.dims[3];
-    out_h = output_dims.dims[2];
-    out_w = output_dims.dims[3];
-    auto out = input_v.reshape(Eigen::array<int, 5>{batch, chs, h, w, 1})
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v),
+                                                              output_dims);
+    auto input_v = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+        Data(ctx, input), input_dims);
+    const auto& device = GetDevice(ctx);
+    int batch = input_dims.dims[0];
+
+    if (input_layout == ODLA_CHANNELS_LAST) {
+      int chs = input_dims.dims[3];
+      int out_h = output_dims.dims[1];
+      int out_w = output_dims.dims[2];
+      auto t = input_v
                    .extract_image_patches(win_w, win_h, stride_w, stride_h, 1,
                                           1, 1, 1, pad_l, pad_r, pad_top, pad_b,
                                           std::numeric_limits<float>::lowest())
-                   .reshape(Eigen::array<int, 6>{batch, chs, out_h, out_w,
-                                                 win_h * win_w, 1});
-    if (is_max) {
-      ret = out.maximum(Eigen::array<int, 1>{4})
-                .reshape(Eigen::array<int, 4>{batch, chs, out_h, out_w});
+                   .reshape(Eigen::array<int, 5>{batch, out_h, out_w,
+                                                 win_h * win_w, chs});
+      if (is_max) {
+        ret.device(device) = t.maximum(Eigen::array<int, 1>{3});
+      } else {
+        ret.device(device) = t.mean(Eigen::array<int, 1>{3});
+      }
     } else {
-      ret = out.mean(Eigen::array<int, 1>{4})
+      int chs = input_dims.dims[1];
+      int h = input_dims.dims[2];
+      int w = input_dims.dims[3];
+      int out_h = output_dims.dims[2];
+      int out_w = output_dims.dims[3];
+      auto out =
+          input_v.reshape(Eigen::array<int, 5>{batch, chs, h, w, 1})
+              .extract_image_patches(win_w, win_h, stride_w, stride_h, 1, 1, 1,
+                                     1, pad_l, pad_r, pad_top, pad_b,
+                                     std::numeric_limits<float>::lowest())
+              .reshape(Eigen::array<int, 6>{batch, chs, out_h, out_w,
+                                            win_h * win_w, 1});
+      if (is_max) {
+        ret.device(device) =
+            out.maximum(Eigen::array<int, 1>{4})
                 .reshape(Eigen::array<int, 4>{batch, chs, out_h, out_w});
+      } else {
+        ret.device(device) =
+            out.mean(Eigen::array<int, 1>{4})
+                .reshape(Eigen::array<int, 4>{batch, chs, out_h, out_w});
+      }
     }
-  }
+  });
   return v;
 }
 
 odla_value odla_Concat(odla_values inputs, odla_int32 axis,
                        odla_value_shape output_dims, const odla_value_id id) {
-  auto val = GetValue({inputs.values[0]->type.element_type, output_dims});
+  output_dims = ResolveBatch(output_dims);
+  auto val =
+      CreateResult({inputs.values[0]->type.element_type, output_dims}, id);
   assert(inputs.values[0]->type.element_type == ODLA_FLOAT32);
   assert(inputs.size == 2);
-  auto ret =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(val->ptr, output_dims);
-
-  auto input_a = EigenTensorHelper<float, 4>::GetEigenTensorMap(
-      inputs.values[0]->ptr, inputs.values[0]->type.shape);
-  auto input_b = EigenTensorHelper<float, 4>::GetEigenTensorMap(
-      inputs.values[1]->ptr, inputs.values[1]->type.shape);
-
-  ret = input_a.concatenate(input_b, axis);
-
-  /*
-  assert(axis == 3 && output_dims.size == 4);
-  int s = 1;
-  for (int i = 0; i < inputs.values[0]->type.shape.size - 1; ++i) {
-    s *= inputs.values[0]->type.shape.dims[i];
-  }
-  float* dst = reinterpret_cast<float*>(val->ptr);
-  for (int i = 0; i < s; ++i) {
-    for (int j = 0; j < inputs.size; ++j) {
-      int ch = inputs.values[j]->type.shape.dims[3];
-      const float* src = reinterpret_cast<const float*>(inputs.values[j]->ptr);
-      memcpy(dst, src + i * ch, sizeof(float) * ch);
-      dst += ch;
-    }
-  }
-  */
+  odla_value a = inputs.values[0];
+  odla_value b = inputs.values[1];
+
+  AddOp({a, b}, val, [=](odla_context ctx) {
+    auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, val),
+                                                              output_dims);
+    auto input_a = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+        Data(ctx, a), a->type.shape);
+    auto input_b = EigenTensorHelper<float, 4>::GetEigenTensorMap(
+        Data(ctx, b), b->type.shape);
+
+    ret.device(GetDevice(ctx)) = input_a.concatenate(input_b, axis);
+  });
   return val;
 }
 
@@ -543,8 +1231,10 @@ odla_value odla_Resize(odla_value input, odla_interpolation_mode interpolation,
                        odla_resize_coordinate_mode mode, odla_uint32 axes_mask,
                        odla_value_shape output_dims,
                        const odla_value_id value_id) {
+  output_dims = ResolveBatch(output_dims);
   assert(input->type.element_type == ODLA_FLOAT32);
-  odla_value val = GetValue({input->type.element_type, output_dims});
+  odla_value val =
+      CreateResult({input->type.element_type, output_dims}, value_id);
   assert(interpolation == ODLA_NEAREST);
   assert(input->type.shape.size == 4 && axes_mask == -1);
   int out_h = output_dims.dims[1];
@@ -552,22 +1242,24 @@ odla_value odla_Resize(odla_value input, odla_interpolation_mode interpolation,
   int ch = output_dims.dims[3];
   int in_h = input->type.shape.dims[1];
   int in_w = input->type.shape.dims[2];
-
-  float* dst_ptr = (float*)val->ptr;
   assert(ch == input->type.shape.dims[3]);
-  size_t copy_size = sizeof(float) * ch;
-  const float* src_ptr = (float*)input->ptr;
-  for (int n = 0; n < output_dims.dims[0]; ++n) {
-    for (int h = 0; h < out_h; ++h) {
-      int src_h = in_h * h / out_h;
-      for (int w = 0; w < out_w; ++w) {
-        int src_w = in_w * w / out_w;
-        memcpy(dst_ptr, src_ptr + src_h * in_w * ch + src_w * ch, copy_size);
-        dst_ptr += ch;
+
+  AddOp({input}, val, [=](odla_context ctx) {
+    float* dst_ptr = static_cast<float*>(Data(ctx, val));
+    size_t copy_size = sizeof(float) * ch;
+    const float* src_ptr = static_cast<const float*>(Data(ctx, input));
+    for (int n = 0; n < output_dims.dims[0]; ++n) {
+      for (int h = 0; h < out_h; ++h) {
+        int src_h = in_h * h / out_h;
+        for (int w = 0; w < out_w; ++w) {
+          int src_w = in_w * w / out_w;
+          memcpy(dst_ptr, src_ptr + src_h * in_w * ch + src_w * ch, copy_size);
+          dst_ptr += ch;
+        }
       }
+      src_ptr += in_h * in_w * ch;
     }
-    src_ptr += in_h * in_w * ch;
-  }
+  });
   return val;
 }
 
@@ -595,26 +1287,28 @@ odla_value odla_AveragePool(odla_value input, odla_memory_layout input_layout,
 
 odla_value odla_Softmax(odla_value input, odla_int32 axis,
                         const odla_value_id id) {
-  auto v = GetValue(input->type);
+  auto v = CreateResult(input->type, id);
   const auto& dims = input->type.shape;
-  auto ret = EigenTensorHelper<float, 2>::GetEigenTensorMap(v->ptr, dims);
-
-  auto input_v =
-      EigenTensorHelper<float, 2>::GetEigenTensorMap(input->ptr, dims);
-
-  Eigen::DSizes<int, 2> shape(dims.dims[0], 1);
-  Eigen::DSizes<int, 2> bd(1, dims.dims[1]);
-
-  auto r = (input_v - input_v.maximum(Eigen::DSizes<int, 1>{1})
-                          .eval()
-                          .reshape(shape)
-                          .broadcast(bd))
-               .exp();
-  ret = r * (r.sum(Eigen::DSizes<int, 1>{1})
-                 .inverse()
-                 .eval()
-                 .reshape(shape)
-                 .broadcast(bd));
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto ret =
+        EigenTensorHelper<float, 2>::GetEigenTensorMap(Data(ctx, v), dims);
+    auto input_v =
+        EigenTensorHelper<float, 2>::GetEigenTensorMap(Data(ctx, input), dims);
+
+    Eigen::DSizes<int, 2> shape(dims.dims[0], 1);
+    Eigen::DSizes<int, 2> bd(1, dims.dims[1]);
+
+    auto r = (input_v - input_v.maximum(Eigen::DSizes<int, 1>{1})
+                            .eval()
+                            .reshape(shape)
+                            .broadcast(bd))
+                 .exp();
+    ret.device(GetDevice(ctx)) = r * (r.sum(Eigen::DSizes<int, 1>{1})
+                                          .inverse()
+                                          .eval()
+                                          .reshape(shape)
+                                          .broadcast(bd));
+  });
   return v;
 }
 
@@ -622,47 +1316,53 @@ odla_value odla_ReduceMean(odla_value input, odla_size_t num_of_axes,
                            const odla_uint32* axes, odla_bool keep_dims,
                            odla_value_shape output_dims,
                            const odla_value_id id) {
-  auto v = GetValue({input->type.element_type, output_dims});
+  output_dims = ResolveBatch(output_dims);
+  auto v = CreateResult({input->type.element_type, output_dims}, id);
   const auto& dims = input->type.shape;
-  auto input_v =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, dims);
   Eigen::array<int, 2> reduction_axes;
   for (int i = 0; i < 2; ++i) {
     reduction_axes[i] = axes[i];
   }
-  auto r = input_v.mean(reduction_axes);
-  if (output_dims.size == dims.size) {
-    int d0 = output_dims.dims[0];
-    int d1 = output_dims.dims[1];
-    int d2 = output_dims.dims[2];
-    int d3 = output_dims.dims[3];
-    auto ret =
-        EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, output_dims);
-
-    ret = r.reshape(Eigen::array<int, 4>{d0, d1, d2, d3});
-  } else {
-    auto ret =
-        EigenTensorHelper<float, 2>::GetEigenTensorMap(v->ptr, output_dims);
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto input_v =
+        EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, input), dims);
+    auto r = input_v.mean(reduction_axes);
+    const auto& device = GetDevice(ctx);
+    if (output_dims.size == dims.size) {
+      int d0 = output_dims.dims[0];
+      int d1 = output_dims.dims[1];
+      int d2 = output_dims.dims[2];
+      int d3 = output_dims.dims[3];
+      auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v),
+                                                                output_dims);
+
+      ret.device(device) = r.reshape(Eigen::array<int, 4>{d0, d1, d2, d3});
+    } else {
+      auto ret = EigenTensorHelper<float, 2>::GetEigenTensorMap(Data(ctx, v),
+                                                                output_dims);
 
-    ret = r;
-  }
+      ret.device(device) = r;
+    }
+  });
   return v;
 }
 
 odla_value odla_Reshape(odla_value input, odla_value_shape output_dims,
                         const odla_value_id id) {
-  return GetValue({input->type.element_type, output_dims}, input->ptr);
+  auto v = CreateValue({input->type.element_type, output_dims}, id, input->ptr);
+  v->alias = input;
+  v->is_result = true;
+  return v;
 }
 
 odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
                      odla_bool transpose_rhs, odla_float32 alpha,
                      odla_float32 beta, odla_value bias,
                      odla_value_shape output_dims, const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& lhs_dims = lhs->type.shape;
   const auto& rhs_dims = rhs->type.shape;
   assert(lhs_dims.size == 2);
-  auto A = EigenTensorHelper<float, 2>::GetEigenTensorMap(lhs->ptr, lhs_dims);
-  auto B = EigenTensorHelper<float, 2>::GetEigenTensorMap(rhs->ptr, rhs_dims);
 
   Eigen::array<Eigen::IndexPair<int>, 1> dims = {Eigen::IndexPair<int>(1, 0)};
   if (transpose_lhs && transpose_rhs) {
@@ -673,46 +1373,163 @@ odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
     dims[0] = Eigen::IndexPair<int>{1, 1};
   }
 
-  auto v = GetValue({lhs->type.element_type, output_dims});
-  auto ret =
-      EigenTensorHelper<float, 2>::GetEigenTensorMap(v->ptr, output_dims);
+  // INT8 matrix multiplications accumulate into INT32.
+  bool is_int8 = lhs->type.element_type == ODLA_INT8;
+  auto v = CreateResult(
+      {is_int8 ? ODLA_INT32 : lhs->type.element_type, output_dims}, id);
+  std::vector<odla_value> inputs{lhs, rhs};
   if (bias) {
-    auto C =
-        EigenTensorHelper<float, 2>::GetEigenTensorMap(bias->ptr, output_dims);
-    ret = A.contract(B, dims) + C;
-  } else {
-    ret = A.contract(B, dims);
+    inputs.push_back(bias);
   }
+  AddOp(inputs, v, [=](odla_context ctx) {
+    void* bias_data = bias == nullptr ? nullptr : Data(ctx, bias);
+    int64_t bias_size =
+        bias == nullptr ? 0 : GetTotalElements(bias->type.shape);
+    if (is_int8) {
+      MatMul<int8_t, int32_t>(GetDevice(ctx), Data(ctx, lhs), lhs_dims,
+                              Data(ctx, rhs), rhs_dims, dims, bias_data,
+                              bias_size, Data(ctx, v), output_dims);
+    } else {
+      MatMul<float, float>(GetDevice(ctx), Data(ctx, lhs), lhs_dims,
+                           Data(ctx, rhs), rhs_dims, dims, bias_data,
+                           bias_size, Data(ctx, v), output_dims);
+    }
+  });
   return v;
 }
 
+// Applies the fused activation in-place. Works on tensors of any rank.
+static odla_value ApplyActivation(odla_value v, odla_activation activation,
+                                  odla_float32 alpha) {
+  if (activation == ODLA_ACTIVATION_NONE) {
+    return v;
+  }
+  bool is_leaky = activation == ODLA_ACTIVATION_LEAKY_RELU;
+  bool is_relu6 = activation == ODLA_ACTIVATION_RELU6;
+  float slope = is_leaky ? alpha : 1;
+  AddOp({v}, v, [=](odla_context ctx) {
+    if (v->type.element_type == ODLA_INT32) {
+      Activate<int32_t>(
+          ctx, v, is_leaky ? std::numeric_limits<int32_t>::lowest() : 0,
+          is_relu6 ? 6 : std::numeric_limits<int32_t>::max(), slope);
+    } else {
+      Activate<float>(ctx, v,
+                      is_leaky ? std::numeric_limits<float>::lowest() : 0,
+                      is_relu6 ? 6 : std::numeric_limits<float>::max(), slope);
+    }
+  });
+  return v;
+}
+
+odla_value odla_FusedConv(
+    odla_value input, odla_memory_layout input_layout, odla_uint32 group,
+    odla_value kernel, odla_memory_layout kernel_layout,
+    const odla_uint32* strides, const odla_uint32* dilations,
+    const odla_uint32* paddings_front, const odla_uint32* paddings_back,
+    odla_value bias, odla_activation activation,
+    odla_float32 activation_alpha, odla_value_shape output_dims,
+    const odla_value_id id) {
+  return ApplyActivation(
+      odla_Conv(input, input_layout, group, kernel, kernel_layout, strides,
+                dilations, paddings_front, paddings_back, bias, output_dims,
+                id),
+      activation, activation_alpha);
+}
+
+odla_value odla_FusedGemm(odla_value lhs, odla_bool transpose_lhs,
+                          odla_value rhs, odla_bool transpose_rhs,
+                          odla_float32 alpha, odla_float32 beta,
+                          odla_value bias, odla_activation activation,
+                          odla_float32 activation_alpha,
+                          odla_value_shape output_dims,
+                          const odla_value_id id) {
+  return ApplyActivation(odla_Gemm(lhs, transpose_lhs, rhs, transpose_rhs,
+                                   alpha, beta, bias, output_dims, id),
+                         activation, activation_alpha);
+}
+
 odla_value odla_Transpose(odla_value input, odla_value_shape permutations,
                           odla_value_shape output_dims,
                           const odla_value_id id) {
+  output_dims = ResolveBatch(output_dims);
   const auto& input_dims = input->type.shape;
   assert(input_dims.size == 4);
-  auto v = GetValue({input->type.element_type, output_dims});
-  auto in =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(input->ptr, input_dims);
-  auto ret =
-      EigenTensorHelper<float, 4>::GetEigenTensorMap(v->ptr, output_dims);
+  auto v = CreateResult({input->type.element_type, output_dims}, id);
   assert(permutations.size == 4);
   Eigen::array<size_t, 4> perm{static_cast<size_t>(permutations.dims[0]),
                                static_cast<size_t>(permutations.dims[1]),
                                static_cast<size_t>(permutations.dims[2]),
                                static_cast<size_t>(permutations.dims[3])};
+  AddOp({input}, v, [=](odla_context ctx) {
+    auto in = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, input),
+                                                             input_dims);
+    auto ret = EigenTensorHelper<float, 4>::GetEigenTensorMap(Data(ctx, v),
+                                                              output_dims);
+    ret.device(GetDevice(ctx)) = in.shuffle(perm);
+  });
+  return v;
+}
 
-  ret = in.shuffle(perm);
+odla_value odla_Quantize(odla_value input, odla_float32 scale,
+                         odla_int32 zero_point, odla_element_type element_type,
+                         const odla_value_id id) {
+  assert(element_type == ODLA_INT8 || element_type == ODLA_UINT8);
+  const auto& dims = input->type.shape;
+  auto v = CreateResult({element_type, dims}, id);
+  AddOp({input}, v, [=](odla_context ctx) {
+    int64_t n = GetTotalElements(dims);
+    if (element_type == ODLA_INT8) {
+      Quantize<int8_t>(GetDevice(ctx), Data(ctx, input), Data(ctx, v), n,
+                       scale, zero_point);
+    } else {
+      Quantize<uint8_t>(GetDevice(ctx), Data(ctx, input), Data(ctx, v), n,
+                        scale, zero_point);
+    }
+  });
+  return v;
+}
+
+odla_value odla_Dequantize(odla_value input, odla_size_t num_of_scales,
+                           const odla_float32* scales, odla_int32 axis,
+                           const odla_value_id id) {
+  const auto& dims = input->type.shape;
+  assert(num_of_scales == 1 ||
+         num_of_scales == static_cast<odla_size_t>(dims.dims[axis]));
+  auto v = CreateResult({ODLA_FLOAT32, dims}, id);
+  std::vector<float> channel_scales(scales, scales + num_of_scales);
+  int64_t inner = 1;
+  for (int i = axis + 1; i < dims.size; ++i) {
+    inner *= dims.dims[i];
+  }
+  AddOp({input}, v, [=](odla_context ctx) {
+    int64_t n = GetTotalElements(dims);
+    float* out = static_cast<float*>(Data(ctx, v));
+    switch (input->type.element_type) {
+      case ODLA_INT8:
+        Dequantize<int8_t>(Data(ctx, input), out, n, channel_scales, inner);
+        break;
+      case ODLA_UINT8:
+        Dequantize<uint8_t>(Data(ctx, input), out, n, channel_scales, inner);
+        break;
+      default:
+        assert(input->type.element_type == ODLA_INT32);
+        Dequantize<int32_t>(Data(ctx, input), out, n, channel_scales, inner);
+    }
+  });
   return v;
 }
 
 odla_value odla_CreateConstant(odla_value_type type, const void* ptr,
                                const odla_value_id id) {
-  return GetValue(type, const_cast<void*>(ptr));
+  return CreateValue(type, id, const_cast<void*>(ptr));
 }
 
 odla_status odla_GetValueData(const odla_value value, odla_void* data_ptr) {
+  if (value->ptr == nullptr) {
+    return ODLA_FAILURE;
+  }
   memcpy(data_ptr, value->ptr, GetValueSize(value->type));
+  return ODLA_SUCCESS;
 }
 
 void odla_Dump(odla_value val) {
@@ -724,5 +1541,4 @@ void odla_Dump(odla_value val) {
     printf("\n");
   }
 }
-
-} // C extern
\ No newline at end of file
+}
@@ -972,6 +972,49 @@ odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
                      id);
 }
 
+static odla_value ApplyActivation(odla_value v, odla_activation activation,
+                                  odla_float32 alpha, const odla_value_id id) {
+  switch (activation) {
+    case ODLA_ACTIVATION_RELU:
+      return odla_Relu(v, id);
+    case ODLA_ACTIVATION_RELU6:
+      return odla_Clamp(v, 0, 6, id);
+    case ODLA_ACTIVATION_LEAKY_RELU:
+      return odla_LeakyRelu(v, alpha, id);
+    default:
+      return v;
+  }
+}
+
+odla_value odla_FusedConv(
+    odla_value input, odla_memory_layout input_layout, odla_uint32 group,
+    odla_value kernel, odla_memory_layout kernel_layout,
+    const odla_uint32* strides, const odla_uint32* dilations,
+    const odla_uint32* paddings_front, const odla_uint32* paddings_back,
+    odla_value bias, odla_activation activation,
+    odla_float32 activation_alpha, odla_value_shape output_dims,
+    const odla_value_id id) {
+  // TensorRT fuses the activation layer into the convolution when building
+  // the engine.
+  return ApplyActivation(
+      odla_Conv(input, input_layout, group, kernel, kernel_layout, strides,
+                dilations, paddings_front, paddings_back, bias, output_dims,
+                id),
+      activation, activation_alpha, id);
+}
+
+odla_value odla_FusedGemm(odla_value lhs, odla_bool transpose_lhs,
+                          odla_value rhs, odla_bool transpose_rhs,
+                          odla_float32 alpha, odla_float32 beta,
+                          odla_value bias, odla_activation activation,
+                          odla_float32 activation_alpha,
+                          odla_value_shape output_dims,
+                          const odla_value_id id) {
+  return ApplyActivation(odla_Gemm(lhs, transpose_lhs, rhs, transpose_rhs,
+                                   alpha, beta, bias, output_dims, id),
+                         activation, activation_alpha, id);
+}
+
 odla_value odla_Reshape(odla_value input, odla_value_shape output_dims,
                         const odla_value_id id) {
   auto shuffle = g_comp->network->addShuffle(*input);
@@ -338,13 +338,23 @@ void odla_Dump(odla_value v) {
   }
 }
 
-odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
-                     odla_uint32 group, odla_value kernel,
-                     odla_memory_layout kernel_layout,
-                     const odla_uint32* strides, const odla_uint32* dilations,
-                     const odla_uint32* paddings_front,
-                     const odla_uint32* paddings_back, odla_value bias,
-                     odla_value_shape output_dims, const odla_value_id id) {
+// Returns the output range that computes relu and relu6 in the operator.
+static void GetActivationRange(odla_activation activation, float* lo,
+                               float* hi) {
+  *lo = activation == ODLA_ACTIVATION_RELU ||
+                activation == ODLA_ACTIVATION_RELU6
+            ? 0
+            : -FLT_MAX;
+  *hi = activation == ODLA_ACTIVATION_RELU6 ? 6 : FLT_MAX;
+}
+
+static odla_value conv(odla_value input, odla_memory_layout input_layout,
+                       odla_uint32 group, odla_value kernel,
+                       const odla_uint32* strides, const odla_uint32* dilations,
+                       const odla_uint32* paddings_front,
+                       const odla_uint32* paddings_back, odla_value bias,
+                       float output_min, float output_max,
+                       odla_value_shape output_dims, const odla_value_id id) {
   xnn_status_t s;
 
   assert(input_layout == ODLA_CHANNELS_LAST);
@@ -389,8 +399,8 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
         output_dims.dims[3] / group /*group_output_channels*/,
         input->shape.dims[3] /* input_pixel_stride */,
         output_dims.dims[3] /*output_pixel_stride*/, kernel->data,
-        (bias == NULL) ? NULL : bias->data, -FLT_MAX /*output_min*/,
-        FLT_MAX /*output_max*/, 0 /*flags*/, &val->op);
+        (bias == NULL) ? NULL : bias->data, output_min, output_max,
+        0 /*flags*/, &val->op);
     assert(s == xnn_status_success);
   }
   if (val->needs_setup || input->needs_setup) {
@@ -406,6 +416,37 @@ odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
   return val;
 }
 
+odla_value odla_Conv(odla_value input, odla_memory_layout input_layout,
+                     odla_uint32 group, odla_value kernel,
+                     odla_memory_layout kernel_layout,
+                     const odla_uint32* strides, const odla_uint32* dilations,
+                     const odla_uint32* paddings_front,
+                     const odla_uint32* paddings_back, odla_value bias,
+                     odla_value_shape output_dims, const odla_value_id id) {
+  return conv(input, input_layout, group, kernel, strides, dilations,
+              paddings_front, paddings_back, bias, -FLT_MAX, FLT_MAX,
+              output_dims, id);
+}
+
+odla_value odla_FusedConv(
+    odla_value input, odla_memory_layout input_layout, odla_uint32 group,
+    odla_value kernel, odla_memory_layout kernel_layout,
+    const odla_uint32* strides, const odla_uint32* dilations,
+    const odla_uint32* paddings_front, const odla_uint32* paddings_back,
+    odla_value bias, odla_activation activation,
+    odla_float32 activation_alpha, odla_value_shape output_dims,
+    const odla_value_id id) {
+  float lo, hi;
+  GetActivationRange(activation, &lo, &hi);
+  odla_value val = conv(input, input_layout, group, kernel, strides, dilations,
+                        paddings_front, paddings_back, bias, lo, hi,
+                        output_dims, id);
+  // Leaky relu runs in-place on the result.
+  return activation == ODLA_ACTIVATION_LEAKY_RELU
+             ? odla_LeakyRelu(val, activation_alpha, id)
+             : val;
+}
+
 odla_value odla_DeConv(odla_value input, odla_memory_layout input_layout,
                        odla_uint32 group, odla_value kernel,
                        odla_memory_layout kernel_layout,
@@ -867,10 +908,9 @@ odla_value odla_Transpose(odla_value input, odla_value_shape permutations,
   return val;
 }
 
-odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
-                     odla_bool transpose_rhs, odla_float32 alpha,
-                     odla_float32 beta, odla_value bias,
-                     odla_value_shape output_dims, const odla_value_id id) {
+static odla_value gemm(odla_value lhs, odla_value rhs, odla_value bias,
+                       float output_min, float output_max,
+                       odla_value_shape output_dims, const odla_value_id id) {
   odla_value val = GetValue(&output_dims, id);
   xnn_status_t s;
   if (val->op == NULL) {
@@ -879,7 +919,8 @@ odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
         rhs->shape.dims[0] /* output_channels*/,
         rhs->shape.dims[1] /*input_stride*/,
         rhs->shape.dims[0] /*output_stride*/, rhs->data,
-        bias ? bias->data : NULL, -FLT_MAX, FLT_MAX, 0 /*flags*/, &val->op);
+        bias ? bias->data : NULL, output_min, output_max, 0 /*flags*/,
+        &val->op);
     assert(s == xnn_status_success);
   }
   if (val->needs_setup || lhs->needs_setup || rhs->needs_setup) {
@@ -894,6 +935,28 @@ odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
   return val;
 }
 
+odla_value odla_Gemm(odla_value lhs, odla_bool transpose_lhs, odla_value rhs,
+                     odla_bool transpose_rhs, odla_float32 alpha,
+                     odla_float32 beta, odla_value bias,
+                     odla_value_shape output_dims, const odla_value_id id) {
+  return gemm(lhs, rhs, bias, -FLT_MAX, FLT_MAX, output_dims, id);
+}
+
+odla_value odla_FusedGemm(odla_value lhs, odla_bool transpose_lhs,
+                          odla_value rhs, odla_bool transpose_rhs,
+                          odla_float32 alpha, odla_float32 beta,
+                          odla_value bias, odla_activation activation,
+                          odla_float32 activation_alpha,
+                          odla_value_shape output_dims,
+                          const odla_value_id id) {
+  float lo, hi;
+  GetActivationRange(activation, &lo, &hi);
+  odla_value val = gemm(lhs, rhs, bias, lo, hi, output_dims, id);
+  return activation == ODLA_ACTIVATION_LEAKY_RELU
+             ? odla_LeakyRelu(val, activation_alpha, id)
+             : val;
+}
+
 odla_status odla_GetValueType(const odla_value value,
                               odla_value_type* value_type) {
   value_type->element_type = ODLA_FLOAT32;
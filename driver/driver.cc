@@ -15,27 +15,36 @@
 // limitations under the License.
 // =============================================================================
 
+#include <sys/resource.h>
+
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <set>
 #include <string>
 
+#include "halo/lib/executor/parallel_executor.h"
 #include "halo/lib/framework/common.h"
 #include "halo/lib/ir/ir_builder.h"
 #include "halo/lib/parser/parser.h"
 #include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/quantizer/quantizer.h"
 #include "halo/lib/target/cpu/arm/binary/arm_llvmir_codegen.h"
 #include "halo/lib/target/cpu/riscv/binary/riscv_llvmir_codegen.h"
 #include "halo/lib/target/cpu/x86/binary/x86_llvmir_codegen.h"
 #include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
 #include "halo/lib/target/generic_llvmir/generic_llvmir_codegen.h"
 #include "halo/lib/target/triton/triton_config_writer.h"
+#include "halo/lib/target/weights_file_writer.h"
 #include "halo/lib/transforms/caffeextension_legalizer.h"
+#include "halo/lib/transforms/constant_dedup.h"
 #include "halo/lib/transforms/dce.h"
 #include "halo/lib/transforms/device_placement.h"
 #include "halo/lib/transforms/fusion.h"
 #include "halo/lib/transforms/input_legalizer.h"
 #include "halo/lib/transforms/input_rewriter.h"
 #include "halo/lib/transforms/inst_simplify.h"
+#include "halo/lib/transforms/mixed_precision.h"
 #include "halo/lib/transforms/onnxextension_legalizer.h"
 #include "halo/lib/transforms/output_rewriter.h"
 #include "halo/lib/transforms/reorder_channel.h"
@@ -78,6 +87,12 @@ static llvm::cl::opt<bool> PrintAll(
 static llvm::cl::opt<bool> EmitLLVMIR("emit-llvm",
                                       llvm::cl::desc("output the LLVM IR code"),
                                       llvm::cl::init(false));
+static llvm::cl::opt<bool> EmitLoopNests(
+    "emit-loop-nests",
+    llvm::cl::desc("Emit shape-specialized loop nests instead of runtime "
+                   "library calls for elementwise, broadcast, transpose, pad "
+                   "and small reductions (LLVM IR and binary output)"),
+    llvm::cl::init(false));
 static llvm::cl::opt<std::string> EntryFunctionName(
     "entry-func-name", llvm::cl::desc("name of entry function"),
     llvm::cl::init(""));
@@ -116,6 +131,10 @@ static llvm::cl::opt<bool> SeparateConstants(
 static llvm::cl::opt<bool> DisableBroadcasting(
     "disable-broadcasting", llvm::cl::desc("disable broadcasting of constants"),
     llvm::cl::init(false));
+static llvm::cl::opt<int> ConstantFoldingLimit(
+    "constant-folding-limit",
+    llvm::cl::desc("Do not fold constants larger than <n> bytes"),
+    llvm::cl::init(ConstantEvaluator::kDefaultMaxBytes));
 static llvm::cl::opt<bool> EmitCodeOnly(
     "code-only", llvm::cl::desc("Generate the code only"),
     llvm::cl::init(false));
@@ -129,6 +148,22 @@ static llvm::cl::opt<int> Batch(
     llvm::cl::desc("Specify batch size if the first dim of input is negative"),
     llvm::cl::init(1));
 
+static llvm::cl::opt<int> MinBatch(
+    "min-batch-size",
+    llvm::cl::desc("Specify the minimum batch size of a dynamic batch model"),
+    llvm::cl::init(1));
+
+static llvm::cl::opt<int> MaxBatch(
+    "max-batch-size",
+    llvm::cl::desc("Specify the maximum batch size of a dynamic batch model"),
+    llvm::cl::init(8));
+
+static llvm::cl::opt<int> OptBatch(
+    "opt-batch-size",
+    llvm::cl::desc("Specify the batch size that a dynamic batch model is "
+                   "optimized for"),
+    llvm::cl::init(4));
+
 static llvm::cl::opt<bool> EnableBF16("enable-bf16",
                                       llvm::cl::desc("Enable BF16"),
                                       llvm::cl::init(false));
@@ -150,10 +185,78 @@ static llvm::cl::opt<bool> EmitDataAsC(
     "emit-data-as-c", llvm::cl::desc("Emit Constants as C/C++ code"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> EmitDataAsBlob(
+    "emit-data-as-blob",
+    llvm::cl::desc("Emit Constants as a binary blob with an assembler stub "
+                   "that embeds it"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> EmitWeightsFile(
+    "emit-weights-file",
+    llvm::cl::desc("Emit Constants as an aligned, memory-mappable weights "
+                   "file"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> ExecCacheDir(
+    "exec-cache-dir",
+    llvm::cl::desc("Emit code that stores the built ODLA computation in "
+                   "<dir> and loads it on later runs"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> Int8CalibrationFile(
+    "int8-calibration-file",
+    llvm::cl::desc("Quantize convolutions and matrix multiplications to INT8 "
+                   "with the value ranges in the calibration file"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<DataType> MixedPrecisionType(
+    llvm::cl::values(clEnumValN(DataType::FLOAT32, "none", "FLOAT32 only"),
+                     clEnumValN(DataType::BFLOAT16, "bf16", "BFLOAT16"),
+                     clEnumValN(DataType::FLOAT16, "fp16", "FLOAT16")),
+    "mixed-precision",
+    llvm::cl::desc("Compute convolutions, matrix multiplications and the "
+                   "instructions they feed in the 16-bit floating point type "
+                   "where it is numerically safe"),
+    llvm::cl::init(DataType::FLOAT32));
+
+static llvm::cl::list<std::string> MixedPrecisionKeepFP32(
+    "mixed-precision-keep-fp32",
+    llvm::cl::desc("Specify instructions that stay in FLOAT32 like "
+                   "-mixed-precision-keep-fp32=foo"));
+
+static llvm::cl::opt<std::string> MixedPrecisionRanges(
+    "mixed-precision-ranges",
+    llvm::cl::desc("Keep instructions whose calibrated value ranges do not "
+                   "fit FLOAT16 in FLOAT32, using a calibration file"),
+    llvm::cl::init(""));
+
 static llvm::cl::opt<bool> PrintMemStats(
     "print-mem-stats", llvm::cl::desc("Print Memory Usage Stats"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> TimePasses(
+    "time-passes",
+    llvm::cl::desc("Print the time and peak memory of parsing, and the time, "
+                   "fixed-point iterations, instruction counts and peak memory "
+                   "of each pass"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> TimePassesTrace(
+    "time-passes-trace",
+    llvm::cl::desc("Write the pass timing as Chrome trace JSON to <file>"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> PrintParallelSchedule(
+    "print-parallel-schedule",
+    llvm::cl::desc("Print the critical path cost and the inter-op parallel "
+                   "speedup bound of each function"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<int> CompileThreads(
+    "compile-threads",
+    llvm::cl::desc("Run function passes on up to <n> functions in parallel"),
+    llvm::cl::init(1));
+
 static llvm::cl::opt<bool> EmitValueReset(
     "emit-value-reset",
     llvm::cl::desc("Emit code to reset value life cycle ends"),
@@ -207,6 +310,8 @@ static llvm::cl::list<std::string> Outputs(
 static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
                                   std::ostream* out_constants,
                                   std::ostream* out_header,
+                                  std::ostream* out_blob_stub,
+                                  std::ostream* out_blob_header,
                                   bool is_c_or_cxx_output,
                                   bool is_binary_output) {
   auto constant_storage =
@@ -228,11 +333,29 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
     opts.emit_value_id_as_int = EmitValueIDAsInt;
     opts.emit_inference_func_sig = EmitInferenceFunctionSignature;
     opts.emit_dynamic_batch = (Batch.getValue() == kDynamicBatchSize);
+    opts.min_batch_size = MinBatch;
+    opts.max_batch_size = MaxBatch;
+    opts.opt_batch_size = OptBatch;
+    opts.emit_weights_file = EmitWeightsFile;
+    opts.exec_cache_dir = ExecCacheDir;
     cg = pm->AddPass<GenericCXXCodeGen>(std::ref(*out_code),
                                         std::ref(*out_header), opts);
     cg->SetAPI(Api);
 
-    if (EmitDataAsC) {
+    if (EmitWeightsFile) {
+      pm->AddPass<WeightsFileWriter>(std::ref(*out_constants));
+    } else if (EmitDataAsBlob) {
+      // The stub refers to the blob by its file name.
+      std::string blob_file_name = "constants.bin";
+      if (!OutputFile.empty() && OutputFile != "-") {
+        llvm::SmallString<128> name(llvm::sys::path::filename(OutputFile));
+        llvm::sys::path::replace_extension(name, "data.bin");
+        blob_file_name = name.str();
+      }
+      pm->AddPass<GenericCXXBlobConstantWriter>(
+          std::ref(*out_constants), std::ref(*out_blob_stub),
+          std::ref(*out_blob_header), blob_file_name);
+    } else if (EmitDataAsC) {
       pm->AddPass<GenericCXXConstantWriter>(std::ref(*out_constants));
     } else {
       pm->AddPass<X86ConstantWriter>(std::ref(*out_constants));
@@ -243,8 +366,10 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
     return;
   }
 
+  GenericLLVMIRCodeGen* llvm_cg = nullptr;
   if (EmitLLVMIR) {
-    cg = pm->AddPass<GenericLLVMIRCodeGen>(constant_storage);
+    llvm_cg = pm->AddPass<GenericLLVMIRCodeGen>(constant_storage);
+    cg = llvm_cg;
     pm->AddPass<GenericLLVMIRWriter>(std::ref(*out_code), is_binary_output);
     if (SeparateConstants && !EmitCodeOnly) {
       pm->AddPass<GenericConstantWriter>(std::ref(*out_constants),
@@ -255,7 +380,7 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
     switch (triple.getArch()) {
       case llvm::Triple::ArchType::x86:
       case llvm::Triple::ArchType::x86_64: {
-        pm->AddPass<X86LLVMIRCodeGen>(
+        llvm_cg = pm->AddPass<X86LLVMIRCodeGen>(
             GenericLLVMIRCodeGen::ConstantDataStorage::DeclaredAsExternal);
         pm->AddPass<X86BinaryWriter>(std::ref(*out_code));
         if (SeparateConstants && !EmitCodeOnly) {
@@ -264,7 +389,7 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
         break;
       }
       case llvm::Triple::ArchType::aarch64: {
-        pm->AddPass<ARMLLVMIRCodeGen>(
+        llvm_cg = pm->AddPass<ARMLLVMIRCodeGen>(
             GenericLLVMIRCodeGen::ConstantDataStorage::DeclaredAsExternal);
         pm->AddPass<ARMBinaryWriter>(std::ref(*out_code));
         if (SeparateConstants && !EmitCodeOnly) {
@@ -275,11 +400,11 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
       case llvm::Triple::ArchType::riscv32:
       case llvm::Triple::ArchType::riscv64: {
         if (RISCVOpt) {
-          pm->AddPass<RISCVLLVMIRCodeGen>(
+          llvm_cg = pm->AddPass<RISCVLLVMIRCodeGen>(
               GenericLLVMIRCodeGen::ConstantDataStorage::DeclaredAsExternal,
               "libRT_RISCV.a");
         } else {
-          pm->AddPass<RISCVLLVMIRCodeGen>(
+          llvm_cg = pm->AddPass<RISCVLLVMIRCodeGen>(
               GenericLLVMIRCodeGen::ConstantDataStorage::DeclaredAsExternal);
         }
         pm->AddPass<RISCVBinaryWriter>(std::ref(*out_code));
@@ -298,12 +423,18 @@ static void PopulateCodeGenPasses(PassManager* pm, std::ostream* out_code,
   if (cg != nullptr) {
     cg->SetAPI(Api);
   }
+  if (llvm_cg != nullptr && EmitLoopNests) {
+    llvm_cg->SetLoweringMode(GenericLLVMIRCodeGen::LoweringMode::LoopNest);
+  }
 }
 
 static void PopulatePasses(PassManager* pm, std::ostream* out_code,
                            std::ostream* out_constants,
-                           std::ostream* out_header, bool is_c_or_cxx_output,
-                           bool is_binary_output, Parser::Format format) {
+                           std::ostream* out_header,
+                           std::ostream* out_blob_stub,
+                           std::ostream* out_blob_header,
+                           bool is_c_or_cxx_output, bool is_binary_output,
+                           Parser::Format format) {
   std::vector<std::string> input_shapes(InputsShape.begin(), InputsShape.end());
   pm->AddPass<InputLegalizer>(Batch.getValue(), input_shapes);
   if (!Outputs.empty()) {
@@ -327,19 +458,39 @@ static void PopulatePasses(PassManager* pm, std::ostream* out_code,
 
   pm->AddPass<InstSimplify>(
       llvm::StringRef(Target).startswith("cxx"), DisableBroadcasting.getValue(),
-      RemoveInputTranspose.getValue(), RemoveOutputTranspose.getValue());
+      RemoveInputTranspose.getValue(), RemoveOutputTranspose.getValue(),
+      ConstantFoldingLimit.getValue());
   if (ReorderChannelLayout != ReorderChannel::ChannelOrder::None) {
     pm->AddPass<ReorderChannel>(ReorderChannelLayout ==
                                 ReorderChannel::ChannelOrder::ChannelFirst);
   }
   pm->AddPass<Fusion>(GetFusionOptions());
+  if (!Int8CalibrationFile.empty()) {
+    pm->AddPass<Quantizer>(Int8CalibrationFile.getValue());
+  }
+  // The generic runtime library has no 16-bit floating point kernels.
+  if (MixedPrecisionType != DataType::FLOAT32 && is_c_or_cxx_output) {
+    MixedPrecision::Options opts;
+    opts.data_type = MixedPrecisionType;
+    opts.keep_fp32.insert(MixedPrecisionKeepFP32.begin(),
+                          MixedPrecisionKeepFP32.end());
+    if (!MixedPrecisionRanges.empty()) {
+      opts.ranges = Quantizer::ReadCalibrationFile(MixedPrecisionRanges);
+    }
+    pm->AddPass<MixedPrecision>(opts);
+  }
+  // Merge the identical constants of the model and of the passes above.
+  pm->AddPass<ConstantDedup>();
+  // Fusion, quantization and mixed precision leave the replaced instructions
+  // and constants behind.
+  pm->AddPass<DCE>();
   if (SplitFunction) {
     pm->AddPass<Splitting>();
     pm->AddPass<DevicePlacement>();
   }
 
-  PopulateCodeGenPasses(pm, out_code, out_constants, out_header,
-                        is_c_or_cxx_output, is_binary_output);
+  PopulateCodeGenPasses(pm, out_code, out_constants, out_header, out_blob_stub,
+                        out_blob_header, is_c_or_cxx_output, is_binary_output);
 }
 
 static bool FormatCode(const std::string& filename) {
@@ -434,6 +585,36 @@ static Status ParseModels(const llvm::cl::list<std::string>& model_files,
   return Status::SUCCESS;
 }
 
+// Prints the time and peak memory of parsing.
+static void PrintParseStats(std::ostream& os,
+                            std::chrono::steady_clock::time_point start) {
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  struct rusage usage;
+  long peak_rss_kb = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << "  Parse Time: " << std::fixed << std::setprecision(3) << ms
+     << " ms  Peak RSS: " << std::setprecision(1)
+     << static_cast<double>(peak_rss_kb) / 1024 << " MB\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+
+// Prints the inter-op parallel schedule summary of each function.
+static void PrintParallelSchedules(std::ostream& os, const Module& m) {
+  for (const auto& func : m) {
+    ParallelExecutor executor(*func);
+    os << "Function " << func->GetName() << ": "
+       << executor.GetNumOfInstructions() << " instructions in "
+       << executor.GetGroups().size() << " groups, max width "
+       << executor.GetMaxWidth() << ", critical path "
+       << executor.GetCriticalPathCost() << " of " << executor.GetTotalCost()
+       << " (speedup " << executor.GetSpeedup() << "x)\n";
+  }
+}
+
 int main(int argc, char** argv) {
   llvm::cl::SetVersionPrinter(PrintVersion);
   llvm::cl::ParseCommandLineOptions(argc, argv);
@@ -446,10 +627,14 @@ int main(int argc, char** argv) {
 
   armory::Opts opts;
   Parser::Format format = Parser::Format::INVALID;
+  auto parse_start = std::chrono::steady_clock::now();
   if (ParseModels(ModelFiles, ModelFormat, EntryFunctionName, opts, &m,
                   &format) != Status::SUCCESS) {
     return 1;
   }
+  if (TimePasses) {
+    PrintParseStats(std::cerr, parse_start);
+  }
 
   if (PrintAll) {
     m.Dump();
@@ -460,9 +645,13 @@ int main(int argc, char** argv) {
   std::ofstream of_code;
   std::ofstream of_constants;
   std::ofstream of_header;
+  std::ofstream of_blob_stub;
+  std::ofstream of_blob_header;
   std::ostream* out_code = &std::cout;
   std::ostream* out_constants = &std::cout;
   std::ostream* out_header = &std::cout;
+  std::ostream* out_blob_stub = &std::cout;
+  std::ostream* out_blob_header = &std::cout;
 
   bool is_binary_output = false;
   llvm::StringRef target_name(Target);
@@ -476,7 +665,19 @@ int main(int argc, char** argv) {
     llvm::SmallString<128> data_file_name(name);
     header_file_name = name;
     is_binary_output = name.endswith(".bc") || name.endswith(".o");
-    if (EmitDataAsC) {
+    if (EmitWeightsFile && is_c_or_cxx_output) {
+      llvm::sys::path::replace_extension(data_file_name, ".weights");
+    } else if (EmitDataAsBlob && is_c_or_cxx_output) {
+      llvm::sys::path::replace_extension(data_file_name, "data.bin");
+      llvm::SmallString<128> stub_file_name(name);
+      llvm::sys::path::replace_extension(stub_file_name, "data.S");
+      of_blob_stub.open(stub_file_name.str());
+      out_blob_stub = &of_blob_stub;
+      llvm::SmallString<128> blob_header_file_name(name);
+      llvm::sys::path::replace_extension(blob_header_file_name, "data.h");
+      of_blob_header.open(blob_header_file_name.str());
+      out_blob_header = &of_blob_header;
+    } else if (EmitDataAsC) {
       llvm::sys::path::replace_extension(data_file_name, "data.cc");
     } else {
       llvm::sys::path::replace_extension(data_file_name, ".bin");
@@ -500,13 +701,25 @@ int main(int argc, char** argv) {
     }
   }
 
-  PopulatePasses(&pm, out_code, out_constants, out_header, is_c_or_cxx_output,
-                 is_binary_output, format);
+  PopulatePasses(&pm, out_code, out_constants, out_header, out_blob_stub,
+                 out_blob_header, is_c_or_cxx_output, is_binary_output, format);
   if (is_c_or_cxx_output) {
     ctx.SetTargetTriple("x86_64"); // For binary constant writer.
   }
 
+  pm.EnableTiming(TimePasses || !TimePassesTrace.empty());
+  pm.SetNumOfThreads(CompileThreads);
   auto status = pm.Run(&m);
+  if (TimePasses) {
+    pm.PrintTiming(std::cerr);
+  }
+  if (!TimePassesTrace.empty()) {
+    std::ofstream of_trace(TimePassesTrace);
+    pm.WriteChromeTrace(of_trace);
+  }
+  if (PrintParallelSchedule) {
+    PrintParallelSchedules(std::cerr, m);
+  }
 
   if (PrintAll) {
     m.Dump();
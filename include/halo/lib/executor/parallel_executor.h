@@ -0,0 +1,106 @@
+//===- parallel_executor.h --------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_EXECUTOR_PARALLEL_EXECUTOR_H_
+#define HALO_LIB_EXECUTOR_PARALLEL_EXECUTOR_H_
+
+#include <functional>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "halo/lib/ir/function.h"
+#include "halo/lib/ir/instruction.h"
+#include "halo/lib/threadpool/thread_pool.h"
+
+namespace halo {
+
+/// This class schedules the instructions of a function for inter-op
+/// parallelism. It builds a dependence DAG from the use lists and partitions
+/// the instructions into groups by their earliest start level, so that the
+/// instructions of one group do not depend on each other and can run
+/// concurrently. It also runs the instructions on a thread pool, starting
+/// each one as soon as all instructions it depends on are done.
+/// The instructions of one group must not share buffers. In particular,
+/// buffers from a MemoryPlanner built on the sequential order may overlap.
+class ParallelExecutor {
+ public:
+  /// Returns the estimated cost of an instruction.
+  using CostFunc = std::function<double(const Instruction&)>;
+  using Group = std::vector<Instruction*>;
+
+  explicit ParallelExecutor(const Function& func);
+  ParallelExecutor(const Function& func, const CostFunc& cost_func);
+
+  virtual ~ParallelExecutor() = default;
+
+  /// Returns the groups in execution order.
+  const std::vector<Group>& GetGroups() const noexcept { return groups_; }
+
+  /// Returns the index of the group of `inst`.
+  size_t GetGroupIndex(const Instruction& inst) const;
+
+  size_t GetNumOfInstructions() const noexcept { return nodes_.size(); }
+
+  /// Returns the largest number of instructions in one group.
+  size_t GetMaxWidth() const noexcept;
+
+  /// Returns the total cost, i.e., the cost of sequential execution.
+  double GetTotalCost() const noexcept { return total_cost_; }
+
+  /// Returns the cost of the most expensive dependence chain, i.e., the cost
+  /// of execution with unlimited threads.
+  double GetCriticalPathCost() const noexcept { return critical_path_cost_; }
+
+  /// Returns the speedup bound of inter-op parallelism, i.e., the total cost
+  /// divided by the critical path cost.
+  double GetSpeedup() const noexcept;
+
+  /// Calls `func` on every instruction on `pool`. An instruction starts when
+  /// all instructions it depends on are done. Returns when all are done,
+  /// without waiting for other tasks on `pool`.
+  void Run(ThreadPool* pool, const std::function<void(Instruction*)>& func);
+
+  /// Returns the number of multiply-adds of `inst` for convolution and matrix
+  /// multiplication, or the number of result elements for others.
+  static double EstimateCost(const Instruction& inst);
+
+  void Print(std::ostream& os) const;
+  void Dump() const { Print(GlobalContext::Dbgs()); }
+
+ private:
+  struct Node {
+    Instruction* inst;
+    double cost;
+    size_t num_of_preds = 0;
+    std::vector<size_t> succs;
+  };
+
+  void BuildGraph(const Function& func, const CostFunc& cost_func);
+  void ComputeSchedule();
+
+  std::vector<Node> nodes_;
+  std::unordered_map<const Instruction*, size_t> node_ids_;
+  std::vector<Group> groups_;
+  std::vector<size_t> levels_;
+  double total_cost_ = 0;
+  double critical_path_cost_ = 0;
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_EXECUTOR_PARALLEL_EXECUTOR_H_
@@ -0,0 +1,125 @@
+//===- arena.h --------------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_FRAMEWORK_ARENA_H_
+#define HALO_LIB_FRAMEWORK_ARENA_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace halo {
+
+/// This class defines a bump allocator for small IR objects that live as long
+/// as the global context, e.g. the use list nodes. Memory is carved out of
+/// large slabs. Deallocated blocks are kept on a free list per size class and
+/// handed out again by later allocations of the same size. Destructors are not
+/// run when the arena goes away, so the objects must not own other resources.
+/// It is thread-safe.
+class Arena {
+ public:
+  Arena() = default;
+  ~Arena() = default;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  Arena(Arena&&) = delete;
+  Arena& operator=(Arena&&) = delete;
+
+  /// Return a block of `size` bytes aligned to `alignof(std::max_align_t)`.
+  void* Allocate(size_t size) {
+    size = RoundUp(size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size <= kMaxRecycledSize) {
+      FreeBlock*& head = free_lists_[size / kAlignment];
+      if (head != nullptr) {
+        FreeBlock* block = head;
+        head = block->next;
+        return block;
+      }
+    }
+    if (size > static_cast<size_t>(end_ - cur_)) {
+      return AllocateSlow(size);
+    }
+    void* ret = cur_;
+    cur_ += size;
+    return ret;
+  }
+
+  /// Give back a block returned by `Allocate(size)` for reuse.
+  void Deallocate(void* ptr, size_t size) noexcept {
+    size = RoundUp(size);
+    if (ptr == nullptr || size > kMaxRecycledSize) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    FreeBlock*& head = free_lists_[size / kAlignment];
+    head = new (ptr) FreeBlock{head};
+  }
+
+  /// Construct an object of type T in the arena.
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    static_assert(alignof(T) <= kAlignment, "over-aligned type");
+    return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /// Destroy `obj` and recycle its storage.
+  template <typename T>
+  void Destroy(T* obj) noexcept {
+    if (obj != nullptr) {
+      obj->~T();
+      Deallocate(obj, sizeof(T));
+    }
+  }
+
+  /// Return the number of bytes reserved from the system.
+  size_t GetReservedBytes() const noexcept { return reserved_bytes_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+  static constexpr size_t kMaxRecycledSize = 256;
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  static size_t RoundUp(size_t size) noexcept {
+    return (std::max(size, sizeof(FreeBlock)) + kAlignment - 1) &
+           ~(kAlignment - 1);
+  }
+
+  void* AllocateSlow(size_t size);
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  char* cur_ = nullptr;
+  char* end_ = nullptr;
+  size_t reserved_bytes_ = 0;
+  std::array<FreeBlock*, kMaxRecycledSize / kAlignment + 1> free_lists_{};
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_FRAMEWORK_ARENA_H_
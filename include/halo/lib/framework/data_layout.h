@@ -57,7 +57,8 @@ class DefaultDataLayout : public DataLayout {
       }
       case DataType::INT16:
       case DataType::UINT16:
-      case DataType::FLOAT16: {
+      case DataType::FLOAT16:
+      case DataType::BFLOAT16: {
         return 16;
       }
       case DataType::INT32:
@@ -85,7 +86,8 @@ class DefaultDataLayout : public DataLayout {
     switch (dt) {
       case DataType::INT16:
       case DataType::UINT16:
-      case DataType::FLOAT16: {
+      case DataType::FLOAT16:
+      case DataType::BFLOAT16: {
         return alignof(int16_t);
       }
       case DataType::INT32:
@@ -23,6 +23,7 @@
 
 namespace halo {
 
+class Arena;
 class CodeGenObject;
 class DataLayout;
 class GlobalContextImpl;
@@ -36,9 +37,36 @@ class GlobalContext {
   GlobalContext(const GlobalContext&) = delete;
   GlobalContext& operator=(const GlobalContext&) = delete;
 
-  /// Return the current global counter.
+  /// Return the current global counter and increase it. It is thread-safe.
   uint64_t GetGlobalCounter() noexcept;
 
+  /// Make sure that the counter is not less than `id`.
+  void AdvanceGlobalCounter(uint64_t id) noexcept;
+
+  /// While an IdScope is alive, the ids handed out on the calling thread come
+  /// from the block that starts at `first_id` instead of the global counter.
+  /// Tasks that create IR objects concurrently use disjoint blocks, so that
+  /// the ids, and the names derived from them, do not depend on scheduling.
+  class IdScope {
+   public:
+    IdScope(GlobalContext& ctx, uint64_t first_id);
+    ~IdScope();
+    IdScope(const IdScope&) = delete;
+    IdScope& operator=(const IdScope&) = delete;
+
+    /// Return the id that will be handed out next.
+    uint64_t GetNextId() const noexcept { return next_id_; }
+
+   private:
+    const GlobalContext& ctx_;
+    uint64_t next_id_;
+    IdScope* prev_;
+    friend class GlobalContext;
+  };
+
+  /// Return the arena that holds the small IR objects, e.g. use list nodes.
+  Arena& GetArena() noexcept;
+
   /// Return the default data layout.
   const DataLayout& GetDefaultDataLayout() const noexcept;
 
@@ -0,0 +1,69 @@
+//===- shape_pool.h ---------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_FRAMEWORK_SHAPE_POOL_H_
+#define HALO_LIB_FRAMEWORK_SHAPE_POOL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace halo {
+
+/// This class defines a pool of uniqued shapes. Types keep the shapes with
+/// more dimensions than they store inline in one that lives as long as the
+/// process. The shapes are spread over shards by hash, each with its own
+/// lock, so types created on different threads rarely contend. It is
+/// thread-safe.
+class ShapePool {
+ public:
+  ShapePool() = default;
+  ~ShapePool() = default;
+
+  ShapePool(const ShapePool&) = delete;
+  ShapePool& operator=(const ShapePool&) = delete;
+  ShapePool(ShapePool&&) = delete;
+  ShapePool& operator=(ShapePool&&) = delete;
+
+  /// Return the uniqued copy of `shape`, which lives as long as the pool.
+  const std::vector<int64_t>* Get(const std::vector<int64_t>& shape);
+
+  /// Return the number of distinct shapes in the pool.
+  size_t GetNumOfShapes() const;
+
+ private:
+  struct Hash {
+    size_t operator()(const std::vector<int64_t>& shape) const noexcept;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    // The nodes of an unordered_set are stable, so types can hold plain
+    // pointers to the shapes.
+    std::unordered_set<std::vector<int64_t>, Hash> shapes;
+  };
+
+  static constexpr size_t kNumOfShards = 16;
+  std::array<Shard, kNumOfShards> shards_;
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_FRAMEWORK_SHAPE_POOL_H_
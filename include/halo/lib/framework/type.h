@@ -33,6 +33,64 @@ const int kDynamicBatchSize = -1;
 /// It includes a data type ID, and the dimension sizes.
 class Type final {
  public:
+  /// This class holds the immutable dimension sizes of a type. Shapes of up to
+  /// kNumOfInlineDims dimensions are stored inline, so copying a type never
+  /// allocates. Longer shapes are uniqued in a shape pool that lives as long
+  /// as the process. Either way, a type is a plain value that does not depend
+  /// on any global context.
+  class DimSizes final {
+   public:
+    using value_type = int64_t;
+    using const_iterator = const int64_t*;
+    using iterator = const_iterator;
+
+    static constexpr size_t kNumOfInlineDims = 6;
+
+    DimSizes() = default;
+    explicit DimSizes(const std::vector<int64_t>& dims);
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    const int64_t* data() const noexcept {
+      return size_ > kNumOfInlineDims ? large_->data() : inline_;
+    }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size_; }
+    int64_t operator[](size_t d) const noexcept { return data()[d]; }
+    int64_t front() const noexcept { return data()[0]; }
+    int64_t back() const noexcept { return data()[size_ - 1]; }
+
+    /// Return a copy as a vector, e.g. to build a modified shape.
+    operator std::vector<int64_t>() const { return {begin(), end()}; }
+
+    friend bool operator==(const DimSizes& lhs, const DimSizes& rhs) noexcept;
+    friend bool operator==(const DimSizes& lhs,
+                           const std::vector<int64_t>& rhs) noexcept;
+    friend bool operator==(const std::vector<int64_t>& lhs,
+                           const DimSizes& rhs) noexcept {
+      return rhs == lhs;
+    }
+    friend bool operator!=(const DimSizes& lhs, const DimSizes& rhs) noexcept {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const DimSizes& lhs,
+                           const std::vector<int64_t>& rhs) noexcept {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const std::vector<int64_t>& lhs,
+                           const DimSizes& rhs) noexcept {
+      return !(rhs == lhs);
+    }
+
+   private:
+    size_t size_ = 0;
+    union {
+      int64_t inline_[kNumOfInlineDims] = {};
+      // The uniqued shape if there are more than kNumOfInlineDims dimensions.
+      const std::vector<int64_t>* large_;
+    };
+  };
+
   /// The default constructor creates a scalar type which is
   /// DataType::INVALID.
   Type() : Type(DataType::INVALID) {}
@@ -66,7 +124,7 @@ class Type final {
     return shape_[d];
   }
 
-  const std::vector<int64_t>& GetDimSizes() const noexcept { return shape_; }
+  const DimSizes& GetDimSizes() const noexcept { return shape_; }
 
   DataType GetDataType() const noexcept { return data_type_id_; }
 
@@ -107,7 +165,8 @@ class Type final {
   }
 
   static bool IsFloatingPointType(const DataType& dt) {
-    return (dt == DataType::FLOAT16 || dt == DataType::FLOAT32);
+    return (dt == DataType::FLOAT16 || dt == DataType::BFLOAT16 ||
+            dt == DataType::FLOAT32);
   }
 
   static std::string DataTypeToString(DataType dt);
@@ -129,7 +188,7 @@ class Type final {
   ///
   /// The shape of a scalar type is empty, and the total number
   /// of elements is one.
-  std::vector<int64_t> shape_;
+  DimSizes shape_;
 };
 
 template <>
@@ -18,6 +18,8 @@
 #ifndef HALO_LIB_IR_CONSTANT_H_
 #define HALO_LIB_IR_CONSTANT_H_
 
+#include <memory>
+
 #include "halo/lib/framework/data_layout.h"
 #include "halo/lib/ir/values.h"
 
@@ -36,6 +38,14 @@ class Constant : public IRObject {
                     const Type& type, const DataLayout& data_layout,
                     const void* data_ptr, bool do_splat = false);
 
+  /// Create a constant object that refers to the data at `data_ptr` instead of
+  /// copying it, e.g., a memory-mapped weights file. `owner` keeps the data
+  /// alive while the constant refers to it. The data is copied the first time
+  /// it is accessed through a non-const pointer.
+  explicit Constant(GlobalContext& context, const std::string& name,
+                    const Type& type, const DataLayout& data_layout,
+                    const void* data_ptr, std::shared_ptr<const void> owner);
+
   /// Returns the parent object that could be a Module or a Function.
   IRObject* GetParent() const noexcept { return parent_; }
 
@@ -45,7 +55,7 @@ class Constant : public IRObject {
     const Type& type = GetResultType(0);
     (void)type;
     HLCHECK(Type::HasNativeType<T>(type));
-    return static_cast<const T*>(static_cast<const void*>(data_.data()));
+    return static_cast<const T*>(GetRawDataPtr());
   }
 
   /// Get the pointer to the data.
@@ -54,12 +64,17 @@ class Constant : public IRObject {
     const Type& type = GetResultType();
     (void)type;
     HLCHECK(Type::HasNativeType<T>(type));
-    return static_cast<T*>(static_cast<void*>(data_.data()));
+    return static_cast<T*>(GetRawDataPtr());
+  }
+
+  const void* GetRawDataPtr() const {
+    return external_data_ != nullptr ? external_data_ : data_.data();
   }
 
-  const void* GetRawDataPtr() const { return data_.data(); }
+  void* GetRawDataPtr();
 
-  void* GetRawDataPtr() { return data_.data(); }
+  /// Returns true if the constant refers to data it does not own.
+  bool IsExternal() const noexcept { return external_data_ != nullptr; }
 
   size_t GetElementSizeInBytes() const noexcept {
     return data_layout_.Bytes(GetResultType().GetDataType());
@@ -111,6 +126,8 @@ class Constant : public IRObject {
   IRObject* parent_ = nullptr;
   const DataLayout& data_layout_;
   std::vector<unsigned char> data_;
+  const unsigned char* external_data_ = nullptr;
+  std::shared_ptr<const void> external_owner_;
 
   friend class ConstantBuilder;
 };
@@ -0,0 +1,66 @@
+//===- constant_pool.h ------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_IR_CONSTANT_POOL_H_
+#define HALO_LIB_IR_CONSTANT_POOL_H_
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "halo/lib/ir/constant.h"
+
+namespace halo {
+
+/// This class groups constants by their contents. Constants of the same type
+/// with the same bytes share one payload, e.g., the repeated bias tensors of a
+/// model, or the weights that the functions created by splitting or by
+/// parsing several models have in common. The first constant added with a
+/// given payload is its canonical constant. Constant writers emit the data of
+/// canonical constants only and make the others refer to it.
+class ConstantPool {
+ public:
+  ConstantPool() = default;
+
+  /// Add `constant` and return the canonical constant with its contents,
+  /// which is `constant` itself if the payload is new.
+  Constant* Insert(Constant* constant);
+
+  /// Return the canonical constant of `constant`, which must be in the pool.
+  Constant* GetCanonical(const Constant* constant) const;
+
+  bool IsCanonical(const Constant* constant) const {
+    return GetCanonical(constant) == constant;
+  }
+
+  /// Return the number of distinct payloads.
+  size_t GetNumOfPayloads() const noexcept { return num_of_payloads_; }
+
+  /// Return the size in bytes of the data of `constant`.
+  static size_t GetSizeInBytes(const Constant& constant);
+
+ private:
+  static size_t Hash(const Constant& constant);
+  static bool HasSameContents(const Constant& lhs, const Constant& rhs);
+
+  std::unordered_multimap<size_t, Constant*> payloads_;
+  std::unordered_map<const Constant*, Constant*> canonical_;
+  size_t num_of_payloads_ = 0;
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_IR_CONSTANT_POOL_H_
@@ -200,6 +200,12 @@ class ConstantBuilder final
   Constant* CreateConstant(const std::string& name, const Type& type,
                            const DataLayout& data_layout, const void* data_ptr);
 
+  /// Create a new constant that refers to the data at `data_ptr` without
+  /// copying it. `owner` keeps the data alive.
+  Constant* CreateExternalConstant(const std::string& name, const Type& type,
+                                   const void* data_ptr,
+                                   std::shared_ptr<const void> owner);
+
   /// Create a new constant from a vector of trivial types.
   template <typename T>
   Constant* CreateConstant(const std::string& name, const Type& type,
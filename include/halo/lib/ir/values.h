@@ -20,10 +20,11 @@
 
 #include <functional>
 #include <iostream>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "halo/lib/framework/global_context.h"
@@ -76,10 +77,18 @@ class Value {
 /// of the base Value class.
 /// A use instance indicates the use value, and its operand indice,
 /// indicating as <IRObject* use_, int use_operand_idx_>.
+/// The uses of a value are linked together intrusively. The nodes are owned
+/// by the operand slots of the user and live in the global context's arena.
 class Use final : public Value {
  public:
   Use() = delete;
   explicit Use(IRObject* obj, int idx) : Value(obj, idx) {}
+  // Copies are not linked into any list.
+  Use(const Use& other) : Value(other) {}
+  Use& operator=(const Use& other) {
+    Value::operator=(other);
+    return *this;
+  }
 
   ~Use() = default;
 
@@ -87,68 +96,140 @@ class Use final : public Value {
   IRObject* GetUse() const noexcept { return GetOwner(); }
   /// Return the use operand index.
   int GetUseOperandIdx() const noexcept { return GetIdx(); }
+
+ private:
+  Use* prev_ = nullptr;
+  Use* next_ = nullptr;
+  friend class UseList;
 };
 
 /// This class defines a use list of a value.
-/// It is typically a very short list (std::list is fine).
+/// It is an intrusive doubly linked list of the Use nodes held by the users,
+/// so adding or removing a use through its node never allocates.
 class UseList {
  public:
   UseList() = default;
   ~UseList() = default;
+  UseList(const UseList&) = delete;
+  UseList& operator=(const UseList&) = delete;
+  UseList(UseList&& other) noexcept
+      : head_(other.head_), tail_(other.tail_), size_(other.size_) {
+    other.head_ = other.tail_ = nullptr;
+    other.size_ = 0;
+  }
+  UseList& operator=(UseList&& other) noexcept {
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
 
-  /// Return the uses list.
-  std::list<Use>& GetUses() noexcept { return uses_; }
-  const std::list<Use>& GetUses() const noexcept { return uses_; }
+  /// Return a copy of the uses.
+  std::vector<Use> GetUses() const { return std::vector<Use>(begin(), end()); }
 
   /// Return the number of uses.
-  size_t GetNumOfUses() const noexcept { return uses_.size(); }
+  size_t GetNumOfUses() const noexcept { return size_; }
 
   /// Return true if the list has some uses.
-  bool HasUses() const noexcept { return !uses_.empty(); }
+  bool HasUses() const noexcept { return size_ != 0; }
 
   /// Return true if the list has only one use.
-  bool HasOneUse() const noexcept { return uses_.size() == 1; }
+  bool HasOneUse() const noexcept { return size_ == 1; }
 
-  /// Add a use.
-  void AddUse(const Use& u) { uses_.push_back(u); }
+  /// Append a use node that is not in any list.
+  void AddUse(Use* u) noexcept;
 
-  /// Return true if it removes a use successfully.
-  bool RemoveUse(const Use& u) noexcept;
+  /// Unlink a use node from this list.
+  void RemoveUse(Use* u) noexcept;
 
   /// Return true if it contains a specifi use.
-  bool HasUse(const Use& u) noexcept;
+  bool HasUse(const Use& u) const noexcept;
+
+  template <typename T>
+  class Iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = Use;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    Iterator() = default;
+    Iterator(Use* node, const UseList* list) : node_(node), list_(list) {}
+    // Allow the conversion from iterator to const_iterator.
+    template <typename U>
+    Iterator(const Iterator<U>& other)  // NOLINT
+        : node_(other.node_), list_(other.list_) {}
+
+    reference operator*() const { return *node_; }
+    pointer operator->() const { return node_; }
+    Iterator& operator++() {
+      node_ = UseList::GetNext(node_);
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+    Iterator& operator--() {
+      node_ = node_ == nullptr ? list_->tail_ : UseList::GetPrev(node_);
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator it = *this;
+      --*this;
+      return it;
+    }
+    bool operator==(const Iterator& other) const {
+      return node_ == other.node_;
+    }
+    bool operator!=(const Iterator& other) const {
+      return node_ != other.node_;
+    }
+
+   private:
+    template <typename U>
+    friend class Iterator;
+    Use* node_ = nullptr;
+    const UseList* list_ = nullptr;
+  };
 
   // Iteration over the uses in the list.
-  using iterator = std::list<Use>::iterator;
-  using const_iterator = std::list<Use>::const_iterator;
-  using reverse_iterator = std::list<Use>::reverse_iterator;
-  using const_reverse_iterator = std::list<Use>::const_reverse_iterator;
+  using iterator = Iterator<Use>;
+  using const_iterator = Iterator<const Use>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
   /// UseList iterator methods.
   ///
-  inline iterator begin() noexcept { return uses_.begin(); }
-  inline const_iterator begin() const noexcept { return uses_.begin(); }
-  inline iterator end() noexcept { return uses_.end(); }
-  inline const_iterator end() const noexcept { return uses_.end(); }
-  inline reverse_iterator rbegin() noexcept { return uses_.rbegin(); }
+  inline iterator begin() noexcept { return {head_, this}; }
+  inline const_iterator begin() const noexcept { return {head_, this}; }
+  inline iterator end() noexcept { return {nullptr, this}; }
+  inline const_iterator end() const noexcept { return {nullptr, this}; }
+  inline reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
   inline const_reverse_iterator rbegin() const noexcept {
-    return uses_.rbegin();
+    return const_reverse_iterator(end());
+  }
+  inline reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  inline const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
   }
-  inline reverse_iterator rend() noexcept { return uses_.rend(); }
-  inline const_reverse_iterator rend() const noexcept { return uses_.rend(); }
 
-  inline size_t size() const noexcept { return uses_.size(); }
-  inline bool empty() const noexcept { return uses_.empty(); }
-  inline const Use& front() const { return uses_.front(); }
-  inline Use& front() { return uses_.front(); }
-  inline const Use& back() const { return uses_.back(); }
-  inline Use& back() { return uses_.back(); }
+  inline size_t size() const noexcept { return size_; }
+  inline bool empty() const noexcept { return size_ == 0; }
+  inline const Use& front() const { return *head_; }
+  inline Use& front() { return *head_; }
+  inline const Use& back() const { return *tail_; }
+  inline Use& back() { return *tail_; }
 
  private:
-  std::list<Use> uses_;
+  static Use* GetNext(const Use* u) noexcept { return u->next_; }
+  static Use* GetPrev(const Use* u) noexcept { return u->prev_; }
 
-  /// Return the list iterator of a use.
-  iterator GetIterator(const Use& u) noexcept;
+  Use* head_ = nullptr;
+  Use* tail_ = nullptr;
+  size_t size_ = 0;
 };
 
 /// This class defines a value def. It is simple a wrapper of
@@ -404,6 +485,10 @@ class IRObject {
   // Operands
   std::vector<Def> operands_;
 
+  // The use nodes of the operands, allocated from the context's arena. A slot
+  // is null until a non-null def is set.
+  std::vector<Use*> operand_uses_;
+
   // Dynamic type flag
   bool has_dynamic_type_ = false;
 
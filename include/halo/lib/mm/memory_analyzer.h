@@ -30,6 +30,8 @@ namespace halo {
 class MemoryAnalyzer {
  public:
   explicit MemoryAnalyzer(const Module& m);
+  /// Analyzes `func` alone, for code generators that emit it on its own.
+  explicit MemoryAnalyzer(const Function& func);
 
   virtual ~MemoryAnalyzer() = default;
 
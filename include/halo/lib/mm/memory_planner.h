@@ -0,0 +1,118 @@
+//===- memory_planner.h -----------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_MM_MEMORY_PLANNER_H_
+#define HALO_LIB_MM_MEMORY_PLANNER_H_
+
+#include <functional>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "halo/lib/ir/function.h"
+#include "halo/lib/ir/instruction.h"
+
+namespace halo {
+
+/// This class statically plans the memory of all non-weight values of a
+/// function. Based on the liveness interval of each value, it assigns every
+/// value an offset inside one pre-sized workspace so that values with
+/// non-overlapping lifetimes can share the same memory.
+/// Unless `in_place` is false, elementwise instructions whose input dies at
+/// the instruction are executed in-place, i.e., their result shares the buffer
+/// of the input.
+class MemoryPlanner {
+ public:
+  /// The order in which buffers are placed. Both policies place a buffer into
+  /// the smallest free gap that fits it.
+  enum class Policy {
+    BestFit,      // Place buffers in program order.
+    GreedyBySize, // Place buffers in decreasing size order.
+  };
+
+  /// Returns true if `def` should get an offset in the workspace.
+  using Filter = std::function<bool(const Def&)>;
+
+  static constexpr size_t DefaultAlignment = 64;
+
+  explicit MemoryPlanner(const Function& func,
+                         Policy policy = Policy::GreedyBySize,
+                         size_t alignment = DefaultAlignment,
+                         bool in_place = true);
+  MemoryPlanner(const Function& func, const Filter& filter,
+                Policy policy = Policy::GreedyBySize,
+                size_t alignment = DefaultAlignment, bool in_place = true);
+
+  virtual ~MemoryPlanner() = default;
+
+  /// Returns the size in bytes of the workspace required by the function.
+  size_t GetWorkspaceSize() const noexcept { return workspace_size_; }
+  /// Returns the total bytes that would be used without sharing.
+  size_t GetUnplannedSize() const noexcept { return unplanned_size_; }
+  /// Returns the number of distinct buffers.
+  size_t GetNumOfBuffers() const noexcept { return buffers_.size(); }
+  /// Returns true if `def` is assigned an offset in the workspace.
+  bool HasOffset(const Def& def) const noexcept;
+  /// Returns the offset in bytes of `def` in the workspace.
+  size_t GetOffset(const Def& def) const;
+  /// Returns true if `def` shares the buffer of one of its operands.
+  bool IsAliased(const Def& def) const noexcept;
+  /// Returns true if `inst` writes its result over its first operand.
+  bool IsInPlace(const Instruction& inst) const noexcept;
+
+  void Print(std::ostream& os) const;
+  void Dump() const { Print(GlobalContext::Dbgs()); }
+
+ private:
+  struct Buffer {
+    size_t size = 0;
+    // The liveness interval [start, end] in terms of instruction index.
+    size_t start = 0;
+    size_t end = 0;
+    size_t offset = 0;
+    std::vector<Def> defs;
+  };
+
+  // Returns the operand index whose buffer is reused by `inst`, or -1 if
+  // `inst` needs its own buffer.
+  static int GetAliasedOperand(const Instruction& inst);
+  // Returns true if `inst` is an elementwise instruction that can safely
+  // write its result over its first operand.
+  static bool IsInPlaceCandidate(const Instruction& inst);
+  // Returns true if the buffer of `def` is not used after position `pos`.
+  bool IsDeadAfter(const Def& def, size_t pos) const;
+  void ComputeLiveness(const Function& func);
+  void AssignOffsets();
+
+  Filter filter_;
+  Policy policy_;
+  size_t alignment_;
+  bool in_place_;
+  std::vector<Buffer> buffers_;
+  std::unordered_map<Def, size_t> def2buf_;
+  std::unordered_map<Def, Def> aliases_;
+  std::unordered_set<const Instruction*> in_place_insts_;
+  // The position of the last use of each def.
+  std::unordered_map<Def, size_t> last_uses_;
+  size_t workspace_size_ = 0;
+  size_t unplanned_size_ = 0;
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_MM_MEMORY_PLANNER_H_
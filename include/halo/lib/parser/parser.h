@@ -18,6 +18,7 @@
 #ifndef HALO_LIB_PARSER_PARSER_H_
 #define HALO_LIB_PARSER_PARSER_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -59,6 +60,26 @@ class Parser {
                       const armory::Opts& opts);
 };
 
+/// A read-only memory mapping of a whole file. Parsers read models through it
+/// and constants may refer to it directly, so it is shared by its users.
+class MappedFile {
+ public:
+  /// Maps `file_name` into memory. Returns nullptr on failure.
+  static std::shared_ptr<MappedFile> Open(const std::string& file_name);
+  ~MappedFile();
+
+  const char* GetData() const noexcept { return data_; }
+  size_t GetSize() const noexcept { return size_; }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+ private:
+  MappedFile(const char* data, size_t size) : data_(data), size_(size) {}
+  const char* data_;
+  size_t size_;
+};
+
 template <typename T>
 class Tensor {
  public:
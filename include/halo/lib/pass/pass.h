@@ -27,6 +27,8 @@
 
 namespace halo {
 
+class ThreadPool;
+
 // An abstract interface for run optimization.
 class Pass {
  public:
@@ -42,6 +44,10 @@ class Pass {
   virtual ~Pass() = default;
 
   virtual bool IsPassManager() const noexcept { return false; }
+  /// Returns true if the pass can run on different functions at the same
+  /// time, i.e., it keeps no state across calls and only touches the IR of
+  /// the function it runs on.
+  virtual bool CanRunConcurrently() const noexcept { return false; }
   const std::string& Name() const noexcept { return name_; }
   virtual void Print(std::ostream& os) const { os << name_ << "\n"; }
 
@@ -55,6 +61,16 @@ class ModulePass : public Pass {
   static constexpr PassType Type = PassType::MODULE;
   explicit ModulePass(const std::string& name) : Pass(name) {}
   virtual bool RunOnModule(Module* module) = 0;
+
+  /// Set the thread pool that the pass may use to work on several functions
+  /// at the same time, or nullptr to run serially.
+  void SetThreadPool(ThreadPool* pool) noexcept { pool_ = pool; }
+
+ protected:
+  ThreadPool* GetThreadPool() const noexcept { return pool_; }
+
+ private:
+  ThreadPool* pool_ = nullptr;
 };
 
 class FunctionPass : public Pass {
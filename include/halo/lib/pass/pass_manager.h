@@ -21,6 +21,8 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "halo/lib/framework/global_context.h"
 #include "halo/lib/ir/module.h"
@@ -31,6 +33,25 @@ namespace halo {
 class FunctionPassManager;
 class PassManagerImpl;
 
+/// Compile-time statistics of a pass, collected when timing is enabled.
+struct PassStatistics {
+  std::string name;
+  /// 0 for module passes, 1 and 2 for the passes run by the function and
+  /// basic block pass managers.
+  int depth = 0;
+  /// Number of times the pass was run.
+  size_t calls = 0;
+  /// Number of fixed-point iterations. Only pass managers iterate.
+  size_t iterations = 0;
+  double wall_time_ms = 0;
+  /// Number of instructions in the IR unit before and after each call,
+  /// summed over all calls.
+  size_t insts_before = 0;
+  size_t insts_after = 0;
+  /// Peak resident set size of the process after the last call, in KB.
+  long peak_rss_kb = 0;
+};
+
 // A class that manages all IR transformation passes.
 class PassManager final {
  public:
@@ -54,6 +75,23 @@ class PassManager final {
 
   void Dump() const;
 
+  /// Collect per-pass timing and memory statistics in Run().
+  void EnableTiming(bool enable = true);
+
+  /// Run function passes on up to `n` functions at the same time. It only
+  /// applies to groups of passes that can all run concurrently, and not
+  /// while timing is enabled. The result is the same as a serial run.
+  void SetNumOfThreads(int n);
+
+  /// Returns the statistics of all passes in the order they first ran.
+  const std::vector<PassStatistics>& GetStatistics() const;
+
+  /// Print the statistics as a table.
+  void PrintTiming(std::ostream& os) const;
+
+  /// Write every pass call as an event in Chrome trace JSON format.
+  void WriteChromeTrace(std::ostream& os) const;
+
  private:
   Pass* Add(std::unique_ptr<ModulePass> pass);
   Pass* Add(std::unique_ptr<FunctionPass> pass);
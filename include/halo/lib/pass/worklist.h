@@ -0,0 +1,119 @@
+//===- worklist.h -----------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_PASS_WORKLIST_H_
+#define HALO_LIB_PASS_WORKLIST_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "halo/lib/pass/pass.h"
+
+namespace halo {
+
+/// This class defines a worklist of the instructions of a basic block. An
+/// instruction is in the list at most once. Instructions are popped in LIFO
+/// order. Instructions of other basic blocks are ignored.
+class InstWorklist {
+ public:
+  explicit InstWorklist(const BasicBlock* bb) : bb_(bb) {}
+
+  /// Add `inst` if it is not in the list yet.
+  void Push(Instruction* inst);
+
+  /// Add all instructions such that they are popped in program order.
+  void PushAll();
+
+  /// Add the instructions that use any result of `obj`.
+  void PushUsers(const IRObject& obj);
+
+  /// Add the instructions that define the operands of `obj`.
+  void PushOperands(const IRObject& obj);
+
+  /// Remove and return the last added instruction.
+  Instruction* Pop();
+
+  /// Remove `inst` from the list, e.g. before it is deleted.
+  void Remove(const Instruction* inst);
+
+  bool IsEmpty() const noexcept { return indices_.empty(); }
+
+ private:
+  const BasicBlock* bb_;
+  std::vector<Instruction*> list_;
+  std::unordered_map<const Instruction*, size_t> indices_;
+};
+
+/// This class is the base of basic block passes that reach their fixed point
+/// through a worklist instead of rescanning the basic block. Every
+/// instruction is visited once in program order. When a visit rewrites the
+/// IR, only the affected instructions are visited again: the users of
+/// replaced values, the replacements and the operands of the rewritten
+/// instruction. The total work is thus proportional to the number of
+/// rewrites rather than to the number of instructions times the depth of
+/// the graph.
+class WorklistPass : public BasicBlockPass {
+ public:
+  /// If `erase_dead` is true, instructions without uses (other than returns)
+  /// are deleted as soon as they are popped from the worklist.
+  explicit WorklistPass(const std::string& name, bool erase_dead = false)
+      : BasicBlockPass(name), erase_dead_(erase_dead) {}
+
+  bool RunOnBasicBlock(BasicBlock* bb) final;
+
+ protected:
+  /// Called before the instructions are visited. Returns true if it changed
+  /// the IR.
+  virtual bool Initialize(BasicBlock* bb) { return false; }
+
+  /// Visit `inst`. Returns true if it changed the IR. Replacements should go
+  /// through `ReplaceAllUsesWith()` and other rewrites should be reported
+  /// with `AddToWorklist()`.
+  virtual bool Visit(Instruction* inst) = 0;
+
+  /// Called after the worklist is drained. Returns true if it changed the IR.
+  virtual bool Finalize(BasicBlock* bb) { return false; }
+
+  /// Replace the uses of the `idx`-th result of `inst` with `new_def` and
+  /// revisit the affected instructions.
+  void ReplaceAllUsesWith(Instruction* inst, size_t idx, const Def& new_def);
+
+  /// Replace the uses of the results of `inst` with `new_defs` and revisit
+  /// the affected instructions.
+  void ReplaceAllUsesWith(Instruction* inst, const std::vector<Def>& new_defs);
+
+  /// Revisit `inst` and its neighbors after it was changed in place.
+  void AddToWorklist(Instruction* inst);
+
+ private:
+  struct RunState;
+
+  // Queue the instructions created by a visit that `def` depends on.
+  static void PushNewInstructions(RunState* state, const Def& def);
+  // Delete `inst` if it is dead. Returns true if it was deleted.
+  static bool EraseIfDead(RunState* state, Instruction* inst);
+
+  const bool erase_dead_;
+  // The state of the run on the calling thread. It is not a member so that a
+  // pass can run on several functions concurrently.
+  static thread_local RunState* run_state_;
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_PASS_WORKLIST_H_
@@ -0,0 +1,59 @@
+//===- quantizer.h --------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_QUANTIZER_QUANTIZER_H_
+#define HALO_LIB_QUANTIZER_QUANTIZER_H_
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "halo/lib/pass/pass.h"
+
+namespace halo {
+
+/// This pass quantizes Conv2D, Gemm and MatMul with constant float weights to
+/// INT8 after calibration. The input is quantized per tensor with the range
+/// observed during calibration. The weights are quantized per output channel
+/// and the bias to INT32. The INT32 result is dequantized to FLOAT32 right
+/// away, so the rest of the graph is unchanged.
+class Quantizer final : public BasicBlockPass {
+ public:
+  /// The [min, max] range of each value observed during calibration, keyed by
+  /// the value id in the generated code.
+  using Ranges = std::unordered_map<std::string, std::pair<float, float>>;
+
+  explicit Quantizer(const Ranges& ranges)
+      : BasicBlockPass("INT8 Quantizer"), ranges_(ranges) {}
+
+  /// Reads the ranges from a calibration file, which has one "<id> <min>
+  /// <max>" line per value. It is written by the ODLA Eigen platform when
+  /// `ODLA_CALIBRATION_FILE` is set.
+  explicit Quantizer(const std::string& calibration_file)
+      : Quantizer(ReadCalibrationFile(calibration_file)) {}
+
+  bool RunOnBasicBlock(BasicBlock* bb) override;
+
+  static Ranges ReadCalibrationFile(const std::string& file_name);
+
+ private:
+  Ranges ranges_;
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_QUANTIZER_QUANTIZER_H_
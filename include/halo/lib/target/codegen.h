@@ -74,6 +74,7 @@ class CodeGen : public ModulePass {
           {OpCode::SLICE, "_sn_rt_slice"},
           {OpCode::TRANSPOSE, "_sn_rt_transpose"},
           {OpCode::SITOFP, "_sn_rt_sitofp"},
+          {OpCode::FPTOFP, "_sn_rt_fptofp"},
           {OpCode::SQRT, "_sn_rt_sqrt"},
           {OpCode::ARGMAX, "_sn_rt_argmax"},
       };
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -32,6 +33,7 @@
 #include "halo/lib/ir/nn_activation_instructions.h"
 #include "halo/lib/ir/nn_cnn_instructions.h"
 #include "halo/lib/mm/memory_analyzer.h"
+#include "halo/lib/mm/memory_planner.h"
 #include "halo/lib/target/codegen.h"
 
 namespace halo {
@@ -53,6 +55,15 @@ struct Opts {
   CodeGen::ExecMode exec_mode = CodeGen::ExecMode::Compile;
   bool emit_inference_func_sig = false;
   bool emit_dynamic_batch = false;
+  // The batch sizes that a dynamic batch computation is optimized for.
+  int min_batch_size = 1;
+  int max_batch_size = 8;
+  int opt_batch_size = 4;
+  // Bind constants from a memory-mapped weights file instead of linking them.
+  bool emit_weights_file = false;
+  // Directory where the generated code stores the built computation and
+  // loads it from on later runs. Empty to always build it.
+  std::string exec_cache_dir;
 };
 
 struct CXXType {
@@ -79,6 +90,7 @@ class CXXValue {
   void Normalize(const std::string& n);
 
   inline static std::unordered_map<std::string, size_t> name2id;
+  inline static std::mutex name2id_mutex;
 };
 
 // The generic CXX compiler, which is a module pass.
@@ -95,6 +107,15 @@ class GenericCXXCodeGen : public CodeGen {
  protected:
   virtual void RunOnFunction(Function& function);
   virtual void RunOnHostFunction(Function& function);
+  /// Returns a code generator of the same kind and configuration that writes
+  /// one function to `os` and `header_os`. Derived classes that change how
+  /// instructions are emitted have to override it, or functions are emitted
+  /// serially.
+  virtual std::unique_ptr<GenericCXXCodeGen> CreateFunctionEmitter(
+      std::ostream& os, std::ostream& header_os) const;
+  /// Emits `funcs` in parallel into buffers of their own, which are written
+  /// out in the order of `funcs`.
+  void RunOnFunctionsConcurrently(const std::vector<Function*>& funcs);
   virtual void RunOnConstant(Constant& constant, bool decl);
   virtual void RunOnBasicBlock(BasicBlock& bb);
   void PreRunOnInstruction(Instruction*);
@@ -113,6 +134,7 @@ class GenericCXXCodeGen : public CodeGen {
   virtual void RunOnInstruction(ExpInst*) override;
   virtual void RunOnInstruction(FloorInst*) override;
   virtual void RunOnInstruction(FPtoSIInst*) override;
+  virtual void RunOnInstruction(FPtoFPInst*) override;
   virtual void RunOnInstruction(LeakyReluInst*) override;
   virtual void RunOnInstruction(SqrtInst*) override;
   virtual void RunOnInstruction(RsqrtInst*) override;
@@ -129,6 +151,8 @@ class GenericCXXCodeGen : public CodeGen {
   virtual void RunOnInstruction(PadInst*) override;
   virtual void RunOnInstruction(PoolingMaxInst*) override;
   virtual void RunOnInstruction(PoolingAvgInst*) override;
+  virtual void RunOnInstruction(QuantizeInst*) override;
+  virtual void RunOnInstruction(DequantizeInst*) override;
   virtual void RunOnInstruction(ReduceMeanInst*) override;
   virtual void RunOnInstruction(ReluInst*) override;
   virtual void RunOnInstruction(Relu6Inst*) override;
@@ -152,12 +176,14 @@ class GenericCXXCodeGen : public CodeGen {
 
   void EmitODLAArgs(const std::vector<int32_t>& arg);
   void EmitODLAArgs(const std::vector<uint32_t>& arg);
+  void EmitODLAArgs(const std::vector<float>& arg);
   void EmitODLAArgs(const std::vector<CXXValue>& arg);
   void EmitODLAArgs(const halo::Type& arg);
   void EmitODLAArgs(const DataType& arg);
   void EmitODLAArgs(const CXXValue& arg);
   void EmitODLAArgs(const bool& arg);
   void EmitODLAArgs(const DataFormat& arg);
+  void EmitODLAArgs(const ActivationType& arg);
 
   template <typename T>
   void EmitODLAArgs(const T& arg) {
@@ -207,6 +233,9 @@ class GenericCXXCodeGen : public CodeGen {
     }
     return ss.str();
   }
+  inline static std::string Join(const Type::DimSizes& dims, char sep = ',') {
+    return Join(std::vector<int64_t>(dims), sep);
+  }
   template <typename T>
   inline static std::string Join(T value) {
     std::ostringstream ss;
@@ -226,6 +255,9 @@ class GenericCXXCodeGen : public CodeGen {
   GlobalContext* ctx_ = nullptr;
   std::unordered_map<Def, CXXValue> ir_mapping_;
   std::unique_ptr<MemoryAnalyzer> memory_analyzer_;
+  // Planned offsets of the current function's buffers in its workspace.
+  std::unique_ptr<MemoryPlanner> memory_planner_;
+  std::string workspace_name_;
   Opts opts_;
 };
 
@@ -240,6 +272,31 @@ class GenericCXXConstantWriter : public GenericCXXCodeGen {
   void static RunOnConstant(const Constant& constant, std::ostream* os);
 };
 
+/// This pass writes the constants as one raw binary blob instead of textual
+/// arrays, which are slow to compile for large models. Each constant is at an
+/// offset aligned to `Alignment`. It also writes an assembler stub, which
+/// embeds the blob with `.incbin` and defines the symbol of each constant
+/// that the generated code refers to, and a header with the offsets. The
+/// stub is for ELF targets.
+class GenericCXXBlobConstantWriter : public GenericCXXCodeGen {
+ public:
+  virtual ~GenericCXXBlobConstantWriter() = default;
+  /// `blob_file_name` is the file name of the blob in the `.incbin`
+  /// directive, which the assembler looks up in its include paths.
+  explicit GenericCXXBlobConstantWriter(std::ostream& blob_os,
+                                        std::ostream& stub_os,
+                                        std::ostream& header_os,
+                                        const std::string& blob_file_name);
+
+  bool RunOnModule(Module* module) override;
+
+  static constexpr uint64_t Alignment = 64;
+
+ private:
+  std::ostream& stub_os_;
+  std::string blob_file_name_;
+};
+
 } // end namespace halo.
 
 #endif // HALO_LIB_TARGET_GENERIC_CXX_GENERIC_CXX_CODEGEN_H_
@@ -18,8 +18,10 @@
 #ifndef HALO_LIB_TARGET_GENERIC_LLVMIR_GENERIC_LLVMIR_CODEGEN_H_
 #define HALO_LIB_TARGET_GENERIC_LLVMIR_GENERIC_LLVMIR_CODEGEN_H_
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "halo/lib/framework/global_context.h"
 #include "halo/lib/ir/common_instructions.h"
@@ -27,6 +29,7 @@
 #include "halo/lib/ir/instruction.h"
 #include "halo/lib/ir/nn_activation_instructions.h"
 #include "halo/lib/ir/nn_cnn_instructions.h"
+#include "halo/lib/mm/memory_planner.h"
 #include "halo/lib/target/codegen.h"
 
 // Forward declaration here to avoid the need of LLVM header files for API
@@ -37,6 +40,7 @@ class CallInst;
 class ConstantFolder;
 class Function;
 class FunctionCallee;
+class GlobalVariable;
 class IRBuilderDefaultInserter;
 template <typename T, typename Inserter>
 class IRBuilder;
@@ -62,6 +66,12 @@ class GenericLLVMIRCodeGen : public CodeGen {
     DefinedAsGlobal          // external, constant, with initializer.
   };
 
+  /// How instructions are lowered when both lowerings are available.
+  enum class LoweringMode {
+    RuntimeCall, // call the kernels of the runtime library.
+    LoopNest,    // emit shape-specialized loop nests and optimize the module.
+  };
+
   GenericLLVMIRCodeGen();
   GenericLLVMIRCodeGen(ConstantDataStorage constant_data_storage);
 
@@ -71,8 +81,14 @@ class GenericLLVMIRCodeGen : public CodeGen {
 
   bool RunOnModule(Module* module) override;
 
+  void SetLoweringMode(LoweringMode mode) noexcept { lowering_mode_ = mode; }
+
  protected:
   virtual void RunOnFunction(Function& function);
+  // Emits `void <func>_init(int64_t num_threads)`, which sets the number of
+  // threads of the runtime library. A non-positive value selects
+  // $HALO_NUM_THREADS or the number of hardware threads.
+  virtual void EmitInitFunction(const Function& function);
   virtual void RunOnConstant(Constant& constant);
   virtual void RunOnBasicBlock(llvm::Function* llvm_func, BasicBlock& bb);
   virtual llvm::TargetMachine* InitTargetMachine();
@@ -91,6 +107,7 @@ class GenericLLVMIRCodeGen : public CodeGen {
   virtual void RunOnInstruction(ReshapeInst*) override;
   virtual void RunOnInstruction(ReturnInst*) override;
   virtual void RunOnInstruction(SItoFPInst*) override;
+  virtual void RunOnInstruction(FPtoFPInst*) override;
   virtual void RunOnInstruction(SliceInst*) override;
   virtual void RunOnInstruction(SoftmaxInst*) override;
   virtual void RunOnInstruction(TransposeInst*) override;
@@ -104,6 +121,14 @@ class GenericLLVMIRCodeGen : public CodeGen {
 
   virtual void RunOnBaseInstruction(Instruction*) override;
 
+  /// Emits elementwise, broadcast, transpose, pad and small reduction
+  /// instructions as loop nests over their static shapes. Returns false,
+  /// without emitting anything, for other instructions.
+  virtual bool RunOnInstructionAsLoopNest(Instruction* inst);
+  /// Runs the LLVM optimization pipeline, which vectorizes and fuses the
+  /// loop nests.
+  virtual void OptimizeModule();
+
   virtual std::string GetRuntimeLibDir() const;
   virtual std::string GetRuntimeLibPath() const;
   virtual void LinkRuntimeLib();
@@ -116,10 +141,26 @@ class GenericLLVMIRCodeGen : public CodeGen {
   virtual llvm::Value* AllocateLLVMBuffer(DefaultIRBuilder* ir_builder,
                                           const Def& def, bool on_stack);
   virtual llvm::Value* AllocateLLVMBuffer(DefaultIRBuilder*, const Def& def);
+  /// Creates a stack buffer in the entry block of the current function, where
+  /// it can be promoted even if `ir_builder` is inside a loop nest.
+  llvm::AllocaInst* CreateEntryBlockAlloca(DefaultIRBuilder* ir_builder,
+                                           llvm::Type* type,
+                                           const std::string& name);
   llvm::CallInst* CreateCall(llvm::FunctionCallee* callee,
                              llvm::ArrayRef<llvm::Value*> args);
+  /// Returns a pointer to the first element of `def`, storing it to the stack
+  /// first if it is not in memory.
+  llvm::Value* GetElementPtr(const Def& def);
+  /// Emits loops over `dims`, from the outermost to the innermost, around the
+  /// code emitted by `body`, which gets the induction variables. Dimensions
+  /// of size 1 get no loop and a constant 0 index.
+  using LoopBody = std::function<void(const std::vector<llvm::Value*>&)>;
+  void EmitLoopNest(const std::vector<int64_t>& dims, const LoopBody& body);
 
   static llvm::LLVMContext& GetLLVMContext() noexcept;
+  /// Returns `name` as a valid C/C++ identifier, the name of the global
+  /// variable of a constant.
+  static std::string NormalizeVariableName(const std::string& name);
   static llvm::Type* SNTypeToLLVMType(DataType dt);
   static const std::string& SNTypeToRTLibFuncSuffix(DataType dt);
   static const std::string& DataFormatToRTLibFuncSuffix(DataFormat df);
@@ -130,6 +171,16 @@ class GenericLLVMIRCodeGen : public CodeGen {
   llvm::TargetMachine* target_machine_ = nullptr;
   DefaultIRBuilder* current_llvm_builder_ = nullptr;
   std::unordered_map<Def, llvm::Value*> ir_mapping_;
+  // Planned offsets of non-stack buffers inside `workspace_`.
+  std::unique_ptr<MemoryPlanner> memory_planner_;
+  llvm::GlobalVariable* workspace_ = nullptr;
+
+  // Buffers with no more elements than this are allocated on stack.
+  static constexpr int64_t StackThreshold = 128;
+  // Reductions with no more input elements than this are emitted as loop
+  // nests. Larger ones use the parallel runtime kernel.
+  static constexpr int64_t LoopNestMaxReduction = 1 << 16;
+  LoweringMode lowering_mode_ = LoweringMode::RuntimeCall;
 
   inline static int64_t GetMaxVectorSize() {
     // This is LLVM's limit of vector length (llvm::SDNode::getMaxNumOperands().
@@ -0,0 +1,62 @@
+//===- weights_file_writer.h ------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_TARGET_WEIGHTS_FILE_WRITER_H_
+#define HALO_LIB_TARGET_WEIGHTS_FILE_WRITER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "halo/lib/target/codegen.h"
+
+namespace halo {
+
+/// This pass writes all constants into a weights file that the runtime maps
+/// into memory and uses in place (see odla_LoadConstantsArray()). The file is
+/// little endian and laid out as:
+///   header: char magic[8], uint32 version, uint32 number of constants,
+///           uint64 offset of the index, uint64 offset of the data.
+///   index:  for each constant, uint64 offset, uint64 size in bytes,
+///           uint32 data type, uint32 rank, int64 dims[rank],
+///           uint32 name size (including the trailing '\0'), char name[],
+///           padded to 8 bytes. The names are unique (see GetEntryName()).
+///   data:   for each constant, the raw data at an offset aligned to
+///           `Alignment`. Constants with the same type and data share one
+///           copy, so several index entries may have the same offset and a
+///           constant modified in place changes its duplicates too.
+class WeightsFileWriter final : public CodeWriter {
+ public:
+  explicit WeightsFileWriter(std::ostream& os)
+      : CodeWriter("Weights File Writer", os) {}
+
+  bool RunOnModule(Module* module) override;
+
+  /// Returns the name of the index entry of `constant`. Constants of a
+  /// function are qualified by the function name, e.g., "func/w0", since
+  /// functions may have constants of the same name. Module constants keep
+  /// their names.
+  static std::string GetEntryName(const Constant& constant);
+
+  static constexpr char Magic[8] = "HALOWTS";
+  static constexpr uint32_t Version = 1;
+  static constexpr uint64_t HeaderSize = 32;
+  static constexpr uint64_t Alignment = 64;
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_TARGET_WEIGHTS_FILE_WRITER_H_
@@ -0,0 +1,109 @@
+//===- thread_pool.h --------------------------------------------*- C++ -*-===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_THREADPOOL_THREAD_POOL_H_
+#define HALO_LIB_THREADPOOL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace halo {
+
+/// A work-stealing thread pool. Each worker owns a task queue: it pops its own
+/// tasks in LIFO order and steals from the other queues in FIFO order when its
+/// queue runs dry. The thread that waits for tasks helps to run them, so a
+/// pool of N threads starts N - 1 workers.
+/// This file does not depend on the rest of Halo so that the runtime library
+/// can be built from the same source.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+  /// Body of a parallel loop over the sub-range [begin, end).
+  using RangeFunc = std::function<void(int64_t begin, int64_t end)>;
+
+  /// Creates a pool of `num_of_threads` threads, including the caller.
+  explicit ThreadPool(int num_of_threads = GetDefaultNumOfThreads());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Returns the number of threads, including the caller.
+  int GetNumOfThreads() const noexcept {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+
+  /// Queues `task` for asynchronous execution.
+  void Schedule(Task task);
+
+  /// Blocks until all scheduled tasks are done. The caller runs pending tasks
+  /// before it goes to sleep.
+  void Wait();
+
+  /// Runs queued tasks on the calling thread until all queues are empty. A
+  /// caller that waits for its own tasks helps with this before it sleeps.
+  void RunPendingTasks();
+
+  /// Splits [begin, end) into chunks of at least `grain` iterations, calls
+  /// `func` on each chunk in parallel and returns when all chunks are done.
+  /// Nested calls from inside a parallel region run sequentially.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                   const RangeFunc& func);
+
+  /// Returns $HALO_NUM_THREADS if it is set to a positive number, otherwise
+  /// the number of hardware threads.
+  static int GetDefaultNumOfThreads();
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(int index);
+  // Runs one queued task. Worker `index` tries its own queue first. Returns
+  // false if all queues are empty.
+  bool RunOneTask(int index);
+  bool PopTask(int index, Task* task);
+  // Returns the index of the calling worker, or -1 for other threads.
+  int GetWorkerIndex() const noexcept;
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::vector<std::thread> workers_;
+  // Guards `stop_`, the sleeping of idle workers and of Wait().
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // Signaled when the last unfinished task is done.
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+  // Tasks that are queued and not yet started.
+  std::atomic<int64_t> num_of_queued_{0};
+  // Tasks that are scheduled and not yet finished.
+  std::atomic<int64_t> num_of_unfinished_{0};
+  std::atomic<uint64_t> next_queue_{0};
+};
+
+} // namespace halo
+
+#endif // HALO_LIB_THREADPOOL_THREAD_POOL_H_
@@ -28,6 +28,8 @@ class CAFFEExtensionLegalizer final : public BasicBlockPass {
   CAFFEExtensionLegalizer() : BasicBlockPass("CAFFE Extension Legalizer") {}
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
 };
 
 } // end namespace halo.
@@ -0,0 +1,40 @@
+//===- constant_dedup.h ---------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_TRANSFORMS_CONSTANT_DEDUP_H_
+#define HALO_LIB_TRANSFORMS_CONSTANT_DEDUP_H_
+
+#include "halo/lib/pass/pass.h"
+
+namespace halo {
+
+/// This pass merges the constants of a function that have the same type and
+/// data, e.g., initializers repeated by the parser or constants duplicated by
+/// the simplifications. The uses of a duplicate are redirected to the first
+/// constant with its contents, and the duplicate is deleted.
+class ConstantDedup final : public FunctionPass {
+ public:
+  ConstantDedup() : FunctionPass("Constant Deduplication") {}
+
+  bool RunOnFunction(Function* func) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_TRANSFORMS_CONSTANT_DEDUP_H_
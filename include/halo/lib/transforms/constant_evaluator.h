@@ -0,0 +1,57 @@
+//===- constant_evaluator.h -----------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_TRANSFORMS_CONSTANT_EVALUATOR_H_
+#define HALO_LIB_TRANSFORMS_CONSTANT_EVALUATOR_H_
+
+#include <cstdint>
+
+#include "halo/lib/ir/constant.h"
+#include "halo/lib/ir/instruction.h"
+
+namespace halo {
+
+/// This class executes instructions whose operands are all constants at
+/// compile time with reference kernels, so that constant subgraphs, e.g.
+/// shape computations or convolutions on constant inputs, are removed from
+/// the generated code. It covers the element-wise math and activation
+/// instructions (with broadcasting), comparisons, reductions, arg max/min,
+/// softmax, matrix multiplications, 2D convolutions, and concat, gather and
+/// transpose on any axis. Results larger than the size budget are not
+/// evaluated, so that the folded constants do not bloat the weights.
+class ConstantEvaluator {
+ public:
+  /// The default limit of the size of an evaluated result, in bytes.
+  static constexpr int64_t kDefaultMaxBytes = 1 << 20;
+
+  explicit ConstantEvaluator(int64_t max_bytes = kDefaultMaxBytes)
+      : max_bytes_(max_bytes) {}
+
+  /// Evaluate `inst` and return a new constant of its function that holds the
+  /// result. Returns nullptr if an operand is not a constant, the instruction
+  /// or its data type is not supported, or the result exceeds the budget.
+  Constant* Evaluate(Instruction* inst) const;
+
+  int64_t GetMaxBytes() const noexcept { return max_bytes_; }
+
+ private:
+  int64_t max_bytes_;
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_TRANSFORMS_CONSTANT_EVALUATOR_H_
@@ -18,16 +18,24 @@
 #ifndef HALO_LIB_TRANSFORMS_DCE_H_
 #define HALO_LIB_TRANSFORMS_DCE_H_
 
-#include "halo/lib/pass/pass.h"
+#include "halo/lib/pass/worklist.h"
 
 namespace halo {
 
-/// This pass eliminates dead IRs.
-class DCE final : public BasicBlockPass {
+/// This pass eliminates dead IRs. Dead instructions are erased by the
+/// worklist, which revisits their operands, so whole dead subgraphs are
+/// removed in one run.
+class DCE final : public WorklistPass {
  public:
-  DCE() : BasicBlockPass("Dead Code Elimination") {}
+  DCE() : WorklistPass("Dead Code Elimination", true) {}
 
-  bool RunOnBasicBlock(BasicBlock* bb) override;
+  bool CanRunConcurrently() const noexcept override { return true; }
+
+ protected:
+  bool Visit(Instruction* inst) override { return false; }
+
+  /// Remove dead constants and arguments.
+  bool Finalize(BasicBlock* bb) override;
 };
 
 } // end namespace halo.
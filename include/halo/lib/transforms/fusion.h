@@ -36,6 +36,8 @@ class Fusion final : public BasicBlockPass {
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
 
+  bool CanRunConcurrently() const noexcept override { return true; }
+
   struct Options opts_;
 
  private:
@@ -30,6 +30,8 @@ class InputRewriter final : public BasicBlockPass {
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
 
+  bool CanRunConcurrently() const noexcept override { return true; }
+
  private:
   std::vector<std::string> inputs_;
 };
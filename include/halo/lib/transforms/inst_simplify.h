@@ -19,23 +19,28 @@
 #define HALO_LIB_TRANSFORMS_INST_SIMPLIFY_H_
 
 #include "halo/lib/ir/all_instructions.h"
-#include "halo/lib/pass/pass.h"
+#include "halo/lib/pass/worklist.h"
+#include "halo/lib/transforms/constant_evaluator.h"
 
 namespace halo {
 
 /// This pass simplififies instructions to reduce computation strength.
-class InstSimplify final : public BasicBlockPass {
+class InstSimplify final : public WorklistPass {
  public:
   InstSimplify() : InstSimplify(false, false, false, false) {}
   InstSimplify(bool simplify_for_preprocess, bool disable_broadcasting,
-               bool remove_input_transpose, bool remove_output_transpose)
-      : BasicBlockPass("Instruction Simplification"),
+               bool remove_input_transpose, bool remove_output_transpose,
+               int64_t max_folded_bytes = ConstantEvaluator::kDefaultMaxBytes)
+      : WorklistPass("Instruction Simplification"),
         simplify_for_preprocess_(simplify_for_preprocess),
         disable_broadcasting_(disable_broadcasting),
         remove_input_transpose_(remove_input_transpose),
-        remove_output_transpose_(remove_output_transpose) {}
+        remove_output_transpose_(remove_output_transpose),
+        evaluator_(max_folded_bytes) {}
 
-  bool RunOnBasicBlock(BasicBlock* bb) override;
+  bool Visit(Instruction* inst) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
 
  private:
   // TODO(unknown): Tablegen.
@@ -65,6 +70,8 @@ class InstSimplify final : public BasicBlockPass {
   bool disable_broadcasting_;
   bool remove_input_transpose_;
   bool remove_output_transpose_;
+  // Folds the instructions on constants that are not simplified otherwise.
+  ConstantEvaluator evaluator_;
 };
 
 } // end namespace halo.
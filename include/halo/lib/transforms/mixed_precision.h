@@ -0,0 +1,84 @@
+//===- mixed_precision.h --------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_TRANSFORMS_MIXED_PRECISION_H_
+#define HALO_LIB_TRANSFORMS_MIXED_PRECISION_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "halo/lib/pass/pass.h"
+
+namespace halo {
+
+/// This pass computes FLOAT32 instructions in BFLOAT16 or FLOAT16 where it is
+/// numerically safe. Instructions on the allow list are always converted.
+/// Instructions on the follow list are converted when one of their operands
+/// is already in the low precision, so that no casts are inserted around
+/// cheap instructions. Everything else, and any instruction whose known value
+/// range does not fit the low precision type, stays in FLOAT32. Constant
+/// operands are converted at compile time and casts are inserted only at the
+/// boundaries between the two precisions.
+class MixedPrecision final : public BasicBlockPass {
+ public:
+  /// The [min, max] range of values, keyed by the value id in the generated
+  /// code. It has the format of the INT8 calibration file.
+  using Ranges = std::unordered_map<std::string, std::pair<float, float>>;
+
+  struct Options {
+    /// BFLOAT16 or FLOAT16.
+    DataType data_type = DataType::BFLOAT16;
+    /// Instructions that are always computed in the low precision.
+    std::unordered_set<OpCode> allow_list{OpCode::CONV2D, OpCode::GEMM,
+                                          OpCode::MATMUL, OpCode::BATCHMATMUL};
+    /// Instructions that are computed in the low precision when they consume
+    /// a low precision value.
+    std::unordered_set<OpCode> follow_list{
+        OpCode::ADD,        OpCode::MUL,        OpCode::RELU,
+        OpCode::LEAKYRELU,  OpCode::POOLINGMAX, OpCode::POOLINGAVG,
+        OpCode::CONCAT,     OpCode::RESHAPE,    OpCode::TRANSPOSE};
+    /// Instructions that always stay in FLOAT32. It overrides the lists above.
+    std::unordered_set<OpCode> deny_list;
+    /// Names of instructions that always stay in FLOAT32.
+    std::unordered_set<std::string> keep_fp32;
+    /// Calibrated ranges of values, e.g. of the inputs. They take precedence
+    /// over the ranges derived from constants.
+    Ranges ranges;
+  };
+
+  explicit MixedPrecision(const Options& opts)
+      : BasicBlockPass("Mixed Precision"), opts_(opts) {}
+
+  bool RunOnBasicBlock(BasicBlock* bb) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
+
+  /// Converts a float to the bits of a BFLOAT16, rounding to nearest even.
+  static uint16_t FloatToBF16(float x);
+  /// Converts a float to the bits of an IEEE FLOAT16, rounding to nearest
+  /// even. Values out of range become infinity.
+  static uint16_t FloatToFP16(float x);
+
+ private:
+  Options opts_;
+};
+
+} // end namespace halo.
+
+#endif // HALO_LIB_TRANSFORMS_MIXED_PRECISION_H_
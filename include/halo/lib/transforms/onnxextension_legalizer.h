@@ -28,6 +28,8 @@ class ONNXExtensionLegalizer final : public BasicBlockPass {
   ONNXExtensionLegalizer() : BasicBlockPass("ONNX Extension Legalizer") {}
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
 };
 
 } // end namespace halo.
@@ -28,6 +28,8 @@ class TFExtensionLegalizer final : public BasicBlockPass {
   TFExtensionLegalizer() : BasicBlockPass("TF Extension Legalizer") {}
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
+
+  bool CanRunConcurrently() const noexcept override { return true; }
 };
 
 } // end namespace halo.
@@ -33,6 +33,8 @@ class TypeLegalizer final : public BasicBlockPass {
 
   bool RunOnBasicBlock(BasicBlock* bb) override;
 
+  bool CanRunConcurrently() const noexcept override { return true; }
+
  private:
   bool relaxed_; // Skip uninferable shape if true.
 };
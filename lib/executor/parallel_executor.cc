@@ -0,0 +1,253 @@
+//===- parallel_executor.cc -----------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/executor/parallel_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+
+#include "halo/lib/ir/math_instructions.h"
+#include "halo/lib/ir/nn_cnn_instructions.h"
+
+namespace halo {
+
+ParallelExecutor::ParallelExecutor(const Function& func)
+    : ParallelExecutor(func, EstimateCost) {}
+
+ParallelExecutor::ParallelExecutor(const Function& func,
+                                   const CostFunc& cost_func) {
+  BuildGraph(func, cost_func);
+  ComputeSchedule();
+}
+
+// Returns the size of the reduction dimension of a matrix multiplication.
+static int64_t GetReductionSize(const Type& lhs, bool transpose) {
+  size_t rank = lhs.GetNumOfDims();
+  if (rank < 2) {
+    return rank == 1 ? lhs.GetNumOfElementsInDim(0) : 1;
+  }
+  return lhs.GetNumOfElementsInDim(transpose ? rank - 2 : rank - 1);
+}
+
+double ParallelExecutor::EstimateCost(const Instruction& inst) {
+  if (inst.GetNumOfResults() == 0 || !inst.GetResultType().IsValid()) {
+    return 1;
+  }
+  double elems = std::max(inst.GetResultType().GetTotalNumOfElements(),
+                          static_cast<int64_t>(1));
+  switch (inst.GetOpCode()) {
+    case OpCode::CONV2D: {
+      const auto& conv = static_cast<const Conv2DInst&>(inst);
+      const Type& out = conv.GetResultType();
+      const Type& kernel = conv.GetOperand(1).GetType();
+      if (!kernel.IsValid() || out.GetNumOfDims() != 4) {
+        return elems;
+      }
+      size_t c_axis = conv.GetDataFormat() == DataFormat::NCHW ? 1 : 3;
+      int64_t oc = std::max(out.GetNumOfElementsInDim(c_axis),
+                            static_cast<int64_t>(1));
+      // Each output element takes (ic / group) x kh x kw multiply-adds.
+      return elems * kernel.GetTotalNumOfElements() / oc;
+    }
+    case OpCode::MATMUL: {
+      const auto& matmul = static_cast<const MatMulInst&>(inst);
+      return elems * GetReductionSize(matmul.GetOperand(0).GetType(),
+                                      matmul.GetTransposeA());
+    }
+    case OpCode::BATCHMATMUL: {
+      const auto& matmul = static_cast<const BatchMatMulInst&>(inst);
+      return elems * GetReductionSize(matmul.GetOperand(0).GetType(),
+                                      matmul.GetTransposeA());
+    }
+    case OpCode::GEMM: {
+      const auto& gemm = static_cast<const GemmInst&>(inst);
+      return elems * GetReductionSize(gemm.GetOperand(0).GetType(),
+                                      gemm.GetTransposeA());
+    }
+    default: {
+      return elems;
+    }
+  }
+}
+
+void ParallelExecutor::BuildGraph(const Function& func,
+                                  const CostFunc& cost_func) {
+  for (auto& bb : func) {
+    for (auto& inst : *bb) {
+      node_ids_[inst.get()] = nodes_.size();
+      nodes_.push_back(Node{inst.get(), cost_func(*inst)});
+      total_cost_ += nodes_.back().cost;
+    }
+  }
+  for (auto& node : nodes_) {
+    std::unordered_set<size_t> succs;
+    for (const auto& uses : node.inst->GetResultsUses()) {
+      for (const auto& use : uses) {
+        const auto* user = DynCast<Instruction>(use.GetUse());
+        auto it = user == nullptr ? node_ids_.end() : node_ids_.find(user);
+        if (it != node_ids_.end() && succs.insert(it->second).second) {
+          node.succs.push_back(it->second);
+        }
+      }
+    }
+  }
+  // A return comes after everything else, including instructions whose
+  // results are unused.
+  for (size_t i = 0, e = nodes_.size(); i < e; ++i) {
+    if (nodes_[i].inst->GetOpCode() != OpCode::RETURN) {
+      continue;
+    }
+    for (size_t j = 0; j < e; ++j) {
+      if (j != i && nodes_[j].succs.empty()) {
+        nodes_[j].succs.push_back(i);
+      }
+    }
+  }
+  for (const auto& node : nodes_) {
+    for (size_t succ : node.succs) {
+      ++nodes_[succ].num_of_preds;
+    }
+  }
+}
+
+void ParallelExecutor::ComputeSchedule() {
+  size_t n = nodes_.size();
+  levels_.assign(n, 0);
+  std::vector<double> finish(n, 0);
+  std::vector<size_t> pending(n);
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < n; ++i) {
+    pending[i] = nodes_[i].num_of_preds;
+    if (pending[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  // Kahn's algorithm. A node starts right after its latest predecessor.
+  std::vector<double> start(n, 0);
+  size_t visited = 0;
+  while (!ready.empty()) {
+    size_t id = ready.back();
+    ready.pop_back();
+    ++visited;
+    finish[id] = start[id] + nodes_[id].cost;
+    critical_path_cost_ = std::max(critical_path_cost_, finish[id]);
+    for (size_t succ : nodes_[id].succs) {
+      levels_[succ] = std::max(levels_[succ], levels_[id] + 1);
+      start[succ] = std::max(start[succ], finish[id]);
+      if (--pending[succ] == 0) {
+        ready.push_back(succ);
+      }
+    }
+  }
+  HLCHECK(visited == n && "Cyclic dependences");
+
+  size_t num_of_groups =
+      n == 0 ? 0 : *std::max_element(levels_.begin(), levels_.end()) + 1;
+  groups_.resize(num_of_groups);
+  // Nodes are numbered in program order, which is kept within a group.
+  for (size_t i = 0; i < n; ++i) {
+    groups_[levels_[i]].push_back(nodes_[i].inst);
+  }
+}
+
+size_t ParallelExecutor::GetGroupIndex(const Instruction& inst) const {
+  auto it = node_ids_.find(&inst);
+  HLCHECK(it != node_ids_.end());
+  return levels_[it->second];
+}
+
+size_t ParallelExecutor::GetMaxWidth() const noexcept {
+  size_t width = 0;
+  for (const auto& group : groups_) {
+    width = std::max(width, group.size());
+  }
+  return width;
+}
+
+double ParallelExecutor::GetSpeedup() const noexcept {
+  return critical_path_cost_ > 0 ? total_cost_ / critical_path_cost_ : 1;
+}
+
+void ParallelExecutor::Run(ThreadPool* pool,
+                           const std::function<void(Instruction*)>& func) {
+  if (pool == nullptr || pool->GetNumOfThreads() == 1) {
+    for (const auto& group : groups_) {
+      for (Instruction* inst : group) {
+        func(inst);
+      }
+    }
+    return;
+  }
+  std::vector<std::atomic<size_t>> pending(nodes_.size());
+  for (size_t i = 0, e = nodes_.size(); i < e; ++i) {
+    pending[i].store(nodes_[i].num_of_preds, std::memory_order_relaxed);
+  }
+  // The instructions of this run that are not done yet. The pool may be
+  // shared, so its own Wait() would also wait for unrelated tasks.
+  struct Completion {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t remaining;
+  } done;
+  done.remaining = nodes_.size();
+  // The last predecessor to finish starts the node.
+  std::function<void(size_t)> start = [&](size_t id) {
+    pool->Schedule([&, id]() {
+      func(nodes_[id].inst);
+      for (size_t succ : nodes_[id].succs) {
+        if (pending[succ].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          start(succ);
+        }
+      }
+      // Notify under the lock: the waiter owns `done` and may return as soon
+      // as it sees the count drop to zero.
+      std::lock_guard<std::mutex> lock(done.mutex);
+      if (--done.remaining == 0) {
+        done.cv.notify_one();
+      }
+    });
+  };
+  for (size_t i = 0, e = nodes_.size(); i < e; ++i) {
+    if (nodes_[i].num_of_preds == 0) {
+      start(i);
+    }
+  }
+  // Help with the queued instructions, then sleep until the running ones are
+  // done. Instructions that become ready later are run by the workers.
+  pool->RunPendingTasks();
+  std::unique_lock<std::mutex> lock(done.mutex);
+  done.cv.wait(lock, [&done]() { return done.remaining == 0; });
+}
+
+void ParallelExecutor::Print(std::ostream& os) const {
+  os << "Parallel schedule: " << nodes_.size() << " instructions in "
+     << groups_.size() << " groups, max width " << GetMaxWidth() << "\n";
+  os << "Critical path: " << critical_path_cost_ << " of " << total_cost_
+     << " (speedup " << GetSpeedup() << "x)\n";
+  for (size_t i = 0, e = groups_.size(); i < e; ++i) {
+    os << "Group " << i << ":";
+    for (const Instruction* inst : groups_[i]) {
+      os << " " << inst->GetName();
+    }
+    os << "\n";
+  }
+}
+
+} // namespace halo
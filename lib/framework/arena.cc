@@ -0,0 +1,38 @@
+//===- arena.cc -----------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/framework/arena.h"
+
+namespace halo {
+
+void* Arena::AllocateSlow(size_t size) {
+  if (size > kSlabSize / 4) {
+    // Large blocks get their own slab so the current one is not wasted.
+    slabs_.emplace_back(new char[size]);
+    reserved_bytes_ += size;
+    return slabs_.back().get();
+  }
+  slabs_.emplace_back(new char[kSlabSize]);
+  reserved_bytes_ += kSlabSize;
+  cur_ = slabs_.back().get();
+  end_ = cur_ + kSlabSize;
+  void* ret = cur_;
+  cur_ += size;
+  return ret;
+}
+
+} // namespace halo
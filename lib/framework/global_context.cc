@@ -17,8 +17,10 @@
 
 #include "halo/lib/framework/global_context.h"
 
+#include <atomic>
 #include <experimental/filesystem>
 
+#include "halo/lib/framework/arena.h"
 #include "halo/lib/framework/data_layout.h"
 #include "halo/lib/target/codegen_object.h"
 #include "llvm/Config/llvm-config.h"
@@ -36,10 +38,18 @@ class GlobalContextImpl {
 
   /// Return the current global counter and then increase it.
   uint64_t ReturnAndIncreaseGlobalCounter() noexcept {
-    uint64_t current = global_counter_++;
-    return current;
+    return global_counter_.fetch_add(1, std::memory_order_relaxed);
   }
 
+  void AdvanceGlobalCounter(uint64_t id) noexcept {
+    uint64_t current = global_counter_.load(std::memory_order_relaxed);
+    while (current < id && !global_counter_.compare_exchange_weak(
+                               current, id, std::memory_order_relaxed)) {
+    }
+  }
+
+  Arena& GetArena() noexcept { return arena_; }
+
   const DataLayout& GetDefaultDataLayout() const noexcept {
     return data_layout_;
   }
@@ -69,7 +79,8 @@ class GlobalContextImpl {
 
  private:
   // A global counter
-  uint64_t global_counter_ = 0;
+  std::atomic<uint64_t> global_counter_{0};
+  Arena arena_;
   DefaultDataLayout data_layout_;
   CodeGenObject code_gen_obj_;
   std::string base_path_{""};
@@ -77,15 +88,35 @@ class GlobalContextImpl {
   std::string processor_{"native"};
 };
 
+// The innermost IdScope of the calling thread.
+static thread_local GlobalContext::IdScope* current_id_scope = nullptr;
+
+GlobalContext::IdScope::IdScope(GlobalContext& ctx, uint64_t first_id)
+    : ctx_(ctx), next_id_(first_id), prev_(current_id_scope) {
+  current_id_scope = this;
+}
+
+GlobalContext::IdScope::~IdScope() { current_id_scope = prev_; }
+
 GlobalContext::GlobalContext() : impl_(std::make_unique<GlobalContextImpl>()) {}
 
 GlobalContext::~GlobalContext() {}
 
 /// Return the current global counter.
 uint64_t GlobalContext::GetGlobalCounter() noexcept {
+  IdScope* scope = current_id_scope;
+  if (scope != nullptr && &scope->ctx_ == this) {
+    return scope->next_id_++;
+  }
   return impl_->ReturnAndIncreaseGlobalCounter();
 }
 
+void GlobalContext::AdvanceGlobalCounter(uint64_t id) noexcept {
+  impl_->AdvanceGlobalCounter(id);
+}
+
+Arena& GlobalContext::GetArena() noexcept { return impl_->GetArena(); }
+
 const DataLayout& GlobalContext::GetDefaultDataLayout() const noexcept {
   return impl_->GetDefaultDataLayout();
 }
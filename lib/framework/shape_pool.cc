@@ -0,0 +1,51 @@
+//===- shape_pool.cc ------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/framework/shape_pool.h"
+
+#include <functional>
+
+namespace halo {
+
+size_t ShapePool::Hash::operator()(
+    const std::vector<int64_t>& shape) const noexcept {
+  size_t h = shape.size();
+  for (int64_t d : shape) {
+    h ^= std::hash<int64_t>()(d) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  }
+  return h;
+}
+
+const std::vector<int64_t>* ShapePool::Get(const std::vector<int64_t>& shape) {
+  size_t h = Hash()(shape);
+  // The top bits pick the shard, so that they do not follow the buckets.
+  Shard& shard = shards_[(h * 0x9e3779b97f4a7c15ULL) >> 60];
+  static_assert(kNumOfShards == 16, "the shard index takes 4 bits");
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return &*shard.shapes.insert(shape).first;
+}
+
+size_t ShapePool::GetNumOfShapes() const {
+  size_t n = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    n += shard.shapes.size();
+  }
+  return n;
+}
+
+} // namespace halo
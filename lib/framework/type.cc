@@ -17,15 +17,46 @@
 
 #include "halo/lib/framework/type.h"
 
+#include <algorithm>
 #include <iostream>
 #include <numeric>
 
 #include "halo/api/halo_data.h"
 #include "halo/lib/framework/common.h"
 #include "halo/lib/framework/global_context.h"
+#include "halo/lib/framework/shape_pool.h"
 
 namespace halo {
 
+Type::DimSizes::DimSizes(const std::vector<int64_t>& dims)
+    : size_(dims.size()) {
+  if (size_ <= kNumOfInlineDims) {
+    std::copy(dims.begin(), dims.end(), inline_);
+    return;
+  }
+  // Long shapes are rare, so they are uniqued once for the whole process
+  // rather than per global context.
+  static auto* const pool = new ShapePool();
+  large_ = pool->Get(dims);
+}
+
+bool operator==(const Type::DimSizes& lhs,
+                const Type::DimSizes& rhs) noexcept {
+  if (lhs.size_ != rhs.size_) {
+    return false;
+  }
+  if (lhs.size_ > Type::DimSizes::kNumOfInlineDims) {
+    return lhs.large_ == rhs.large_;
+  }
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+bool operator==(const Type::DimSizes& lhs,
+                const std::vector<int64_t>& rhs) noexcept {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
 /// To constructs a scalar dt_id type.
 Type::Type(const DataType dt_id) : data_type_id_(dt_id) {
   is_scalar_ = true;
@@ -79,7 +110,9 @@ bool Type::HasNativeType<int16_t>(DataType dt) {
 
 template <>
 bool Type::HasNativeType<uint16_t>(DataType dt) {
-  return dt == DataType::UINT32;
+  // 16-bit floating point values are stored as their bit patterns.
+  return dt == DataType::UINT16 || dt == DataType::FLOAT16 ||
+         dt == DataType::BFLOAT16;
 }
 
 template <>
@@ -141,16 +174,7 @@ bool Type::operator==(const Type& rhs) const noexcept {
   if (is_scalar_ ^ rhs.IsScalar()) {
     return false;
   }
-  if (data_type_id_ != rhs.GetDataType() ||
-      shape_.size() != rhs.GetNumOfDims()) {
-    return false;
-  }
-  for (int i = 0, e = GetNumOfDims(); i < e; ++i) {
-    if (shape_[i] != rhs.GetNumOfElementsInDim(i)) {
-      return false;
-    }
-  }
-  return true;
+  return data_type_id_ == rhs.GetDataType() && shape_ == rhs.shape_;
 }
 
 bool Type::operator!=(const Type& rhs) const noexcept {
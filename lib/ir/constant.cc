@@ -47,6 +47,32 @@ Constant::Constant(GlobalContext& context, const std::string& name,
   }
 }
 
+Constant::Constant(GlobalContext& context, const std::string& name,
+                   const Type& ty, const DataLayout& data_layout,
+                   const void* data_ptr, std::shared_ptr<const void> owner)
+    : IRObject(context, name, 1),
+      parent_(nullptr),
+      data_layout_(data_layout),
+      external_data_(static_cast<const unsigned char*>(data_ptr)),
+      external_owner_(std::move(owner)) {
+  HLCHECK(ty.IsValid());
+  HLCHECK(data_ptr != nullptr);
+  auto& results = GetResultsTypes();
+  results.resize(1);
+  results[0] = ty;
+}
+
+void* Constant::GetRawDataPtr() {
+  if (external_data_ != nullptr) {
+    // Copy on write.
+    data_.assign(external_data_,
+                 external_data_ + data_layout_.Bytes(GetResultType()));
+    external_data_ = nullptr;
+    external_owner_.reset();
+  }
+  return data_.data();
+}
+
 template <typename T>
 static void PrintValues(std::ostream* os, const T* ptr, size_t n) {
   for (size_t i = 0; i < n; ++i) {
@@ -107,6 +133,12 @@ void Constant::PrintData(std::ostream* os, size_t num_to_print) const {
       PrintValues(os, GetDataPtr<int>(), num_to_print);
       break;
     }
+    case DataType::FLOAT16:
+    case DataType::BFLOAT16: {
+      // Printed as the bit patterns they are stored in.
+      PrintValues(os, GetDataPtr<uint16_t>(), num_to_print);
+      break;
+    }
     case DataType::FLOAT32: {
       PrintValues(os, GetDataPtr<float>(), num_to_print);
       break;
@@ -0,0 +1,80 @@
+//===- constant_pool.cc ---------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/ir/constant_pool.h"
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace halo {
+
+size_t ConstantPool::GetSizeInBytes(const Constant& constant) {
+  return constant.GetElementSizeInBytes() *
+         constant.GetResultType().GetTotalNumOfElements();
+}
+
+size_t ConstantPool::Hash(const Constant& constant) {
+  const Type& type = constant.GetResultType();
+  size_t h = std::hash<int>()(static_cast<int>(type.GetDataType()));
+  auto combine = [&h](size_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  };
+  for (int64_t d : type.GetDimSizes()) {
+    combine(std::hash<int64_t>()(d));
+  }
+  combine(std::hash<std::string_view>()(
+      std::string_view(static_cast<const char*>(constant.GetRawDataPtr()),
+                       GetSizeInBytes(constant))));
+  return h;
+}
+
+bool ConstantPool::HasSameContents(const Constant& lhs, const Constant& rhs) {
+  if (lhs.GetResultType() != rhs.GetResultType()) {
+    return false;
+  }
+  const size_t size = GetSizeInBytes(lhs);
+  return size == GetSizeInBytes(rhs) &&
+         (size == 0 ||
+          std::memcmp(lhs.GetRawDataPtr(), rhs.GetRawDataPtr(), size) == 0);
+}
+
+Constant* ConstantPool::Insert(Constant* constant) {
+  if (auto it = canonical_.find(constant); it != canonical_.end()) {
+    return it->second;
+  }
+  const size_t h = Hash(*constant);
+  auto range = payloads_.equal_range(h);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (HasSameContents(*it->second, *constant)) {
+      canonical_[constant] = it->second;
+      return it->second;
+    }
+  }
+  payloads_.emplace(h, constant);
+  canonical_[constant] = constant;
+  ++num_of_payloads_;
+  return constant;
+}
+
+Constant* ConstantPool::GetCanonical(const Constant* constant) const {
+  auto it = canonical_.find(constant);
+  HLCHECK(it != canonical_.end());
+  return it->second;
+}
+
+} // namespace halo
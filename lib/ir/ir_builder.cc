@@ -65,6 +65,16 @@ Constant* ConstantBuilder::CreateConstant(const std::string& name,
                         data_ptr);
 }
 
+Constant* ConstantBuilder::CreateExternalConstant(
+    const std::string& name, const Type& type, const void* data_ptr,
+    std::shared_ptr<const void> owner) {
+  auto c = std::make_unique<Constant>(GetContext(), name, type,
+                                      GetContext().GetDefaultDataLayout(),
+                                      data_ptr, std::move(owner));
+  c->parent_ = GetParent();
+  return Insert(std::move(c));
+}
+
 Constant* ConstantBuilder::SplatConstant(const std::string& name,
                                          const Type& type,
                                          const void* data_ptr) {
@@ -19,6 +19,8 @@
 
 #include <algorithm>
 
+#include "halo/lib/framework/arena.h"
+
 namespace halo {
 
 /// Equal operator
@@ -42,31 +44,30 @@ void Value::Print(std::ostream& os) const {
   GetOwner()->GetResultsTypes()[GetIdx()].Print(os);
 }
 
-/// Return the list iterator of a use.
-UseList::iterator UseList::GetIterator(const Use& u) noexcept {
-  auto it = uses_.begin();
-  for (; it != uses_.end(); ++it) {
-    if (*it == u) {
-      break;
-    }
+/// Append a use node that is not in any list.
+void UseList::AddUse(Use* u) noexcept {
+  HLCHECK(u->prev_ == nullptr && u->next_ == nullptr && head_ != u);
+  u->prev_ = tail_;
+  if (tail_ != nullptr) {
+    tail_->next_ = u;
+  } else {
+    head_ = u;
   }
-  return it;
+  tail_ = u;
+  ++size_;
 }
 
-/// Return true if it removes a use successfully.
-bool UseList::RemoveUse(const Use& u) noexcept {
-  auto it = GetIterator(u);
-  if (it != uses_.end()) {
-    uses_.erase(it);
-    return true;
-  }
-  return false;
+/// Unlink a use node from this list.
+void UseList::RemoveUse(Use* u) noexcept {
+  (u->prev_ != nullptr ? u->prev_->next_ : head_) = u->next_;
+  (u->next_ != nullptr ? u->next_->prev_ : tail_) = u->prev_;
+  u->prev_ = u->next_ = nullptr;
+  --size_;
 }
 
 /// Return true if it contains a specific use.
-bool UseList::HasUse(const Use& u) noexcept {
-  auto it = GetIterator(u);
-  return (it != uses_.end());
+bool UseList::HasUse(const Use& u) const noexcept {
+  return std::find(begin(), end(), u) != end();
 }
 
 /// Return the uses of the def object
@@ -145,13 +146,14 @@ bool IRObject::ComputeResultTypes() {
 /// Append one operand to the last of operand list
 /// and update operand's uselist
 void IRObject::AddOneOperand(const Def& one) {
+  Use* use = nullptr;
   if (!one.IsNull()) {
-    size_t use_idx = operands_.size();
-    UseList& uses = one.GetUses();
-    Use use(this, use_idx);
-    uses.AddUse(use);
+    int use_idx = static_cast<int>(operands_.size());
+    use = context_.GetArena().Create<Use>(this, use_idx);
+    one.GetUses().AddUse(use);
   }
   operands_.push_back(one);
+  operand_uses_.push_back(use);
 }
 
 /// Destructor of the IRObject class
@@ -206,8 +208,10 @@ void IRObject::ResetOperand(size_t idx) {
 void IRObject::DropAllOperands() {
   for (size_t i = 0; i < operands_.size(); ++i) {
     ResetOperand(i);
+    context_.GetArena().Destroy(operand_uses_[i]);
   }
   operands_.clear();
+  operand_uses_.clear();
 }
 
 void IRObject::ReplaceOperandWith(size_t idx, const Def& new_def) {
@@ -215,14 +219,15 @@ void IRObject::ReplaceOperandWith(size_t idx, const Def& new_def) {
   if (old_op == new_def) {
     return;
   }
-  Use use(this, idx);
+  // The use node of the operand slot moves from the old def to the new one.
+  Use*& use = operand_uses_[idx];
   if (!old_op.IsNull()) {
-    // Drop the use.
-    UseList& uses = old_op.GetUses();
-    HLCHECK(uses.HasUse(use));
-    uses.RemoveUse(use);
+    old_op.GetUses().RemoveUse(use);
   }
   if (!new_def.IsNull()) {
+    if (use == nullptr) {
+      use = context_.GetArena().Create<Use>(this, static_cast<int>(idx));
+    }
     new_def.GetUses().AddUse(use);
   }
   operands_[idx] = new_def;
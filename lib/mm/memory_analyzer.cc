@@ -72,4 +72,15 @@ MemoryAnalyzer::MemoryAnalyzer(const Module& m)
   Reset();
 }
 
+MemoryAnalyzer::MemoryAnalyzer(const Function& func)
+    : module_(*func.GetParent()),
+      ctx_(func.GetGlobalContext()),
+      weights_(0),
+      non_weights_(0),
+      curr_non_weights_(0),
+      peak_(0) {
+  RunOnFunction(func);
+  Reset();
+}
+
 } // namespace halo
\ No newline at end of file
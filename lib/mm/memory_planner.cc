@@ -0,0 +1,253 @@
+//===- memory_planner.cc --------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/mm/memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "halo/lib/framework/data_layout.h"
+
+namespace halo {
+
+static size_t AlignTo(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+MemoryPlanner::MemoryPlanner(const Function& func, Policy policy,
+                             size_t alignment, bool in_place)
+    : MemoryPlanner(
+          func, [](const Def&) { return true; }, policy, alignment, in_place) {}
+
+MemoryPlanner::MemoryPlanner(const Function& func, const Filter& filter,
+                             Policy policy, size_t alignment, bool in_place)
+    : filter_(filter),
+      policy_(policy),
+      alignment_(alignment),
+      in_place_(in_place) {
+  HLCHECK(alignment_ > 0);
+  ComputeLiveness(func);
+  AssignOffsets();
+}
+
+int MemoryPlanner::GetAliasedOperand(const Instruction& inst) {
+  // Values produced by these instructions are views of their first operand.
+  switch (inst.GetOpCode()) {
+    case OpCode::RESHAPE: {
+      return 0;
+    }
+    default: {
+      return -1;
+    }
+  }
+}
+
+bool MemoryPlanner::IsInPlaceCandidate(const Instruction& inst) {
+  switch (inst.GetOpCode()) {
+    case OpCode::ERF:
+    case OpCode::FLOOR:
+    case OpCode::LEAKYRELU:
+    case OpCode::RELU:
+    case OpCode::RELU6:
+    case OpCode::RSQRT:
+    case OpCode::SIGMOID:
+    case OpCode::SQRT: {
+      return inst.GetNumOfOperands() == 1;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool MemoryPlanner::IsDeadAfter(const Def& def, size_t pos) const {
+  const auto& buf = buffers_[def2buf_.at(def)];
+  for (const auto& d : buf.defs) {
+    auto it = last_uses_.find(d);
+    if (it != last_uses_.end() && it->second > pos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MemoryPlanner::ComputeLiveness(const Function& func) {
+  const DataLayout& dl = func.GetGlobalContext().GetDefaultDataLayout();
+  std::unordered_map<const Instruction*, size_t> positions;
+  size_t num_insts = 0;
+  for (auto& bb : func) {
+    for (auto& inst : *bb) {
+      positions[inst.get()] = num_insts++;
+    }
+  }
+  size_t last_pos = num_insts == 0 ? 0 : num_insts - 1;
+
+  for (auto& bb : func) {
+    for (auto& inst : *bb) {
+      size_t pos = positions[inst.get()];
+      for (const auto& op : inst->GetOperands()) {
+        const auto* def_inst = DynCast<Instruction>(op.GetOwner());
+        if (def_inst == nullptr) {
+          continue;
+        }
+        bool same_bb = def_inst->GetParent() == inst->GetParent();
+        size_t& last_use = last_uses_[op];
+        last_use = std::max(last_use, same_bb ? pos : last_pos);
+      }
+    }
+  }
+
+  for (auto& bb : func) {
+    for (auto& inst_ptr : *bb) {
+      const Instruction* inst = inst_ptr.get();
+      size_t pos = positions[inst];
+      // Extend the lifetime of buffers used by this instruction.
+      for (const auto& op : inst->GetOperands()) {
+        auto it = def2buf_.find(op);
+        if (it == def2buf_.end()) {
+          continue;
+        }
+        auto& buf = buffers_[it->second];
+        const auto* def_inst = DynCast<Instruction>(op.GetOwner());
+        // Values live across blocks are kept alive till the end of function.
+        bool same_bb = def_inst->GetParent() == inst->GetParent();
+        buf.end = std::max(buf.end, same_bb ? pos : last_pos);
+      }
+      if (inst->GetOpCode() == OpCode::RETURN) {
+        continue;
+      }
+      int alias_idx = GetAliasedOperand(*inst);
+      if (alias_idx < 0 && in_place_ && IsInPlaceCandidate(*inst)) {
+        // Reuse the input buffer if the input dies here.
+        const Def& op = inst->GetOperand(0);
+        if (def2buf_.count(op) > 0 &&
+            dl.Bytes(op.GetType()) == dl.Bytes(inst->GetResultType()) &&
+            IsDeadAfter(op, pos)) {
+          alias_idx = 0;
+          in_place_insts_.insert(inst);
+        }
+      }
+      for (size_t i = 0, e = inst->GetNumOfResults(); i < e; ++i) {
+        Def def(const_cast<Instruction*>(inst), i); // NOLINT
+        if (alias_idx >= 0 && i == 0) {
+          const Def& op = inst->GetOperand(alias_idx);
+          if (auto it = def2buf_.find(op); it != def2buf_.end()) {
+            def2buf_[def] = it->second;
+            buffers_[it->second].defs.push_back(def);
+            aliases_.emplace(def, op);
+            continue;
+          }
+        }
+        if (!filter_(def)) {
+          continue;
+        }
+        Buffer buf;
+        buf.size = AlignTo(dl.Bytes(def.GetType()), alignment_);
+        buf.start = pos;
+        buf.end = pos;
+        buf.defs.push_back(def);
+        unplanned_size_ += buf.size;
+        def2buf_[def] = buffers_.size();
+        buffers_.push_back(buf);
+      }
+    }
+  }
+}
+
+void MemoryPlanner::AssignOffsets() {
+  std::vector<size_t> order(buffers_.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (policy_ == Policy::GreedyBySize) {
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return buffers_[a].size > buffers_[b].size;
+    });
+  }
+
+  std::vector<const Buffer*> placed;
+  for (size_t idx : order) {
+    Buffer& buf = buffers_[idx];
+    // Collect placed buffers that are alive at the same time.
+    std::vector<const Buffer*> conflicts;
+    for (const Buffer* other : placed) {
+      if (other->start <= buf.end && buf.start <= other->end) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const Buffer* a, const Buffer* b) {
+                return a->offset < b->offset;
+              });
+
+    // Find the smallest gap that fits. Fall back to the end of the conflicts.
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (const Buffer* other : conflicts) {
+      if (other->offset > prev_end) {
+        size_t gap = other->offset - prev_end;
+        if (gap >= buf.size && gap < best_gap) {
+          best_gap = gap;
+          best_offset = prev_end;
+        }
+      }
+      prev_end = std::max(prev_end, other->offset + other->size);
+    }
+    if (best_gap == std::numeric_limits<size_t>::max()) {
+      best_offset = prev_end;
+    }
+    buf.offset = best_offset;
+    workspace_size_ = std::max(workspace_size_, buf.offset + buf.size);
+    placed.push_back(&buf);
+  }
+}
+
+bool MemoryPlanner::HasOffset(const Def& def) const noexcept {
+  return def2buf_.count(def) > 0;
+}
+
+size_t MemoryPlanner::GetOffset(const Def& def) const {
+  auto it = def2buf_.find(def);
+  HLCHECK(it != def2buf_.end());
+  return buffers_[it->second].offset;
+}
+
+bool MemoryPlanner::IsAliased(const Def& def) const noexcept {
+  return aliases_.count(def) > 0;
+}
+
+bool MemoryPlanner::IsInPlace(const Instruction& inst) const noexcept {
+  return in_place_insts_.count(&inst) > 0;
+}
+
+void MemoryPlanner::Print(std::ostream& os) const {
+  os << "Workspace: " << workspace_size_ << " bytes (" << unplanned_size_
+     << " bytes unplanned), " << buffers_.size() << " buffers\n";
+  for (const auto& buf : buffers_) {
+    os << "  [" << buf.offset << ", " << buf.offset + buf.size << ") live ["
+       << buf.start << ", " << buf.end << "]:";
+    for (const auto& def : buf.defs) {
+      os << " " << def.GetOwner()->GetName();
+      if (def.GetIdx() != 0) {
+        os << ":" << def.GetIdx();
+      }
+    }
+    os << "\n";
+  }
+}
+
+} // namespace halo
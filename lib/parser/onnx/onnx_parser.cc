@@ -20,9 +20,11 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
 
-#include <fstream>
+#include <cstdint>
+#include <limits>
 
 #include "halo/lib/framework/common.h"
+#include "halo/lib/framework/data_layout.h"
 #include "halo/lib/framework/type.h"
 #include "halo/lib/ir/extension_instructions.h"
 #include "onnx.pb.h"
@@ -39,27 +41,33 @@ Status ONNXParser::Parse(Function* function,
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   HLCHECK(!file_list.empty());
-  std::ifstream ifs(file_list.front());
-  HLCHECK(!ifs.fail());
-
-  // Total bytes hard limit / warning limit are set to 1GB and 512MB
-  // respectively.
-  onnx::ModelProto model_def;
-  std::string data{std::istreambuf_iterator<char>{ifs},
-                   std::istreambuf_iterator<char>{}};
+  const std::string& file_name = file_list.front();
+  auto model_file = MappedFile::Open(file_name);
+  HLCHECK(model_file != nullptr);
+
+  // Total bytes hard limit / warning limit are set to 2GB and 512MB
+  // respectively. Larger models keep their weights in external data files.
+  // The model is parsed straight from the mapped file. Parsing copies the
+  // bytes of `raw_data` into the message once; constants then refer to those
+  // strings instead of copying them again, and keep `model_def` alive. Only
+  // external data is used without any copy.
+  auto model_def = std::make_shared<onnx::ModelProto>();
   google::protobuf::io::ArrayInputStream input_stream(
-      data.c_str(), static_cast<int>(data.size()));
+      model_file->GetData(), static_cast<int>(model_file->GetSize()));
   google::protobuf::io::CodedInputStream coded_stream(&input_stream);
   coded_stream.SetTotalBytesLimit((2048LL << 20) - 1, 512LL << 20);
-  if (!model_def.ParseFromCodedStream(&coded_stream)) {
-    LOG(ERROR) << "Encountered error(s) when parsing " << file_list.front();
+  if (!model_def->ParseFromCodedStream(&coded_stream)) {
+    LOG(ERROR) << "Encountered error(s) when parsing " << file_name;
     return Status::ASSERTION;
   }
-  if (!model_def.has_graph()) {
+  if (!model_def->has_graph()) {
     LOG(ERROR) << "No graph is defined in onnx file.";
     return Status::ASSERTION;
   }
-  const onnx::GraphProto& graph_def = model_def.graph();
+  proto_owner_ = model_def;
+  auto pos = file_name.find_last_of('/');
+  model_dir_ = pos == std::string::npos ? "." : file_name.substr(0, pos);
+  const onnx::GraphProto& graph_def = model_def->graph();
   BasicBlockBuilder bb_builder(function);
   BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
   return Parse(bb, graph_def, opts);
@@ -96,7 +104,9 @@ Status ONNXParser::ConvertToHaloIR(const onnx::GraphProto& graph_def) {
   auto const_inputs_size = graph_def.initializer_size();
   for (int i = 0; i < const_inputs_size; ++i) {
     const_input_names.emplace(graph_def.initializer(i).name());
-    ConvertConstNode(graph_def.initializer(i));
+    if (ConvertConstNode(graph_def.initializer(i)) == nullptr) {
+      return Status::ASSERTION;
+    }
   }
 
   // Convert input
@@ -364,9 +374,118 @@ const Tensor<int8_t> ONNXParser::ProcessTensor<int8_t>(
   return Tensor<int8_t>(data_type, shape, v);
 }
 
+Constant* ONNXParser::CreateConstantFromRawData(
+    const onnx::TensorProto& tensor_def, const Type& type) {
+  const std::string& raw_data = tensor_def.raw_data();
+  if (raw_data.size() !=
+      c_builder_->GetContext().GetDefaultDataLayout().Bytes(type)) {
+    LOG(ERROR) << "Size of raw data of " << tensor_def.name()
+               << " does not match its type";
+    return nullptr;
+  }
+  if (proto_owner_ == nullptr) {
+    return c_builder_->CreateConstant(tensor_def.name(), type,
+                                      raw_data.data());
+  }
+  // Refer to the parsed tensor instead of copying it.
+  return c_builder_->CreateExternalConstant(tensor_def.name(), type,
+                                            raw_data.data(), proto_owner_);
+}
+
+// Parses a non-negative decimal number. Returns false if `str` is not one or
+// does not fit in size_t.
+static bool ParseSize(const std::string& str, size_t* value) {
+  if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  size_t v = 0;
+  for (char c : str) {
+    size_t digit = c - '0';
+    if (v > (std::numeric_limits<size_t>::max() - digit) / 10) {
+      return false;
+    }
+    v = v * 10 + digit;
+  }
+  *value = v;
+  return true;
+}
+
+Constant* ONNXParser::CreateConstantFromExternalData(
+    const onnx::TensorProto& tensor_def, const Type& type) {
+  const DataLayout& data_layout =
+      c_builder_->GetContext().GetDefaultDataLayout();
+  std::string location;
+  size_t offset = 0;
+  size_t length = data_layout.Bytes(type);
+  for (const auto& entry : tensor_def.external_data()) {
+    if (entry.key() == "location") {
+      location = entry.value();
+    } else if (entry.key() == "offset") {
+      if (!ParseSize(entry.value(), &offset)) {
+        LOG(ERROR) << "Invalid external data offset \"" << entry.value()
+                   << "\" of " << tensor_def.name();
+        return nullptr;
+      }
+    } else if (entry.key() == "length") {
+      size_t value = 0;
+      if (!ParseSize(entry.value(), &value) || value != length) {
+        LOG(ERROR) << "External data length \"" << entry.value() << "\" of "
+                   << tensor_def.name() << " does not match its " << length
+                   << "-byte type";
+        return nullptr;
+      }
+    }
+  }
+  if (location.empty()) {
+    LOG(ERROR) << "No external data location for " << tensor_def.name();
+    return nullptr;
+  }
+
+  auto& file = external_files_[location];
+  if (file == nullptr) {
+    file = MappedFile::Open(model_dir_ + "/" + location);
+    if (file == nullptr) {
+      LOG(ERROR) << "Unable to map external data file " << location;
+      return nullptr;
+    }
+  }
+  if (offset > file->GetSize() || length > file->GetSize() - offset) {
+    LOG(ERROR) << "External data of " << tensor_def.name() << " exceeds "
+               << location;
+    return nullptr;
+  }
+  const char* data = file->GetData() + offset;
+  if (reinterpret_cast<uintptr_t>(data) % // NOLINT.
+          data_layout.Bytes(type.GetDataType()) !=
+      0) {
+    // Misaligned data is copied.
+    return c_builder_->CreateConstant(tensor_def.name(), type, data);
+  }
+  return c_builder_->CreateExternalConstant(tensor_def.name(), type, data,
+                                            file);
+}
+
 IRObject* ONNXParser::ConvertConstNode(const onnx::TensorProto& tensor_def) {
   DataType data_type = ProcessDataType(tensor_def.data_type());
   IRObject* inst = nullptr;
+  if (tensor_def.data_location() == onnx::TensorProto::EXTERNAL ||
+      !tensor_def.raw_data().empty()) {
+    // Bool is stored as one byte per element.
+    Type type(data_type == DataType::BOOL ? DataType::INT8 : data_type,
+              std::vector<int64_t>(tensor_def.dims().begin(),
+                                   tensor_def.dims().end()));
+    HLCHECK(type.IsValid() && data_type != DataType::STRING);
+    if (tensor_def.data_location() == onnx::TensorProto::EXTERNAL) {
+      inst = CreateConstantFromExternalData(tensor_def, type);
+    } else {
+      inst = CreateConstantFromRawData(tensor_def, type);
+    }
+    if (inst == nullptr) {
+      return nullptr;
+    }
+    inst_name_to_ptr_.emplace(tensor_def.name(), std::make_pair(inst, 0));
+    return inst;
+  }
   switch (data_type) {
     case DataType::FLOAT32: {
       const Tensor<float> temp = ProcessTensor<float>(tensor_def);
@@ -408,6 +527,9 @@ Status ONNXParser::ConvertConstNode(const onnx::NodeProto& cur_node) {
     HLCHECK(attr.type() == onnx::AttributeProto::TENSOR);
     HLCHECK(attr.has_t());
     auto inst = ConvertConstNode(attr.t());
+    if (inst == nullptr) {
+      return Status::ASSERTION;
+    }
     if (inst->GetName().empty()) {
       // Fix constant node name is null in generated cpp code
       inst->SetName(cur_node.name());
@@ -76,6 +76,10 @@ class ONNXParser : public Parser {
   Status ConvertToHaloIR(const onnx::GraphProto& graph_def);
   Status ConvertOneNode(const onnx::NodeProto& node_def);
   IRObject* ConvertConstNode(const onnx::TensorProto& tensor_def);
+  Constant* CreateConstantFromRawData(const onnx::TensorProto& tensor_def,
+                                      const Type& type);
+  Constant* CreateConstantFromExternalData(const onnx::TensorProto& tensor_def,
+                                           const Type& type);
   Status ConvertConstNode(const onnx::NodeProto& cur_node);
   Status ConvertDummyNode(const onnx::NodeProto& cur_node);
   Status ConvertPlaceholderNode(const onnx::ValueInfoProto& value_info_def);
@@ -89,6 +93,10 @@ class ONNXParser : public Parser {
   std::unique_ptr<ArgumentBuilder> arg_builder_;
   std::unique_ptr<ConstantBuilder> c_builder_;
   armory::Opts opts_;
+  // Keeps the parsed model alive for the constants that refer to it.
+  std::shared_ptr<const void> proto_owner_;
+  std::string model_dir_;
+  std::unordered_map<std::string, std::shared_ptr<MappedFile>> external_files_;
   std::unordered_map<std::string, std::pair<IRObject*, int>> inst_name_to_ptr_;
   std::unordered_map<std::string, std::function<Status(const onnx::NodeProto&)>>
       func_lists_;
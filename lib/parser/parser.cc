@@ -17,6 +17,11 @@
 
 #include "halo/lib/parser/parser.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <fstream>
 #include <memory>
 #include <set>
@@ -39,6 +44,30 @@ static bool ValidateFiles(const std::vector<std::string>& file_list) {
   return true;
 }
 
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  return std::shared_ptr<MappedFile>(
+      new MappedFile(static_cast<const char*>(data), size));
+}
+
+MappedFile::~MappedFile() {
+  munmap(const_cast<char*>(data_), size_); // NOLINT.
+}
+
 Status Parser::Parse(Function* function, Format format,
                      const std::string& variant,
                      const std::vector<std::string>& file_list,
@@ -41,23 +41,37 @@ Status TFParser::Parse(Function* function,
   // compatible with the version of the headers we compiled against.
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-  tensorflow::GraphDef graph_def;
   HLCHECK(!file_list.empty());
-
-  std::ifstream ifs(file_list.front());
-  HLCHECK(!ifs.fail());
-
-  if (!graph_def.ParseFromIstream(&ifs)) {
-    google::protobuf::io::IstreamInputStream input_stream(&ifs);
-    if (!google::protobuf::TextFormat::Parse(&input_stream, &graph_def)) {
-      LOG(ERROR) << "Encountered error(s) when parsing " << file_list.front();
+  const std::string& file_name = file_list.front();
+  auto model_file = MappedFile::Open(file_name);
+  HLCHECK(model_file != nullptr);
+
+  // The graph is parsed straight from the mapped file. The parsed tensors are
+  // used in place by constants, which keep `graph_def` alive.
+  auto graph_def = std::make_shared<tensorflow::GraphDef>();
+  bool parsed = false;
+  {
+    google::protobuf::io::ArrayInputStream input_stream(
+        model_file->GetData(), static_cast<int>(model_file->GetSize()));
+    google::protobuf::io::CodedInputStream coded_stream(&input_stream);
+    coded_stream.EnableAliasing(true);
+    coded_stream.SetTotalBytesLimit((2048LL << 20) - 1, 512LL << 20);
+    parsed = graph_def->ParseFromCodedStream(&coded_stream);
+  }
+  if (!parsed) {
+    graph_def->Clear();
+    google::protobuf::io::ArrayInputStream input_stream(
+        model_file->GetData(), static_cast<int>(model_file->GetSize()));
+    if (!google::protobuf::TextFormat::Parse(&input_stream, graph_def.get())) {
+      LOG(ERROR) << "Encountered error(s) when parsing " << file_name;
       return Status::ASSERTION;
     }
   }
+  proto_owner_ = graph_def;
 
   BasicBlockBuilder bb_builder(function);
   BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
-  return Parse(bb, graph_def, opts);
+  return Parse(bb, *graph_def, opts);
 }
 
 Status TFParser::Parse(BasicBlock* bb, const tensorflow::GraphDef& graph_def,
@@ -746,20 +760,27 @@ Status TFParser::ConvertPlaceholderNode(const tensorflow::NodeDef& node_def) {
 }
 
 template <typename T>
-Constant* TFParser::CreateConstant(TFAttrs* attrs, DataType data_type,
+Constant* TFParser::CreateConstant(DataType data_type,
                                    const tensorflow::NodeDef& node_def) {
-  std::vector<Tensor<std::string>> tensors;
-  if (attrs->Process<std::vector<Tensor<std::string>>>("value", &tensors)) {
-    HLCHECK(1 == tensors.size());
-    if (tensors.back().GetNeedDecode()) {
-      auto v = Tensor<T>::DecodeTensorContent(tensors.back().GetData().back());
-      auto inst = c_builder_->CreateConstant(
-          node_def.name(), Type(data_type, tensors.back().GetShape()), v);
-      inst_name_to_ptr_.emplace(node_def.name(), inst);
-      return inst;
-    }
+  auto it = node_def.attr().find("value");
+  if (it == node_def.attr().end() || !it->second.has_tensor() ||
+      it->second.tensor().tensor_content().empty()) {
+    return nullptr;
+  }
+  const tensorflow::TensorProto& tensor_proto = it->second.tensor();
+  const std::string& content = tensor_proto.tensor_content();
+  Type type(data_type, ProcessShape(tensor_proto.tensor_shape()));
+  HLCHECK(content.size() == sizeof(T) * type.GetTotalNumOfElements());
+  Constant* inst = nullptr;
+  if (proto_owner_ == nullptr) {
+    inst = c_builder_->CreateConstant(node_def.name(), type, content.data());
+  } else {
+    // Refer to the parsed tensor content instead of copying it.
+    inst = c_builder_->CreateExternalConstant(node_def.name(), type,
+                                              content.data(), proto_owner_);
   }
-  return nullptr;
+  inst_name_to_ptr_.emplace(node_def.name(), inst);
+  return inst;
 }
 
 Status TFParser::ConvertConstNode(const tensorflow::NodeDef& node_def) {
@@ -768,20 +789,19 @@ Status TFParser::ConvertConstNode(const tensorflow::NodeDef& node_def) {
   if (attrs.Process<DataType>("dtype", &data_type)) {
     switch (data_type) {
       case DataType::UINT8: {
-        CreateConstant<uint8_t>(&attrs, data_type, node_def);
+        CreateConstant<uint8_t>(data_type, node_def);
         break;
       }
 
       case DataType::INT8: {
         // definitely need decoded from tensor content
-        CreateConstant<int8_t>(&attrs, data_type, node_def);
+        CreateConstant<int8_t>(data_type, node_def);
         break;
       }
       case DataType::INT32: {
         // check need decoded from tensor content
-        std::vector<Tensor<std::string>> tensors;
-        IRObject* inst = nullptr;
-        if (CreateConstant<int>(&attrs, data_type, node_def) == nullptr) {
+        if (CreateConstant<int>(data_type, node_def) == nullptr) {
+          IRObject* inst = nullptr;
           std::vector<Tensor<int>> native_tensors;
           if (attrs.Process<std::vector<Tensor<int>>>("value",
                                                       &native_tensors)) {
@@ -791,34 +811,23 @@ Status TFParser::ConvertConstNode(const tensorflow::NodeDef& node_def) {
                 Type(data_type, native_tensors.back().GetShape()),
                 native_tensors.back().GetData());
           }
+          inst_name_to_ptr_.emplace(node_def.name(), inst);
         }
-        inst_name_to_ptr_.emplace(node_def.name(), inst);
         break;
       }
       case DataType::FLOAT32: {
         // check need decoded from tensor content
-        std::vector<Tensor<std::string>> tensors;
-        IRObject* inst = nullptr;
-        if (attrs.Process<std::vector<Tensor<std::string>>>("value",
-                                                            &tensors)) {
-          HLCHECK(1 == tensors.size());
-          if (tensors.back().GetNeedDecode()) {
-            auto v = Tensor<float>::DecodeTensorContent(
-                tensors.back().GetData().back());
-            inst = c_builder_->CreateConstant(
-                node_def.name(), Type(data_type, tensors.back().GetShape()), v);
-          } else {
-            std::vector<Tensor<float>> native_tensors;
-            if (attrs.Process<std::vector<Tensor<float>>>("value",
-                                                          &native_tensors)) {
-              HLCHECK(1 == native_tensors.size());
-              inst = c_builder_->CreateConstant(
-                  node_def.name(),
-                  Type(data_type, native_tensors.back().GetShape()),
-                  native_tensors.back().GetData());
-            }
+        if (CreateConstant<float>(data_type, node_def) == nullptr) {
+          std::vector<Tensor<float>> native_tensors;
+          if (attrs.Process<std::vector<Tensor<float>>>("value",
+                                                        &native_tensors)) {
+            HLCHECK(1 == native_tensors.size());
+            IRObject* inst = c_builder_->CreateConstant(
+                node_def.name(),
+                Type(data_type, native_tensors.back().GetShape()),
+                native_tensors.back().GetData());
+            inst_name_to_ptr_.emplace(node_def.name(), inst);
           }
-          inst_name_to_ptr_.emplace(node_def.name(), inst);
         }
         break;
       }
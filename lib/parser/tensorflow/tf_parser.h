@@ -79,7 +79,7 @@ class TFParser : public Parser {
   Status ConvertToHaloIR(const tensorflow::GraphDef& graph_def);
   Status ConvertOneNode(const tensorflow::NodeDef& cur_node, size_t index);
   template <typename T>
-  Constant* CreateConstant(TFAttrs* attrs, DataType data_type,
+  Constant* CreateConstant(DataType data_type,
                            const tensorflow::NodeDef& node_def);
 
 /// create node function auto generatered by tablegen
@@ -108,6 +108,8 @@ class TFParser : public Parser {
   std::unique_ptr<ArgumentBuilder> arg_builder_;
   std::unique_ptr<ConstantBuilder> c_builder_;
   armory::Opts opts_;
+  // Keeps the parsed graph alive for the constants that refer to it.
+  std::shared_ptr<const void> proto_owner_;
   std::unordered_map<std::string, IRObject*> inst_name_to_ptr_;
   std::unordered_map<std::string,
                      std::function<Status(const tensorflow::NodeDef&)>>
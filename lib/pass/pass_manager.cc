@@ -17,8 +17,130 @@
 
 #include "halo/lib/pass/pass_manager.h"
 
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <unordered_map>
+
+#include "halo/lib/threadpool/thread_pool.h"
+
 namespace halo {
 
+static size_t CountInstructions(const BasicBlock& bb) { return bb.size(); }
+
+static size_t CountInstructions(const Function& function) {
+  size_t n = 0;
+  for (auto& bb : function) {
+    n += CountInstructions(*bb);
+  }
+  return n;
+}
+
+static size_t CountInstructions(const Module& module) {
+  size_t n = 0;
+  for (auto& func : module) {
+    n += CountInstructions(*func);
+  }
+  return n;
+}
+
+static long GetPeakRSS() {
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+// Measures pass calls and records the statistics and trace events.
+class PassTimer {
+ public:
+  template <typename T, typename F>
+  bool Run(const Pass& pass, int depth, const T& unit, F&& run) {
+    size_t idx = GetIndex(pass, depth);
+    size_t before = CountInstructions(unit);
+    auto start = Clock::now();
+    bool changed = run();
+    auto end = Clock::now();
+    size_t after = CountInstructions(unit);
+
+    PassStatistics& stats = stats_[idx];
+    ++stats.calls;
+    stats.wall_time_ms +=
+        std::chrono::duration<double, std::milli>(end - start).count();
+    stats.insts_before += before;
+    stats.insts_after += after;
+    stats.peak_rss_kb = GetPeakRSS();
+    events_.push_back({idx, ToMicroseconds(start), ToMicroseconds(end), before,
+                       after});
+    return changed;
+  }
+
+  void AddIteration(const Pass& pass, int depth) {
+    ++stats_[GetIndex(pass, depth)].iterations;
+  }
+
+  const std::vector<PassStatistics>& GetStatistics() const { return stats_; }
+
+  void WriteChromeTrace(std::ostream& os) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Event {
+    size_t index;
+    double start_us;
+    double end_us;
+    size_t insts_before;
+    size_t insts_after;
+  };
+
+  size_t GetIndex(const Pass& pass, int depth) {
+    auto it = indices_.find(&pass);
+    if (it != indices_.end()) {
+      return it->second;
+    }
+    PassStatistics stats;
+    stats.name = pass.Name();
+    stats.depth = depth;
+    stats_.push_back(stats);
+    indices_[&pass] = stats_.size() - 1;
+    return stats_.size() - 1;
+  }
+
+  double ToMicroseconds(Clock::time_point t) const {
+    return std::chrono::duration<double, std::micro>(t - origin_).count();
+  }
+
+  Clock::time_point origin_ = Clock::now();
+  std::vector<PassStatistics> stats_;
+  std::unordered_map<const Pass*, size_t> indices_;
+  std::vector<Event> events_;
+};
+
+void PassTimer::WriteChromeTrace(std::ostream& os) const {
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << "{\"traceEvents\": [";
+  const char* sep = "\n";
+  for (const auto& event : events_) {
+    os << sep << "  {\"name\": \"";
+    for (char c : stats_[event.index].name) {
+      if (c == '"' || c == '\\') {
+        os << '\\';
+      }
+      os << c;
+    }
+    os << "\", \"cat\": \"pass\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+       << std::fixed << std::setprecision(3) << "\"ts\": " << event.start_us
+       << ", \"dur\": " << event.end_us - event.start_us
+       << ", \"args\": {\"insts_before\": " << event.insts_before
+       << ", \"insts_after\": " << event.insts_after << "}}";
+    sep = ",\n";
+  }
+  os << "\n], \"displayTimeUnit\": \"ms\"}\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+
 class PassManagerImpl {
  public:
   explicit PassManagerImpl(GlobalContext* ctx) : ctx_(*ctx) {}
@@ -33,11 +155,27 @@ class PassManagerImpl {
 
   void Print(std::ostream& os) const;
 
+  void EnableTiming(bool enable) {
+    timer_ = enable ? std::make_unique<PassTimer>() : nullptr;
+  }
+
+  void SetNumOfThreads(int n) {
+    pool_ = n > 1 ? std::make_unique<ThreadPool>(n) : nullptr;
+  }
+
+  const std::vector<PassStatistics>& GetStatistics() const;
+
+  void PrintTiming(std::ostream& os) const;
+
+  void WriteChromeTrace(std::ostream& os) const;
+
  private:
   FunctionPassManager* GetFunctionPassManager();
 
   GlobalContext& ctx_;
   std::list<std::unique_ptr<ModulePass>> passes_;
+  std::unique_ptr<PassTimer> timer_;
+  std::unique_ptr<ThreadPool> pool_;
 }; // namespace halo
 
 PassManager::PassManager(GlobalContext& ctx)
@@ -63,6 +201,22 @@ void PassManager::Print(std::ostream& os) const { impl_->Print(os); }
 
 void PassManager::Dump() const { Print(GlobalContext::Dbgs()); }
 
+void PassManager::EnableTiming(bool enable) { impl_->EnableTiming(enable); }
+
+void PassManager::SetNumOfThreads(int n) { impl_->SetNumOfThreads(n); }
+
+const std::vector<PassStatistics>& PassManager::GetStatistics() const {
+  return impl_->GetStatistics();
+}
+
+void PassManager::PrintTiming(std::ostream& os) const {
+  impl_->PrintTiming(os);
+}
+
+void PassManager::WriteChromeTrace(std::ostream& os) const {
+  impl_->WriteChromeTrace(os);
+}
+
 // BasicBlockPassManager is a function level pass that contains basic block
 // passes.
 class BasicBlockPassManager final : public FunctionPass {
@@ -72,9 +226,18 @@ class BasicBlockPassManager final : public FunctionPass {
     bool changed = true;
     while (changed) {
       changed = false;
+      if (timer_ != nullptr) {
+        timer_->AddIteration(*this, 1);
+      }
       for (auto& bb : *function) {
         for (auto& fp : passes_) {
-          changed |= fp->RunOnBasicBlock(bb.get());
+          if (timer_ == nullptr) {
+            changed |= fp->RunOnBasicBlock(bb.get());
+          } else {
+            changed |= timer_->Run(*fp, 2, *bb, [&fp, &bb]() {
+              return fp->RunOnBasicBlock(bb.get());
+            });
+          }
         }
       }
       if (!changed) {
@@ -87,6 +250,8 @@ class BasicBlockPassManager final : public FunctionPass {
     passes_.push_back(std::move(pass));
   }
 
+  void SetTimer(PassTimer* timer) noexcept { timer_ = timer; }
+
   void Print(std::ostream& os) const override {
     os << Name() << "\n";
     for (auto& pass : passes_) {
@@ -96,8 +261,15 @@ class BasicBlockPassManager final : public FunctionPass {
 
   bool IsPassManager() const noexcept override { return true; }
 
+  bool CanRunConcurrently() const noexcept override {
+    return std::all_of(passes_.begin(), passes_.end(), [](const auto& pass) {
+      return pass->CanRunConcurrently();
+    });
+  }
+
  private:
   std::list<std::unique_ptr<BasicBlockPass>> passes_;
+  PassTimer* timer_ = nullptr;
 };
 
 // FunctionPassManager is a module level pass that contains function passes.
@@ -108,15 +280,37 @@ class FunctionPassManager final : public ModulePass {
     bool changed = true;
     while (changed) {
       changed = false;
+      if (timer_ != nullptr) {
+        timer_->AddIteration(*this, 0);
+      }
+      if (ShouldRunConcurrently(*module)) {
+        changed |= RunInGroups(module);
+        continue;
+      }
       for (auto& func : *module) {
         for (auto& fp : passes_) {
-          changed |= fp->RunOnFunction(func.get());
+          if (timer_ == nullptr) {
+            changed |= fp->RunOnFunction(func.get());
+          } else {
+            changed |= timer_->Run(*fp, 1, *func, [&fp, &func]() {
+              return fp->RunOnFunction(func.get());
+            });
+          }
         }
       }
     }
     return changed;
   }
 
+  void SetTimer(PassTimer* timer) {
+    timer_ = timer;
+    for (auto& pass : passes_) {
+      if (pass->IsPassManager()) {
+        Downcast<BasicBlockPassManager>(pass.get())->SetTimer(timer);
+      }
+    }
+  }
+
   void AddPass(std::unique_ptr<FunctionPass> pass) {
     passes_.push_back(std::move(pass));
   }
@@ -140,7 +334,76 @@ class FunctionPassManager final : public ModulePass {
   bool IsPassManager() const noexcept override { return true; }
 
  private:
+  // Each function creates its IR objects with ids from its own block, so the
+  // result does not depend on how the functions are scheduled.
+  static constexpr uint64_t kIdBlockSize = 1ULL << 32;
+
+  using PassIter = std::list<std::unique_ptr<FunctionPass>>::iterator;
+
+  bool ShouldRunConcurrently(const Module& module) const {
+    // The timer is not thread-safe.
+    return GetThreadPool() != nullptr && timer_ == nullptr &&
+           module.Functions().size() > 1 &&
+           std::any_of(passes_.begin(), passes_.end(), [](const auto& pass) {
+             return pass->CanRunConcurrently();
+           });
+  }
+
+  // Splits the passes into runs of consecutive passes that can or cannot run
+  // concurrently, and runs each run on all functions before the next one.
+  // Function passes only change the function they run on, so this gives the
+  // same result as running all passes on one function after another.
+  bool RunInGroups(Module* module) {
+    bool changed = false;
+    for (auto begin = passes_.begin(); begin != passes_.end();) {
+      const bool concurrent = (*begin)->CanRunConcurrently();
+      auto end = std::find_if(begin, passes_.end(), [concurrent](auto& pass) {
+        return pass->CanRunConcurrently() != concurrent;
+      });
+      if (concurrent) {
+        changed |= RunConcurrently(module, begin, end);
+      } else {
+        for (auto& func : *module) {
+          for (auto it = begin; it != end; ++it) {
+            changed |= (*it)->RunOnFunction(func.get());
+          }
+        }
+      }
+      begin = end;
+    }
+    return changed;
+  }
+
+  // Runs the passes in [pass_begin, pass_end) on all functions of `module` in
+  // parallel.
+  bool RunConcurrently(Module* module, PassIter pass_begin, PassIter pass_end) {
+    GlobalContext& ctx = module->GetGlobalContext();
+    std::vector<Function*> funcs;
+    funcs.reserve(module->Functions().size());
+    for (auto& func : *module) {
+      funcs.push_back(func.get());
+    }
+    const int64_t n = funcs.size();
+    const uint64_t base = ctx.GetGlobalCounter();
+    std::vector<char> changed(n, 0);
+    std::vector<uint64_t> next_ids(n, 0);
+    GetThreadPool()->ParallelFor(0, n, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        GlobalContext::IdScope scope(ctx, base + (i + 1) * kIdBlockSize);
+        for (auto it = pass_begin; it != pass_end; ++it) {
+          changed[i] |= (*it)->RunOnFunction(funcs[i]) ? 1 : 0;
+        }
+        next_ids[i] = scope.GetNextId();
+      }
+    });
+    ctx.AdvanceGlobalCounter(*std::max_element(next_ids.begin(),
+                                               next_ids.end()));
+    return std::any_of(changed.begin(), changed.end(),
+                       [](char c) { return c != 0; });
+  }
+
   std::list<std::unique_ptr<FunctionPass>> passes_;
+  PassTimer* timer_ = nullptr;
 };
 
 Pass* PassManagerImpl::Add(std::unique_ptr<ModulePass> pass) {
@@ -165,11 +428,60 @@ Pass* PassManagerImpl::Add(std::unique_ptr<BasicBlockPass> pass) {
 
 Status PassManagerImpl::Run(Module* module) {
   for (auto& pass : passes_) {
-    pass->RunOnModule(module);
+    pass->SetThreadPool(pool_.get());
+    if (timer_ == nullptr) {
+      pass->RunOnModule(module);
+      continue;
+    }
+    if (pass->IsPassManager()) {
+      Downcast<FunctionPassManager>(pass.get())->SetTimer(timer_.get());
+    }
+    timer_->Run(*pass, 0, *module,
+                [&pass, module]() { return pass->RunOnModule(module); });
   }
   return Status::SUCCESS;
 }
 
+const std::vector<PassStatistics>& PassManagerImpl::GetStatistics() const {
+  static const std::vector<PassStatistics> empty;
+  return timer_ == nullptr ? empty : timer_->GetStatistics();
+}
+
+void PassManagerImpl::PrintTiming(std::ostream& os) const {
+  const auto& stats = GetStatistics();
+  double total_ms = 0;
+  for (const auto& s : stats) {
+    total_ms += s.depth == 0 ? s.wall_time_ms : 0;
+  }
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << "===" << std::string(73, '-') << "===\n"
+     << std::string(25, ' ') << "Pass execution timing report\n"
+     << "===" << std::string(73, '-') << "===\n"
+     << "  Total Execution Time: " << std::fixed << std::setprecision(3)
+     << total_ms << " ms\n\n"
+     << "  Wall (ms)      %  Calls  Iters  Insts In  Insts Out  Peak RSS (MB)"
+        "  Name\n";
+  for (const auto& s : stats) {
+    os << std::setw(11) << std::setprecision(3) << s.wall_time_ms
+       << std::setw(7) << std::setprecision(1)
+       << (total_ms > 0 ? s.wall_time_ms * 100 / total_ms : 0.0)
+       << std::setw(7) << s.calls << std::setw(7) << s.iterations
+       << std::setw(10) << s.insts_before << std::setw(11) << s.insts_after
+       << std::setw(15) << std::setprecision(1)
+       << static_cast<double>(s.peak_rss_kb) / 1024 << "  "
+       << std::string(2 * s.depth, ' ') << s.name << "\n";
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void PassManagerImpl::WriteChromeTrace(std::ostream& os) const {
+  if (timer_ != nullptr) {
+    timer_->WriteChromeTrace(os);
+  }
+}
+
 FunctionPassManager* PassManagerImpl::GetFunctionPassManager() {
   if (passes_.empty() || !passes_.back()->IsPassManager()) {
     passes_.push_back(std::make_unique<FunctionPassManager>());
@@ -0,0 +1,190 @@
+//===- worklist.cc --------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/pass/worklist.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace halo {
+
+void InstWorklist::Push(Instruction* inst) {
+  if (inst == nullptr || inst->GetParent() != bb_) {
+    return;
+  }
+  if (indices_.emplace(inst, list_.size()).second) {
+    list_.push_back(inst);
+  }
+}
+
+void InstWorklist::PushAll() {
+  list_.reserve(list_.size() + bb_->size());
+  for (auto it = bb_->rbegin(), e = bb_->rend(); it != e; ++it) {
+    Push(it->get());
+  }
+}
+
+void InstWorklist::PushUsers(const IRObject& obj) {
+  for (const auto& uses : obj.GetResultsUses()) {
+    for (const auto& use : uses) {
+      if (IsA<Instruction>(use.GetUse())) {
+        Push(Downcast<Instruction>(use.GetUse()));
+      }
+    }
+  }
+}
+
+void InstWorklist::PushOperands(const IRObject& obj) {
+  for (const auto& op : obj.GetOperands()) {
+    if (!op.IsNull() && IsA<Instruction>(op.GetOwner())) {
+      Push(Downcast<Instruction>(op.GetOwner()));
+    }
+  }
+}
+
+Instruction* InstWorklist::Pop() {
+  while (!list_.empty()) {
+    Instruction* inst = list_.back();
+    list_.pop_back();
+    if (inst != nullptr) {
+      indices_.erase(inst);
+      return inst;
+    }
+  }
+  return nullptr;
+}
+
+void InstWorklist::Remove(const Instruction* inst) {
+  auto it = indices_.find(inst);
+  if (it != indices_.end()) {
+    list_[it->second] = nullptr;
+    indices_.erase(it);
+  }
+}
+
+struct WorklistPass::RunState {
+  explicit RunState(BasicBlock* bb) : worklist(bb) {}
+  InstWorklist worklist;
+  // Instructions with a larger id were created during the run.
+  uint64_t last_old_id = 0;
+  std::unordered_set<const Instruction*> new_insts;
+  std::unordered_set<const Instruction*> erased;
+};
+
+thread_local WorklistPass::RunState* WorklistPass::run_state_ = nullptr;
+
+bool WorklistPass::RunOnBasicBlock(BasicBlock* bb) {
+  bool changed = Initialize(bb);
+  RunState state(bb);
+  RunState* outer_state = run_state_;
+  run_state_ = &state;
+  for (auto& inst : *bb) {
+    state.last_old_id = std::max(state.last_old_id, inst->GetId());
+  }
+  state.worklist.PushAll();
+  while (!state.worklist.IsEmpty()) {
+    Instruction* inst = state.worklist.Pop();
+    if (state.erased.count(inst) != 0) {
+      continue;
+    }
+    if (erase_dead_ && EraseIfDead(&state, inst)) {
+      changed = true;
+      continue;
+    }
+    changed |= Visit(inst);
+  }
+  run_state_ = outer_state;
+  if (!state.erased.empty()) {
+    bb->Instructions().remove_if([&state](const auto& inst) {
+      return state.erased.count(inst.get()) != 0;
+    });
+  }
+  changed |= Finalize(bb);
+  return changed;
+}
+
+void WorklistPass::ReplaceAllUsesWith(Instruction* inst, size_t idx,
+                                      const Def& new_def) {
+  InstWorklist& worklist = run_state_->worklist;
+  for (const auto& use : inst->GetIthResultUses(idx)) {
+    if (IsA<Instruction>(use.GetUse())) {
+      worklist.Push(Downcast<Instruction>(use.GetUse()));
+    }
+  }
+  inst->ReplaceAllUsesWith(idx, new_def);
+  PushNewInstructions(run_state_, new_def);
+  // The replacement has new users.
+  if (!new_def.IsNull() && IsA<Instruction>(new_def.GetOwner())) {
+    worklist.Push(Downcast<Instruction>(new_def.GetOwner()));
+  }
+  if (erase_dead_) {
+    // `inst` may be dead now.
+    worklist.Push(inst);
+  }
+}
+
+void WorklistPass::ReplaceAllUsesWith(Instruction* inst,
+                                      const std::vector<Def>& new_defs) {
+  HLCHECK(new_defs.size() == inst->GetNumOfResults());
+  for (size_t i = 0, e = new_defs.size(); i < e; ++i) {
+    ReplaceAllUsesWith(inst, i, new_defs[i]);
+  }
+}
+
+void WorklistPass::AddToWorklist(Instruction* inst) {
+  InstWorklist& worklist = run_state_->worklist;
+  worklist.PushUsers(*inst);
+  worklist.PushOperands(*inst);
+  for (const auto& op : inst->GetOperands()) {
+    PushNewInstructions(run_state_, op);
+  }
+  worklist.Push(inst);
+}
+
+void WorklistPass::PushNewInstructions(RunState* state, const Def& def) {
+  if (def.IsNull() || !IsA<Instruction>(def.GetOwner())) {
+    return;
+  }
+  std::vector<Instruction*> stack{Downcast<Instruction>(def.GetOwner())};
+  while (!stack.empty()) {
+    Instruction* inst = stack.back();
+    stack.pop_back();
+    if (inst->GetId() <= state->last_old_id ||
+        !state->new_insts.insert(inst).second) {
+      continue;
+    }
+    state->worklist.Push(inst);
+    for (const auto& op : inst->GetOperands()) {
+      if (!op.IsNull() && IsA<Instruction>(op.GetOwner())) {
+        stack.push_back(Downcast<Instruction>(op.GetOwner()));
+      }
+    }
+  }
+}
+
+bool WorklistPass::EraseIfDead(RunState* state, Instruction* inst) {
+  if (inst->GetOpCode() == OpCode::RETURN || inst->GetNumberOfUses() != 0) {
+    return false;
+  }
+  // The operands may become dead.
+  state->worklist.PushOperands(*inst);
+  inst->DropAllOperands();
+  state->erased.insert(inst);
+  return true;
+}
+
+} // end namespace halo
@@ -0,0 +1,246 @@
+//===- quantizer.cc -------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/quantizer/quantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "halo/lib/framework/common.h"
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+namespace halo {
+
+// The quantized values are symmetric, in [-127, 127].
+static constexpr int kInt8Max = 127;
+
+Quantizer::Ranges Quantizer::ReadCalibrationFile(const std::string& file_name) {
+  Ranges ranges;
+  std::ifstream ifs(file_name);
+  if (!ifs.good()) {
+    std::cerr << "Unable to open file " << file_name << std::endl;
+    return ranges;
+  }
+  std::string id;
+  float lo = 0;
+  float hi = 0;
+  while (ifs >> id >> lo >> hi) {
+    ranges[id] = {lo, hi};
+  }
+  return ranges;
+}
+
+// Returns the value id of `def` in the generated code.
+static std::string GetValueId(const Def& def) {
+  std::string id = def.GetOwner()->GetName();
+  std::replace_if(
+      id.begin(), id.end(),
+      [](char c) { return c == '/' || c == ' ' || c == '.' || c == '-'; },
+      '_');
+  return id;
+}
+
+// Returns the scale that maps [-range, range] to [-127, 127].
+static float GetScale(float range) {
+  return range > 0 ? range / kInt8Max : 1.0F;
+}
+
+// Quantizes the weights per channel along `axis`. Returns the scales.
+static std::vector<float> QuantizeWeights(const Constant& weights, int axis,
+                                          std::vector<int8_t>* quantized) {
+  const Type& type = weights.GetResultType();
+  int64_t channels = type.GetNumOfElementsInDim(axis);
+  int64_t inner = 1;
+  for (size_t i = axis + 1; i < type.GetNumOfDims(); ++i) {
+    inner *= type.GetNumOfElementsInDim(i);
+  }
+  const float* w = weights.GetDataPtr<float>();
+  int64_t n = type.GetTotalNumOfElements();
+  std::vector<float> scales(channels, 0);
+  for (int64_t i = 0; i < n; ++i) {
+    float& range = scales[i / inner % channels];
+    range = std::max(range, std::abs(w[i]));
+  }
+  std::transform(scales.begin(), scales.end(), scales.begin(), GetScale);
+  quantized->resize(n);
+  const float limit = kInt8Max;
+  for (int64_t i = 0; i < n; ++i) {
+    float q = std::round(w[i] / scales[i / inner % channels]);
+    (*quantized)[i] = static_cast<int8_t>(std::clamp(q, -limit, limit));
+  }
+  return scales;
+}
+
+// Returns the axis of the output channels of the weights and of the result of
+// `inst` if it can be quantized, or -1.
+static std::pair<int, int> GetChannelAxes(Instruction* inst) {
+  constexpr std::pair<int, int> none{-1, -1};
+  switch (inst->GetOpCode()) {
+    case OpCode::CONV2D: {
+      // The dequantization scales do not commute with clipping activations.
+      Conv2DInst* conv = DynCast<Conv2DInst>(inst);
+      if (conv->GetGroup() != 1 ||
+          (conv->GetActivation() != ActivationType::NONE &&
+           conv->GetActivation() != ActivationType::RELU)) {
+        return none;
+      }
+      const auto& info = ImageAxisInfo::GetImageAxisInfo(
+          conv->GetDataFormat(), conv->GetFilterFormat());
+      return {info.kernel_output_axis, info.data_channel_axis};
+    }
+    case OpCode::GEMM: {
+      GemmInst* gemm = DynCast<GemmInst>(inst);
+      if (gemm->GetActivation() != ActivationType::NONE &&
+          gemm->GetActivation() != ActivationType::RELU) {
+        return none;
+      }
+      return {gemm->GetTransposeB() ? 0 : 1, 1};
+    }
+    case OpCode::MATMUL: {
+      MatMulInst* matmul = DynCast<MatMulInst>(inst);
+      if (matmul->GetOperand(0).GetType().GetNumOfDims() != 2) {
+        return none;
+      }
+      return {matmul->GetTransposeB() ? 0 : 1, 1};
+    }
+    default:
+      return none;
+  }
+}
+
+static Instruction* CreateInt8Inst(IRBuilder* builder, const Instruction* inst,
+                                   const std::vector<Def>& operands) {
+  const std::string name = inst->GetName() + "_int8";
+  Instruction* ret = nullptr;
+  switch (inst->GetOpCode()) {
+    case OpCode::CONV2D:
+      ret = builder->CreateConv2D(name, operands);
+      break;
+    case OpCode::GEMM:
+      ret = builder->CreateGemm(name, operands);
+      break;
+    default:
+      HLCHECK(inst->GetOpCode() == OpCode::MATMUL);
+      ret = builder->CreateMatMul(name, operands);
+      break;
+  }
+  ret->CopyAttrsFrom(*inst);
+  ret->GetResultsTypes()[0] =
+      Type{DataType::INT32, inst->GetResultType().GetDimSizes()};
+  return ret;
+}
+
+bool Quantizer::RunOnBasicBlock(BasicBlock* bb) {
+  bool changed = false;
+  IRBuilder builder(bb);
+  ConstantBuilder cb(bb->GetParent());
+  // Inputs shared by several instructions are quantized once.
+  std::unordered_map<Def, std::pair<Def, float>> quantized_inputs;
+
+  for (auto& inst_t : *bb) {
+    Instruction* inst = inst_t.get();
+    auto axes = GetChannelAxes(inst);
+    if (axes.first < 0 || inst->GetNumberOfUses() == 0 ||
+        !inst->GetResultType().IsValid()) {
+      continue;
+    }
+    const Def& input = inst->GetOperand(0);
+    const Def& weights = inst->GetOperand(1);
+    const halo::Type& weights_type = weights.GetType();
+    if (input.GetType().GetDataType() != DataType::FLOAT32 ||
+        !IsA<Constant>(weights) ||
+        weights_type.GetDataType() != DataType::FLOAT32 ||
+        weights_type.GetNumOfDims() != input.GetType().GetNumOfDims()) {
+      continue;
+    }
+    int64_t channels = weights_type.GetNumOfElementsInDim(axes.first);
+    if (channels != inst->GetResultType().GetNumOfElementsInDim(axes.second)) {
+      continue;
+    }
+    bool has_bias = inst->GetNumOfOperands() == 3;
+    if (has_bias) {
+      const Def& bias = inst->GetOperand(2);
+      if (!IsA<Constant>(bias) ||
+          bias.GetType().GetDataType() != DataType::FLOAT32 ||
+          bias.GetType().GetTotalNumOfElements() != channels) {
+        continue;
+      }
+    }
+    auto it = quantized_inputs.find(input);
+    if (it == quantized_inputs.end()) {
+      auto range = ranges_.find(GetValueId(input));
+      if (input.GetIdx() != 0 || range == ranges_.end()) {
+        continue;
+      }
+      const auto& [lo, hi] = range->second;
+      float scale = GetScale(std::max(std::abs(lo), std::abs(hi)));
+      builder.SetInsertAfter(inst);
+      QuantizeInst* q = builder.CreateQuantize(
+          input.GetOwner()->GetName() + "_quantized", input);
+      q->SetScale(scale);
+      q->SetZeroPoint(0);
+      q->SetDataType(DataType::INT8);
+      q->GetResultsTypes()[0] =
+          halo::Type{DataType::INT8, input.GetType().GetDimSizes()};
+      it = quantized_inputs.emplace(input, std::make_pair(Def{q, 0}, scale))
+               .first;
+    } else {
+      builder.SetInsertAfter(inst);
+    }
+    float input_scale = it->second.second;
+
+    std::vector<int8_t> q_weights;
+    std::vector<float> scales = QuantizeWeights(
+        *DynCast<Constant>(weights), axes.first, &q_weights);
+    halo::Type q_weights_type{DataType::INT8, weights_type.GetDimSizes()};
+    std::vector<Def> operands{
+        it->second.first,
+        *cb.CreateConstant(inst->GetName() + "_int8_weights", q_weights_type,
+                           q_weights)};
+    for (float& scale : scales) {
+      scale *= input_scale;
+    }
+    if (has_bias) {
+      const Constant* bias = DynCast<Constant>(inst->GetOperand(2));
+      std::vector<int32_t> q_bias(channels);
+      for (int64_t i = 0; i < channels; ++i) {
+        q_bias[i] = static_cast<int32_t>(
+            std::round(bias->GetDataPtr<float>()[i] / scales[i]));
+      }
+      halo::Type q_bias_type{DataType::INT32,
+                             bias->GetResultType().GetDimSizes()};
+      operands.push_back(*cb.CreateConstant(inst->GetName() + "_int32_bias",
+                                            q_bias_type, q_bias));
+    }
+
+    Instruction* int8_inst = CreateInt8Inst(&builder, inst, operands);
+    DequantizeInst* dq = builder.CreateDequantize(
+        inst->GetName() + "_dequantized", *int8_inst);
+    dq->SetScales(scales);
+    dq->SetAxis(axes.second);
+    dq->GetResultsTypes()[0] = inst->GetResultType();
+    inst->ReplaceAllUsesWith(0, *dq);
+    changed = true;
+  }
+  return changed;
+}
+
+} // end namespace halo
@@ -23,4 +23,16 @@ void GenericCXXCodeGen::RunOnInstruction(FPtoSIInst* inst) {
   VLOG(0) << "TODO cast is not implemented";
 }
 
+void GenericCXXCodeGen::RunOnInstruction(FPtoFPInst* inst) {
+  const Def& input = inst->GetOperand(0);
+
+  CXXValue op0 = ir_mapping_[input];
+
+  CXXValue ret(inst->GetName(),
+               TensorTypeToCXXType(inst->GetResultType(), false));
+
+  EmitODLACall(ret, "odla_Cast", op0, inst->GetDataType());
+  ir_mapping_[*inst] = ret;
+}
+
 } // end namespace halo
\ No newline at end of file
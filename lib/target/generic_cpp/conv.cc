@@ -75,6 +75,14 @@ void GenericCXXCodeGen::RunOnInstruction(Conv2DInst* inst) {
     bias_name = op2.name;
     bias_ty = bias.GetType();
   }
+  if (inst->GetActivation() != ActivationType::NONE) {
+    EmitODLACall(ret, "odla_FusedConv", op0, data_layout, group, op1,
+                 kernel_layout, strides, dilations, paddings_front,
+                 paddings_back, bias_name, inst->GetActivation(),
+                 inst->GetActivationAlpha(), EmitShape(ret_type));
+    ir_mapping_[*inst] = ret;
+    return;
+  }
   EmitODLACall(ret, "odla_Conv", op0, data_layout, group, op1, kernel_layout,
                std::vector<uint32_t>{stride_h, stride_w},
                std::vector<uint32_t>{dilation_h, dilation_w},
@@ -41,8 +41,14 @@ void GenericCXXCodeGen::RunOnInstruction(GemmInst* inst) {
 
   CXXValue ret(inst->GetName(), op0.type);
 
-  EmitODLACall(ret, "odla_Gemm", op0, inst->GetTransposeA(), op1,
-               inst->GetTransposeB(), 1, 0, bias_name, EmitShape(ret_type));
+  if (inst->GetActivation() != ActivationType::NONE) {
+    EmitODLACall(ret, "odla_FusedGemm", op0, inst->GetTransposeA(), op1,
+                 inst->GetTransposeB(), 1, 0, bias_name, inst->GetActivation(),
+                 inst->GetActivationAlpha(), EmitShape(ret_type));
+  } else {
+    EmitODLACall(ret, "odla_Gemm", op0, inst->GetTransposeA(), op1,
+                 inst->GetTransposeB(), 1, 0, bias_name, EmitShape(ret_type));
+  }
   ir_mapping_[*inst] = ret;
 }
 
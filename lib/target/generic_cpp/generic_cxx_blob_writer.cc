@@ -0,0 +1,106 @@
+//===- generic_cxx_blob_writer.cc -----------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <unordered_map>
+#include <vector>
+
+#include "halo/lib/ir/constant_pool.h"
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+
+namespace halo {
+
+static uint64_t AlignTo(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+GenericCXXBlobConstantWriter::GenericCXXBlobConstantWriter(
+    std::ostream& blob_os, std::ostream& stub_os, std::ostream& header_os,
+    const std::string& blob_file_name)
+    : GenericCXXCodeGen(blob_os, header_os),
+      stub_os_(stub_os),
+      blob_file_name_(blob_file_name) {}
+
+bool GenericCXXBlobConstantWriter::RunOnModule(Module* module) {
+  const std::string blob_name =
+      CXXValue(module->GetName() + "_constants", CXXType("")).name;
+
+  stub_os_ << "/* Halo Compiler Generated File */\n\n";
+  stub_os_ << "  .section .rodata." << blob_name << ",\"a\",@progbits\n";
+  stub_os_ << "  .balign " << Alignment << "\n";
+  stub_os_ << "  .globl " << blob_name << "\n";
+  stub_os_ << "  .type " << blob_name << ", @object\n";
+  stub_os_ << blob_name << ":\n";
+
+  header_os_ << "//===- Halo Compiler Generated File "
+                "-------------------------------------===//\n\n";
+  header_os_ << "#include <stddef.h>\n\n";
+  header_os_ << "extern const unsigned char " << blob_name << "[];\n";
+
+  uint64_t offset = 0;
+  const std::string padding(Alignment, '\0');
+  ConstantPool pool;
+  // The symbol names and offsets of the emitted payloads.
+  std::unordered_map<const Constant*, std::pair<std::string, uint64_t>>
+      payloads;
+  for (auto& func : *module) {
+    for (auto& constant : func->Constants()) {
+      const auto& type = constant->GetResultType();
+      const std::string name =
+          CXXValue(constant->GetName(), TensorTypeToCXXType(type, true)).name;
+      uint64_t size = constant->GetElementSizeInBytes() *
+                      type.GetTotalNumOfElements();
+      stub_os_ << "  .globl " << name << "\n";
+      stub_os_ << "  .type " << name << ", @object\n";
+      stub_os_ << "  .size " << name << ", " << size << "\n";
+
+      const Constant* canonical = pool.Insert(constant.get());
+      if (canonical != constant.get()) {
+        // The data of duplicated constants is stored once.
+        const auto& [canonical_name, canonical_offset] =
+            payloads.at(canonical);
+        stub_os_ << "  .set " << name << ", " << canonical_name << "\n";
+        header_os_ << "static const size_t " << name
+                   << "_offset = " << canonical_offset << ";\n";
+        continue;
+      }
+      payloads.emplace(canonical, std::make_pair(name, offset));
+      os_.write(static_cast<const char*>(constant->GetRawDataPtr()), size);
+      uint64_t next = AlignTo(offset + size, Alignment);
+      os_.write(padding.data(), next - offset - size);
+
+      stub_os_ << name << ":\n";
+      if (size > 0) {
+        stub_os_ << "  .incbin \"" << blob_file_name_ << "\", " << offset
+                 << ", " << size << "\n";
+      }
+      stub_os_ << "  .balign " << Alignment << "\n";
+
+      header_os_ << "static const size_t " << name << "_offset = " << offset
+                 << ";\n";
+      offset = next;
+    }
+  }
+
+  stub_os_ << "  .size " << blob_name << ", " << offset << "\n";
+  // The constants do not need an executable stack.
+  stub_os_ << "  .section .note.GNU-stack,\"\",@progbits\n";
+  header_os_ << "static const size_t " << blob_name << "_size = " << offset
+             << ";\n";
+  return false;
+}
+
+} // namespace halo
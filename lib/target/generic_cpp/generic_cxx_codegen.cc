@@ -18,15 +18,22 @@
 #include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <set>
 #include <sstream>
+#include <typeinfo>
 
 #include "halo/api/halo_data.h"
+#include "halo/lib/framework/data_layout.h"
 #include "halo/lib/framework/global_context.h"
 #include "halo/lib/ir/all_instructions.h"
 #include "halo/lib/ir/instruction.h"
 #include "halo/lib/mm/memory_analyzer.h"
 #include "halo/lib/target/codegen.h"
 #include "halo/lib/target/codegen_object.h"
+#include "halo/lib/target/weights_file_writer.h"
+#include "halo/lib/threadpool/thread_pool.h"
 
 namespace halo {
 
@@ -46,7 +53,10 @@ std::string CXXType::Str(bool use_array_decl) const {
   return str;
 }
 
-void CXXValue::Reset() { name2id.clear(); }
+void CXXValue::Reset() {
+  std::lock_guard<std::mutex> lock(name2id_mutex);
+  name2id.clear();
+}
 void CXXValue::Normalize(const std::string& n) {
   std::transform(n.begin(), n.end(), name.begin(), [](char c) {
     switch (c) {
@@ -64,25 +74,19 @@ void CXXValue::Normalize(const std::string& n) {
 CXXValue::CXXValue(const std::string& name, const CXXType& type)
     : name(name), type(type) {
   Normalize(name);
-  if (name2id.count(name) == 0) {
-    name2id[name] = name2id.size();
-  }
-  id = name2id[name];
+  std::lock_guard<std::mutex> lock(name2id_mutex);
+  id = name2id.emplace(name, name2id.size()).first->second;
 }
 
 GenericCXXCodeGen::GenericCXXCodeGen(std::ostream& os, std::ostream& header_os)
-    : CodeGen("Generic CXX Compilation"), os_(os), header_os_(header_os) {
-  CXXValue::Reset();
-}
+    : CodeGen("Generic CXX Compilation"), os_(os), header_os_(header_os) {}
 
 GenericCXXCodeGen::GenericCXXCodeGen(std::ostream& os, std::ostream& header_os,
                                      const Opts& opts)
     : CodeGen("Generic CXX Compilation"),
       os_(os),
       header_os_(header_os),
-      opts_(opts) {
-  CXXValue::Reset();
-}
+      opts_(opts) {}
 
 GenericCXXCodeGen::~GenericCXXCodeGen() = default;
 
@@ -109,14 +113,128 @@ static void EmitBanner(std::ostream* os, std::ostream* header_os,
   *os << "#include " << GetIncludeFile(api) << "\n\n";
 }
 
+// Returns the FNV-1a hash of the module and its constants as a hex string.
+// Computations stored by the generated code are keyed by it.
+static std::string GetModelHash(const Module& module) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&hash](const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  };
+  std::ostringstream ir;
+  module.Print(ir);
+  const std::string& ir_str = ir.str();
+  update(ir_str.data(), ir_str.size());
+  for (const auto& func : module) {
+    for (const auto& c : func->Constants()) {
+      update(c->GetRawDataPtr(),
+             c->GetElementSizeInBytes() *
+                 c->GetResultType().GetTotalNumOfElements());
+    }
+  }
+  std::ostringstream oss;
+  oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return oss.str();
+}
+
+static void EmitDynamicBatchItems(std::ostream* os, const Opts& opts) {
+  *os << "bool is_dynamic_batch = true;\n";
+  *os << "int min_batch_size = " << opts.min_batch_size << ";\n";
+  *os << "int max_batch_size = " << opts.max_batch_size << ";\n";
+  *os << "int opt_batch_size = " << opts.opt_batch_size << ";\n";
+  *os << "odla_SetComputationItem(Comp, ODLA_DYNAMIC_BATCH, "
+         "(odla_item_value) &is_dynamic_batch);\n";
+  *os << "odla_SetComputationItem(Comp, ODLA_MIN_BATCH_SIZE, "
+         "(odla_item_value) &min_batch_size);\n";
+  *os << "odla_SetComputationItem(Comp, ODLA_MAX_BATCH_SIZE, "
+         "(odla_item_value) &max_batch_size);\n";
+  *os << "odla_SetComputationItem(Comp, ODLA_OPT_BATCH_SIZE, "
+         "(odla_item_value) &opt_batch_size);\n";
+}
+
+// Returns the size in bytes of one sample of `type`, whose first dimension is
+// the batch.
+static size_t GetSampleSize(const Type& type) {
+  const auto& dims = type.GetDimSizes();
+  size_t num_of_elements = 1;
+  for (size_t i = 1; i < dims.size(); ++i) {
+    num_of_elements *= dims[i];
+  }
+  return DefaultDataLayout().Bytes(type.GetDataType(), num_of_elements);
+}
+
+// Emits the sample sizes of the inputs and outputs of model_run() and the
+// maximum batch size, which configure a batcher (see ODLA/odla_batching.h).
+// The declarations go to `decl_os` and the definitions to `def_os`.
+static void EmitBatchingInfo(const Function& func, const Instruction& ret_inst,
+                             const Opts& opts, std::ostream* decl_os,
+                             std::ostream* def_os) {
+  std::vector<size_t> input_sizes;
+  int64_t max_batch_size = opts.emit_dynamic_batch ? opts.max_batch_size : 1;
+  for (auto& arg : func.Args()) {
+    const auto& type = arg->GetResultType();
+    input_sizes.push_back(GetSampleSize(type));
+    if (!opts.emit_dynamic_batch && input_sizes.size() == 1 &&
+        type.GetNumOfDims() > 0) {
+      max_batch_size = type.GetNumOfElementsInDim(0);
+    }
+  }
+  std::vector<size_t> output_sizes;
+  for (auto& op : ret_inst.GetOperands()) {
+    output_sizes.push_back(GetSampleSize(op.GetType()));
+  }
+  auto join = [](const std::vector<size_t>& sizes) {
+    std::ostringstream ss;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      ss << (i == 0 ? "" : ", ") << sizes[i];
+    }
+    return ss.str();
+  };
+  *decl_os << "extern const int model_num_inputs;\n";
+  *decl_os << "extern const odla_size_t model_input_sizes[];\n";
+  *decl_os << "extern const int model_num_outputs;\n";
+  *decl_os << "extern const odla_size_t model_output_sizes[];\n";
+  *decl_os << "extern const int model_max_batch_size;\n";
+  *def_os << "const int model_num_inputs = " << input_sizes.size() << ";\n";
+  *def_os << "const odla_size_t model_input_sizes[] = {"
+          << join(input_sizes) << "};\n";
+  *def_os << "const int model_num_outputs = " << output_sizes.size() << ";\n";
+  *def_os << "const odla_size_t model_output_sizes[] = {"
+          << join(output_sizes) << "};\n";
+  *def_os << "const int model_max_batch_size = " << max_batch_size << ";\n";
+}
+
 bool GenericCXXCodeGen::RunOnModule(Module* module) {
+  // Value ids are numbered per module. The emitters of single functions do
+  // not reset them, as they run in the middle of a module.
+  CXXValue::Reset();
   memory_analyzer_ = std::make_unique<MemoryAnalyzer>(*module);
   Function* entry_func = nullptr;
   EmitBanner(&os_, &header_os_, GetAPI());
+  if (opts_.dialect == Dialect::CXX_11 &&
+      opts_.exec_mode == CodeGen::ExecMode::Compile) {
+    os_ << "#include <mutex>\n\n";
+  }
+  if (opts_.emit_weights_file) {
+    os_ << "static odla_constants_array Weights;\n";
+  }
+  std::vector<Function*> funcs;
   for (auto& func : *module) {
     if (func->IsEntryFunction()) {
       entry_func = func.get();
     } else {
+      funcs.push_back(func.get());
+    }
+  }
+  // The memory statistics cover the whole module and the value ids depend on
+  // the order in which values are created, so both need serial emission.
+  if (GetThreadPool() != nullptr && funcs.size() > 1 &&
+      !opts_.print_mem_stats && !opts_.emit_value_id_as_int) {
+    RunOnFunctionsConcurrently(funcs);
+  } else {
+    for (Function* func : funcs) {
       RunOnFunction(*func);
     }
   }
@@ -140,8 +258,54 @@ bool GenericCXXCodeGen::RunOnModule(Module* module) {
   return false;
 }
 
+std::unique_ptr<GenericCXXCodeGen> GenericCXXCodeGen::CreateFunctionEmitter(
+    std::ostream& os, std::ostream& header_os) const {
+  if (typeid(*this) != typeid(GenericCXXCodeGen)) {
+    return nullptr;
+  }
+  auto emitter = std::make_unique<GenericCXXCodeGen>(os, header_os, opts_);
+  emitter->SetAPI(GetAPI());
+  return emitter;
+}
+
+void GenericCXXCodeGen::RunOnFunctionsConcurrently(
+    const std::vector<Function*>& funcs) {
+  const size_t n = funcs.size();
+  std::vector<std::ostringstream> code(n);
+  std::vector<std::ostringstream> headers(n);
+  std::vector<std::unique_ptr<GenericCXXCodeGen>> emitters(n);
+  for (size_t i = 0; i < n; ++i) {
+    emitters[i] = CreateFunctionEmitter(code[i], headers[i]);
+    if (emitters[i] == nullptr) {
+      for (Function* func : funcs) {
+        RunOnFunction(*func);
+      }
+      return;
+    }
+    emitters[i]->memory_analyzer_ = std::make_unique<MemoryAnalyzer>(*funcs[i]);
+  }
+  GetThreadPool()->ParallelFor(0, n, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      emitters[i]->RunOnFunction(*funcs[i]);
+    }
+  });
+  for (size_t i = 0; i < n; ++i) {
+    os_ << code[i].str();
+    header_os_ << headers[i].str();
+  }
+}
+
 CXXValue GenericCXXCodeGen::AllocateBuffer(const Def& def, bool on_stack) {
-  return CXXValue("undef", CXXType(""));
+  if (on_stack || workspace_name_.empty() ||
+      !memory_planner_->HasOffset(def)) {
+    return CXXValue("undef", CXXType(""));
+  }
+  // Returns a view into the workspace at the planned offset.
+  CXXValue buf(def.GetOwner()->GetName(),
+               TensorTypeToCXXType(def.GetType(), false));
+  buf.name = "((" + buf.type.Str(false) + ")(" + workspace_name_ + " + " +
+             std::to_string(memory_planner_->GetOffset(def)) + "))";
+  return buf;
 }
 
 CXXType GenericCXXCodeGen::SNTypeToCXXType(DataType dt) {
@@ -156,6 +320,11 @@ CXXType GenericCXXCodeGen::SNTypeToCXXType(DataType dt) {
     case DataType::UINT16: {
       return (CXXType("unsigned short"));
     }
+    case DataType::FLOAT16:
+    case DataType::BFLOAT16: {
+      // The bit patterns, as odla_float16 and odla_bfloat16.
+      return (CXXType("uint16_t"));
+    }
     case DataType::FLOAT32: {
       return (CXXType("float"));
     }
@@ -189,8 +358,12 @@ std::string GenericCXXCodeGen::GetFunctionDecl(const Function& func,
   const static std::string inference_func_decl =
       "void model_run(int num_inputs, const void* inputs[],"
       "int num_outputs, void* outputs[])";
+  const static std::string dynamic_batch_inference_func_decl =
+      "void model_run(int num_inputs, const void* inputs[],"
+      "int num_outputs, void* outputs[], int batch_size)";
   if (opts_.emit_inference_func_sig && func.IsEntryFunction()) {
-    return inference_func_decl;
+    return opts_.emit_dynamic_batch ? dynamic_batch_inference_func_decl
+                                    : inference_func_decl;
   }
 
   std::ostringstream ss;
@@ -217,7 +390,7 @@ std::string GenericCXXCodeGen::GetFunctionDecl(const Function& func,
       if (with_type) {
         ss << (is_first ? "" : ", ") << cv.type.Str(true) << " " << cv.name
            << "[";
-        auto shape = type.GetDimSizes();
+        std::vector<int64_t> shape = type.GetDimSizes();
         if (type.IsDynamicBatch()) {
           shape[0] = 1;
         }
@@ -240,7 +413,7 @@ std::string GenericCXXCodeGen::GetFunctionDecl(const Function& func,
         ss << (is_first ? "" : ", ")
            << TensorTypeToCXXType(type, false).Str(true) << " out_" + cv.name
            << "[";
-        auto shape = type.GetDimSizes();
+        std::vector<int64_t> shape = type.GetDimSizes();
         if (type.IsDynamicBatch()) {
           shape[0] = 1;
         }
@@ -290,6 +463,18 @@ std::string GenericCXXCodeGen::GetODLAType(DataType type) const noexcept {
     case DataType::FLOAT32: {
       return "ODLA_FLOAT32";
     }
+    case DataType::FLOAT16: {
+      return "ODLA_FLOAT16";
+    }
+    case DataType::BFLOAT16: {
+      return "ODLA_BFLOAT16";
+    }
+    case DataType::INT8: {
+      return "ODLA_INT8";
+    }
+    case DataType::UINT8: {
+      return "ODLA_UINT8";
+    }
     case DataType::INT32: {
       return "ODLA_INT32";
     }
@@ -328,6 +513,15 @@ void GenericCXXCodeGen::RunOnHostFunction(Function& function) {
   if (opts_.dialect == Dialect::CXX_11) {
     os_ << DeclAsExtern(func_decl);
   }
+  if (opts_.emit_weights_file) {
+    // The sub-functions hold the constants; they share one weights file.
+    const std::string load_func_decl =
+        "int " + function.GetName() + "_load_weights(const char* file_name)";
+    header_os_ << load_func_decl << ";\n";
+    os_ << load_func_decl << " {\n";
+    os_ << "  return odla_LoadConstantsArray(file_name, &Weights);\n";
+    os_ << "}\n";
+  }
 
   os_ << func_decl << " {\n";
   os_ << "  static odla_device trt_dev;\n";
@@ -381,6 +575,21 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
     RunOnConstant(*constant, true);
   }
 
+  memory_planner_ = std::make_unique<MemoryPlanner>(function);
+  workspace_name_.clear();
+  if (opts_.print_mem_stats) {
+    std::cout << "Planned Workspace of " << function.GetName() << ": "
+              << memory_planner_->GetWorkspaceSize() << " bytes\n";
+  }
+  // With ODLA, the buffers are managed by the ODLA runtime. Otherwise, all
+  // buffers are views into one static workspace.
+  if (!IsODLA05() && memory_planner_->GetWorkspaceSize() > 0) {
+    workspace_name_ = function.GetName() + "_workspace";
+    os_ << "static char " << workspace_name_ << "["
+        << memory_planner_->GetWorkspaceSize() << "] __attribute__((aligned("
+        << MemoryPlanner::DefaultAlignment << ")));\n";
+  }
+
   Instruction* return_inst = function.GetReturnInst();
   HLCHECK(return_inst && "No Return Instruction found");
 
@@ -397,41 +606,52 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
 
   // contents in oss will be write to c file and header file.
   std::ostringstream oss;
+  std::ostringstream batching_info;
   const std::string init_func_name = function.GetName() + "_init";
   const std::string fini_func_name = function.GetName() + "_fini";
+  const std::string load_func_name = function.GetName() + "_load_weights";
 
   if (function.IsEntryFunction()) {
     if (opts_.dialect == Dialect::CXX_11) {
       oss << "extern \"C\" {\n";
     }
     oss << "  " << func_decl << ";\n";
+    if (opts_.emit_inference_func_sig && IsODLA05()) {
+      EmitBatchingInfo(function, *return_inst, opts_, &oss, &batching_info);
+    }
     oss << "void " << init_func_name << "();\n";
     oss << "void " << fini_func_name << "();\n";
+    if (opts_.emit_weights_file) {
+      // Maps the weights file. Returns 0 on success.
+      oss << "int " << load_func_name << "(const char* file_name);\n";
+    }
     if (opts_.dialect == Dialect::CXX_11) {
       oss << "};\n";
     }
   }
   os_ << oss.str();
   header_os_ << oss.str();
+  os_ << batching_info.str();
+  if (function.IsEntryFunction() && opts_.emit_weights_file) {
+    os_ << "int " << load_func_name << "(const char* file_name) {\n";
+    os_ << "  return odla_LoadConstantsArray(file_name, &Weights);\n";
+    os_ << "}\n";
+  }
 
+  bool guard_comp = is_compile_mode && opts_.dialect == Dialect::CXX_11;
+  // The computation executed by the run function.
+  std::string comp_name = "Comp";
   if (emit_builder_func) {
     os_ << "  static odla_computation Comp;\n";
+    if (guard_comp) {
+      // Serializes building and destroying the computation.
+      os_ << "static std::mutex CompMutex;\n";
+    }
     if (is_compile_mode) {
       os_ << "static void " << helper_func_name << "() {\n";
       os_ << "  odla_CreateComputation(&Comp);\n";
       if (opts_.emit_dynamic_batch) {
-        os_ << "bool is_dynamic_batch = true;\n";
-        os_ << "int min_batch_size = 1;\n";
-        os_ << "int max_batch_size = 8;\n";
-        os_ << "int opt_batch_size = 4;\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_DYNAMIC_BATCH, "
-               "(odla_item_value) &is_dynamic_batch);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_MIN_BATCH_SIZE, "
-               "(odla_item_value) &min_batch_size);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_MAX_BATCH_SIZE, "
-               "(odla_item_value) &max_batch_size);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_OPT_BATCH_SIZE, "
-               "(odla_item_value) &opt_batch_size);\n";
+        EmitDynamicBatchItems(&os_, opts_);
       }
     } else {
       os_ << "static odla_computation comp;\n"; // only for legacy odla
@@ -449,18 +669,7 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
       os_ << "  if (Comp == " << EmitNull() << ") {\n";
       os_ << "    odla_CreateComputation(&Comp);\n";
       if (opts_.emit_dynamic_batch) {
-        os_ << "bool is_dynamic_batch = true;\n";
-        os_ << "int min_batch_size = 1;\n";
-        os_ << "int max_batch_size = 8;\n";
-        os_ << "int opt_batch_size = 4;\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_DYNAMIC_BATCH, "
-               "(odla_item_value) &is_dynamic_batch);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_MIN_BATCH_SIZE, "
-               "(odla_item_value) &min_batch_size);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_MAX_BATCH_SIZE, "
-               "(odla_item_value) &max_batch_size);\n";
-        os_ << "odla_SetComputationItem(Comp, ODLA_OPT_BATCH_SIZE, "
-               "(odla_item_value) &opt_batch_size);\n";
+        EmitDynamicBatchItems(&os_, opts_);
       }
     }
   }
@@ -490,6 +699,31 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
     RunOnBasicBlock(*bb);
   }
 
+  if (!is_compile_mode) {
+    // The values are created by each run, so they are released once the
+    // outputs are copied.
+    std::set<std::string> released;
+    auto release = [this, &released](const Def& def) {
+      auto it = ir_mapping_.find(def);
+      if (it != ir_mapping_.end() && released.insert(it->second.name).second) {
+        os_ << "  odla_ReleaseValue(" << it->second.name << ");\n";
+      }
+    };
+    for (auto& arg : function.Args()) {
+      release(Def(arg.get(), 0));
+    }
+    for (auto& constant : function.Constants()) {
+      release(Def(constant.get(), 0));
+    }
+    for (auto& bb : function) {
+      for (auto& inst : *bb) {
+        for (size_t i = 0, e = inst->GetNumOfResults(); i < e; ++i) {
+          release(Def(inst.get(), static_cast<int>(i)));
+        }
+      }
+    }
+  }
+
   os_ << "}\n"; // End of computation build function.
 
   if (emit_builder_func) {
@@ -497,15 +731,39 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
     if (opts_.exec_mode == CodeGen::ExecMode::Compile) {
       if (function.IsEntryFunction()) {
         os_ << "void " << fini_func_name << "(){\n";
+        if (guard_comp) {
+          os_ << "  std::lock_guard<std::mutex> lock(CompMutex);\n";
+        }
         os_ << "  odla_DestroyComputation(Comp);\n";
+        os_ << "  Comp = " << EmitNull() << ";\n";
+        if (opts_.emit_weights_file) {
+          os_ << "  odla_DestroyConstantsArray(Weights);\n";
+        }
         os_ << "}\n";
 
         os_ << "void " << init_func_name << "(){\n";
       } else {
         os_ << GetFunctionDecl(function, *return_inst, true, true) << " {\n";
       }
-      os_ << "  if (Comp == " << EmitNull() << ") { " << helper_func_name
-          << "(); }\n";
+      if (guard_comp) {
+        os_ << "  std::lock_guard<std::mutex> lock(CompMutex);\n";
+      }
+      if (function.IsEntryFunction() && !opts_.exec_cache_dir.empty()) {
+        // Reuses the computation stored by an earlier run of the same model
+        // and stores it after building it otherwise.
+        const std::string cache_file = opts_.exec_cache_dir + "/" +
+                                       function.GetName() + "." +
+                                       GetModelHash(*function.GetParent()) +
+                                       ".odla";
+        os_ << "  if (Comp == " << EmitNull() << " && odla_LoadComputation(\""
+            << cache_file << "\", &Comp) != ODLA_SUCCESS) {\n";
+        os_ << "    " << helper_func_name << "();\n";
+        os_ << "    odla_StoreComputation(\"" << cache_file << "\", Comp);\n";
+        os_ << "  }\n";
+      } else {
+        os_ << "  if (Comp == " << EmitNull() << ") { " << helper_func_name
+            << "(); }\n";
+      }
       os_ << "}\n";
     }
     if (function.IsEntryFunction()) {
@@ -513,6 +771,15 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
       if (opts_.exec_mode == CodeGen::ExecMode::Compile) {
         os_ << "  " << init_func_name << "();\n";
       }
+      if (guard_comp) {
+        // Comp may be rebuilt by other threads, so it is read under the lock.
+        comp_name = "RunComp";
+        os_ << "  odla_computation " << comp_name << ";\n";
+        os_ << "  {\n";
+        os_ << "    std::lock_guard<std::mutex> lock(CompMutex);\n";
+        os_ << "    " << comp_name << " = Comp;\n";
+        os_ << "  }\n";
+      }
     }
 
     if (opts_.exec_mode == CodeGen::ExecMode::Interpret) {
@@ -524,7 +791,18 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
   }
 
   if (opts_.exec_mode == CodeGen::ExecMode::Compile) {
-    os_ << "  static odla_context Ctx;\n";
+    if (opts_.dialect == Dialect::CXX_11) {
+      // Each calling thread executes the shared computation with its own
+      // context, which is destroyed when the thread exits.
+      os_ << "  static thread_local struct ContextHolder {\n";
+      os_ << "    odla_context ctx = nullptr;\n";
+      os_ << "    ~ContextHolder() { if (ctx != nullptr) { "
+             "odla_DestroyContext(ctx); } }\n";
+      os_ << "  } Holder;\n";
+      os_ << "  odla_context& Ctx = Holder.ctx;\n";
+    } else {
+      os_ << "  static odla_context Ctx;\n";
+    }
     os_ << "  if (Ctx == " << EmitNull()
         << ") {  odla_CreateContext(&Ctx); };\n";
     if (opts_.emit_dynamic_batch) {
@@ -560,9 +838,8 @@ void GenericCXXCodeGen::RunOnFunction(Function& function) {
         << ");\n";
   }
   if (opts_.exec_mode == CodeGen::ExecMode::Compile) {
-    os_ << "  odla_ExecuteComputation(Comp, Ctx, "
-           "ODLA_COMPUTE_INFERENCE, "
-        << EmitNull() << ");\n";
+    os_ << "  odla_ExecuteComputation(" << comp_name << ", Ctx, "
+        << "ODLA_COMPUTE_INFERENCE, " << EmitNull() << ");\n";
   }
   os_ << "}\n";
 }
@@ -583,6 +860,16 @@ void GenericCXXCodeGen::RunOnConstant(Constant& constant, bool decl) {
   }
 
   auto& type = constant.GetResultType();
+  if (opts_.emit_weights_file) {
+    // The data stays in the mapped weights file.
+    if (!decl) {
+      CXXValue value(constant.GetName() + "_", TensorTypeToCXXType(type, true));
+      EmitODLACall(value, "odla_CreateConstantFromArray", "Weights", type,
+                   "\"" + WeightsFileWriter::GetEntryName(constant) + "\"");
+      ir_mapping_[constant] = value;
+    }
+    return;
+  }
   if (decl) {
     CXXValue value(constant.GetName(), TensorTypeToCXXType(type, true));
 
@@ -645,6 +932,11 @@ void GenericCXXCodeGen::EmitODLAArgs(const std::vector<uint32_t>& arg) {
   os_ << '{' << Join(arg) << '}';
 }
 
+void GenericCXXCodeGen::EmitODLAArgs(const std::vector<float>& arg) {
+  os_ << "(const odla_float32[])";
+  os_ << '{' << Join(arg) << '}';
+}
+
 void GenericCXXCodeGen::EmitODLAArgs(const std::vector<CXXValue>& arg) {
   os_ << "(odla_values){.size = " << arg.size() << ", .values = {";
   for (const auto& v : arg) {
@@ -672,4 +964,18 @@ void GenericCXXCodeGen::EmitODLAArgs(const DataFormat& arg) {
   os_ << (arg == DataFormat::NHWC ? "CHANNELS_LAST" : "CHANNELS_FIRST");
 }
 
+void GenericCXXCodeGen::EmitODLAArgs(const ActivationType& arg) {
+  const static std::unordered_map<ActivationType, std::string> names{
+      {ActivationType::NONE, "NONE"},
+      {ActivationType::RELU, "RELU"},
+      {ActivationType::RELU6, "RELU6"},
+      {ActivationType::LEAKY_RELU, "LEAKY_RELU"}};
+  auto it = names.find(arg);
+  HLCHECK(it != names.end());
+  if (opts_.dialect == Dialect::CXX_11) {
+    os_ << "odla_activation::";
+  }
+  os_ << "ODLA_ACTIVATION_" << it->second;
+}
+
 } // namespace halo
@@ -15,6 +15,7 @@
 // limitations under the License.
 // =============================================================================
 
+#include "halo/lib/ir/constant_pool.h"
 #include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
 
 namespace halo {
@@ -39,9 +40,21 @@ bool GenericCXXConstantWriter::RunOnModule(Module* module) {
          "-------------------------------------===//\n\n";
   os_ << "#include <stdint.h>\n";
 
+  ConstantPool pool;
   for (auto& func : *module) {
     for (auto& constant : func->Constants()) {
-      RunOnConstant(*constant, &os_);
+      const Constant* canonical = pool.Insert(constant.get());
+      if (canonical == constant.get()) {
+        RunOnConstant(*constant, &os_);
+        continue;
+      }
+      // The data of duplicated constants is stored once.
+      const auto& type = constant->GetResultType();
+      CXXValue value(constant->GetName(), TensorTypeToCXXType(type, true));
+      CXXValue target(canonical->GetName(), value.type);
+      os_ << "extern const " << value.type.name << " " << value.name << "["
+          << Join(type.GetDimSizes(), '*') << "] __attribute__((alias(\""
+          << target.name << "\")));\n";
     }
   }
 
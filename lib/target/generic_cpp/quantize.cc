@@ -0,0 +1,49 @@
+//===- quantize.cc --------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+
+namespace halo {
+
+void GenericCXXCodeGen::RunOnInstruction(QuantizeInst* inst) {
+  const Def& input = inst->GetOperand(0);
+
+  CXXValue op0 = ir_mapping_[input];
+
+  CXXValue ret(inst->GetName(),
+               TensorTypeToCXXType(inst->GetResultType(), false));
+
+  EmitODLACall(ret, "odla_Quantize", op0, inst->GetScale(),
+               inst->GetZeroPoint(), inst->GetDataType());
+  ir_mapping_[*inst] = ret;
+}
+
+void GenericCXXCodeGen::RunOnInstruction(DequantizeInst* inst) {
+  const Def& input = inst->GetOperand(0);
+
+  CXXValue op0 = ir_mapping_[input];
+
+  CXXValue ret(inst->GetName(),
+               TensorTypeToCXXType(inst->GetResultType(), false));
+
+  const auto& scales = inst->GetScales();
+  EmitODLACall(ret, "odla_Dequantize", op0, scales.size(), scales,
+               inst->GetAxis());
+  ir_mapping_[*inst] = ret;
+}
+
+} // namespace halo
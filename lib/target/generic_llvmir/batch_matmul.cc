@@ -65,8 +65,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(BatchMatMulInst* inst) {
   llvm::Value* transpose_a = ir_builder->getInt1(inst->GetTransposeA());
   llvm::Value* transpose_b = ir_builder->getInt1(inst->GetTransposeB());
 
-  llvm::Value* ret_buf = ir_builder->CreateAlloca(
-      TensorTypeToLLVMType(inst->GetResultType(), false), nullptr,
+  llvm::Value* ret_buf = CreateEntryBlockAlloca(
+      ir_builder, TensorTypeToLLVMType(inst->GetResultType(), false),
       inst->GetName());
   llvm::Value* ret_buf_ptr = ir_builder->CreateBitCast(ret_buf, ptr_type);
   CreateCall(&callee, {ret_buf_ptr, param0, param1, batch, dim_lhs_0, dim_lhs_1,
@@ -47,9 +47,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(BatchNormInst* inst) {
     llvm::Value* op_i = ir_mapping_[def];
     HLCHECK(op_i != nullptr);
     if (!op_i->getType()->isPointerTy()) {
-      auto buf =
-          ir_builder->CreateAlloca(TensorTypeToLLVMType(def.GetType(), false),
-                                   nullptr, def.GetOwner()->GetName() + "_buf");
+      auto buf = CreateEntryBlockAlloca(
+          ir_builder, TensorTypeToLLVMType(def.GetType(), false),
+          def.GetOwner()->GetName() + "_buf");
       ir_builder->CreateStore(op_i, buf);
       op_i = buf;
     }
@@ -62,7 +62,7 @@ void GenericLLVMIRCodeGen::RunOnInstruction(BatchNormInst* inst) {
   bool scalar_scale{false};
   if (ops.size() <= 3) {
     scalar_offset = true;
-    auto buf = ir_builder->CreateAlloca(float32_ty, nullptr, "offset_buf");
+    auto buf = CreateEntryBlockAlloca(ir_builder, float32_ty, "offset_buf");
     llvm::Value* offset_v =
         llvm::ConstantFP::get(float32_ty, inst->GetOffset());
     ir_builder->CreateStore(offset_v, buf);
@@ -70,7 +70,7 @@ void GenericLLVMIRCodeGen::RunOnInstruction(BatchNormInst* inst) {
   }
   if (ops.size() <= 4) {
     scalar_scale = true;
-    auto buf = ir_builder->CreateAlloca(float32_ty, nullptr, "scale_buf");
+    auto buf = CreateEntryBlockAlloca(ir_builder, float32_ty, "scale_buf");
     llvm::Value* scale_v = llvm::ConstantFP::get(float32_ty, inst->GetScale());
     ir_builder->CreateStore(scale_v, buf);
     ops.push_back(buf);
@@ -35,9 +35,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(Conv2DInst* inst0) {
   llvm::Type* op0_ty = op0->getType();
 
   if (!op0_ty->isPointerTy()) {
-    auto buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(lhs.GetType(), false),
-                                 nullptr, lhs.GetOwner()->GetName() + "_buf");
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(lhs.GetType(), false),
+        lhs.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
@@ -45,11 +45,13 @@ void GenericLLVMIRCodeGen::RunOnInstruction(Conv2DInst* inst0) {
   llvm::Type* ptr_ty =
       SNTypeToLLVMType(lhs.GetType().GetDataType())->getPointerTo();
   llvm::Type* int64_ty = ir_builder->getInt64Ty();
+  llvm::Type* float32_ty = ir_builder->getFloatTy();
   llvm::FunctionType* ftype = llvm::FunctionType::get(
       ir_builder->getVoidTy(),
       {ptr_ty, ptr_ty, ptr_ty, int64_ty, int64_ty, int64_ty, int64_ty, int64_ty,
        int64_ty, int64_ty, int64_ty, int64_ty, int64_ty, int64_ty, int64_ty,
-       int64_ty, int64_ty, int64_ty},
+       int64_ty, int64_ty, int64_ty, int64_ty, int64_ty, int64_ty, ptr_ty,
+       int64_ty, float32_ty},
       false);
 
   auto llvm_module = ir_builder->GetInsertBlock()->getParent()->getParent();
@@ -89,14 +91,39 @@ void GenericLLVMIRCodeGen::RunOnInstruction(Conv2DInst* inst0) {
   llvm::Value* padding_right = ir_builder->getInt64(inst.GetPaddingRight());
   llvm::Value* padding_top = ir_builder->getInt64(inst.GetPaddingTop());
   llvm::Value* padding_bottom = ir_builder->getInt64(inst.GetPaddingBottom());
+  llvm::Value* dilation_h =
+      ir_builder->getInt64(inst.GetDilations()[info.data_height_axis]);
+  llvm::Value* dilation_w =
+      ir_builder->getInt64(inst.GetDilations()[info.data_width_axis]);
+  llvm::Value* group = ir_builder->getInt64(inst.GetGroup());
+  // The bias and activation are applied by the runtime.
+  llvm::Value* bias = llvm::ConstantPointerNull::get(
+      llvm::cast<llvm::PointerType>(ptr_ty));
+  if (inst.GetNumOfOperands() == 3) {
+    const Def& rhs2 = inst.GetOperand(2);
+    llvm::Value* op2 = ir_mapping_[rhs2];
+    if (!op2->getType()->isPointerTy()) {
+      auto buf = CreateEntryBlockAlloca(
+          ir_builder, TensorTypeToLLVMType(rhs2.GetType(), false),
+          rhs2.GetOwner()->GetName() + "_buf");
+      ir_builder->CreateStore(op2, buf);
+      op2 = buf;
+    }
+    bias = ir_builder->CreateBitCast(op2, ptr_ty);
+  }
+  llvm::Value* activation =
+      ir_builder->getInt64(static_cast<int64_t>(inst.GetActivation()));
+  llvm::Value* activation_alpha =
+      llvm::ConstantFP::get(float32_ty, inst.GetActivationAlpha());
 
   llvm::Value* result = AllocateLLVMBuffer(ir_builder, Def{&inst, 0});
 
   llvm::Value* ret_buf_ptr = ir_builder->CreateBitCast(result, ptr_ty);
   CreateCall(&callee, {ret_buf_ptr, data, kernel, batch, spatial_h, spatial_w,
                        channel, output_h, output_w, output_channel, kernel_h,
-                       kernel_w, stride_h, stride_w, padding_left,
-                       padding_right, padding_top, padding_bottom});
+                       kernel_w, stride_h, stride_w, padding_top,
+                       padding_bottom, padding_left, padding_right, dilation_h,
+                       dilation_w, group, bias, activation, activation_alpha});
   ir_mapping_[inst] = result;
 }
 
@@ -33,15 +33,15 @@ void GenericLLVMIRCodeGen::RunOnInstruction(GatherInst* inst) {
   llvm::Type* op0_ty = op0->getType();
 
   if (!op0_ty->isPointerTy()) {
-    auto buf = ir_builder->CreateAlloca(
-        TensorTypeToLLVMType(params.GetType(), false), nullptr,
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(params.GetType(), false),
         params.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
   if (!op1->getType()->isPointerTy()) {
-    auto buf = ir_builder->CreateAlloca(
-        TensorTypeToLLVMType(indices.GetType(), false), nullptr,
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(indices.GetType(), false),
         indices.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op1, buf);
     op1 = buf;
@@ -46,7 +46,7 @@ void GenericLLVMIRCodeGen::RunOnInstruction(GemmInst* inst) {
       ir_builder->getVoidTy(),
       {ptr_type, ptr_type, ptr_type, ptr_type, int64_type, int64_type,
        int64_type, int64_type, int64_type, bool_type, bool_type, fp32_type,
-       fp32_type},
+       fp32_type, int64_type, fp32_type},
       false);
 
   llvm::FunctionCallee callee = llvm_module->getOrInsertFunction(fname, ftype);
@@ -68,14 +68,19 @@ void GenericLLVMIRCodeGen::RunOnInstruction(GemmInst* inst) {
   llvm::Value* transpose_b = ir_builder->getInt1(inst->GetTransposeB());
   llvm::Value* alpha = llvm::ConstantFP::get(fp32_type, inst->GetAlpha());
   llvm::Value* beta = llvm::ConstantFP::get(fp32_type, inst->GetBeta());
+  llvm::Value* activation =
+      ir_builder->getInt64(static_cast<int64_t>(inst->GetActivation()));
+  llvm::Value* activation_alpha =
+      llvm::ConstantFP::get(fp32_type, inst->GetActivationAlpha());
 
-  llvm::Value* ret_buf = ir_builder->CreateAlloca(
-      TensorTypeToLLVMType(inst->GetResultType(), false), nullptr,
+  llvm::Value* ret_buf = CreateEntryBlockAlloca(
+      ir_builder, TensorTypeToLLVMType(inst->GetResultType(), false),
       inst->GetName());
   llvm::Value* ret_buf_ptr = ir_builder->CreateBitCast(ret_buf, ptr_type);
   CreateCall(&callee, {ret_buf_ptr, param0, param1, param2, dim_lhs_0,
                        dim_lhs_1, dim_rhs_0, dim_rhs_1, num_bias, transpose_a,
-                       transpose_b, alpha, beta});
+                       transpose_b, alpha, beta, activation,
+                       activation_alpha});
   ir_mapping_[*inst] = ret_buf;
 }
 
@@ -32,6 +32,7 @@
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Target/TargetLoweringObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include "halo/lib/ir/constant_pool.h"
 #include "halo/lib/target/generic_llvmir/generic_llvmir_codegen.h"
 
 namespace halo {
@@ -63,9 +64,21 @@ bool GenericConstantWriter::RunOnModule(Module* module) {
       module->GetName() + "_constants", GetLLVMContext());
   llvm_module_->setDataLayout(target_machine_->createDataLayout());
   llvm_module_->setTargetTriple(target_machine_->getTargetTriple().getTriple());
+  ConstantPool pool;
   for (auto& func : *module) {
     for (auto& constant : func->Constants()) {
-      RunOnConstant(*constant);
+      Constant* canonical = pool.Insert(constant.get());
+      if (canonical == constant.get()) {
+        RunOnConstant(*constant);
+        continue;
+      }
+      // The data of duplicated constants is stored once. The duplicates are
+      // aliases of the global variable that holds it.
+      auto gv = llvm::cast<llvm::GlobalVariable>(ir_mapping_[*canonical]);
+      llvm::GlobalAlias::create(gv->getValueType(), gv->getAddressSpace(),
+                                gv->getLinkage(),
+                                NormalizeVariableName(constant->GetName()), gv,
+                                llvm_module_.get());
     }
   }
   WriteToBuf();
@@ -183,6 +196,21 @@ void ELFConstantWriter::WriteToBuf() {
     }
     mc_streamer->emitELFSize(gv_sym, llvm::MCConstantExpr::create(size, mctx));
   }
+
+  for (const auto& ga : llvm_module_->aliases()) {
+    llvm::MCSymbol* ga_sym = asm_printer->getSymbol(&ga);
+    asm_printer->EmitVisibility(ga_sym, ga.getVisibility(),
+                                true /* definition */);
+    asm_printer->EmitLinkage(&ga, ga_sym);
+    mc_streamer->EmitSymbolAttribute(ga_sym, llvm::MCSA_ELF_TypeObject);
+    const auto* aliasee = llvm::cast<llvm::GlobalValue>(ga.getAliasee());
+    mc_streamer->EmitAssignment(
+        ga_sym, llvm::MCSymbolRefExpr::create(asm_printer->getSymbol(aliasee),
+                                              mctx));
+    const llvm::DataLayout& dl = ga.getParent()->getDataLayout();
+    uint64_t size = dl.getTypeAllocSize(ga.getValueType());
+    mc_streamer->emitELFSize(ga_sym, llvm::MCConstantExpr::create(size, mctx));
+  }
   mc_streamer->Finish();
 }
 
@@ -100,9 +100,14 @@ llvm::Type* GenericLLVMIRCodeGen::SNTypeToLLVMType(DataType dt) {
       return llvm::Type::getInt8Ty(GetLLVMContext());
     }
     case DataType::INT16:
-    case DataType::UINT16: {
+    case DataType::UINT16:
+    case DataType::BFLOAT16: {
+      // BFLOAT16 values are only stored and cast by the runtime library.
       return llvm::Type::getInt16Ty(GetLLVMContext());
     }
+    case DataType::FLOAT16: {
+      return llvm::Type::getHalfTy(GetLLVMContext());
+    }
     case DataType::FLOAT32: {
       return llvm::Type::getFloatTy(GetLLVMContext());
     }
@@ -119,6 +124,8 @@ llvm::Type* GenericLLVMIRCodeGen::SNTypeToLLVMType(DataType dt) {
 const std::string& GenericLLVMIRCodeGen::SNTypeToRTLibFuncSuffix(DataType dt) {
   static const std::unordered_map<DataType, std::string> suffixes = {
       {DataType::FLOAT32, "_f32"},
+      {DataType::FLOAT16, "_f16"},
+      {DataType::BFLOAT16, "_bf16"},
       {DataType::INT32, "_i32"},
       {DataType::INVALID, "_inv"}};
   if (auto kv = suffixes.find(dt); kv != suffixes.end()) {
@@ -162,22 +169,37 @@ llvm::BasicBlock* GenericLLVMIRCodeGen::GetLLVMBasicBlock(Instruction* inst) {
 
 llvm::Value* GenericLLVMIRCodeGen::AllocateLLVMBuffer(
     llvm::IRBuilder<>* ir_builder, const Def& def) {
-  constexpr int64_t stack_threshold =
-      128; // std::numeric_limits<int64_t>::max();
-  bool use_stack = def.GetType().GetTotalNumOfElements() <= stack_threshold;
+  const auto* inst = DynCast<Instruction>(def);
+  if (inst != nullptr && memory_planner_ != nullptr &&
+      memory_planner_->IsInPlace(*inst)) {
+    // Write the result over the input buffer.
+    auto it = ir_mapping_.find(inst->GetOperand(0));
+    if (it != ir_mapping_.end() && it->second->getType()->isPointerTy()) {
+      return ir_builder->CreateBitCast(
+          it->second, TensorTypeToLLVMType(def.GetType(), true));
+    }
+  }
+  bool use_stack = def.GetType().GetTotalNumOfElements() <= StackThreshold;
   return AllocateLLVMBuffer(ir_builder, def, use_stack);
 }
 
 llvm::Value* GenericLLVMIRCodeGen::AllocateLLVMBuffer(
     llvm::IRBuilder<>* ir_builder, const Def& def, bool on_stack) {
   if (on_stack) {
-    llvm::Value* buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(def.GetType(), false),
-                                 nullptr, def.GetOwner()->GetName());
-    return buf;
+    return CreateEntryBlockAlloca(ir_builder,
+                                  TensorTypeToLLVMType(def.GetType(), false),
+                                  def.GetOwner()->GetName());
   }
 
   auto type = TensorTypeToLLVMType(def.GetType(), false);
+  if (workspace_ != nullptr && memory_planner_->HasOffset(def)) {
+    // Returns a view into the workspace at the planned offset.
+    llvm::Value* ptr = ir_builder->CreateConstInBoundsGEP2_64(
+        workspace_->getValueType(), workspace_, 0,
+        memory_planner_->GetOffset(def));
+    return ir_builder->CreateBitCast(ptr, type->getPointerTo(),
+                                     def.GetOwner()->GetName());
+  }
   llvm::GlobalVariable* gv =
       new llvm::GlobalVariable(*llvm_module_, type, false,
                                llvm::GlobalValue::LinkageTypes::InternalLinkage,
@@ -186,6 +208,19 @@ llvm::Value* GenericLLVMIRCodeGen::AllocateLLVMBuffer(
   return gv;
 }
 
+llvm::AllocaInst* GenericLLVMIRCodeGen::CreateEntryBlockAlloca(
+    llvm::IRBuilder<>* ir_builder, llvm::Type* type, const std::string& name) {
+  // Loop nests move the insertion point out of the entry block, where
+  // allocas have to stay to be promoted.
+  llvm::BasicBlock* entry =
+      &ir_builder->GetInsertBlock()->getParent()->getEntryBlock();
+  if (ir_builder->GetInsertBlock() == entry) {
+    return ir_builder->CreateAlloca(type, nullptr, name);
+  }
+  llvm::IRBuilder<> entry_builder(entry, entry->begin());
+  return entry_builder.CreateAlloca(type, nullptr, name);
+}
+
 bool GenericLLVMIRCodeGen::RunOnModule(Module* module) {
   ctx_ = &module->GetGlobalContext();
   if (target_machine_ == nullptr) {
@@ -199,6 +234,7 @@ bool GenericLLVMIRCodeGen::RunOnModule(Module* module) {
   llvm_module_->setTargetTriple(target_machine_->getTargetTriple().getTriple());
   for (auto& func : *module) {
     RunOnFunction(*func);
+    EmitInitFunction(*func);
   }
   LinkRuntimeLib();
 
@@ -209,6 +245,9 @@ bool GenericLLVMIRCodeGen::RunOnModule(Module* module) {
     LOG(ERROR) << "Incorrect LLVM module" << err_os.str();
     return false;
   }
+  if (lowering_mode_ == LoweringMode::LoopNest) {
+    OptimizeModule();
+  }
 
   module->GetGlobalContext().GetCodeGenObject().SetLLVMModule(
       std::move(llvm_module_));
@@ -267,6 +306,22 @@ void GenericLLVMIRCodeGen::RunOnFunction(Function& function) {
     RunOnConstant(*constant);
   }
 
+  // All non-stack buffers of this function are packed into one workspace.
+  memory_planner_ = std::make_unique<MemoryPlanner>(
+      function, [](const Def& def) {
+        return def.GetType().GetTotalNumOfElements() > StackThreshold;
+      });
+  workspace_ = nullptr;
+  if (size_t size = memory_planner_->GetWorkspaceSize(); size > 0) {
+    auto ty = llvm::ArrayType::get(llvm::Type::getInt8Ty(GetLLVMContext()),
+                                   size);
+    workspace_ = new llvm::GlobalVariable(
+        *llvm_module_, ty, false,
+        llvm::GlobalValue::LinkageTypes::InternalLinkage,
+        llvm::Constant::getNullValue(ty), function.GetName() + "_workspace");
+    workspace_->setAlignment(MemoryPlanner::DefaultAlignment);
+  }
+
   for (auto& bb : function) {
     RunOnBasicBlock(llvm_func, *bb);
   }
@@ -277,6 +332,29 @@ void GenericLLVMIRCodeGen::RunOnFunction(Function& function) {
   ir_builder.CreateRetVoid();
 } // namespace halo
 
+void GenericLLVMIRCodeGen::EmitInitFunction(const Function& function) {
+  llvm::LLVMContext& llvm_ctx = GetLLVMContext();
+  llvm::FunctionType* func_ty =
+      llvm::FunctionType::get(llvm::Type::getVoidTy(llvm_ctx),
+                              {llvm::Type::getInt64Ty(llvm_ctx)}, false);
+  llvm::Function* init_func =
+      llvm::Function::Create(func_ty, llvm::GlobalValue::ExternalLinkage,
+                             function.GetName() + "_init", llvm_module_.get());
+  init_func->addFnAttr(llvm::Attribute::NoUnwind);
+  init_func->setCallingConv(llvm::CallingConv::C);
+  llvm::Argument* num_threads = init_func->args().begin();
+  num_threads->setName("num_threads");
+
+  llvm::IRBuilder<> ir_builder(
+      llvm::BasicBlock::Create(llvm_ctx, "entry", init_func));
+  llvm::FunctionCallee callee =
+      llvm_module_->getOrInsertFunction("_sn_rt_set_num_threads", func_ty);
+  llvm::CallInst* call = ir_builder.CreateCall(callee, {num_threads});
+  call->setCallingConv(llvm::CallingConv::C);
+  call->setDoesNotThrow();
+  ir_builder.CreateRetVoid();
+}
+
 llvm::CallInst* GenericLLVMIRCodeGen::CreateCall(
     llvm::FunctionCallee* callee, llvm::ArrayRef<llvm::Value*> args) {
   auto func = current_llvm_builder_->CreateCall(*callee, args);
@@ -285,6 +363,24 @@ llvm::CallInst* GenericLLVMIRCodeGen::CreateCall(
   return func;
 }
 
+std::string GenericLLVMIRCodeGen::NormalizeVariableName(const std::string& n) {
+  // make a valid C/C++ identifier name.
+  std::string name = n;
+  std::transform(n.begin(), n.end(), name.begin(), [](char c) {
+    switch (c) {
+      case '/':
+      case ' ':
+      case '.':
+      case '-': {
+        return '_';
+      }
+      default:
+        return c;
+    }
+  });
+  return name;
+}
+
 void GenericLLVMIRCodeGen::RunOnConstant(Constant& constant) {
   const auto& sn_ty = constant.GetResultType(0);
   bool use_vector = sn_ty.GetTotalNumOfElements() <= GetMaxVectorSize();
@@ -312,7 +408,9 @@ void GenericLLVMIRCodeGen::RunOnConstant(Constant& constant) {
       break;
     }
     case DataType::INT16:
-    case DataType::UINT16: {
+    case DataType::UINT16:
+    case DataType::FLOAT16:
+    case DataType::BFLOAT16: {
       llvm::ArrayRef<uint16_t> data(constant.GetDataPtr<uint16_t>(),
                                     sn_ty.GetTotalNumOfElements());
       cv = llvm::ConstantDataVector::get(llvm_module_->getContext(), data);
@@ -330,31 +428,13 @@ void GenericLLVMIRCodeGen::RunOnConstant(Constant& constant) {
     }
   }
 
-  // make a valid C/C++ identifier name.
-  auto normalize = [](const std::string& n) {
-    std::string name = n;
-    std::transform(n.begin(), n.end(), name.begin(), [](char c) {
-      switch (c) {
-        case '/':
-        case ' ':
-        case '.':
-        case '-': {
-          return '_';
-        }
-        default:
-          return c;
-      }
-    });
-    return name;
-  };
-
   if (cv == nullptr) {
     HLCHECK(0);
     return;
   }
 
-  auto v = llvm_module_->getOrInsertGlobal(normalize(constant.GetName()),
-                                           cv->getType());
+  auto v = llvm_module_->getOrInsertGlobal(
+      NormalizeVariableName(constant.GetName()), cv->getType());
   llvm::GlobalVariable* gv = llvm::dyn_cast<llvm::GlobalVariable>(v);
   HLCHECK(gv);
   if (gv != nullptr) {
@@ -463,6 +543,10 @@ void GenericLLVMIRCodeGen::LinkRuntimeLib() {
 }
 
 void GenericLLVMIRCodeGen::RunOnBaseInstruction(Instruction* inst) {
+  if (lowering_mode_ == LoweringMode::LoopNest &&
+      RunOnInstructionAsLoopNest(inst)) {
+    return;
+  }
   switch (inst->GetOpCode()) {
     case OpCode::ADD:
     case OpCode::SUB:
@@ -0,0 +1,412 @@
+//===- loop_nest.cc -------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include <algorithm>
+#include <vector>
+
+#include "halo/lib/ir/all_instructions.h"
+#include "halo/lib/target/generic_llvmir/generic_llvmir_codegen.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+
+namespace halo {
+
+// Returns the row-major strides of `dims`.
+static std::vector<int64_t> GetStrides(const std::vector<int64_t>& dims) {
+  std::vector<int64_t> strides(dims.size(), 1);
+  for (int i = static_cast<int>(dims.size()) - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * dims[i + 1];
+  }
+  return strides;
+}
+
+// Returns the strides of an operand of shape `dims` broadcast to `rank`
+// dimensions. Broadcast dimensions have a stride of 0.
+static std::vector<int64_t> GetBroadcastStrides(
+    const std::vector<int64_t>& dims, size_t rank) {
+  std::vector<int64_t> strides(rank, 0);
+  std::vector<int64_t> orig = GetStrides(dims);
+  for (size_t i = 0; i < dims.size(); ++i) {
+    if (dims[i] != 1) {
+      strides[rank - dims.size() + i] = orig[i];
+    }
+  }
+  return strides;
+}
+
+// Returns the sum of ivs[i] * strides[i].
+static llvm::Value* GetOffset(llvm::IRBuilder<>* ir_builder,
+                              const std::vector<llvm::Value*>& ivs,
+                              const std::vector<int64_t>& strides) {
+  llvm::Value* offset = ir_builder->getInt64(0);
+  for (size_t i = 0; i < ivs.size(); ++i) {
+    if (strides[i] != 0) {
+      offset = ir_builder->CreateNUWAdd(
+          offset, ir_builder->CreateNUWMul(ivs[i],
+                                           ir_builder->getInt64(strides[i])));
+    }
+  }
+  return offset;
+}
+
+llvm::Value* GenericLLVMIRCodeGen::GetElementPtr(const Def& def) {
+  llvm::IRBuilder<>* ir_builder = current_llvm_builder_;
+  llvm::Value* v = ir_mapping_[def];
+  if (!v->getType()->isPointerTy()) {
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(def.GetType(), false),
+        def.GetOwner()->GetName() + "_buf");
+    ir_builder->CreateStore(v, buf);
+    v = buf;
+  }
+  return ir_builder->CreateBitCast(
+      v, SNTypeToLLVMType(def.GetType().GetDataType())->getPointerTo());
+}
+
+void GenericLLVMIRCodeGen::EmitLoopNest(const std::vector<int64_t>& dims,
+                                        const LoopBody& body) {
+  llvm::IRBuilder<>* ir_builder = current_llvm_builder_;
+  if (std::any_of(dims.begin(), dims.end(),
+                  [](int64_t d) { return d <= 0; })) {
+    return;
+  }
+  llvm::Function* func = ir_builder->GetInsertBlock()->getParent();
+  std::vector<llvm::Value*> ivs(dims.size(), ir_builder->getInt64(0));
+  // Each loop runs at least once, so the condition is checked at the end.
+  std::function<void(size_t)> emit = [&](size_t d) {
+    if (d == dims.size()) {
+      body(ivs);
+      return;
+    }
+    if (dims[d] == 1) {
+      emit(d + 1);
+      return;
+    }
+    llvm::BasicBlock* preheader = ir_builder->GetInsertBlock();
+    llvm::BasicBlock* header =
+        llvm::BasicBlock::Create(GetLLVMContext(), "loop", func);
+    ir_builder->CreateBr(header);
+    ir_builder->SetInsertPoint(header);
+    llvm::PHINode* iv = ir_builder->CreatePHI(ir_builder->getInt64Ty(), 2);
+    iv->addIncoming(ir_builder->getInt64(0), preheader);
+    ivs[d] = iv;
+    emit(d + 1);
+    llvm::Value* next = ir_builder->CreateNUWAdd(iv, ir_builder->getInt64(1));
+    iv->addIncoming(next, ir_builder->GetInsertBlock());
+    llvm::BasicBlock* exit =
+        llvm::BasicBlock::Create(GetLLVMContext(), "loop.exit", func);
+    ir_builder->CreateCondBr(
+        ir_builder->CreateICmpULT(next, ir_builder->getInt64(dims[d])), header,
+        exit);
+    ir_builder->SetInsertPoint(exit);
+  };
+  emit(0);
+}
+
+bool GenericLLVMIRCodeGen::RunOnInstructionAsLoopNest(Instruction* inst) {
+  llvm::IRBuilder<>* ir_builder = current_llvm_builder_;
+  if (inst->GetNumOfOperands() == 0 || inst->GetNumOfResults() != 1) {
+    return false;
+  }
+  const Def& op0 = inst->GetOperand(0);
+  const halo::Type& in_type = op0.GetType();
+  const halo::Type& ret_type = inst->GetResultType();
+  const DataType dt = in_type.GetDataType();
+  const bool is_float = dt == DataType::FLOAT32;
+  if (!is_float && dt != DataType::INT32) {
+    return false;
+  }
+  const std::vector<int64_t>& in_dims = in_type.GetDimSizes();
+  const std::vector<int64_t>& ret_dims = ret_type.GetDimSizes();
+  const OpCode opcode = inst->GetOpCode();
+
+  // Checks the instruction and collects what the loop nests need.
+  std::vector<int64_t> pads;
+  float pad_value = 0;
+  std::vector<bool> is_reduced(in_dims.size());
+  switch (opcode) {
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+    case OpCode::DIV: {
+      if (inst->GetOperand(1).GetType().GetDataType() != dt) {
+        return false;
+      }
+      break;
+    }
+    case OpCode::RELU: {
+      // Small relus are already emitted as vector operations.
+      if (!is_float || in_type.GetTotalNumOfElements() <= GetMaxVectorSize()) {
+        return false;
+      }
+      break;
+    }
+    case OpCode::FLOOR:
+    case OpCode::RSQRT:
+    case OpCode::SQRT: {
+      if (!is_float) {
+        return false;
+      }
+      break;
+    }
+    case OpCode::TRANSPOSE: {
+      if (DynCast<TransposeInst>(inst)->GetPermutation().size() !=
+          in_dims.size()) {
+        return false;
+      }
+      break;
+    }
+    case OpCode::PAD: {
+      const PadInst* pad = DynCast<PadInst>(inst);
+      const Constant* paddings = DynCast<Constant>(inst->GetOperand(1));
+      if (pad->GetMode() != PadMode::CONSTANT || paddings == nullptr ||
+          inst->GetOperand(1).GetType().GetTotalNumOfElements() !=
+              static_cast<int64_t>(in_dims.size() * 2)) {
+        return false;
+      }
+      for (size_t i = 0; i < in_dims.size() * 2; ++i) {
+        pads.push_back(paddings->GetDataAsInt64(i));
+        if (pads.back() < 0) {
+          return false;
+        }
+      }
+      if (inst->GetNumOfOperands() > 2) {
+        const Constant* value = DynCast<Constant>(inst->GetOperand(2));
+        if (value == nullptr || !is_float) {
+          return false;
+        }
+        pad_value = value->GetData<float>(0);
+      }
+      break;
+    }
+    case OpCode::REDUCEMEAN: {
+      if (!is_float ||
+          in_type.GetTotalNumOfElements() > LoopNestMaxReduction) {
+        return false;
+      }
+      std::vector<int> axes = DynCast<ReduceMeanInst>(inst)->GetAxis();
+      if (inst->GetNumOfOperands() > 1) {
+        const Constant* c = DynCast<Constant>(inst->GetOperand(1));
+        if (c == nullptr) {
+          return false;
+        }
+        axes.clear();
+        for (int64_t i = 0, e = c->GetResultType().GetTotalNumOfElements();
+             i < e; ++i) {
+          axes.push_back(c->GetDataAsInt64(i));
+        }
+      }
+      if (axes.empty()) {
+        return false;
+      }
+      for (int axis : axes) {
+        is_reduced[axis < 0 ? axis + in_dims.size() : axis] = true;
+      }
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
+
+  llvm::Type* elem_type = SNTypeToLLVMType(dt);
+  llvm::Value* in_ptr = GetElementPtr(op0);
+  llvm::Value* in_ptr1 =
+      inst->GetNumOfOperands() > 1 ? GetElementPtr(inst->GetOperand(1))
+                                   : nullptr;
+  llvm::Value* ret_buf = AllocateLLVMBuffer(ir_builder, Def{inst, 0});
+  llvm::Value* ret_ptr =
+      ir_builder->CreateBitCast(ret_buf, elem_type->getPointerTo());
+  auto load = [ir_builder](llvm::Value* ptr, llvm::Value* offset) {
+    return ir_builder->CreateLoad(ir_builder->CreateInBoundsGEP(ptr, offset));
+  };
+  auto store = [ir_builder](llvm::Value* v, llvm::Value* ptr,
+                            llvm::Value* offset) {
+    ir_builder->CreateStore(v, ir_builder->CreateInBoundsGEP(ptr, offset));
+  };
+  // Fills the result with `v`.
+  auto fill = [&](llvm::Value* v) {
+    EmitLoopNest({ret_type.GetTotalNumOfElements()},
+                 [&](const std::vector<llvm::Value*>& ivs) {
+                   store(v, ret_ptr, ivs[0]);
+                 });
+  };
+  const std::vector<int64_t> ret_strides = GetStrides(ret_dims);
+
+  switch (opcode) {
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+    case OpCode::DIV: {
+      auto lhs_strides = GetBroadcastStrides(in_dims, ret_dims.size());
+      auto rhs_strides = GetBroadcastStrides(
+          inst->GetOperand(1).GetType().GetDimSizes(), ret_dims.size());
+      EmitLoopNest(ret_dims, [&](const std::vector<llvm::Value*>& ivs) {
+        llvm::Value* a = load(in_ptr, GetOffset(ir_builder, ivs, lhs_strides));
+        llvm::Value* b =
+            load(in_ptr1, GetOffset(ir_builder, ivs, rhs_strides));
+        llvm::Value* v = nullptr;
+        if (opcode == OpCode::ADD) {
+          v = is_float ? ir_builder->CreateFAdd(a, b)
+                       : ir_builder->CreateAdd(a, b);
+        } else if (opcode == OpCode::SUB) {
+          v = is_float ? ir_builder->CreateFSub(a, b)
+                       : ir_builder->CreateSub(a, b);
+        } else if (opcode == OpCode::MUL) {
+          v = is_float ? ir_builder->CreateFMul(a, b)
+                       : ir_builder->CreateMul(a, b);
+        } else {
+          v = is_float ? ir_builder->CreateFDiv(a, b)
+                       : ir_builder->CreateSDiv(a, b);
+        }
+        store(v, ret_ptr, GetOffset(ir_builder, ivs, ret_strides));
+      });
+      break;
+    }
+    case OpCode::RELU:
+    case OpCode::FLOOR:
+    case OpCode::RSQRT:
+    case OpCode::SQRT: {
+      llvm::Function* sqrt = llvm::Intrinsic::getDeclaration(
+          llvm_module_.get(), llvm::Intrinsic::sqrt, {elem_type});
+      llvm::Function* floor = llvm::Intrinsic::getDeclaration(
+          llvm_module_.get(), llvm::Intrinsic::floor, {elem_type});
+      EmitLoopNest({ret_type.GetTotalNumOfElements()},
+                   [&](const std::vector<llvm::Value*>& ivs) {
+                     llvm::Value* v = load(in_ptr, ivs[0]);
+                     if (opcode == OpCode::RELU) {
+                       llvm::Value* zero = llvm::Constant::getNullValue(
+                           elem_type);
+                       v = ir_builder->CreateSelect(
+                           ir_builder->CreateFCmpOGT(v, zero), v, zero);
+                     } else if (opcode == OpCode::FLOOR) {
+                       v = ir_builder->CreateCall(floor, {v});
+                     } else {
+                       v = ir_builder->CreateCall(sqrt, {v});
+                       if (opcode == OpCode::RSQRT) {
+                         v = ir_builder->CreateFDiv(
+                             llvm::ConstantFP::get(elem_type, 1.0), v);
+                       }
+                     }
+                     store(v, ret_ptr, ivs[0]);
+                   });
+      break;
+    }
+    case OpCode::TRANSPOSE: {
+      const std::vector<int>& perm =
+          DynCast<TransposeInst>(inst)->GetPermutation();
+      const std::vector<int64_t> in_strides = GetStrides(in_dims);
+      std::vector<int64_t> strides(perm.size());
+      for (size_t i = 0; i < perm.size(); ++i) {
+        strides[i] = in_strides[perm[i]];
+      }
+      EmitLoopNest(ret_dims, [&](const std::vector<llvm::Value*>& ivs) {
+        store(load(in_ptr, GetOffset(ir_builder, ivs, strides)), ret_ptr,
+              GetOffset(ir_builder, ivs, ret_strides));
+      });
+      break;
+    }
+    case OpCode::PAD: {
+      fill(is_float ? llvm::ConstantFP::get(elem_type, pad_value)
+                    : llvm::Constant::getNullValue(elem_type));
+      const std::vector<int64_t> in_strides = GetStrides(in_dims);
+      int64_t base = 0;
+      for (size_t i = 0; i < in_dims.size(); ++i) {
+        base += pads[i * 2] * ret_strides[i];
+      }
+      EmitLoopNest(in_dims, [&](const std::vector<llvm::Value*>& ivs) {
+        llvm::Value* offset = ir_builder->CreateNUWAdd(
+            GetOffset(ir_builder, ivs, ret_strides), ir_builder->getInt64(base));
+        store(load(in_ptr, GetOffset(ir_builder, ivs, in_strides)), ret_ptr,
+              offset);
+      });
+      break;
+    }
+    case OpCode::REDUCEMEAN: {
+      // The result is accumulated in place, with reduced dimensions having a
+      // stride of 0, and then scaled.
+      std::vector<int64_t> out_strides(in_dims.size(), 0);
+      int64_t stride = 1;
+      int64_t count = 1;
+      for (int i = static_cast<int>(in_dims.size()) - 1; i >= 0; --i) {
+        if (is_reduced[i]) {
+          count *= in_dims[i];
+        } else {
+          out_strides[i] = stride;
+          stride *= in_dims[i];
+        }
+      }
+      fill(llvm::ConstantFP::get(elem_type, 0.0));
+      const std::vector<int64_t> in_strides = GetStrides(in_dims);
+      llvm::FastMathFlags fmf;
+      fmf.setAllowReassoc();
+      EmitLoopNest(in_dims, [&](const std::vector<llvm::Value*>& ivs) {
+        llvm::Value* offset = GetOffset(ir_builder, ivs, out_strides);
+        llvm::Value* sum =
+            ir_builder->CreateFAdd(load(ret_ptr, offset),
+                                   load(in_ptr, GetOffset(ir_builder, ivs,
+                                                          in_strides)));
+        llvm::cast<llvm::Instruction>(sum)->setFastMathFlags(fmf);
+        store(sum, ret_ptr, offset);
+      });
+      llvm::Value* scale = llvm::ConstantFP::get(elem_type, 1.0 / count);
+      EmitLoopNest({ret_type.GetTotalNumOfElements()},
+                   [&](const std::vector<llvm::Value*>& ivs) {
+                     store(ir_builder->CreateFMul(load(ret_ptr, ivs[0]),
+                                                  scale),
+                           ret_ptr, ivs[0]);
+                   });
+      break;
+    }
+    default: {
+      HLCHECK(0 && "Unreachable");
+    }
+  }
+  ir_mapping_[*inst] = ret_buf;
+  return true;
+}
+
+void GenericLLVMIRCodeGen::OptimizeModule() {
+  llvm::PassManagerBuilder builder;
+  builder.OptLevel = 3;
+  builder.LoopVectorize = true;
+  builder.SLPVectorize = true;
+  target_machine_->adjustPassManager(builder);
+
+  llvm::legacy::FunctionPassManager fpm(llvm_module_.get());
+  llvm::legacy::PassManager mpm;
+  fpm.add(llvm::createTargetTransformInfoWrapperPass(
+      target_machine_->getTargetIRAnalysis()));
+  mpm.add(llvm::createTargetTransformInfoWrapperPass(
+      target_machine_->getTargetIRAnalysis()));
+  builder.populateFunctionPassManager(fpm);
+  builder.populateModulePassManager(mpm);
+
+  fpm.doInitialization();
+  for (llvm::Function& func : *llvm_module_) {
+    fpm.run(func);
+  }
+  fpm.doFinalization();
+  mpm.run(*llvm_module_);
+}
+
+} // namespace halo
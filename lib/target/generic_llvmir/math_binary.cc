@@ -72,7 +72,8 @@ void GenericLLVMIRCodeGen::RunOnMathBinaryInstruction(Instruction* inst) {
   } else {
     llvm::Type* shape_type =
         llvm::ArrayType::get(ir_builder->getInt64Ty(), dim);
-    llvm::ArrayRef<int64_t> shape_data(ret_type.GetDimSizes());
+    llvm::ArrayRef<int64_t> shape_data(ret_type.GetDimSizes().begin(),
+                                       ret_type.GetDimSizes().end());
     llvm::Constant* shape_cv =
         llvm::ConstantDataArray::get(llvm_module_->getContext(), shape_data);
     auto shape_gv =
@@ -53,8 +53,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(OneHotInst* inst) {
   HLCHECK(inst->GetAxis() == -1 && "unsupported axis value for onehot.");
   llvm::Type* op0_ty = op0->getType();
   if (!op0_ty->isPointerTy()) {
-    auto buf = ir_builder->CreateAlloca(
-        TensorTypeToLLVMType(indices.GetType(), false), nullptr,
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(indices.GetType(), false),
         indices.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
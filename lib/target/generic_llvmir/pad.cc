@@ -52,9 +52,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(PadInst* inst) {
   llvm::FunctionCallee callee = llvm_module->getOrInsertFunction(fname, ftype);
 
   if (!op0->getType()->isPointerTy()) {
-    auto buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(lhs.GetType(), false),
-                                 nullptr, lhs.GetOwner()->GetName() + "_buf");
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(lhs.GetType(), false),
+        lhs.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
@@ -67,7 +67,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(PadInst* inst) {
 
   llvm::Value* ret_buf_ptr = ir_builder->CreateBitCast(ret_buf, data_ptr_type);
 
-  const llvm::ArrayRef<int64_t> orig_shape(lhs_type.GetDimSizes());
+  const llvm::ArrayRef<int64_t> orig_shape(lhs_type.GetDimSizes().begin(),
+                                           lhs_type.GetDimSizes().end());
   llvm::Constant* orig_shape_data =
       llvm::ConstantDataArray::get(llvm_module->getContext(), orig_shape);
   auto v = llvm_module_->getOrInsertGlobal(
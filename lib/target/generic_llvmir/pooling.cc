@@ -34,9 +34,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(PoolingMaxInst* inst0) {
 
   llvm::Type* op0_ty = op0->getType();
   if (!op0_ty->isPointerTy()) {
-    auto buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(lhs.GetType(), false),
-                                 nullptr, lhs.GetOwner()->GetName() + "_buf");
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(lhs.GetType(), false),
+        lhs.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
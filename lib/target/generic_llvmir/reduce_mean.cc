@@ -49,9 +49,9 @@ void GenericLLVMIRCodeGen::RunOnCommonReductionInstruction(
   llvm::FunctionCallee callee = llvm_module->getOrInsertFunction(fname, ftype);
 
   if (!op0->getType()->isPointerTy()) {
-    auto buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(lhs_type, false), nullptr,
-                                 lhs.GetOwner()->GetName() + "_buf");
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(lhs_type, false),
+        lhs.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
@@ -62,7 +62,8 @@ void GenericLLVMIRCodeGen::RunOnCommonReductionInstruction(
   llvm::Value* noe_v = ir_builder->getInt64(num_of_elements);
   llvm::Value* dim_v = ir_builder->getInt32(dim);
   llvm::Type* shape_type = llvm::ArrayType::get(i64_type, dim);
-  llvm::ArrayRef<int64_t> shape_data(lhs_type.GetDimSizes());
+  llvm::ArrayRef<int64_t> shape_data(lhs_type.GetDimSizes().begin(),
+                                     lhs_type.GetDimSizes().end());
   llvm::Constant* shape_cv =
       llvm::ConstantDataArray::get(llvm_module_->getContext(), shape_data);
   auto shape_gv = llvm_module_->getOrInsertGlobal(
@@ -80,9 +81,9 @@ void GenericLLVMIRCodeGen::RunOnCommonReductionInstruction(
     auto& rhs_type = rhs.GetType();
     axis_size = rhs_type.GetTotalNumOfElements();
     if (!op1->getType()->isPointerTy()) {
-      auto buf =
-          ir_builder->CreateAlloca(TensorTypeToLLVMType(rhs_type, false),
-                                   nullptr, rhs.GetOwner()->GetName() + "_buf");
+      auto buf = CreateEntryBlockAlloca(
+          ir_builder, TensorTypeToLLVMType(rhs_type, false),
+          rhs.GetOwner()->GetName() + "_buf");
       ir_builder->CreateStore(op1, buf);
       op1 = buf;
     }
@@ -33,9 +33,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(SliceInst* inst) {
     const Def& def = inst->GetOperand(i);
     llvm::Value* op_i = ir_mapping_[def];
     if (!op_i->getType()->isPointerTy()) {
-      auto buf =
-          ir_builder->CreateAlloca(TensorTypeToLLVMType(def.GetType(), false),
-                                   nullptr, def.GetOwner()->GetName() + "_buf");
+      auto buf = CreateEntryBlockAlloca(
+          ir_builder, TensorTypeToLLVMType(def.GetType(), false),
+          def.GetOwner()->GetName() + "_buf");
       ir_builder->CreateStore(op_i, buf);
       op_i = buf;
     }
@@ -67,7 +67,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(SliceInst* inst) {
   auto dim = params.GetType().GetNumOfDims();
   llvm::Value* dim_v = ir_builder->getInt32(dim);
   llvm::Type* shape_type = llvm::ArrayType::get(ir_builder->getInt64Ty(), dim);
-  llvm::ArrayRef<int64_t> shape_data(params.GetType().GetDimSizes());
+  llvm::ArrayRef<int64_t> shape_data(params.GetType().GetDimSizes().begin(),
+                                     params.GetType().GetDimSizes().end());
   llvm::Constant* shape_cv =
       llvm::ConstantDataArray::get(llvm_module_->getContext(), shape_data);
   auto shape_gv = llvm_module_->getOrInsertGlobal(
@@ -45,9 +45,9 @@ void GenericLLVMIRCodeGen::RunOnInstruction(SoftmaxInst* inst) {
   llvm::FunctionCallee callee = llvm_module->getOrInsertFunction(fname, ftype);
 
   if (!op0->getType()->isPointerTy()) {
-    auto buf =
-        ir_builder->CreateAlloca(TensorTypeToLLVMType(lhs_type, false), nullptr,
-                                 lhs.GetOwner()->GetName() + "_buf");
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(lhs_type, false),
+        lhs.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
   }
@@ -64,7 +64,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(SoftmaxInst* inst) {
   }
   llvm::Value* axis_v = ir_builder->getInt32(axis);
   llvm::Type* shape_type = llvm::ArrayType::get(int64_type, dim);
-  llvm::ArrayRef<int64_t> shape_data(lhs_type.GetDimSizes());
+  llvm::ArrayRef<int64_t> shape_data(lhs_type.GetDimSizes().begin(),
+                                     lhs_type.GetDimSizes().end());
   llvm::Constant* shape_cv =
       llvm::ConstantDataArray::get(llvm_module_->getContext(), shape_data);
   auto shape_gv = llvm_module_->getOrInsertGlobal(
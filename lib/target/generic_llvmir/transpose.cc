@@ -31,8 +31,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(TransposeInst* inst) {
   // llvm::Type* op0_ty = op0->getType();
 #if 0
   if (!op0_ty->isPointerTy()) {
-    auto buf = ir_builder->CreateAlloca(
-        TensorTypeToLLVMType(params.GetType(), false), nullptr,
+    auto buf = CreateEntryBlockAlloca(
+        ir_builder, TensorTypeToLLVMType(params.GetType(), false),
         params.GetOwner()->GetName() + "_buf");
     ir_builder->CreateStore(op0, buf);
     op0 = buf;
@@ -54,7 +54,8 @@ void GenericLLVMIRCodeGen::RunOnInstruction(TransposeInst* inst) {
 
   auto dim = params.GetType().GetNumOfDims();
   llvm::Type* shape_type = llvm::ArrayType::get(ir_builder->getInt64Ty(), dim);
-  llvm::ArrayRef<int64_t> shape_data(params.GetType().GetDimSizes());
+  llvm::ArrayRef<int64_t> shape_data(params.GetType().GetDimSizes().begin(),
+                                     params.GetType().GetDimSizes().end());
   llvm::Constant* shape_cv =
       llvm::ConstantDataArray::get(llvm_module_->getContext(), shape_data);
   auto shape_gv = llvm_module_->getOrInsertGlobal(
@@ -0,0 +1,140 @@
+//===- weights_file_writer.cc ---------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/target/weights_file_writer.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "halo/lib/ir/constant_pool.h"
+
+namespace halo {
+
+static uint64_t AlignTo(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Appends the bytes of `value`. The host is assumed to be little endian.
+template <typename T>
+static void Append(std::string* buf, T value) {
+  buf->append(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT.
+}
+
+std::string WeightsFileWriter::GetEntryName(const Constant& constant) {
+  const IRObject* parent = constant.GetParent();
+  if (IsA<Function>(parent)) {
+    return DynCast<const Function>(parent)->GetName() + "/" + constant.GetName();
+  }
+  return constant.GetName();
+}
+
+bool WeightsFileWriter::RunOnModule(Module* module) {
+  std::vector<Constant*> constants;
+  ConstantPool pool;
+  for (auto& constant : module->Constants()) {
+    constants.push_back(constant.get());
+    pool.Insert(constant.get());
+  }
+  for (auto& func : *module) {
+    for (auto& constant : func->Constants()) {
+      constants.push_back(constant.get());
+      pool.Insert(constant.get());
+    }
+  }
+  std::vector<std::string> names;
+  names.reserve(constants.size());
+  std::unordered_set<std::string> unique_names;
+  for (const Constant* c : constants) {
+    names.push_back(GetEntryName(*c));
+    HLCHECK(unique_names.insert(names.back()).second &&
+            "Duplicate constant name in weights file");
+  }
+
+  // The data offsets depend on the index size, which is known up front.
+  uint64_t index_size = 0;
+  for (size_t i = 0, e = constants.size(); i < e; ++i) {
+    index_size += AlignTo(2 * sizeof(uint64_t) + 2 * sizeof(uint32_t) +
+                              constants[i]->GetResultType().GetNumOfDims() *
+                                  sizeof(int64_t) +
+                              sizeof(uint32_t) + names[i].size() + 1,
+                          sizeof(uint64_t));
+  }
+  uint64_t data_offset = AlignTo(HeaderSize + index_size, Alignment);
+
+  std::string header;
+  header.append(Magic, sizeof(Magic));
+  Append(&header, Version);
+  Append(&header, static_cast<uint32_t>(constants.size()));
+  Append(&header, HeaderSize);
+  Append(&header, data_offset);
+  HLCHECK(header.size() == HeaderSize);
+
+  std::string index;
+  index.reserve(index_size);
+  std::vector<uint64_t> offsets;
+  offsets.reserve(constants.size());
+  // The data of duplicated constants is stored once.
+  std::unordered_map<const Constant*, uint64_t> payload_offsets;
+  uint64_t offset = data_offset;
+  for (size_t i = 0, e = constants.size(); i < e; ++i) {
+    const Constant* c = constants[i];
+    const halo::Type& type = c->GetResultType();
+    uint64_t size = c->GetElementSizeInBytes() * type.GetTotalNumOfElements();
+    const Constant* canonical = pool.GetCanonical(c);
+    if (canonical == c) {
+      payload_offsets[c] = offset;
+      offsets.push_back(offset);
+      offset = AlignTo(offset + size, Alignment);
+    } else {
+      offsets.push_back(payload_offsets.at(canonical));
+    }
+    Append(&index, offsets.back());
+    Append(&index, size);
+    Append(&index, static_cast<uint32_t>(type.GetDataType()));
+    Append(&index, static_cast<uint32_t>(type.GetNumOfDims()));
+    for (int64_t dim : type.GetDimSizes()) {
+      Append(&index, dim);
+    }
+    const std::string& name = names[i];
+    Append(&index, static_cast<uint32_t>(name.size() + 1));
+    index.append(name.c_str(), name.size() + 1);
+    index.resize(AlignTo(index.size(), sizeof(uint64_t)), '\0');
+  }
+  HLCHECK(index.size() == index_size);
+
+  os_.write(header.data(), header.size());
+  os_.write(index.data(), index.size());
+  uint64_t pos = HeaderSize + index_size;
+  const std::string padding(Alignment, '\0');
+  for (size_t i = 0, e = constants.size(); i < e; ++i) {
+    const Constant* c = constants[i];
+    if (!pool.IsCanonical(c)) {
+      continue;
+    }
+    os_.write(padding.data(), offsets[i] - pos);
+    uint64_t size = c->GetElementSizeInBytes() *
+                    c->GetResultType().GetTotalNumOfElements();
+    // Written straight from the constant without an intermediate copy.
+    os_.write(static_cast<const char*>(c->GetRawDataPtr()), size);
+    pos = offsets[i] + size;
+  }
+  return false;
+}
+
+} // namespace halo
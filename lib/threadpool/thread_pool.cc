@@ -0,0 +1,226 @@
+//===- thread_pool.cc -----------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/threadpool/thread_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace halo {
+
+// The pool and worker index of the current thread, if it is a worker.
+static thread_local const ThreadPool* tls_pool = nullptr;
+static thread_local int tls_worker_index = -1;
+// Number of parallel loop chunks the current thread is running.
+static thread_local int tls_parallel_depth = 0;
+
+namespace {
+class ParallelRegion {
+ public:
+  ParallelRegion() noexcept { ++tls_parallel_depth; }
+  ~ParallelRegion() { --tls_parallel_depth; }
+};
+} // end anonymous namespace
+
+ThreadPool::ThreadPool(int num_of_threads) {
+  int num_of_workers = std::max(num_of_threads, 1) - 1;
+  queues_.reserve(num_of_workers);
+  for (int i = 0; i < num_of_workers; ++i) {
+    queues_.push_back(std::make_unique<WorkQueue>());
+  }
+  workers_.reserve(num_of_workers);
+  for (int i = 0; i < num_of_workers; ++i) {
+    workers_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+int ThreadPool::GetDefaultNumOfThreads() {
+  // The runtime library compiles this file as C++14.
+  const char* env = std::getenv("HALO_NUM_THREADS");
+  if (env != nullptr) {
+    int n = std::atoi(env);
+    if (n > 0) {
+      return n;
+    }
+  }
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+int ThreadPool::GetWorkerIndex() const noexcept {
+  return tls_pool == this ? tls_worker_index : -1;
+}
+
+void ThreadPool::Schedule(Task task) {
+  if (workers_.empty()) {
+    task();
+    return;
+  }
+  num_of_unfinished_.fetch_add(1, std::memory_order_relaxed);
+  // Workers keep the tasks they spawn local; other threads spread their tasks
+  // over all queues.
+  int index = GetWorkerIndex();
+  size_t q = index >= 0 ? static_cast<size_t>(index)
+                        : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                              queues_.size();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_of_queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+    queues_[q]->tasks.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+bool ThreadPool::PopTask(int index, Task* task) {
+  if (index >= 0) {
+    WorkQueue& own = *queues_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      *task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  size_t n = queues_.size();
+  size_t start = index >= 0 ? static_cast<size_t>(index) + 1 : 0;
+  for (size_t i = 0; i < n; ++i) {
+    WorkQueue& victim = *queues_[(start + i) % n];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::RunOneTask(int index) {
+  Task task;
+  if (!PopTask(index, &task)) {
+    return false;
+  }
+  num_of_queued_.fetch_sub(1, std::memory_order_relaxed);
+  task();
+  if (num_of_unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_cv_.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::WorkerLoop(int index) {
+  tls_pool = this;
+  tls_worker_index = index;
+  while (true) {
+    if (RunOneTask(index)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() {
+      return stop_ || num_of_queued_.load(std::memory_order_relaxed) > 0;
+    });
+    if (stop_ && num_of_queued_.load(std::memory_order_relaxed) <= 0) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::RunPendingTasks() {
+  int index = GetWorkerIndex();
+  while (RunOneTask(index)) {
+  }
+}
+
+void ThreadPool::Wait() {
+  // Help while there are queued tasks, then sleep until the running ones are
+  // done.
+  RunPendingTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() {
+    return num_of_unfinished_.load(std::memory_order_acquire) <= 0;
+  });
+}
+
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                             const RangeFunc& func) {
+  int64_t n = end - begin;
+  if (n <= 0) {
+    return;
+  }
+  grain = std::max(grain, static_cast<int64_t>(1));
+  // A few chunks per thread even out chunks of uneven cost.
+  constexpr int64_t chunks_per_thread = 4;
+  int64_t num_of_chunks = std::min((n + grain - 1) / grain,
+                                   chunks_per_thread * GetNumOfThreads());
+  if (num_of_chunks <= 1 || workers_.empty() || tls_parallel_depth > 0) {
+    ParallelRegion region;
+    func(begin, end);
+    return;
+  }
+  int64_t chunk = (n + num_of_chunks - 1) / num_of_chunks;
+  num_of_chunks = (n + chunk - 1) / chunk;
+
+  // The chunks scheduled by this loop that are not done yet.
+  struct Completion {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int64_t remaining;
+  } done;
+  done.remaining = num_of_chunks - 1;
+  for (int64_t i = 1; i < num_of_chunks; ++i) {
+    int64_t lo = begin + i * chunk;
+    int64_t hi = std::min(end, lo + chunk);
+    Schedule([&func, &done, lo, hi]() {
+      {
+        ParallelRegion region;
+        func(lo, hi);
+      }
+      // Notify under the lock: the waiter owns `done` and may return as soon
+      // as it sees the count drop to zero.
+      std::lock_guard<std::mutex> lock(done.mutex);
+      if (--done.remaining == 0) {
+        done.cv.notify_one();
+      }
+    });
+  }
+  {
+    ParallelRegion region;
+    func(begin, begin + chunk);
+  }
+  // Help with the remaining chunks, or with whatever else is queued. Once the
+  // queues are empty, every chunk has been started, so sleep until the last
+  // one finishes.
+  RunPendingTasks();
+  std::unique_lock<std::mutex> lock(done.mutex);
+  done.cv.wait(lock, [&done]() { return done.remaining == 0; });
+}
+
+} // namespace halo
@@ -138,7 +138,7 @@ static std::vector<Def> ConvertConvolution(const CAFFEExtensionInst* ext,
     auto bias = ext->GetOperand(2);
     const auto& orig_bias = DynCast<Constant>(bias.GetOwner());
     // do broadcast, need to be offline for performance
-    auto shape = bias.GetType().GetDimSizes();
+    std::vector<int64_t> shape = bias.GetType().GetDimSizes();
     if (shape.size() > 1) {
       auto c = shape.back();
       shape.clear();
@@ -231,7 +231,7 @@ static std::vector<Def> ConvertInnerProduct(const CAFFEExtensionInst* ext,
     for (unsigned i = 0, e = op1_type.GetNumOfDims() - 2; i < e; ++i) {
       HLCHECK(op1_type.GetNumOfElementsInDim(i) == 1);
     }
-    auto dims = op1_type.GetDimSizes();
+    std::vector<int64_t> dims = op1_type.GetDimSizes();
     auto dim_a = dims[dims.size() - 2];
     auto dim_b = dims.back();
     op1.GetOwner()->GetResultsTypes()[0] =
@@ -244,7 +244,7 @@ static std::vector<Def> ConvertInnerProduct(const CAFFEExtensionInst* ext,
   ConstantBuilder cb(ext->GetParent()->GetParent());
   HLCHECK(input_type.GetNumOfDims() >= 2);
   if (input_type.GetNumOfDims() > 2) {
-    auto new_shape = input_type.GetDimSizes();
+    std::vector<int64_t> new_shape = input_type.GetDimSizes();
     for (int i = 1; i < axis; ++i) {
       new_shape[0] *= new_shape[i];
     }
@@ -527,7 +527,7 @@ static std::vector<Def> ConvertDeConvolution(const CAFFEExtensionInst* ext,
     auto bias = ext->GetOperand(2);
     const auto& orig_bias = DynCast<Constant>(bias.GetOwner());
     // do broadcast, need to be offline for performance
-    auto shape = bias.GetType().GetDimSizes();
+    std::vector<int64_t> shape = bias.GetType().GetDimSizes();
     const static int axis = 1; // broadcast on C
     const static int dims = 4; // conv2D
     HLCHECK(shape.size() == 1);
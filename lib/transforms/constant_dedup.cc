@@ -0,0 +1,43 @@
+//===- constant_dedup.cc --------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/transforms/constant_dedup.h"
+
+#include "halo/lib/ir/constant_pool.h"
+#include "halo/lib/ir/function.h"
+
+namespace halo {
+
+bool ConstantDedup::RunOnFunction(Function* func) {
+  ConstantPool pool;
+  bool changed = false;
+  Function::ConstantList& constants = func->Constants();
+  for (auto it = constants.begin(), ie = constants.end(); it != ie;) {
+    Constant* constant = it->get();
+    Constant* canonical = pool.Insert(constant);
+    if (canonical == constant) {
+      ++it;
+      continue;
+    }
+    constant->ReplaceAllUsesWith(0, Def{canonical, 0});
+    it = constants.erase(it);
+    changed = true;
+  }
+  return changed;
+}
+
+} // end namespace halo
@@ -0,0 +1,1079 @@
+//===- constant_evaluator.cc ----------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/transforms/constant_evaluator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "halo/lib/framework/data_layout.h"
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+namespace halo {
+
+using Shape = std::vector<int64_t>;
+
+// Floating point values are accumulated in double. Integer values wrap around
+// like in the generated code.
+template <typename T>
+using AccType = std::conditional_t<std::is_floating_point_v<T>, double, T>;
+
+template <typename T>
+static T Add(T x, T y) {
+  if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(static_cast<uint64_t>(x) + static_cast<uint64_t>(y));
+  } else {
+    return x + y;
+  }
+}
+
+template <typename T>
+static T Sub(T x, T y) {
+  if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(static_cast<uint64_t>(x) - static_cast<uint64_t>(y));
+  } else {
+    return x - y;
+  }
+}
+
+template <typename T>
+static T Mul(T x, T y) {
+  if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(static_cast<uint64_t>(x) * static_cast<uint64_t>(y));
+  } else {
+    return x * y;
+  }
+}
+
+// Calls `func` with a value of the C++ type that stores the elements of `dt`.
+// Returns false for data types without one, e.g., FLOAT16.
+template <typename Func>
+static bool VisitNativeType(DataType dt, Func&& func) {
+  switch (dt) {
+    case DataType::BOOL:
+    case DataType::INT8: {
+      return func(int8_t{});
+    }
+    case DataType::UINT8: {
+      return func(uint8_t{});
+    }
+    case DataType::INT16: {
+      return func(int16_t{});
+    }
+    case DataType::INT32: {
+      return func(int32_t{});
+    }
+    case DataType::UINT32: {
+      return func(uint32_t{});
+    }
+    case DataType::INT64: {
+      return func(int64_t{});
+    }
+    case DataType::FLOAT32: {
+      return func(float{});
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+static int64_t GetNumOfElements(const Shape& shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t{1},
+                         std::multiplies<int64_t>());
+}
+
+// Returns the row-major strides of `shape`.
+static Shape GetStrides(const Shape& shape) {
+  Shape strides(shape.size(), 1);
+  for (size_t i = shape.size(); i-- > 1;) {
+    strides[i - 1] = strides[i] * shape[i];
+  }
+  return strides;
+}
+
+// Computes the strides to read a value of `shape` broadcast to `ret_shape`.
+// They are 0 on the broadcast dimensions. Returns false if the shapes are not
+// compatible.
+static bool GetBroadcastStrides(const Shape& shape, const Shape& ret_shape,
+                                Shape* strides) {
+  if (shape.size() > ret_shape.size()) {
+    return false;
+  }
+  strides->assign(ret_shape.size(), 0);
+  const size_t offset = ret_shape.size() - shape.size();
+  int64_t stride = 1;
+  for (size_t i = shape.size(); i-- > 0;) {
+    if (shape[i] == ret_shape[offset + i]) {
+      (*strides)[offset + i] = shape[i] == 1 ? 0 : stride;
+    } else if (shape[i] != 1) {
+      return false;
+    }
+    stride *= shape[i];
+  }
+  return true;
+}
+
+// Calls `func(i, offsets)` for every element of `shape` in row-major order,
+// where `i` is the index of the element and `offsets[k]` is its offset with
+// `strides[k]`.
+template <size_t N, typename Func>
+static void ForEachElement(const Shape& shape,
+                           const std::array<Shape, N>& strides, Func func) {
+  const size_t rank = shape.size();
+  Shape index(rank, 0);
+  std::array<int64_t, N> offsets{};
+  for (int64_t i = 0, n = GetNumOfElements(shape); i < n; ++i) {
+    func(i, offsets);
+    for (size_t d = rank; d-- > 0;) {
+      for (size_t k = 0; k < N; ++k) {
+        offsets[k] += strides[k][d];
+      }
+      if (++index[d] < shape[d]) {
+        break;
+      }
+      for (size_t k = 0; k < N; ++k) {
+        offsets[k] -= strides[k][d] * shape[d];
+      }
+      index[d] = 0;
+    }
+  }
+}
+
+// Reads the elements of an INT32 or INT64 constant.
+static bool GetIntegers(const Def& def, std::vector<int64_t>* values) {
+  const Constant* c = DynCast<Constant>(def);
+  const Type& type = c->GetResultType();
+  if (type.GetDataType() != DataType::INT32 &&
+      type.GetDataType() != DataType::INT64) {
+    return false;
+  }
+  values->resize(type.GetTotalNumOfElements());
+  for (size_t i = 0, e = values->size(); i < e; ++i) {
+    (*values)[i] = c->GetDataAsInt64(i);
+  }
+  return true;
+}
+
+// Returns `axis` in [0, rank), or -1 if it is out of range.
+static int64_t NormalizeAxis(int64_t axis, size_t rank) {
+  const auto r = static_cast<int64_t>(rank);
+  axis = axis < 0 ? axis + r : axis;
+  return axis >= 0 && axis < r ? axis : -1;
+}
+
+template <typename T, typename Pred>
+static bool AllOf(const Constant& c, Pred pred) {
+  const T* data = c.GetDataPtr<T>();
+  return std::all_of(data, data + c.GetResultType().GetTotalNumOfElements(),
+                     pred);
+}
+
+template <typename T>
+static T Activate(T x, ActivationType activation, float alpha) {
+  switch (activation) {
+    case ActivationType::RELU: {
+      return std::max(x, T{0});
+    }
+    case ActivationType::RELU6: {
+      return std::min(std::max(x, T{0}), T{6});
+    }
+    case ActivationType::LEAKY_RELU: {
+      return x < 0 ? static_cast<T>(x * alpha) : x;
+    }
+    default: {
+      return x;
+    }
+  }
+}
+
+template <typename T>
+static bool EvaluateUnary(Instruction* inst, T* ret) {
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const int64_t n = inst->GetResultType().GetTotalNumOfElements();
+  if (x.GetResultType().GetTotalNumOfElements() != n) {
+    return false;
+  }
+  const T* data = x.GetDataPtr<T>();
+  auto apply = [data, n, ret](auto op) {
+    for (int64_t i = 0; i < n; ++i) {
+      ret[i] = static_cast<T>(op(data[i]));
+    }
+    return true;
+  };
+  switch (inst->GetOpCode()) {
+    case OpCode::ABS: {
+      return apply([](T v) { return v < 0 ? Sub(T{0}, v) : v; });
+    }
+    case OpCode::NEG: {
+      return apply([](T v) { return Sub(T{0}, v); });
+    }
+    case OpCode::SIGN: {
+      return apply([](T v) { return (v > 0) - (v < 0); });
+    }
+    case OpCode::RELU: {
+      return apply([](T v) { return std::max(v, T{0}); });
+    }
+    case OpCode::RELU6: {
+      return apply([](T v) { return std::min(std::max(v, T{0}), T{6}); });
+    }
+    default: {
+      break;
+    }
+  }
+  if constexpr (std::is_floating_point_v<T>) {
+    switch (inst->GetOpCode()) {
+      case OpCode::CEIL: {
+        return apply([](T v) { return std::ceil(v); });
+      }
+      case OpCode::FLOOR: {
+        return apply([](T v) { return std::floor(v); });
+      }
+      case OpCode::EXP: {
+        return apply([](T v) { return std::exp(v); });
+      }
+      case OpCode::ERF: {
+        return apply([](T v) { return std::erf(v); });
+      }
+      case OpCode::RCP: {
+        return apply([](T v) { return T{1} / v; });
+      }
+      case OpCode::SQRT: {
+        return apply([](T v) { return std::sqrt(v); });
+      }
+      case OpCode::RSQRT: {
+        return apply([](T v) { return T{1} / std::sqrt(v); });
+      }
+      case OpCode::TANH: {
+        return apply([](T v) { return std::tanh(v); });
+      }
+      case OpCode::SIGMOID: {
+        return apply([](T v) { return T{1} / (T{1} + std::exp(-v)); });
+      }
+      case OpCode::ELU: {
+        return apply([](T v) { return v < 0 ? std::exp(v) - T{1} : v; });
+      }
+      case OpCode::LEAKYRELU: {
+        const float alpha = DynCast<LeakyReluInst>(inst)->GetAlpha();
+        return apply([alpha](T v) { return v < 0 ? v * alpha : v; });
+      }
+      default: {
+        break;
+      }
+    }
+  }
+  return false;
+}
+
+// Computes ret[i] = op(lhs[j], rhs[k]) with lhs and rhs broadcast to the
+// result shape.
+template <typename T, typename R, typename Op>
+static bool EvaluateBroadcast(Instruction* inst, R* ret, Op op) {
+  const Constant& lhs = *DynCast<Constant>(inst->GetOperand(0));
+  const Constant& rhs = *DynCast<Constant>(inst->GetOperand(1));
+  const Shape& ret_shape = inst->GetResultType().GetDimSizes();
+  std::array<Shape, 2> strides;
+  if (!GetBroadcastStrides(lhs.GetResultType().GetDimSizes(), ret_shape,
+                           &strides[0]) ||
+      !GetBroadcastStrides(rhs.GetResultType().GetDimSizes(), ret_shape,
+                           &strides[1])) {
+    return false;
+  }
+  const T* x = lhs.GetDataPtr<T>();
+  const T* y = rhs.GetDataPtr<T>();
+  ForEachElement(ret_shape, strides,
+                 [x, y, ret, &op](int64_t i, const auto& offsets) {
+                   ret[i] = op(x[offsets[0]], y[offsets[1]]);
+                 });
+  return true;
+}
+
+template <typename T>
+static bool EvaluateBinary(Instruction* inst, T* ret) {
+  const Constant& lhs = *DynCast<Constant>(inst->GetOperand(0));
+  const Constant& rhs = *DynCast<Constant>(inst->GetOperand(1));
+  if (lhs.GetResultType().GetDataType() != rhs.GetResultType().GetDataType()) {
+    return false;
+  }
+  switch (inst->GetOpCode()) {
+    case OpCode::ADD: {
+      return EvaluateBroadcast<T>(inst, ret, Add<T>);
+    }
+    case OpCode::SUB: {
+      return EvaluateBroadcast<T>(inst, ret, Sub<T>);
+    }
+    case OpCode::MUL: {
+      return EvaluateBroadcast<T>(inst, ret, Mul<T>);
+    }
+    case OpCode::MAXIMUM: {
+      return EvaluateBroadcast<T>(inst, ret,
+                                  [](T x, T y) { return std::max(x, y); });
+    }
+    case OpCode::MINIMUM: {
+      return EvaluateBroadcast<T>(inst, ret,
+                                  [](T x, T y) { return std::min(x, y); });
+    }
+    case OpCode::POW: {
+      return EvaluateBroadcast<T>(
+          inst, ret, [](T x, T y) { return static_cast<T>(std::pow(x, y)); });
+    }
+    case OpCode::DIV: {
+      if constexpr (std::is_integral_v<T>) {
+        // Leave the undefined cases to the runtime.
+        if (!AllOf<T>(rhs, [](T v) { return v != 0; }) ||
+            (std::is_signed_v<T> &&
+             !AllOf<T>(rhs, [](T v) { return v != T(-1); }) &&
+             !AllOf<T>(lhs, [](T v) {
+               return v != std::numeric_limits<T>::min();
+             }))) {
+          return false;
+        }
+      }
+      return EvaluateBroadcast<T>(inst, ret, [](T x, T y) { return x / y; });
+    }
+    case OpCode::AND: {
+      return EvaluateBroadcast<T>(inst, ret,
+                                  [](T x, T y) { return T(x != 0 && y != 0); });
+    }
+    case OpCode::OR: {
+      return EvaluateBroadcast<T>(inst, ret,
+                                  [](T x, T y) { return T(x != 0 || y != 0); });
+    }
+    default: {
+      break;
+    }
+  }
+  if constexpr (std::is_integral_v<T>) {
+    using UT = std::make_unsigned_t<T>;
+    constexpr T bits = sizeof(T) * 8;
+    if (inst->GetOpCode() == OpCode::SHIFTL ||
+        inst->GetOpCode() == OpCode::SHIFTR) {
+      if (!AllOf<T>(rhs, [bits](T v) { return v >= 0 && v < bits; })) {
+        return false;
+      }
+    }
+    if (inst->GetOpCode() == OpCode::SHIFTL) {
+      return EvaluateBroadcast<T>(inst, ret, [](T x, T y) {
+        return static_cast<T>(static_cast<UT>(x) << y);
+      });
+    }
+    if (inst->GetOpCode() == OpCode::SHIFTR) {
+      return EvaluateBroadcast<T>(inst, ret, [](T x, T y) {
+        return static_cast<T>(static_cast<UT>(x) >> y);
+      });
+    }
+  }
+  return false;
+}
+
+template <typename T>
+static bool EvaluateCompare(CmpInst* inst, int8_t* ret) {
+  if (inst->GetOperand(0).GetType().GetDataType() !=
+      inst->GetOperand(1).GetType().GetDataType()) {
+    return false;
+  }
+  switch (inst->GetPredicator()) {
+    case KindPredicate::EQ: {
+      return EvaluateBroadcast<T>(inst, ret, std::equal_to<T>());
+    }
+    case KindPredicate::NE: {
+      return EvaluateBroadcast<T>(inst, ret, std::not_equal_to<T>());
+    }
+    case KindPredicate::GT: {
+      return EvaluateBroadcast<T>(inst, ret, std::greater<T>());
+    }
+    case KindPredicate::GE: {
+      return EvaluateBroadcast<T>(inst, ret, std::greater_equal<T>());
+    }
+    case KindPredicate::LT: {
+      return EvaluateBroadcast<T>(inst, ret, std::less<T>());
+    }
+    case KindPredicate::LE: {
+      return EvaluateBroadcast<T>(inst, ret, std::less_equal<T>());
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+template <typename InstType>
+static std::vector<int64_t> GetReductionAxes(Instruction* inst) {
+  const auto& axis = DynCast<InstType>(inst)->GetAxis();
+  return std::vector<int64_t>(axis.begin(), axis.end());
+}
+
+template <typename T>
+static bool EvaluateReduction(Instruction* inst, T* ret) {
+  std::vector<int64_t> axes;
+  switch (inst->GetOpCode()) {
+    case OpCode::REDUCEMAX: {
+      axes = GetReductionAxes<ReduceMaxInst>(inst);
+      break;
+    }
+    case OpCode::REDUCEMEAN: {
+      axes = GetReductionAxes<ReduceMeanInst>(inst);
+      break;
+    }
+    case OpCode::REDUCEMIN: {
+      axes = GetReductionAxes<ReduceMinInst>(inst);
+      break;
+    }
+    case OpCode::REDUCEPRODUCT: {
+      axes = GetReductionAxes<ReduceProductInst>(inst);
+      break;
+    }
+    case OpCode::REDUCESUM: {
+      axes = GetReductionAxes<ReduceSumInst>(inst);
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
+  // The axes operand takes the place of the attribute, like in the type
+  // legalizer.
+  if (inst->GetNumOfOperands() > 1 &&
+      (!axes.empty() || !GetIntegers(inst->GetOperand(1), &axes))) {
+    return false;
+  }
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const Shape& shape = x.GetResultType().GetDimSizes();
+  const size_t rank = shape.size();
+  std::vector<bool> reduced(rank, false);
+  for (int64_t axis : axes) {
+    axis = NormalizeAxis(axis, rank);
+    if (axis < 0) {
+      return false;
+    }
+    reduced[axis] = true;
+  }
+  // Maps every element of the input to the element of the result it is
+  // reduced into.
+  std::array<Shape, 1> ret_strides{Shape(rank, 0)};
+  int64_t ret_size = 1;
+  for (size_t d = rank; d-- > 0;) {
+    if (!reduced[d]) {
+      ret_strides[0][d] = ret_size;
+      ret_size *= shape[d];
+    }
+  }
+  const int64_t size = x.GetResultType().GetTotalNumOfElements();
+  if (ret_size != inst->GetResultType().GetTotalNumOfElements() || size == 0) {
+    return false;
+  }
+
+  using Acc = AccType<T>;
+  const OpCode opcode = inst->GetOpCode();
+  Acc init = Acc{0};
+  if (opcode == OpCode::REDUCEPRODUCT) {
+    init = Acc{1};
+  } else if (opcode == OpCode::REDUCEMAX) {
+    init = std::numeric_limits<Acc>::lowest();
+  } else if (opcode == OpCode::REDUCEMIN) {
+    init = std::numeric_limits<Acc>::max();
+  }
+  std::vector<Acc> acc(ret_size, init);
+  const T* data = x.GetDataPtr<T>();
+  ForEachElement(shape, ret_strides,
+                 [&acc, data, opcode](int64_t i, const auto& offsets) {
+                   Acc& a = acc[offsets[0]];
+                   const Acc v = data[i];
+                   if (opcode == OpCode::REDUCEMAX) {
+                     a = std::max(a, v);
+                   } else if (opcode == OpCode::REDUCEMIN) {
+                     a = std::min(a, v);
+                   } else if (opcode == OpCode::REDUCEPRODUCT) {
+                     a = Mul(a, v);
+                   } else {
+                     a = Add(a, v);
+                   }
+                 });
+  const int64_t count = size / ret_size;
+  for (int64_t i = 0; i < ret_size; ++i) {
+    ret[i] = static_cast<T>(opcode == OpCode::REDUCEMEAN
+                                ? acc[i] / static_cast<Acc>(count)
+                                : acc[i]);
+  }
+  return true;
+}
+
+// Splits `shape` at `axis` into the number of outer slices, the size of the
+// axis and the size of the inner slices.
+static std::array<int64_t, 3> SplitAtAxis(const Shape& shape, int64_t axis) {
+  return {GetNumOfElements(Shape(shape.begin(), shape.begin() + axis)),
+          shape[axis],
+          GetNumOfElements(Shape(shape.begin() + axis + 1, shape.end()))};
+}
+
+template <typename T>
+static bool EvaluateArgMinMax(Instruction* inst, int32_t* ret) {
+  const bool is_max = inst->GetOpCode() == OpCode::ARGMAX;
+  int64_t axis = is_max ? DynCast<ArgmaxInst>(inst)->GetAxis()
+                        : DynCast<ArgminInst>(inst)->GetAxis();
+  if (inst->GetNumOfOperands() > 1) {
+    std::vector<int64_t> values;
+    if (!GetIntegers(inst->GetOperand(1), &values) || values.size() != 1) {
+      return false;
+    }
+    axis = values[0];
+  }
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const Shape& shape = x.GetResultType().GetDimSizes();
+  axis = NormalizeAxis(axis, shape.size());
+  if (axis < 0 || shape[axis] == 0) {
+    return false;
+  }
+  const auto [outer, len, inner] = SplitAtAxis(shape, axis);
+  if (outer * inner != inst->GetResultType().GetTotalNumOfElements()) {
+    return false;
+  }
+  const T* data = x.GetDataPtr<T>();
+  for (int64_t i = 0; i < outer; ++i) {
+    for (int64_t k = 0; k < inner; ++k) {
+      const T* v = data + i * len * inner + k;
+      int64_t best = 0;
+      for (int64_t j = 1; j < len; ++j) {
+        if (is_max ? v[j * inner] > v[best * inner]
+                   : v[j * inner] < v[best * inner]) {
+          best = j;
+        }
+      }
+      ret[i * inner + k] = static_cast<int32_t>(best);
+    }
+  }
+  return true;
+}
+
+// Computes ret = alpha * op(a) * op(b) for `batch` pairs of matrices, where
+// op(a) is M x K and op(b) is K x N.
+template <typename T>
+static void MatMul(const T* a, const T* b, T* ret, int64_t batch, int64_t m,
+                   int64_t n, int64_t k, bool trans_a, bool trans_b,
+                   float alpha) {
+  using Acc = AccType<T>;
+  for (int64_t s = 0; s < batch; ++s) {
+    const T* x = a + s * m * k;
+    const T* y = b + s * k * n;
+    T* z = ret + s * m * n;
+    for (int64_t i = 0; i < m; ++i) {
+      for (int64_t j = 0; j < n; ++j) {
+        Acc sum{0};
+        for (int64_t p = 0; p < k; ++p) {
+          const Acc u = trans_a ? x[p * m + i] : x[i * k + p];
+          const Acc v = trans_b ? y[j * k + p] : y[p * n + j];
+          sum = Add(sum, Mul(u, v));
+        }
+        z[i * n + j] = alpha == 1.0F ? static_cast<T>(sum)
+                                     : static_cast<T>(sum * alpha);
+      }
+    }
+  }
+}
+
+// Computes the sizes of op(a) * op(b) for (batched) matrices. Returns false if
+// they do not match.
+static bool GetMatMulSizes(const Shape& a, const Shape& b, bool trans_a,
+                           bool trans_b, int64_t* batch, int64_t* m,
+                           int64_t* n, int64_t* k) {
+  const size_t rank = a.size();
+  if (rank < 2 || b.size() != rank ||
+      !std::equal(a.begin(), a.end() - 2, b.begin())) {
+    return false;
+  }
+  *batch = GetNumOfElements(Shape(a.begin(), a.end() - 2));
+  *m = trans_a ? a[rank - 1] : a[rank - 2];
+  *k = trans_a ? a[rank - 2] : a[rank - 1];
+  *n = trans_b ? b[rank - 2] : b[rank - 1];
+  return (trans_b ? b[rank - 1] : b[rank - 2]) == *k;
+}
+
+template <typename T>
+static bool EvaluateMatMul(Instruction* inst, T* ret) {
+  bool trans_a = false;
+  bool trans_b = false;
+  if (inst->GetOpCode() == OpCode::MATMUL) {
+    trans_a = DynCast<MatMulInst>(inst)->GetTransposeA();
+    trans_b = DynCast<MatMulInst>(inst)->GetTransposeB();
+  } else {
+    trans_a = DynCast<BatchMatMulInst>(inst)->GetTransposeA();
+    trans_b = DynCast<BatchMatMulInst>(inst)->GetTransposeB();
+  }
+  const Constant& a = *DynCast<Constant>(inst->GetOperand(0));
+  const Constant& b = *DynCast<Constant>(inst->GetOperand(1));
+  if (a.GetResultType().GetDataType() != b.GetResultType().GetDataType()) {
+    return false;
+  }
+  const Shape& a_shape = a.GetResultType().GetDimSizes();
+  int64_t batch = 0;
+  int64_t m = 0;
+  int64_t n = 0;
+  int64_t k = 0;
+  if (!GetMatMulSizes(a_shape, b.GetResultType().GetDimSizes(), trans_a,
+                      trans_b, &batch, &m, &n, &k)) {
+    return false;
+  }
+  Shape ret_shape(a_shape.begin(), a_shape.end() - 2);
+  ret_shape.push_back(m);
+  ret_shape.push_back(n);
+  if (ret_shape != inst->GetResultType().GetDimSizes()) {
+    return false;
+  }
+  MatMul(a.GetDataPtr<T>(), b.GetDataPtr<T>(), ret, batch, m, n, k, trans_a,
+         trans_b, 1.0F);
+  return true;
+}
+
+template <typename T>
+static bool EvaluateGemm(GemmInst* inst, T* ret) {
+  const Constant& a = *DynCast<Constant>(inst->GetOperand(0));
+  const Constant& b = *DynCast<Constant>(inst->GetOperand(1));
+  const Shape& ret_shape = inst->GetResultType().GetDimSizes();
+  int64_t batch = 0;
+  int64_t m = 0;
+  int64_t n = 0;
+  int64_t k = 0;
+  if (a.GetResultType().GetDataType() != b.GetResultType().GetDataType() ||
+      a.GetResultType().GetNumOfDims() != 2 ||
+      !GetMatMulSizes(a.GetResultType().GetDimSizes(),
+                      b.GetResultType().GetDimSizes(), inst->GetTransposeA(),
+                      inst->GetTransposeB(), &batch, &m, &n, &k) ||
+      ret_shape != Shape{m, n}) {
+    return false;
+  }
+  MatMul(a.GetDataPtr<T>(), b.GetDataPtr<T>(), ret, 1, m, n, k,
+         inst->GetTransposeA(), inst->GetTransposeB(), inst->GetAlpha());
+  if (inst->GetNumOfOperands() > 2) {
+    const Constant& c = *DynCast<Constant>(inst->GetOperand(2));
+    std::array<Shape, 1> strides;
+    if (c.GetResultType().GetDataType() != a.GetResultType().GetDataType() ||
+        !GetBroadcastStrides(c.GetResultType().GetDimSizes(), ret_shape,
+                             &strides[0])) {
+      return false;
+    }
+    const T* data = c.GetDataPtr<T>();
+    const float beta = inst->GetBeta();
+    ForEachElement(ret_shape, strides,
+                   [data, ret, beta](int64_t i, const auto& offsets) {
+                     ret[i] = static_cast<T>(ret[i] + data[offsets[0]] * beta);
+                   });
+  }
+  for (int64_t i = 0; i < m * n; ++i) {
+    ret[i] = Activate(ret[i], inst->GetActivation(),
+                      inst->GetActivationAlpha());
+  }
+  return true;
+}
+
+template <typename T>
+static bool EvaluateConv2D(Conv2DInst* inst, T* ret) {
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const Constant& w = *DynCast<Constant>(inst->GetOperand(1));
+  const Shape& xs = x.GetResultType().GetDimSizes();
+  const Shape& ws = w.GetResultType().GetDimSizes();
+  const Shape& rs = inst->GetResultType().GetDimSizes();
+  if (w.GetResultType().GetDataType() != x.GetResultType().GetDataType() ||
+      xs.size() != 4 || ws.size() != 4 || rs.size() != 4) {
+    return false;
+  }
+  const auto& info = ImageAxisInfo::GetImageAxisInfo(inst->GetDataFormat(),
+                                                     inst->GetFilterFormat());
+  const std::vector<int> axes{
+      info.batch_axis,         info.data_channel_axis,
+      info.data_height_axis,   info.data_width_axis,
+      info.kernel_output_axis, info.kernel_input_axis,
+      info.kernel_height_axis, info.kernel_width_axis};
+  if (std::any_of(axes.begin(), axes.end(), [](int a) { return a < 0; }) ||
+      inst->GetStrides().size() != 4 || inst->GetDilations().size() != 4) {
+    return false;
+  }
+  const int64_t batch = xs[info.batch_axis];
+  const int64_t channels = xs[info.data_channel_axis];
+  const int64_t height = xs[info.data_height_axis];
+  const int64_t width = xs[info.data_width_axis];
+  const int64_t out_channels = ws[info.kernel_output_axis];
+  const int64_t in_channels = ws[info.kernel_input_axis];
+  const int64_t kernel_h = ws[info.kernel_height_axis];
+  const int64_t kernel_w = ws[info.kernel_width_axis];
+  const int64_t out_h = rs[info.data_height_axis];
+  const int64_t out_w = rs[info.data_width_axis];
+  const int64_t group = inst->GetGroup();
+  if (group <= 0 || rs[info.batch_axis] != batch ||
+      rs[info.data_channel_axis] != out_channels ||
+      in_channels * group != channels || out_channels % group != 0) {
+    return false;
+  }
+  const T* bias = nullptr;
+  if (inst->GetNumOfOperands() > 2) {
+    const Constant& b = *DynCast<Constant>(inst->GetOperand(2));
+    if (b.GetResultType().GetDataType() != x.GetResultType().GetDataType() ||
+        b.GetResultType().GetTotalNumOfElements() != out_channels) {
+      return false;
+    }
+    bias = b.GetDataPtr<T>();
+  }
+  const int64_t stride_h = inst->GetStrides()[info.data_height_axis];
+  const int64_t stride_w = inst->GetStrides()[info.data_width_axis];
+  const int64_t dilation_h = inst->GetDilations()[info.data_height_axis];
+  const int64_t dilation_w = inst->GetDilations()[info.data_width_axis];
+  const int64_t pad_top = inst->GetPaddingTop();
+  const int64_t pad_left = inst->GetPaddingLeft();
+
+  const Shape x_strides = GetStrides(xs);
+  const Shape w_strides = GetStrides(ws);
+  const Shape r_strides = GetStrides(rs);
+  const T* data = x.GetDataPtr<T>();
+  const T* kernel = w.GetDataPtr<T>();
+  const int64_t out_per_group = out_channels / group;
+  using Acc = AccType<T>;
+  for (int64_t n = 0; n < batch; ++n) {
+    for (int64_t oc = 0; oc < out_channels; ++oc) {
+      const int64_t first_ic = oc / out_per_group * in_channels;
+      for (int64_t oy = 0; oy < out_h; ++oy) {
+        for (int64_t ox = 0; ox < out_w; ++ox) {
+          Acc sum = bias == nullptr ? Acc{0} : Acc{bias[oc]};
+          for (int64_t ic = 0; ic < in_channels; ++ic) {
+            for (int64_t ky = 0; ky < kernel_h; ++ky) {
+              const int64_t iy = oy * stride_h - pad_top + ky * dilation_h;
+              if (iy < 0 || iy >= height) {
+                continue;
+              }
+              for (int64_t kx = 0; kx < kernel_w; ++kx) {
+                const int64_t ix = ox * stride_w - pad_left + kx * dilation_w;
+                if (ix < 0 || ix >= width) {
+                  continue;
+                }
+                const Acc u =
+                    data[n * x_strides[info.batch_axis] +
+                         (first_ic + ic) * x_strides[info.data_channel_axis] +
+                         iy * x_strides[info.data_height_axis] +
+                         ix * x_strides[info.data_width_axis]];
+                const Acc v =
+                    kernel[oc * w_strides[info.kernel_output_axis] +
+                           ic * w_strides[info.kernel_input_axis] +
+                           ky * w_strides[info.kernel_height_axis] +
+                           kx * w_strides[info.kernel_width_axis]];
+                sum = Add(sum, Mul(u, v));
+              }
+            }
+          }
+          ret[n * r_strides[info.batch_axis] +
+              oc * r_strides[info.data_channel_axis] +
+              oy * r_strides[info.data_height_axis] +
+              ox * r_strides[info.data_width_axis]] =
+              Activate(static_cast<T>(sum), inst->GetActivation(),
+                       inst->GetActivationAlpha());
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template <typename T>
+static bool EvaluateSoftmax(SoftmaxInst* inst, T* ret) {
+  if constexpr (!std::is_floating_point_v<T>) {
+    return false;
+  } else {
+    const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+    const Shape& shape = x.GetResultType().GetDimSizes();
+    const int64_t axis = NormalizeAxis(inst->GetAxis(), shape.size());
+    if (axis < 0 || shape != inst->GetResultType().GetDimSizes()) {
+      return false;
+    }
+    const auto [outer, len, inner] = SplitAtAxis(shape, axis);
+    const T* data = x.GetDataPtr<T>();
+    for (int64_t i = 0; i < outer; ++i) {
+      for (int64_t k = 0; k < inner; ++k) {
+        const int64_t base = i * len * inner + k;
+        T max_v = std::numeric_limits<T>::lowest();
+        for (int64_t j = 0; j < len; ++j) {
+          max_v = std::max(max_v, data[base + j * inner]);
+        }
+        double sum = 0;
+        for (int64_t j = 0; j < len; ++j) {
+          sum += std::exp(data[base + j * inner] - max_v);
+        }
+        for (int64_t j = 0; j < len; ++j) {
+          ret[base + j * inner] =
+              static_cast<T>(std::exp(data[base + j * inner] - max_v) / sum);
+        }
+      }
+    }
+    return true;
+  }
+}
+
+template <typename T>
+static bool EvaluateTranspose(TransposeInst* inst, T* ret) {
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const Shape& shape = x.GetResultType().GetDimSizes();
+  const size_t rank = shape.size();
+  const auto& attr = inst->GetPermutation();
+  std::vector<int64_t> perm(attr.begin(), attr.end());
+  if (inst->GetNumOfOperands() > 1 &&
+      (!perm.empty() || !GetIntegers(inst->GetOperand(1), &perm))) {
+    return false;
+  }
+  if (perm.empty()) {
+    // Reverse the dimensions by default.
+    perm.resize(rank);
+    std::iota(perm.rbegin(), perm.rend(), 0);
+  }
+  std::vector<int64_t> sorted(perm);
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<int64_t> identity(rank);
+  std::iota(identity.begin(), identity.end(), 0);
+  if (sorted != identity) {
+    return false;
+  }
+  const Shape strides = GetStrides(shape);
+  Shape ret_shape(rank);
+  std::array<Shape, 1> src_strides{Shape(rank)};
+  for (size_t i = 0; i < rank; ++i) {
+    ret_shape[i] = shape[perm[i]];
+    src_strides[0][i] = strides[perm[i]];
+  }
+  if (ret_shape != inst->GetResultType().GetDimSizes()) {
+    return false;
+  }
+  const T* data = x.GetDataPtr<T>();
+  ForEachElement(ret_shape, src_strides,
+                 [data, ret](int64_t i, const auto& offsets) {
+                   ret[i] = data[offsets[0]];
+                 });
+  return true;
+}
+
+template <typename T>
+static bool EvaluateConcat(ConcatInst* inst, T* ret) {
+  const size_t num_ops = inst->GetNumOfOperands();
+  const size_t n = inst->GetN() > 0 ? inst->GetN() : num_ops;
+  int64_t axis = inst->GetAxis();
+  if (num_ops == n + 1) {
+    // The last operand is the axis.
+    std::vector<int64_t> values;
+    if (!GetIntegers(inst->GetOperand(n), &values) || values.size() != 1) {
+      return false;
+    }
+    axis = values[0];
+  } else if (num_ops != n) {
+    return false;
+  }
+  const DataType dt = inst->GetResultType().GetDataType();
+  const Shape& ret_shape = inst->GetResultType().GetDimSizes();
+  axis = NormalizeAxis(axis, ret_shape.size());
+  if (axis < 0) {
+    return false;
+  }
+  const int64_t outer = SplitAtAxis(ret_shape, axis)[0];
+  if (outer == 0) {
+    return false;
+  }
+  // The number of elements of one outer slice of the result.
+  const int64_t ret_chunk = GetNumOfElements(ret_shape) / outer;
+  int64_t offset = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const Constant& x = *DynCast<Constant>(inst->GetOperand(i));
+    const Type& type = x.GetResultType();
+    Shape shape = type.GetDimSizes();
+    if (type.GetDataType() != dt || shape.size() != ret_shape.size()) {
+      return false;
+    }
+    shape[axis] = ret_shape[axis];
+    if (shape != ret_shape) {
+      return false;
+    }
+    const int64_t chunk = type.GetTotalNumOfElements() / outer;
+    if (offset + chunk > ret_chunk) {
+      return false;
+    }
+    const T* data = x.GetDataPtr<T>();
+    for (int64_t j = 0; j < outer; ++j) {
+      std::copy_n(data + j * chunk, chunk, ret + j * ret_chunk + offset);
+    }
+    offset += chunk;
+  }
+  return offset == ret_chunk;
+}
+
+template <typename T>
+static bool EvaluateGather(GatherInst* inst, T* ret) {
+  std::vector<int64_t> indices;
+  if (inst->GetNumOfOperands() != 2 ||
+      !GetIntegers(inst->GetOperand(1), &indices)) {
+    return false;
+  }
+  const Constant& x = *DynCast<Constant>(inst->GetOperand(0));
+  const Shape& shape = x.GetResultType().GetDimSizes();
+  const int64_t axis = NormalizeAxis(inst->GetAxis(), shape.size());
+  if (axis < 0) {
+    return false;
+  }
+  const auto [outer, len, inner] = SplitAtAxis(shape, axis);
+  for (int64_t& index : indices) {
+    index = index < 0 ? index + len : index;
+    if (index < 0 || index >= len) {
+      return false;
+    }
+  }
+  const auto num_indices = static_cast<int64_t>(indices.size());
+  if (outer * num_indices * inner !=
+      inst->GetResultType().GetTotalNumOfElements()) {
+    return false;
+  }
+  const T* data = x.GetDataPtr<T>();
+  for (int64_t i = 0; i < outer; ++i) {
+    for (int64_t j = 0; j < num_indices; ++j) {
+      std::copy_n(data + (i * len + indices[j]) * inner, inner,
+                  ret + (i * num_indices + j) * inner);
+    }
+  }
+  return true;
+}
+
+// Evaluates `inst` whose first operand has elements of type T and writes the
+// result to `ret`.
+template <typename T>
+static bool EvaluateAs(Instruction* inst, void* ret) {
+  const DataType ret_dt = inst->GetResultType().GetDataType();
+  switch (inst->GetOpCode()) {
+    case OpCode::CMP: {
+      return ret_dt == DataType::BOOL &&
+             EvaluateCompare<T>(DynCast<CmpInst>(inst),
+                                static_cast<int8_t*>(ret));
+    }
+    case OpCode::ARGMAX:
+    case OpCode::ARGMIN: {
+      return ret_dt == DataType::INT32 &&
+             EvaluateArgMinMax<T>(inst, static_cast<int32_t*>(ret));
+    }
+    default: {
+      break;
+    }
+  }
+  if (ret_dt != inst->GetOperand(0).GetType().GetDataType()) {
+    return false;
+  }
+  T* out = static_cast<T*>(ret);
+  switch (inst->GetOpCode()) {
+    case OpCode::ABS:
+    case OpCode::CEIL:
+    case OpCode::ELU:
+    case OpCode::ERF:
+    case OpCode::EXP:
+    case OpCode::FLOOR:
+    case OpCode::LEAKYRELU:
+    case OpCode::NEG:
+    case OpCode::RCP:
+    case OpCode::RELU:
+    case OpCode::RELU6:
+    case OpCode::RSQRT:
+    case OpCode::SIGMOID:
+    case OpCode::SIGN:
+    case OpCode::SQRT:
+    case OpCode::TANH: {
+      return EvaluateUnary(inst, out);
+    }
+    case OpCode::ADD:
+    case OpCode::AND:
+    case OpCode::DIV:
+    case OpCode::MAXIMUM:
+    case OpCode::MINIMUM:
+    case OpCode::MUL:
+    case OpCode::OR:
+    case OpCode::POW:
+    case OpCode::SHIFTL:
+    case OpCode::SHIFTR:
+    case OpCode::SUB: {
+      return EvaluateBinary(inst, out);
+    }
+    case OpCode::REDUCEMAX:
+    case OpCode::REDUCEMEAN:
+    case OpCode::REDUCEMIN:
+    case OpCode::REDUCEPRODUCT:
+    case OpCode::REDUCESUM: {
+      return EvaluateReduction(inst, out);
+    }
+    case OpCode::MATMUL:
+    case OpCode::BATCHMATMUL: {
+      return EvaluateMatMul(inst, out);
+    }
+    case OpCode::GEMM: {
+      return EvaluateGemm(DynCast<GemmInst>(inst), out);
+    }
+    case OpCode::CONV2D: {
+      return EvaluateConv2D(DynCast<Conv2DInst>(inst), out);
+    }
+    case OpCode::SOFTMAX: {
+      return EvaluateSoftmax(DynCast<SoftmaxInst>(inst), out);
+    }
+    case OpCode::TRANSPOSE: {
+      return EvaluateTranspose(DynCast<TransposeInst>(inst), out);
+    }
+    case OpCode::CONCAT: {
+      return EvaluateConcat(DynCast<ConcatInst>(inst), out);
+    }
+    case OpCode::GATHER: {
+      return EvaluateGather(DynCast<GatherInst>(inst), out);
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+Constant* ConstantEvaluator::Evaluate(Instruction* inst) const {
+  if (inst->GetNumOfResults() != 1 || inst->GetNumOfOperands() == 0) {
+    return nullptr;
+  }
+  for (const auto& op : inst->GetOperands()) {
+    if (op.IsNull() || !IsA<Constant>(op) || !op.GetType().IsValid()) {
+      return nullptr;
+    }
+  }
+  const Type& ret_type = inst->GetResultType();
+  if (!ret_type.IsValid() || ret_type.GetTotalNumOfElements() <= 0) {
+    return nullptr;
+  }
+  const DataLayout& data_layout =
+      inst->GetGlobalContext().GetDefaultDataLayout();
+  const auto bytes = static_cast<int64_t>(data_layout.Bytes(ret_type));
+  if (bytes > max_bytes_) {
+    return nullptr;
+  }
+  std::vector<unsigned char> buf(bytes);
+  const DataType dt = inst->GetOperand(0).GetType().GetDataType();
+  bool done = VisitNativeType(dt, [inst, &buf](auto tag) {
+    return EvaluateAs<decltype(tag)>(inst, buf.data());
+  });
+  if (!done) {
+    return nullptr;
+  }
+  ConstantBuilder cb(inst->GetParent()->GetParent());
+  return cb.CreateConstant(inst->GetName() + "_folding", ret_type, buf.data());
+}
+
+} // end namespace halo
@@ -23,23 +23,8 @@
 
 namespace halo {
 
-bool DCE::RunOnBasicBlock(BasicBlock* bb) {
+bool DCE::Finalize(BasicBlock* bb) {
   bool changed = false;
-  for (BasicBlock::reverse_iterator it = bb->rbegin(), e = bb->rend();
-       it != e;) {
-    Instruction* inst = it->get();
-    if (inst->GetOpCode() == OpCode::RETURN || inst->GetNumberOfUses() != 0) {
-      ++it;
-      continue;
-    }
-    changed = true;
-    auto nit = std::next(it);
-    // Delete the instruction.
-    inst->DropAllOperands();
-    bb->Instructions().erase(nit.base());
-    it = nit;
-  }
-
   auto remove = [](auto& objs) {
     bool changed = false;
     for (auto it = objs.begin(), ie = objs.end(); it != ie;) {
@@ -17,11 +17,14 @@
 
 #include "halo/lib/transforms/fusion.h"
 
+#include <cmath>
+
 #include "halo/api/halo_data.h"
 #include "halo/lib/framework/common.h"
 #include "halo/lib/framework/data_layout.h"
 #include "halo/lib/framework/global_context.h"
 #include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/transforms/type_legalizer.h"
 
 namespace halo {
 
@@ -30,6 +33,112 @@ static bool ValidateOpSizeAndCode(const Instruction* inst, size_t op_num,
   return inst->GetNumOfOperands() == op_num && inst->GetOpCode() == op;
 }
 
+static bool HasNoActivation(const Def& def) {
+  if (!IsA<Instruction>(def)) {
+    return true;
+  }
+  const Instruction* inst = DynCast<Instruction>(def);
+  if (inst->GetOpCode() == OpCode::CONV2D) {
+    return static_cast<const Conv2DInst*>(inst)->GetActivation() ==
+           ActivationType::NONE;
+  }
+  if (inst->GetOpCode() == OpCode::GEMM) {
+    return static_cast<const GemmInst*>(inst)->GetActivation() ==
+           ActivationType::NONE;
+  }
+  return true;
+}
+
+// Returns the constant float data of `def` if it has `n` elements.
+static const float* GetConstantData(const Def& def, int64_t n) {
+  if (!IsA<Constant>(def) ||
+      def.GetType().GetDataType() != DataType::FLOAT32 ||
+      def.GetType().GetTotalNumOfElements() != n) {
+    return nullptr;
+  }
+  return DynCast<Constant>(def)->GetDataPtr<float>();
+}
+
+// Folds y = scale * (conv(x, w) + b - mean) / sqrt(var + epsilon) + offset
+// into conv(x, w') + b', where w' = w * s, b' = (b - mean) * s + offset and
+// s = scale / sqrt(var + epsilon) per output channel. The operands are the
+// input, the kernel, the optional bias and the operands of batch norm.
+static Conv2DInst* FoldBatchNormIntoConv(IRBuilder* builder, Instruction* inst,
+                                         const std::vector<Def>& operands) {
+  const BatchNormInst* bn = DynCast<BatchNormInst>(inst);
+  const Conv2DInst* conv = DynCast<Conv2DInst>(inst->GetOperand(0).GetOwner());
+  const Type& out_type = conv->GetResultType();
+  if (bn->GetPreScalingFactor() != 1.0F || !out_type.IsValid() ||
+      out_type.GetNumOfDims() != 4) {
+    return nullptr;
+  }
+  const auto& info = ImageAxisInfo::GetImageAxisInfo(conv->GetDataFormat(),
+                                                     conv->GetFilterFormat());
+  if (info.data_channel_axis < 0 || info.kernel_output_axis < 0) {
+    return nullptr;
+  }
+  // The batch norm must normalize the output channels of the convolution.
+  if (bn->GetDataFormat() != conv->GetDataFormat()) {
+    return nullptr;
+  }
+  int64_t oc = out_type.GetNumOfElementsInDim(info.data_channel_axis);
+
+  // Each kernel element belongs to output channel (index / inner) % oc.
+  const Def& kernel = operands[1];
+  const Type& kernel_type = kernel.GetType();
+  const float* w = GetConstantData(kernel, kernel_type.GetTotalNumOfElements());
+  if (w == nullptr || kernel_type.GetNumOfDims() != 4) {
+    return nullptr;
+  }
+  int64_t inner = 1;
+  for (size_t i = info.kernel_output_axis + 1; i < 4; ++i) {
+    inner *= kernel_type.GetNumOfElementsInDim(i);
+  }
+  if (kernel_type.GetNumOfElementsInDim(info.kernel_output_axis) != oc) {
+    // Depthwise HWCN kernels keep (channel, multiplier) innermost.
+    if (conv->GetFilterFormat() != DataFormat::HWCN ||
+        kernel_type.GetNumOfElementsInDim(2) *
+                kernel_type.GetNumOfElementsInDim(3) !=
+            oc) {
+      return nullptr;
+    }
+    inner = 1;
+  }
+
+  bool has_bias = operands.size() == 7;
+  const float* bias = has_bias ? GetConstantData(operands[2], oc) : nullptr;
+  size_t bn_idx = has_bias ? 3 : 2;
+  const float* scale = GetConstantData(operands[bn_idx], oc);
+  const float* offset = GetConstantData(operands[bn_idx + 1], oc);
+  const float* mean = GetConstantData(operands[bn_idx + 2], oc);
+  const float* var = GetConstantData(operands[bn_idx + 3], oc);
+  if ((has_bias && bias == nullptr) || scale == nullptr || offset == nullptr ||
+      mean == nullptr || var == nullptr) {
+    return nullptr;
+  }
+
+  std::vector<float> s(oc);
+  std::vector<float> new_bias(oc);
+  for (int64_t c = 0; c < oc; ++c) {
+    s[c] = scale[c] / std::sqrt(var[c] + bn->GetEpsilon());
+    new_bias[c] = ((has_bias ? bias[c] : 0) - mean[c]) * s[c] + offset[c];
+  }
+  std::vector<float> new_w(kernel_type.GetTotalNumOfElements());
+  for (size_t i = 0, e = new_w.size(); i < e; ++i) {
+    new_w[i] = w[i] * s[i / inner % oc];
+  }
+
+  ConstantBuilder cb(inst->GetParent()->GetParent());
+  Constant* c_w = cb.CreateConstant(inst->GetName() + "_folded_kernel",
+                                    kernel_type, new_w);
+  Constant* c_b = cb.CreateConstant(
+      inst->GetName() + "_folded_bias",
+      has_bias ? operands[2].GetType() : Type{DataType::FLOAT32, {oc}},
+      new_bias);
+  return builder->CreateConv2D(inst->GetName() + "_fused",
+                               {operands[0], *c_w, *c_b});
+}
+
 #define HALO_FUSION_MATCHERS
 #include "halo/lib/ir/fusion.cc.inc"
 #undef HALO_FUSION_MATCHERS
@@ -77,7 +77,7 @@ bool InputLegalizer::RunOnFunction(Function* func) {
     if (!ty.IsDynamicBatch()) {
       continue;
     }
-    auto dims = ty.GetDimSizes();
+    std::vector<int64_t> dims = ty.GetDimSizes();
     if (!dims.empty() && (dims[0] < 0) && (dims[0] != batch_size_)) {
       dims[0] = batch_size_;
       arg->GetResultsTypes()[0] = halo::Type(ty.GetDataType(), dims);
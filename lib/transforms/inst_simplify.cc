@@ -241,7 +241,7 @@ static std::pair<Def, Def> RunOnMathBinaryInstruction(
 
       Instruction* new_op1 = nullptr;
       if (op1_type.GetNumOfDims() == 1) {
-        auto dims = op0_type.GetDimSizes();
+        std::vector<int64_t> dims = op0_type.GetDimSizes();
         for (auto& d : dims) {
           d = 1;
         }
@@ -1092,7 +1092,7 @@ std::pair<Def, Def> InstSimplify::RunOnInstruction(TransposeInst* inst) {
     Argument* arg = DynCast<Argument>(input);
     const auto& orig_dims = input.GetType().GetDimSizes();
     const auto& perms = inst->GetPermutation();
-    auto new_dims = orig_dims;
+    std::vector<int64_t> new_dims = orig_dims;
     for (int i = 0, e = orig_dims.size(); i < e; ++i) {
       new_dims[i] = orig_dims[perms[i]];
     }
@@ -1423,35 +1423,38 @@ std::pair<Def, Def> InstSimplify::RunOnInstruction(OneHotInst* inst) {
   return {orig_def, orig_def};
 }
 
-bool InstSimplify::RunOnBasicBlock(BasicBlock* bb) {
-  bool changed = false;
-  for (auto& inst_t : *bb) {
-    Instruction* inst = inst_t.get();
-    if (inst->GetNumberOfUses() == 0) {
-      if (inst->GetOpCode() == OpCode::RETURN) {
-        RunOnInstruction(DynCast<ReturnInst>(inst));
-      }
-      continue;
+bool InstSimplify::Visit(Instruction* inst) {
+  if (inst->GetNumberOfUses() == 0) {
+    if (inst->GetOpCode() == OpCode::RETURN) {
+      RunOnInstruction(DynCast<ReturnInst>(inst));
     }
-    std::pair<Def, Def> ret{Def{inst, 0}, Def{inst, 0}};
-    switch (inst->GetOpCode()) {
+    return false;
+  }
+  std::pair<Def, Def> ret{Def{inst, 0}, Def{inst, 0}};
+  switch (inst->GetOpCode()) {
 #define GET_INST_DOWNCAST_SWITCH_WITH_RETURN
 #include "halo/lib/ir/instructions_info.def"
 #undef GET_INST_DOWNCAST_SWITCH_WITH_RETURN
-      default: {
-        // skip extension instruction.
-        continue;
-      }
+    default: {
+      // skip extension instruction.
+      return false;
     }
-    if (ret.first != ret.second) {
-      changed |= true;
-      if (ret.second.GetOwner() != nullptr) {
-        // Replace all uses
-        inst->ReplaceAllUsesWith(ret.first.GetIdx(), ret.second);
-      }
+  }
+  if (ret.first == ret.second) {
+    // Fall back to evaluating the instruction if all operands are constants.
+    Constant* c = evaluator_.Evaluate(inst);
+    if (c == nullptr) {
+      return false;
     }
+    ret.second = *c;
+  }
+  if (ret.second.GetOwner() != nullptr) {
+    // Replace all uses and revisit the affected instructions.
+    ReplaceAllUsesWith(inst, ret.first.GetIdx(), ret.second);
+  } else {
+    AddToWorklist(inst);
   }
-  return changed;
+  return true;
 }
 
 } // end namespace halo
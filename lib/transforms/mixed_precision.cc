@@ -0,0 +1,323 @@
+//===- mixed_precision.cc -------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "halo/lib/transforms/mixed_precision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "halo/lib/ir/ir_builder.h"
+
+namespace halo {
+
+// The largest finite FLOAT16 value.
+static constexpr float kFP16Max = 65504.0F;
+
+uint16_t MixedPrecision::FloatToBF16(float x) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &x, sizeof(bits));
+  if (std::isnan(x)) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40); // Quiet NaN.
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+uint16_t MixedPrecision::FloatToFP16(float x) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t exp = (bits >> 23) & 0xff;
+  uint32_t mant = bits & 0x7fffff;
+  if (exp == 0xff) {
+    return static_cast<uint16_t>(sign | 0x7c00 | (mant != 0 ? 0x200 : 0));
+  }
+  int e = static_cast<int>(exp) - 127 + 15;
+  if (e >= 31) {
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+  // Rounds `v` right shifted by `shift` bits to nearest even.
+  auto round_shift = [](uint32_t v, int shift) {
+    uint32_t ret = v >> shift;
+    uint32_t rem = v & ((1U << shift) - 1);
+    uint32_t half = 1U << (shift - 1);
+    return ret + ((rem > half || (rem == half && (ret & 1) != 0)) ? 1 : 0);
+  };
+  if (e <= 0) {
+    // Subnormal, in units of 2^-24.
+    if (e < -10) {
+      return static_cast<uint16_t>(sign);
+    }
+    return static_cast<uint16_t>(sign | round_shift(mant | 0x800000, 14 - e));
+  }
+  // A carry out of the mantissa correctly rounds up the exponent.
+  return static_cast<uint16_t>(
+      sign | round_shift((static_cast<uint32_t>(e) << 23) | mant, 13));
+}
+
+namespace {
+
+struct Range {
+  float lo = -std::numeric_limits<float>::infinity();
+  float hi = std::numeric_limits<float>::infinity();
+  bool known = false;
+  float GetMaxAbs() const { return std::max(std::abs(lo), std::abs(hi)); }
+};
+
+} // end anonymous namespace
+
+// Returns the value id of `def` in the generated code.
+static std::string GetValueId(const Def& def) {
+  std::string id = def.GetOwner()->GetName();
+  std::replace_if(
+      id.begin(), id.end(),
+      [](char c) { return c == '/' || c == ' ' || c == '.' || c == '-'; },
+      '_');
+  return id;
+}
+
+static Range GetConstantRange(const Constant& c) {
+  Range r;
+  const float* data = c.GetDataPtr<float>();
+  int64_t n = c.GetResultType().GetTotalNumOfElements();
+  if (n <= 0) {
+    return r;
+  }
+  auto minmax = std::minmax_element(data, data + n);
+  r.lo = *minmax.first;
+  r.hi = *minmax.second;
+  r.known = true;
+  return r;
+}
+
+// Derives the range of the result of `inst` from the ranges of its operands.
+static Range PropagateRange(const Instruction& inst,
+                            const std::vector<Range>& ops) {
+  Range r;
+  auto all_known = [&ops]() {
+    return !ops.empty() && std::all_of(ops.begin(), ops.end(),
+                                       [](const Range& o) { return o.known; });
+  };
+  switch (inst.GetOpCode()) {
+    case OpCode::SIGMOID:
+    case OpCode::SOFTMAX: {
+      return Range{0, 1, true};
+    }
+    case OpCode::TANH: {
+      return Range{-1, 1, true};
+    }
+    case OpCode::RELU: {
+      if (ops[0].known) {
+        r = Range{std::max(0.0F, ops[0].lo), std::max(0.0F, ops[0].hi), true};
+      }
+      break;
+    }
+    case OpCode::RESHAPE:
+    case OpCode::TRANSPOSE:
+    case OpCode::POOLINGMAX:
+    case OpCode::POOLINGAVG:
+    case OpCode::FPTOFP: {
+      r = ops[0];
+      break;
+    }
+    case OpCode::CONCAT: {
+      if (all_known()) {
+        r = ops[0];
+        for (const Range& o : ops) {
+          r.lo = std::min(r.lo, o.lo);
+          r.hi = std::max(r.hi, o.hi);
+        }
+      }
+      break;
+    }
+    case OpCode::ADD: {
+      if (ops.size() == 2 && all_known()) {
+        r = Range{ops[0].lo + ops[1].lo, ops[0].hi + ops[1].hi, true};
+      }
+      break;
+    }
+    case OpCode::MUL: {
+      if (ops.size() == 2 && all_known()) {
+        float p[] = {ops[0].lo * ops[1].lo, ops[0].lo * ops[1].hi,
+                     ops[0].hi * ops[1].lo, ops[0].hi * ops[1].hi};
+        auto minmax = std::minmax_element(std::begin(p), std::end(p));
+        r = Range{*minmax.first, *minmax.second, true};
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+  return r;
+}
+
+bool MixedPrecision::RunOnBasicBlock(BasicBlock* bb) {
+  const DataType low_dt = opts_.data_type;
+  HLCHECK(low_dt == DataType::BFLOAT16 || low_dt == DataType::FLOAT16);
+  const std::string suffix = low_dt == DataType::BFLOAT16 ? "_bf16" : "_fp16";
+  bool changed = false;
+  IRBuilder builder(bb);
+  ConstantBuilder cb(bb->GetParent());
+
+  std::unordered_map<Def, Range> ranges;
+  // The low precision version of FLOAT32 values and constants.
+  std::unordered_map<Def, Def> low_values;
+  // The FLOAT32 version of converted values.
+  std::unordered_map<Def, Def> fp32_values;
+  std::unordered_set<const IRObject*> converted;
+
+  auto get_range = [&](const Def& def) {
+    if (auto it = ranges.find(def); it != ranges.end()) {
+      return it->second;
+    }
+    Range r;
+    if (auto it = opts_.ranges.find(GetValueId(def));
+        def.GetIdx() == 0 && it != opts_.ranges.end()) {
+      r = Range{it->second.first, it->second.second, true};
+    } else if (IsA<Constant>(def) &&
+               def.GetType().GetDataType() == DataType::FLOAT32) {
+      r = GetConstantRange(*DynCast<Constant>(def));
+    }
+    ranges[def] = r;
+    return r;
+  };
+
+  auto get_low_value = [&](const Def& def, Instruction* user) {
+    if (auto it = low_values.find(def); it != low_values.end()) {
+      return it->second;
+    }
+    const std::string name = def.GetOwner()->GetName() + suffix;
+    halo::Type type{low_dt, def.GetType().GetDimSizes()};
+    Def low = def;
+    if (IsA<Constant>(def)) {
+      // Constants are converted at compile time.
+      const Constant* c = DynCast<Constant>(def);
+      const float* data = c->GetDataPtr<float>();
+      std::vector<uint16_t> bits(def.GetType().GetTotalNumOfElements());
+      std::transform(data, data + bits.size(), bits.begin(),
+                     low_dt == DataType::BFLOAT16 ? FloatToBF16 : FloatToFP16);
+      low = *cb.CreateConstant(name, type, bits.data());
+    } else {
+      builder.SetInsertBefore(user);
+      FPtoFPInst* cast = builder.CreateFPtoFP(name, def);
+      cast->SetDataType(low_dt);
+      cast->GetResultsTypes()[0] = type;
+      low = *cast;
+    }
+    low_values.emplace(def, low);
+    return low;
+  };
+
+  auto get_fp32_value = [&](const Def& def) {
+    if (auto it = fp32_values.find(def); it != fp32_values.end()) {
+      return it->second;
+    }
+    builder.SetInsertAfter(DynCast<Instruction>(def.GetOwner()));
+    FPtoFPInst* cast =
+        builder.CreateFPtoFP(def.GetOwner()->GetName() + "_fp32", def);
+    cast->SetDataType(DataType::FLOAT32);
+    cast->GetResultsTypes()[0] =
+        halo::Type{DataType::FLOAT32, def.GetType().GetDimSizes()};
+    fp32_values.emplace(def, *cast);
+    return Def{cast, 0};
+  };
+
+  auto is_low = [&converted, low_dt](const Def& def) {
+    return def.GetType().GetDataType() == low_dt &&
+           converted.count(def.GetOwner()) != 0;
+  };
+
+  // Returns true if `inst` should be computed in the low precision.
+  auto should_convert = [&](Instruction* inst) {
+    OpCode op = inst->GetOpCode();
+    bool allowed = opts_.allow_list.count(op) != 0;
+    if (opts_.deny_list.count(op) != 0 ||
+        opts_.keep_fp32.count(inst->GetName()) != 0 ||
+        (!allowed && opts_.follow_list.count(op) == 0) ||
+        inst->GetNumOfResults() != 1 ||
+        inst->GetResultType().GetDataType() != DataType::FLOAT32) {
+      return false;
+    }
+    bool has_low_operand = false;
+    for (size_t i = 0, e = inst->GetNumOfOperands(); i < e; ++i) {
+      const Def& op = inst->GetOperand(i);
+      DataType dt = op.GetType().GetDataType();
+      if (is_low(op)) {
+        has_low_operand = true;
+      } else if (Type::IsFloatingPointType(dt) && dt != DataType::FLOAT32) {
+        return false;
+      } else if (dt == DataType::FLOAT32 && low_dt == DataType::FLOAT16 &&
+                 get_range(op).known && get_range(op).GetMaxAbs() > kFP16Max) {
+        return false;
+      }
+    }
+    if (!allowed && !has_low_operand) {
+      return false;
+    }
+    // BFLOAT16 has the exponent range of FLOAT32, FLOAT16 does not.
+    const Range& r = get_range(Def{inst, 0});
+    return low_dt != DataType::FLOAT16 || !r.known || r.GetMaxAbs() <= kFP16Max;
+  };
+
+  std::vector<Instruction*> insts;
+  insts.reserve(bb->Instructions().size());
+  for (auto& it : *bb) {
+    insts.push_back(it.get());
+  }
+
+  for (Instruction* inst : insts) {
+    const size_t num_ops = inst->GetNumOfOperands();
+    std::vector<Range> op_ranges;
+    op_ranges.reserve(num_ops);
+    for (size_t i = 0; i < num_ops; ++i) {
+      op_ranges.push_back(get_range(inst->GetOperand(i)));
+    }
+    Def result{inst, 0};
+    if (!ranges.count(result) && inst->GetNumOfResults() > 0) {
+      Range r = get_range(result);
+      ranges[result] = r.known ? r : PropagateRange(*inst, op_ranges);
+    }
+
+    if (should_convert(inst)) {
+      for (size_t i = 0; i < num_ops; ++i) {
+        const Def& op = inst->GetOperand(i);
+        if (op.GetType().GetDataType() == DataType::FLOAT32) {
+          inst->ReplaceOperandWith(i, get_low_value(op, inst));
+        }
+      }
+      inst->GetResultsTypes()[0] =
+          halo::Type{low_dt, inst->GetResultType().GetDimSizes()};
+      converted.insert(inst);
+      changed = true;
+      continue;
+    }
+    // Converted values are cast back where they flow into FLOAT32 code.
+    for (size_t i = 0; i < num_ops; ++i) {
+      const Def& op = inst->GetOperand(i);
+      if (is_low(op)) {
+        inst->ReplaceOperandWith(i, get_fp32_value(op));
+      }
+    }
+  }
+  return changed;
+}
+
+} // end namespace halo
@@ -113,7 +113,7 @@ static std::vector<Def> ConvertNonZero(const ONNXExtensionInst* ext,
   }
   int64_t len = non_zero_indices.size();
   std::vector<int64_t> data(rank * len);
-  auto extends = in_type.GetDimSizes();
+  std::vector<int64_t> extends = in_type.GetDimSizes();
   int64_t product = 1;
   for (auto it = extends.rbegin(), e = extends.rend(); it != e; ++it) {
     auto t = *it;
@@ -170,7 +170,7 @@ static bool Reorder(T* inst, bool target_is_ch_first) {
     if (auto type = inst->GetResultType(); type.IsValid()) {
       // permute the result shape
       const auto& dims = type.GetDimSizes();
-      auto new_dims = dims;
+      std::vector<int64_t> new_dims = dims;
       for (size_t i = 0, e = dims.size(); i < e; ++i) {
         new_dims[i] = dims[perm[i]];
       }
@@ -558,7 +558,7 @@ static std::vector<Def> ConvertSpace2Batch(const TFExtensionInst* tf_inst,
 
   if (!ignore_padding) {
     std::vector<int32_t> padding_amt(2 * input_dims);
-    auto result_dims = input_type.GetDimSizes();
+    std::vector<int64_t> result_dims = input_type.GetDimSizes();
     for (unsigned k = 1; k <= space_n; ++k) {
       padding_amt[k * 2] = padding_vals[(k - 1) * 2];
       padding_amt[k * 2 + 1] = padding_vals[(k - 1) * 2 + 1];
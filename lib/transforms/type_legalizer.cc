@@ -152,6 +152,11 @@ static void RunOnCastInstruction(Instruction* inst, DataType dst_dt) {
   inst->GetResultsTypes()[0] = new_type;
 }
 
+// INT8 convolutions and matrix multiplications accumulate into INT32.
+static DataType GetAccumulatorType(DataType dt) {
+  return dt == DataType::INT8 ? DataType::INT32 : dt;
+}
+
 static void RunOnInstruction(Instruction* inst) {
   switch (inst->GetOpCode()) {
     case OpCode::ADD:
@@ -188,6 +193,18 @@ static void RunOnInstruction(SItoFPInst* inst) {
   RunOnCastInstruction(inst, inst->GetDataType());
 }
 
+static void RunOnInstruction(FPtoFPInst* inst) {
+  RunOnCastInstruction(inst, inst->GetDataType());
+}
+
+static void RunOnInstruction(QuantizeInst* inst) {
+  RunOnCastInstruction(inst, inst->GetDataType());
+}
+
+static void RunOnInstruction(DequantizeInst* inst) {
+  RunOnCastInstruction(inst, DataType::FLOAT32);
+}
+
 static void RunOnInstruction(ReshapeInst* inst) {
   auto& op0_type = inst->GetOperand(0).GetType();
   Def op1 = inst->GetOperand(1);
@@ -283,7 +300,7 @@ static Type ComputeKernelWiseType(
   const auto& info =
       ImageAxisInfo::GetImageAxisInfo(data_format, kernel_format);
   auto& data_shape = data_type.GetDimSizes();
-  auto ret_shape = data_shape;
+  std::vector<int64_t> ret_shape = data_shape;
 
   int kernel_h = kernel_shape[info.kernel_height_axis];
   int kernel_w = kernel_shape[info.kernel_width_axis];
@@ -382,7 +399,8 @@ static void RunOnInstruction(Conv2DInst* inst) {
       inst->GetPadding(), &explicit_paddings, inst->GetDilations(),
       inst->GetDataFormat(), inst->GetFilterFormat(), inst->GetGroup(),
       inst->GetOpCode());
-  inst->GetResultsTypes()[0] = ret_type;
+  inst->GetResultsTypes()[0] =
+      Type{GetAccumulatorType(data_type.GetDataType()), ret_type.GetDimSizes()};
   if (inst->GetPadding() != Padding::EXPLICIT) {
     inst->SetPaddingTop(explicit_paddings[0]);
     inst->SetPaddingBottom(explicit_paddings[1]);
@@ -564,7 +582,8 @@ static void RunOnMatrixMultiplyInstruction(Instruction* inst, bool trans_a,
   ret_shape.pop_back();
   ret_shape.push_back(row);
   ret_shape.push_back(col);
-  inst->GetResultsTypes()[0] = halo::Type{input_type.GetDataType(), ret_shape};
+  inst->GetResultsTypes()[0] =
+      halo::Type{GetAccumulatorType(input_type.GetDataType()), ret_shape};
 }
 
 static void RunOnInstruction(GemmInst* inst) {
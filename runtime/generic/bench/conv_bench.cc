@@ -0,0 +1,175 @@
+//===- conv_bench.cc ------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Compares the convolution engine with fused bias and relu against the
+// reference direct loop at ResNet-50 layer shapes, plus grouped, depthwise and
+// dilated cases.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+extern "C" {
+void _sn_rt_conv2d_f32_helper(
+    float* output, const float* data, const float* kernel, int64_t batch,
+    int64_t spatial_h, int64_t spatial_w, int64_t channel, int64_t output_h,
+    int64_t output_w, int64_t output_channel, int64_t kernel_h,
+    int64_t kernel_w, int64_t stride_h, int64_t stride_w, int64_t pad_top,
+    int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    int64_t dilation_h, int64_t dilation_w, int64_t group, bool is_nchw,
+    const float* bias, int64_t activation, float activation_alpha);
+}
+
+struct Shape {
+  const char* name;
+  int64_t h;
+  int64_t w;
+  int64_t c;
+  int64_t oc;
+  int64_t k;
+  int64_t stride;
+  int64_t pad;
+  int64_t dilation;
+  int64_t group;
+};
+
+// Computes relu(conv(in, kernel) + bias).
+static void RefConv(float* out, const float* in, const float* kernel,
+                    const float* bias, const Shape& s, int64_t oh, int64_t ow,
+                    bool nchw) {
+  int64_t cg = s.c / s.group;
+  int64_t og = s.oc / s.group;
+  for (int64_t o = 0; o < s.oc; ++o) {
+    int64_t g = o / og;
+    for (int64_t y = 0; y < oh; ++y) {
+      for (int64_t x = 0; x < ow; ++x) {
+        float sum = bias[o];
+        for (int64_t m = 0; m < s.k; ++m) {
+          for (int64_t n = 0; n < s.k; ++n) {
+            for (int64_t c = 0; c < cg; ++c) {
+              int64_t h = y * s.stride - s.pad + m * s.dilation;
+              int64_t w = x * s.stride - s.pad + n * s.dilation;
+              if (h < 0 || h >= s.h || w < 0 || w >= s.w) {
+                continue;
+              }
+              int64_t ic = g * cg + c;
+              float a = nchw ? in[(ic * s.h + h) * s.w + w]
+                             : in[(h * s.w + w) * s.c + ic];
+              float b = nchw ? kernel[((o * cg + c) * s.k + m) * s.k + n]
+                             : kernel[((m * s.k + n) * cg + c) * s.oc + o];
+              sum += a * b;
+            }
+          }
+        }
+        sum = std::max(sum, 0.0F);
+        if (nchw) {
+          out[(o * oh + y) * ow + x] = sum;
+        } else {
+          out[(y * ow + x) * s.oc + o] = sum;
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+static double TimeIt(int iters, T func) {
+  func(); // warm up
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; ++i) {
+    func();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+static bool Run(const Shape& s, bool nchw) {
+  int64_t ek = (s.k - 1) * s.dilation + 1;
+  int64_t oh = (s.h + 2 * s.pad - ek) / s.stride + 1;
+  int64_t ow = (s.w + 2 * s.pad - ek) / s.stride + 1;
+  std::mt19937 gen(s.h * s.c + s.oc);
+  std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+  std::vector<float> in(s.h * s.w * s.c);
+  std::vector<float> kernel(s.k * s.k * s.c / s.group * s.oc);
+  for (auto& x : in) {
+    x = dist(gen);
+  }
+  for (auto& x : kernel) {
+    x = dist(gen);
+  }
+  std::vector<float> bias(s.oc);
+  for (auto& x : bias) {
+    x = dist(gen);
+  }
+  std::vector<float> ref(oh * ow * s.oc);
+  std::vector<float> out(oh * ow * s.oc);
+
+  int64_t macs = oh * ow * s.oc * s.k * s.k * s.c / s.group;
+  int iters = macs > (1LL << 28) ? 1 : 3;
+  double t_ref = TimeIt(iters, [&]() {
+    RefConv(ref.data(), in.data(), kernel.data(), bias.data(), s, oh, ow, nchw);
+  });
+  constexpr int64_t relu = 1;
+  double t_new = TimeIt(iters, [&]() {
+    _sn_rt_conv2d_f32_helper(out.data(), in.data(), kernel.data(), 1, s.h, s.w,
+                             s.c, oh, ow, s.oc, s.k, s.k, s.stride, s.stride,
+                             s.pad, s.pad, s.pad, s.pad, s.dilation,
+                             s.dilation, s.group, nchw, bias.data(), relu, 0);
+  });
+
+  float max_err = 0;
+  for (size_t i = 0; i < ref.size(); ++i) {
+    max_err = std::max(max_err, std::abs(ref[i] - out[i]));
+  }
+  int64_t reduce = s.k * s.k * s.c / s.group;
+  bool ok = max_err <= 1e-4F * reduce;
+  std::cout << s.name << (nchw ? " NCHW" : " NHWC") << ": ref " << t_ref
+            << " ms, engine " << t_new << " ms (" << t_ref / t_new
+            << "x), max err " << max_err << (ok ? "" : " MISMATCH") << "\n";
+  return ok;
+}
+
+int main() {
+  const std::vector<Shape> shapes{
+      // name, h, w, c, oc, k, stride, pad, dilation, group
+      {"conv1 7x7/2", 224, 224, 3, 64, 7, 2, 3, 1, 1},
+      {"res2 1x1", 56, 56, 64, 64, 1, 1, 0, 1, 1},
+      {"res2 3x3", 56, 56, 64, 64, 3, 1, 1, 1, 1},
+      {"res2 1x1 expand", 56, 56, 64, 256, 1, 1, 0, 1, 1},
+      {"res3 3x3/2", 56, 56, 128, 128, 3, 2, 1, 1, 1},
+      {"res3 3x3", 28, 28, 128, 128, 3, 1, 1, 1, 1},
+      {"res4 3x3", 14, 14, 256, 256, 3, 1, 1, 1, 1},
+      {"res4 1x1 reduce", 14, 14, 1024, 256, 1, 1, 0, 1, 1},
+      {"res5 3x3", 7, 7, 512, 512, 3, 1, 1, 1, 1},
+      {"grouped 3x3", 28, 28, 128, 128, 3, 1, 1, 1, 32},
+      {"depthwise 3x3", 56, 56, 128, 128, 3, 1, 1, 1, 128},
+      {"depthwise 3x3/2", 56, 56, 128, 128, 3, 2, 1, 1, 128},
+      {"dilated 3x3", 28, 28, 64, 64, 3, 1, 2, 2, 1},
+      {"odd 5x5", 17, 23, 12, 20, 5, 1, 2, 1, 1},
+  };
+  bool ok = true;
+  for (const auto& s : shapes) {
+    ok &= Run(s, true);
+    ok &= Run(s, false);
+  }
+  return ok ? 0 : 1;
+}
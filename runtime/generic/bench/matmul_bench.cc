@@ -0,0 +1,128 @@
+//===- matmul_bench.cc ----------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Compares _sn_rt_matmul_f32 against the reference triple loop at BERT and
+// fully connected layer shapes.
+
+#include <stdint.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+extern "C" {
+void _sn_rt_matmul_f32(float* C, const float* A, const float* B, int64_t A_row,
+                       int64_t A_col, int64_t B_row, int64_t B_col,
+                       bool transposeA, bool transposeB);
+}
+
+static void RefMatmul(float* C, const float* A, const float* B, int64_t A_row,
+                      int64_t A_col, int64_t B_row, int64_t B_col,
+                      bool transposeA, bool transposeB) {
+  int64_t M = transposeA ? A_col : A_row;
+  int64_t K = transposeA ? A_row : A_col;
+  int64_t N = transposeB ? B_row : B_col;
+  for (int64_t i = 0; i < M; ++i) {
+    for (int64_t j = 0; j < N; ++j) {
+      float sum = 0;
+      for (int64_t k = 0; k < K; ++k) {
+        float a = transposeA ? A[k * A_col + i] : A[i * A_col + k];
+        float b = transposeB ? B[j * B_col + k] : B[k * B_col + j];
+        sum += a * b;
+      }
+      C[i * N + j] = sum;
+    }
+  }
+}
+
+template <typename T>
+static double TimeIt(int iters, T func) {
+  func(); // warm up
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; ++i) {
+    func();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+static bool Run(int64_t M, int64_t N, int64_t K, bool ta, bool tb) {
+  std::mt19937 gen(M * N + K);
+  std::uniform_real_distribution<float> dist(-1.0F, 1.0F);
+  std::vector<float> a(M * K);
+  std::vector<float> b(K * N);
+  for (auto& x : a) {
+    x = dist(gen);
+  }
+  for (auto& x : b) {
+    x = dist(gen);
+  }
+  std::vector<float> ref(M * N);
+  std::vector<float> out(M * N);
+  int64_t a_row = ta ? K : M;
+  int64_t a_col = ta ? M : K;
+  int64_t b_row = tb ? N : K;
+  int64_t b_col = tb ? K : N;
+
+  int iters = M * N * K > (1LL << 28) ? 1 : 5;
+  double t_ref = TimeIt(iters, [&]() {
+    RefMatmul(ref.data(), a.data(), b.data(), a_row, a_col, b_row, b_col, ta,
+              tb);
+  });
+  double t_new = TimeIt(iters, [&]() {
+    _sn_rt_matmul_f32(out.data(), a.data(), b.data(), a_row, a_col, b_row,
+                      b_col, ta, tb);
+  });
+
+  float max_err = 0;
+  for (int64_t i = 0; i < M * N; ++i) {
+    max_err = std::max(max_err, std::abs(ref[i] - out[i]));
+  }
+  bool ok = max_err <= 1e-3F * std::sqrt(static_cast<float>(K));
+  double gflops = 2.0 * M * N * K / (t_new * 1e6);
+  std::cout << M << "x" << N << "x" << K << " tA=" << ta << " tB=" << tb
+            << ": ref " << t_ref << " ms, blocked " << t_new << " ms ("
+            << gflops << " GFLOPS, " << t_ref / t_new << "x), max err "
+            << max_err << (ok ? "" : " MISMATCH") << "\n";
+  return ok;
+}
+
+int main() {
+  struct Shape {
+    int64_t m;
+    int64_t n;
+    int64_t k;
+  };
+  const std::vector<Shape> shapes{
+      {128, 768, 768},   // BERT-base QKV / output projection
+      {128, 3072, 768},  // BERT-base FFN up
+      {128, 768, 3072},  // BERT-base FFN down
+      {128, 128, 64},    // BERT-base attention scores per head
+      {1, 1000, 2048},   // ResNet-50 FC
+      {1, 4096, 4096},   // VGG FC
+      {37, 53, 71},      // odd sizes exercising the edge tiles
+  };
+  bool ok = true;
+  for (const auto& s : shapes) {
+    for (int t = 0; t < 4; ++t) {
+      ok &= Run(s.m, s.n, s.k, (t & 2) != 0, (t & 1) != 0);
+    }
+  }
+  return ok ? 0 : 1;
+}
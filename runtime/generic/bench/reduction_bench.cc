@@ -0,0 +1,285 @@
+//===- reduction_bench.cc -------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// Compares the vectorized exp, softmax, reduce-mean and max pooling kernels
+// against the previous scalar implementations at BERT and ResNet-50 shapes,
+// plus odd sizes exercising the vector tails and the pooling borders.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../math/vec_math.h"
+
+extern "C" {
+void _sn_rt_softmax_f32(float* result, const float* logits,
+                        const int64_t* shape, int32_t axis, int32_t dim,
+                        int64_t num_of_elements);
+void _sn_rt_reduce_mean_f32(float* result, const float* data,
+                            const int64_t* shape, const int32_t* axis,
+                            int64_t num_of_elements, int32_t dim,
+                            int32_t axis_dim);
+void _sn_rt_poolingmax_f32_helper(
+    float* output, const float* data, int64_t batch, int64_t spatial_h,
+    int64_t spatial_w, int64_t channel, int64_t output_h, int64_t output_w,
+    int64_t kernel_h, int64_t kernel_w, int64_t stride_h, int64_t stride_w,
+    int64_t pad_top, int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    bool is_nchw);
+}
+
+// The previous softmax, with the stack array replaced by a vector.
+static void RefSoftmax(float* result, const float* logits, int64_t before,
+                       int64_t after) {
+  std::vector<float> temp(after);
+  for (int64_t i = 0; i < before; ++i) {
+    float sum = 0;
+    int64_t index = i * after;
+    float max_value = *std::max_element(logits + index, logits + index + after);
+    for (int64_t j = 0; j < after; ++j) {
+      temp[j] = std::exp(logits[j + index] - max_value);
+      sum += temp[j];
+    }
+    for (int64_t j = 0; j < after; ++j) {
+      result[j + index] = temp[j] / sum;
+    }
+  }
+}
+
+// The previous reduce-mean: one strided pass and division per axis.
+static void RefReduceMean(float* result, const float* data,
+                          std::vector<int64_t> dims,
+                          const std::vector<int32_t>& axes) {
+  int64_t n = 1;
+  for (int64_t d : dims) {
+    n *= d;
+  }
+  std::vector<float> temp(data, data + n);
+  for (int32_t axis : axes) {
+    int64_t before = 1;
+    int64_t after = 1;
+    for (int32_t i = 0; i < static_cast<int32_t>(dims.size()); ++i) {
+      if (i < axis) {
+        before *= dims[i];
+      } else if (i > axis) {
+        after *= dims[i];
+      }
+    }
+    int64_t dim = dims[axis];
+    for (int64_t i = 0; i < before; ++i) {
+      for (int64_t j = 0; j < dim; ++j) {
+        for (int64_t k = 0; k < after; ++k) {
+          auto o_index = k + i * after;
+          auto i_index = k + (j + i * dim) * after;
+          if (j == 0) {
+            temp[o_index] = temp[i_index];
+          } else {
+            temp[o_index] += temp[i_index];
+          }
+        }
+      }
+    }
+    for (int64_t i = 0; i < before * after; ++i) {
+      temp[i] /= static_cast<float>(dim);
+    }
+    dims[axis] = 1;
+  }
+  int64_t result_noe = 1;
+  for (int64_t d : dims) {
+    result_noe *= d;
+  }
+  std::copy(temp.begin(), temp.begin() + result_noe, result);
+}
+
+// The previous max pooling, which bounds-checks every window element.
+static void RefPoolingMax(float* output, const float* data, int64_t spatial_h,
+                          int64_t spatial_w, int64_t channel, int64_t output_h,
+                          int64_t output_w, int64_t k, int64_t stride,
+                          int64_t pad, bool is_nchw) {
+  for (int64_t c = 0; c < channel; ++c) {
+    for (int64_t i = 0; i < output_h; ++i) {
+      for (int64_t j = 0; j < output_w; ++j) {
+        float max = std::numeric_limits<float>::lowest();
+        for (int64_t m = 0; m < k; ++m) {
+          for (int64_t n = 0; n < k; ++n) {
+            int64_t h = i * stride - pad + m;
+            int64_t w = j * stride - pad + n;
+            bool valid = h >= 0 && h < spatial_h && w >= 0 && w < spatial_w;
+            auto in_index = is_nchw ? (c * spatial_h + h) * spatial_w + w
+                                    : (h * spatial_w + w) * channel + c;
+            float value =
+                valid ? data[in_index] : std::numeric_limits<float>::lowest();
+            max = std::max(max, value);
+          }
+        }
+        auto o_index = is_nchw ? (c * output_h + i) * output_w + j
+                               : (i * output_w + j) * channel + c;
+        output[o_index] = max;
+      }
+    }
+  }
+}
+
+template <typename T>
+static double TimeIt(int iters, T func) {
+  func(); // warm up
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; ++i) {
+    func();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count() / iters;
+}
+
+static std::vector<float> Random(int64_t n, float lo, float hi, int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(lo, hi);
+  std::vector<float> v(n);
+  for (auto& x : v) {
+    x = dist(gen);
+  }
+  return v;
+}
+
+static bool Report(const std::string& name, double t_ref, double t_new,
+                   float max_err, float tolerance) {
+  bool ok = max_err <= tolerance;
+  std::cout << name << ": ref " << t_ref << " ms, vectorized " << t_new
+            << " ms (" << t_ref / t_new << "x), max err " << max_err
+            << (ok ? "" : " MISMATCH") << "\n";
+  return ok;
+}
+
+static float MaxError(const std::vector<float>& a,
+                      const std::vector<float>& b) {
+  float max_err = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    max_err = std::max(max_err, std::abs(a[i] - b[i]));
+  }
+  return max_err;
+}
+
+static bool RunExp() {
+  // Relative error over the range used by softmax and beyond.
+  std::vector<float> x = Random(1 << 20, -87.0F, 88.0F, 1);
+  double max_rel = 0;
+  for (float v : x) {
+    double ref = std::exp(static_cast<double>(v));
+    max_rel = std::max(max_rel, std::abs(_sn_rt_exp_f32(v) - ref) / ref);
+  }
+  bool ok = max_rel <= 3 * std::numeric_limits<float>::epsilon();
+  std::cout << "exp: max relative err " << max_rel << (ok ? "" : " MISMATCH")
+            << "\n";
+  return ok;
+}
+
+static bool RunSoftmax(const char* name, std::vector<int64_t> shape,
+                       int32_t axis) {
+  int64_t n = 1;
+  int64_t after = 1;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    n *= shape[i];
+    after *= static_cast<int32_t>(i) >= axis ? shape[i] : 1;
+  }
+  std::vector<float> in = Random(n, -20.0F, 20.0F, n);
+  std::vector<float> ref(n);
+  std::vector<float> out(n);
+  int iters = n > (1 << 22) ? 2 : 10;
+  double t_ref = TimeIt(
+      iters, [&]() { RefSoftmax(ref.data(), in.data(), n / after, after); });
+  double t_new = TimeIt(iters, [&]() {
+    _sn_rt_softmax_f32(out.data(), in.data(), shape.data(), axis,
+                       shape.size(), n);
+  });
+  return Report(std::string("softmax ") + name, t_ref, t_new,
+                MaxError(ref, out), 1e-6F);
+}
+
+static bool RunReduceMean(const char* name, std::vector<int64_t> shape,
+                          std::vector<int32_t> axes) {
+  int64_t n = 1;
+  int64_t reduced = 1;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    n *= shape[i];
+  }
+  for (int32_t a : axes) {
+    reduced *= shape[a];
+  }
+  std::vector<float> in = Random(n, -1.0F, 1.0F, n);
+  std::vector<float> ref(n / reduced);
+  std::vector<float> out(n / reduced);
+  int iters = n > (1 << 22) ? 2 : 10;
+  double t_ref = TimeIt(
+      iters, [&]() { RefReduceMean(ref.data(), in.data(), shape, axes); });
+  double t_new = TimeIt(iters, [&]() {
+    _sn_rt_reduce_mean_f32(out.data(), in.data(), shape.data(), axes.data(), n,
+                           shape.size(), axes.size());
+  });
+  return Report(std::string("reduce mean ") + name, t_ref, t_new,
+                MaxError(ref, out), 1e-5F);
+}
+
+static bool RunPoolingMax(const char* name, int64_t h, int64_t w, int64_t c,
+                          int64_t k, int64_t stride, int64_t pad,
+                          bool is_nchw) {
+  int64_t oh = (h + 2 * pad - k) / stride + 1;
+  int64_t ow = (w + 2 * pad - k) / stride + 1;
+  std::vector<float> in = Random(h * w * c, -1.0F, 1.0F, h * w + c);
+  std::vector<float> ref(oh * ow * c);
+  std::vector<float> out(oh * ow * c);
+  int iters = 10;
+  double t_ref = TimeIt(iters, [&]() {
+    RefPoolingMax(ref.data(), in.data(), h, w, c, oh, ow, k, stride, pad,
+                  is_nchw);
+  });
+  double t_new = TimeIt(iters, [&]() {
+    _sn_rt_poolingmax_f32_helper(out.data(), in.data(), 1, h, w, c, oh, ow, k,
+                                 k, stride, stride, pad, pad, pad, pad,
+                                 is_nchw);
+  });
+  return Report(std::string("pooling max ") + name +
+                    (is_nchw ? " NCHW" : " NHWC"),
+                t_ref, t_new, MaxError(ref, out), 0);
+}
+
+int main() {
+  bool ok = RunExp();
+  ok &= RunSoftmax("BERT attention 12x128x128", {12, 128, 128}, 2);
+  ok &= RunSoftmax("vocab 8x30522", {8, 30522}, 1);
+  ok &= RunSoftmax("ImageNet 1x1000", {1, 1000}, 1);
+  ok &= RunSoftmax("odd 3x5x7 over 5x7", {3, 5, 7}, 1);
+
+  ok &= RunReduceMean("global average pool NCHW", {8, 2048, 7, 7}, {2, 3});
+  ok &= RunReduceMean("global average pool NHWC", {8, 7, 7, 2048}, {1, 2});
+  ok &= RunReduceMean("layer norm 128x768", {1, 128, 768}, {2});
+  ok &= RunReduceMean("outer 64x4096", {64, 4096}, {0});
+  ok &= RunReduceMean("strided axes 4x8x16x33", {4, 8, 16, 33}, {1, 3});
+  ok &= RunReduceMean("odd 3x5x7", {3, 5, 7}, {0, 2});
+
+  for (bool is_nchw : {true, false}) {
+    ok &= RunPoolingMax("ResNet stem 3x3/2", 112, 112, 64, 3, 2, 1, is_nchw);
+    ok &= RunPoolingMax("VGG 2x2/2", 56, 56, 128, 2, 2, 0, is_nchw);
+    ok &= RunPoolingMax("odd 3x3/1", 17, 23, 12, 3, 1, 1, is_nchw);
+    ok &= RunPoolingMax("wide pad 5x5/1", 7, 9, 5, 5, 1, 4, is_nchw);
+  }
+  return ok ? 0 : 1;
+}
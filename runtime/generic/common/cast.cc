@@ -17,6 +17,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 
 extern "C" {
 /// A dummy implementation.
@@ -25,4 +26,88 @@ void _sn_rt_sitofp_i32(float* out, const int* lhs, int64_t lhs_size) {
     out[i] = static_cast<float>(lhs[i]);
   }
 }
+
+static inline uint32_t FloatBits(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+static inline float BitsToFloat(uint32_t bits) {
+  float x;
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+void _sn_rt_fptofp_f32_bf16(uint16_t* out, const float* lhs, int64_t lhs_size) {
+  for (int64_t i = 0; i < lhs_size; ++i) {
+    uint32_t bits = FloatBits(lhs[i]);
+    if (isnan(lhs[i])) {
+      out[i] = static_cast<uint16_t>((bits >> 16) | 0x40);
+      continue;
+    }
+    // Round to nearest even.
+    bits += 0x7fff + ((bits >> 16) & 1);
+    out[i] = static_cast<uint16_t>(bits >> 16);
+  }
+}
+
+void _sn_rt_fptofp_bf16_f32(float* out, const uint16_t* lhs, int64_t lhs_size) {
+  for (int64_t i = 0; i < lhs_size; ++i) {
+    out[i] = BitsToFloat(static_cast<uint32_t>(lhs[i]) << 16);
+  }
+}
+
+void _sn_rt_fptofp_f32_f16(uint16_t* out, const float* lhs, int64_t lhs_size) {
+  for (int64_t i = 0; i < lhs_size; ++i) {
+    uint32_t bits = FloatBits(lhs[i]);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exp = (bits >> 23) & 0xff;
+    uint32_t mant = bits & 0x7fffff;
+    int e = static_cast<int>(exp) - 127 + 15;
+    if (exp == 0xff) {
+      out[i] = static_cast<uint16_t>(sign | 0x7c00 | (mant != 0 ? 0x200 : 0));
+      continue;
+    }
+    if (e >= 31) {
+      out[i] = static_cast<uint16_t>(sign | 0x7c00);
+      continue;
+    }
+    if (e < -10) {
+      out[i] = static_cast<uint16_t>(sign);
+      continue;
+    }
+    int shift = 13;
+    uint32_t v = (static_cast<uint32_t>(e) << 23) | mant;
+    if (e <= 0) {
+      // Subnormal, in units of 2^-24.
+      shift = 14 - e;
+      v = mant | 0x800000;
+    }
+    uint32_t h = v >> shift;
+    uint32_t rem = v & ((1U << shift) - 1);
+    uint32_t half = 1U << (shift - 1);
+    if (rem > half || (rem == half && (h & 1) != 0)) {
+      ++h;
+    }
+    out[i] = static_cast<uint16_t>(sign | h);
+  }
+}
+
+void _sn_rt_fptofp_f16_f32(float* out, const uint16_t* lhs, int64_t lhs_size) {
+  for (int64_t i = 0; i < lhs_size; ++i) {
+    uint32_t sign = static_cast<uint32_t>(lhs[i] & 0x8000) << 16;
+    uint32_t exp = (lhs[i] >> 10) & 0x1f;
+    uint32_t mant = lhs[i] & 0x3ff;
+    float v = 0;
+    if (exp == 0x1f) {
+      v = BitsToFloat(0x7f800000 | (mant << 13));
+    } else if (exp == 0) {
+      v = ldexpf(static_cast<float>(mant), -24);
+    } else {
+      v = BitsToFloat(((exp + 127 - 15) << 23) | (mant << 13));
+    }
+    out[i] = BitsToFloat(FloatBits(v) | sign);
+  }
+}
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+//===- parallel.cc --------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "parallel.h"
+
+#ifdef HALO_RT_SINGLE_THREADED
+extern "C" {
+void _sn_rt_set_num_threads(int64_t num_threads) {}
+}
+#else
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// The pool used by the kernels. It is read on every kernel call, so reading it
+// takes no lock.
+static std::atomic<halo::ThreadPool*> current_pool{nullptr};
+// Guards the creation of pools and owns them. A pool replaced by
+// _sn_rt_set_num_threads() is kept alive since a kernel on another thread may
+// still be running on it.
+static std::mutex pool_mutex;
+static std::vector<std::unique_ptr<halo::ThreadPool>> pools;
+
+static halo::ThreadPool* CreatePool(int num_threads) {
+  pools.push_back(std::make_unique<halo::ThreadPool>(num_threads));
+  current_pool.store(pools.back().get(), std::memory_order_release);
+  return pools.back().get();
+}
+
+halo::ThreadPool& _sn_rt_get_thread_pool() {
+  halo::ThreadPool* pool = current_pool.load(std::memory_order_acquire);
+  if (pool != nullptr) {
+    return *pool;
+  }
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  pool = current_pool.load(std::memory_order_acquire);
+  if (pool == nullptr) {
+    pool = CreatePool(halo::ThreadPool::GetDefaultNumOfThreads());
+  }
+  return *pool;
+}
+
+extern "C" {
+void _sn_rt_set_num_threads(int64_t num_threads) {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  int n = num_threads > 0 ? static_cast<int>(num_threads)
+                          : halo::ThreadPool::GetDefaultNumOfThreads();
+  halo::ThreadPool* pool = current_pool.load(std::memory_order_acquire);
+  if (pool != nullptr && pool->GetNumOfThreads() == n) {
+    return;
+  }
+  // Reuse a pool of the same size created earlier, so that calling the init
+  // function repeatedly does not pile up idle threads.
+  for (auto& p : pools) {
+    if (p->GetNumOfThreads() == n) {
+      current_pool.store(p.get(), std::memory_order_release);
+      return;
+    }
+  }
+  CreatePool(n);
+}
+}
+#endif
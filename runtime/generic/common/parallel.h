@@ -0,0 +1,73 @@
+//===- parallel.h ---------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_RUNTIME_GENERIC_COMMON_PARALLEL_H_
+#define HALO_LIB_RUNTIME_GENERIC_COMMON_PARALLEL_H_
+
+#include <stdint.h>
+
+#ifndef HALO_RT_SINGLE_THREADED
+#include "halo/lib/threadpool/thread_pool.h"
+#endif
+
+extern "C" {
+/// Sets the number of threads used by the runtime kernels. A non-positive
+/// value restores the default, i.e., $HALO_NUM_THREADS or the number of
+/// hardware threads. Kernels that are running keep using the previous pool.
+void _sn_rt_set_num_threads(int64_t num_threads);
+}
+
+// Work below this many multiply-adds (or equivalent) is not worth handing to
+// another thread.
+static constexpr int64_t ParallelMinWork = 1 << 15;
+
+/// Returns the number of iterations that make up ParallelMinWork when each
+/// iteration costs `work_per_iteration`.
+static inline int64_t ParallelGrain(int64_t work_per_iteration) {
+  return work_per_iteration >= ParallelMinWork
+             ? 1
+             : ParallelMinWork / (work_per_iteration > 0 ? work_per_iteration
+                                                         : 1);
+}
+
+#ifdef HALO_RT_SINGLE_THREADED
+static inline int64_t _sn_rt_get_num_threads() { return 1; }
+
+template <typename Func>
+static inline void ParallelFor(int64_t n, int64_t grain, const Func& func) {
+  if (n > 0) {
+    func(0, n);
+  }
+}
+#else
+/// Returns the thread pool shared by all runtime kernels.
+halo::ThreadPool& _sn_rt_get_thread_pool();
+
+static inline int64_t _sn_rt_get_num_threads() {
+  return _sn_rt_get_thread_pool().GetNumOfThreads();
+}
+
+/// Calls func(begin, end) on chunks of [0, n) in parallel. Each chunk has at
+/// least `grain` iterations. Calls from inside a parallel loop run
+/// sequentially on the calling thread.
+template <typename Func>
+static inline void ParallelFor(int64_t n, int64_t grain, const Func& func) {
+  _sn_rt_get_thread_pool().ParallelFor(0, n, grain, func);
+}
+#endif
+
+#endif // HALO_LIB_RUNTIME_GENERIC_COMMON_PARALLEL_H_
@@ -17,111 +17,147 @@
 
 #include <algorithm>
 #include <cstring>
+#include <utility>
+#include <vector>
 
-extern "C" {
-/// Helper function
-static void _sn_rt_reduce_helper(float* data, int64_t* in_dims,
-                                 int in_dims_size, const int64_t* axies,
-                                 int axies_size, int index) {
-  if (index == axies_size) {
-    return;
-  }
-  int64_t curr = axies[index];
-  int64_t dim = in_dims[curr];
-  int64_t before, after;
-  before = after = 1;
-  for (int i = 0; i < in_dims_size; ++i) {
-    if (i < curr) {
-      before *= in_dims[i];
-    } else if (i > curr) {
-      after *= in_dims[i];
-    } else {
-      in_dims[i] = 1;
+#include "../math/vec_math.h"
+#include "parallel.h"
+
+// Number of consecutive elements of the kept inner dimensions reduced by one
+// task, so that the innermost loop stays contiguous.
+static constexpr int64_t ReduceBlock = 256;
+
+// Returns the sum of n contiguous elements.
+static float SumRow(const float* x, int64_t n) {
+  FloatVec acc[4] = {};
+  int64_t i = 0;
+  for (; i + 4 * VecLanes <= n; i += 4 * VecLanes) {
+    for (int64_t u = 0; u < 4; ++u) {
+      acc[u] += LoadVec(x + i + u * VecLanes);
     }
   }
-  for (int i = 0; i < before; ++i) {
-    for (int j = 0; j < dim; ++j) {
-      for (int k = 0; k < after; ++k) {
-        auto o_index = k + i * after;
-        auto i_index = k + (j + i * dim) * after;
-        if (j == 0) {
-          data[o_index] = data[i_index];
-        } else {
-          data[o_index] += data[i_index];
-        }
-      }
-    }
+  for (; i + VecLanes <= n; i += VecLanes) {
+    acc[0] += LoadVec(x + i);
   }
-  for (int i = 0; i < before * after; ++i) {
-    data[i] /= (float)dim;
+  float sum = HorizontalSum((acc[0] + acc[1]) + (acc[2] + acc[3]));
+  for (; i < n; ++i) {
+    sum += x[i];
   }
-  _sn_rt_reduce_helper(data, in_dims, in_dims_size, axies, axies_size,
-                       index + 1);
+  return sum;
 }
 
-/// reducemean with fp32.
+// Computes y[outer][inner] as the sum of x[outer][reduced][inner] over the
+// middle dimension.
+static void ReduceSum(float* y, const float* x, int64_t outer, int64_t reduced,
+                      int64_t inner) {
+  if (inner == 1) {
+    // The reduced elements are contiguous.
+    ParallelFor(outer, ParallelGrain(reduced), [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        y[i] = SumRow(x + i * reduced, reduced);
+      }
+    });
+    return;
+  }
+  // Rows of the inner elements are added up block by block, which splits the
+  // work over the outer rows and the inner blocks.
+  int64_t blocks = (inner + ReduceBlock - 1) / ReduceBlock;
+  int64_t block = std::min(inner, ReduceBlock);
+  ParallelFor(outer * blocks, ParallelGrain(reduced * block),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t t = begin; t < end; ++t) {
+                  int64_t i = t / blocks;
+                  int64_t k0 = t % blocks * ReduceBlock;
+                  int64_t n = std::min(k0 + ReduceBlock, inner) - k0;
+                  float* dst = y + i * inner + k0;
+                  const float* src = x + i * reduced * inner + k0;
+                  memcpy(dst, src, n * sizeof(float));
+                  for (int64_t j = 1; j < reduced; ++j) {
+                    const float* row = src + j * inner;
+                    int64_t k = 0;
+                    for (; k + VecLanes <= n; k += VecLanes) {
+                      StoreVec(dst + k, LoadVec(dst + k) + LoadVec(row + k));
+                    }
+                    for (; k < n; ++k) {
+                      dst[k] += row[k];
+                    }
+                  }
+                }
+              });
+}
+
+extern "C" {
+/// reducemean with fp32. Adjacent reduced (or kept) dimensions are merged,
+/// so that each group of reduced dimensions takes one pass over contiguous
+/// rows. The sum is divided by the number of reduced elements at the end.
 void _sn_rt_reduce_mean_f32(float* result, const float* data,
                             const int64_t* shape, const int32_t* axis,
                             int64_t num_of_elements, int32_t dim,
                             int32_t axis_dim) {
-  constexpr int DIM_BEFORE = 4;
-  int64_t in_dims[] = {1, 1, 1, 1};
-  constexpr int in_dims_size = sizeof(in_dims) / sizeof(in_dims[0]);
-  int64_t axies[axis_dim];
-  const int axies_size = axis_dim;
-  for (int i = 0; i < axis_dim; ++i) {
-    axies[i] = 1;
-  }
-  const int DIM_EXPAND = DIM_BEFORE - dim;
-  for (auto i = 0; i != DIM_BEFORE; ++i) {
-    in_dims[i] = i >= DIM_EXPAND ? shape[i - DIM_EXPAND] : 1;
-  }
-  for (auto i = 0; i != axis_dim; ++i) {
-    axies[i] = axis[i] + DIM_EXPAND;
-  }
-  // std::sort(axies.begin(), axies.end());
-  // axies.erase(std::unique(axies.begin(), axies.end()), axies.end());
-  int64_t before, after;
-  before = after = 1;
-  int64_t curr = axies[0];
-  int64_t reduced_dim = in_dims[curr];
-  for (int i = 0; i < in_dims_size; ++i) {
-    if (i < curr) {
-      before *= in_dims[i];
-    } else if (i > curr) {
-      after *= in_dims[i];
-    } else {
-      in_dims[i] = 1;
+  std::vector<bool> is_reduced(dim);
+  for (int32_t i = 0; i < axis_dim; ++i) {
+    is_reduced[axis[i] < 0 ? axis[i] + dim : axis[i]] = true;
+  }
+  // (size, is_reduced) of merged dimensions. Dimensions of size 1 are
+  // dropped.
+  std::vector<std::pair<int64_t, bool>> groups;
+  int64_t count = 1;
+  for (int32_t i = 0; i < dim; ++i) {
+    if (is_reduced[i]) {
+      count *= shape[i];
     }
-  }
-  float temp[before * after];
-  for (int i = 0; i < before; ++i) {
-    for (int j = 0; j < reduced_dim; ++j) {
-      for (int k = 0; k < after; ++k) {
-        auto o_index = k + i * after;
-        auto i_index = k + (j + i * reduced_dim) * after;
-        if (j == 0) {
-          temp[o_index] = data[i_index];
-        } else {
-          temp[o_index] += data[i_index];
-        }
-      }
+    if (shape[i] == 1) {
+      continue;
+    }
+    if (!groups.empty() && groups.back().second == is_reduced[i]) {
+      groups.back().first *= shape[i];
+    } else {
+      groups.emplace_back(shape[i], is_reduced[i]);
     }
   }
-  for (int i = 0; i < before * after; ++i) {
-    temp[i] /= (float)reduced_dim;
+  if (num_of_elements == 0) {
+    return;
   }
 
-  if (axies_size > 1) {
-    _sn_rt_reduce_helper(temp, in_dims, in_dims_size, axies, axies_size, 1);
+  int64_t passes = std::count_if(
+      groups.begin(), groups.end(),
+      [](const std::pair<int64_t, bool>& g) { return g.second; });
+  const float* src = data;
+  int64_t size = num_of_elements;
+  std::vector<float> buffers[2];
+  // Each pass reduces the innermost remaining group of reduced dimensions.
+  for (int64_t pass = 0; pass < passes; ++pass) {
+    auto it = std::find_if(
+        groups.rbegin(), groups.rend(),
+        [](const std::pair<int64_t, bool>& g) { return g.second; });
+    size_t g = groups.size() - 1 - (it - groups.rbegin());
+    int64_t reduced = groups[g].first;
+    int64_t inner = 1;
+    for (size_t i = g + 1; i < groups.size(); ++i) {
+      inner *= groups[i].first;
+    }
+    size /= reduced;
+    float* dst = result;
+    if (pass + 1 < passes) {
+      buffers[pass % 2].resize(size);
+      dst = buffers[pass % 2].data();
+    }
+    ReduceSum(dst, src, size / inner, reduced, inner);
+    src = dst;
+    // Merge the kept neighbours of the reduced group.
+    if (g > 0 && g + 1 < groups.size()) {
+      groups[g - 1].first *= groups[g + 1].first;
+      groups.erase(groups.begin() + g, groups.begin() + g + 2);
+    } else {
+      groups.erase(groups.begin() + g);
+    }
   }
-
-  int64_t result_noe = 1;
-  for (auto i : in_dims) {
-    result_noe *= i;
+  if (passes == 0) {
+    memcpy(result, data, size * sizeof(float));
   }
-  for (int i = 0; i < result_noe; ++i) {
-    result[i] = temp[i];
+  const float scale = 1.0F / static_cast<float>(count);
+  for (int64_t i = 0; i < size; ++i) {
+    result[i] *= scale;
   }
 }
 
@@ -143,21 +179,29 @@ void _sn_rt_argmax_f32(int* result, const float* data, const int64_t* shape,
     }
   }
   int64_t reduced_dims = shape[axis_adj];
-  for (int i = 0; i < before; ++i) {
-    float value_max[after];
-    for (int j = 0; j < reduced_dims; ++j) {
-      for (int k = 0; k < after; ++k) {
-        auto o_index = k + i * after;
-        auto i_index = k + (j + i * reduced_dims) * after;
-        if (j == 0) {
-          value_max[k] = data[i_index];
-          result[o_index] = 0;
-        } else if (value_max[k] < data[i_index]) {
-          value_max[k] = data[i_index];
-          result[o_index] = j;
-        }
-      }
-    }
-  }
+  int64_t blocks = (after + ReduceBlock - 1) / ReduceBlock;
+  int64_t block = after < ReduceBlock ? after : ReduceBlock;
+  ParallelFor(before * blocks, ParallelGrain(reduced_dims * block),
+              [&](int64_t begin, int64_t end) {
+                float value_max[block];
+                for (int64_t t = begin; t < end; ++t) {
+                  int64_t i = t / blocks;
+                  int64_t k0 = t % blocks * ReduceBlock;
+                  int64_t k1 = std::min(k0 + ReduceBlock, after);
+                  for (int64_t j = 0; j < reduced_dims; ++j) {
+                    for (int64_t k = k0; k < k1; ++k) {
+                      auto o_index = k + i * after;
+                      auto i_index = k + (j + i * reduced_dims) * after;
+                      if (j == 0) {
+                        value_max[k - k0] = data[i_index];
+                        result[o_index] = 0;
+                      } else if (value_max[k - k0] < data[i_index]) {
+                        value_max[k - k0] = data[i_index];
+                        result[o_index] = j;
+                      }
+                    }
+                  }
+                }
+              });
+}
 }
-}
\ No newline at end of file
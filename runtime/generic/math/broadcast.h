@@ -21,6 +21,8 @@
 #include <iostream>
 #include <numeric>
 
+#include "../common/parallel.h"
+
 extern "C" {
 void _sn_rt_broadcast_strides_calculation(
     int64_t* lhs_strides, int64_t* rhs_strides, const int64_t* result_shape,
@@ -42,4 +44,55 @@ void _sn_rt_broadcast_strides_calculation(
 }
 }
 
+/// Computes out = op(lhs, rhs) elementwise, broadcasting lhs and rhs to
+/// `ret_shape` if `need_broadcast` is true. The elements are split over the
+/// runtime thread pool.
+template <typename Op>
+static inline void _sn_rt_binary_f32(float* out, const float* lhs,
+                                     const float* rhs, int64_t ret_size,
+                                     bool need_broadcast,
+                                     const int64_t* ret_shape,
+                                     const int64_t* lhs_shape,
+                                     const int64_t* rhs_shape, int32_t dims,
+                                     Op op) {
+  if (!need_broadcast) {
+    ParallelFor(ret_size, ParallelMinWork, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        out[i] = op(lhs[i], rhs[i]);
+      }
+    });
+    return;
+  }
+  int64_t lhs_strides_buf[dims];
+  int64_t rhs_strides_buf[dims];
+  int64_t* lhs_strides = lhs_strides_buf;
+  int64_t* rhs_strides = rhs_strides_buf;
+  _sn_rt_broadcast_strides_calculation(lhs_strides, rhs_strides, ret_shape,
+                                       lhs_shape, rhs_shape, dims);
+  ParallelFor(ret_size, ParallelMinWork, [=](int64_t begin, int64_t end) {
+    // Position of element `begin` in the result.
+    int64_t pos[dims];
+    for (int64_t i = dims - 1, rem = begin; i >= 0; --i) {
+      pos[i] = rem % ret_shape[i];
+      rem /= ret_shape[i];
+    }
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t lhs_index =
+          std::inner_product(&pos[0], pos + dims, lhs_strides, int64_t(0));
+      int64_t rhs_index =
+          std::inner_product(&pos[0], pos + dims, rhs_strides, int64_t(0));
+      out[i] = op(lhs[lhs_index], rhs[rhs_index]);
+      int c = 1;
+      for (int j = dims - 1; j >= 0 && c == 1; --j) {
+        pos[j] += c;
+        if (pos[j] >= ret_shape[j]) {
+          pos[j] = 0;
+        } else {
+          c = 0;
+        }
+      }
+    }
+  });
+}
+
 #endif // HALO_LIB_RUNTIME_GENERIC_MATH_BROADCAST_H_
\ No newline at end of file
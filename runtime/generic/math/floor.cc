@@ -19,7 +19,7 @@
 #include <stdint.h>
 
 extern "C" {
-/// A dummy implementation.
+/// A dummy implementation. `out` may alias the input for in-place execution.
 void _sn_rt_floor_f32(float* out, const float* lhs, int64_t lhs_size) {
   for (int64_t i = 0; i < lhs_size; ++i) {
     out[i] = std::floor(lhs[i]);
@@ -0,0 +1,34 @@
+//===- gemm.h -------------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_RUNTIME_GENERIC_MATH_GEMM_H_
+#define HALO_LIB_RUNTIME_GENERIC_MATH_GEMM_H_
+
+#include <stdint.h>
+
+extern "C" {
+/// Computes C[M x N] (+)= A[M x K] * B[K x N] with a cache-blocked,
+/// register-tiled kernel. Element (i, k) of A is A[i * a_rs + k * a_cs] and
+/// element (k, j) of B is B[k * b_rs + j * b_cs], so transposed operands are
+/// expressed by swapping the strides. Rows of C are `ldc` elements apart.
+/// If `accumulate` is false, C is overwritten.
+void _sn_rt_sgemm(float* C, const float* A, const float* B, int64_t M,
+                  int64_t N, int64_t K, int64_t a_rs, int64_t a_cs,
+                  int64_t b_rs, int64_t b_cs, int64_t ldc, bool accumulate);
+}
+
+#endif // HALO_LIB_RUNTIME_GENERIC_MATH_GEMM_H_
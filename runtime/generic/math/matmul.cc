@@ -16,96 +16,286 @@
 // =============================================================================
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-extern "C" {
-/// A dummy implementation.
-void _sn_rt_matmul_f32(float* C, const float* A, const float* B, int64_t A_row,
-                       int64_t A_col, int64_t B_row, int64_t B_col,
-                       bool transposeA, bool transposeB) {
-  auto C_row = (transposeA ? A_col : A_row);
-  auto C_col = (transposeB ? B_row : B_col);
-  if (!transposeA && transposeB) {
-    for (int64_t i = 0; i < C_row; ++i) {
-      for (int64_t j = 0; j < C_col; ++j) {
-        *C = 0;
-        for (int64_t k = 0; k < B_col; ++k)
-          *C += A[i * A_col + k] * B[j * B_col + k];
-        ++C;
+#include "../common/parallel.h"
+#include "../nn/activation.h"
+#include "gemm.h"
+
+// Register tile of the micro kernel. NR floats of a row of C are kept in
+// vector registers (one AVX-512, two AVX2 or four NEON registers).
+static constexpr int64_t MR = 4;
+static constexpr int64_t NR = 16;
+// Cache blocking: a MC x KC panel of A stays in L1/L2, a KC x NC panel of B
+// stays in L2.
+static constexpr int64_t MC = 64;
+static constexpr int64_t KC = 256;
+static constexpr int64_t NC = 256;
+static constexpr size_t Alignment = 64;
+
+static float* AllocPanel(int64_t elems) {
+  size_t blocks = (elems * sizeof(float) + Alignment - 1) / Alignment;
+  return static_cast<float*>(aligned_alloc(Alignment, blocks * Alignment));
+}
+
+// Packs a mc x kc block of A into MR-row slivers, each stored k-major and
+// zero-padded to MR rows.
+static void PackA(float* __restrict pa, const float* A, int64_t mc, int64_t kc,
+                  int64_t a_rs, int64_t a_cs) {
+  for (int64_t i = 0; i < mc; i += MR) {
+    int64_t mr = mc - i < MR ? mc - i : MR;
+    for (int64_t k = 0; k < kc; ++k) {
+      int64_t ii = 0;
+      for (; ii < mr; ++ii) {
+        *pa++ = A[(i + ii) * a_rs + k * a_cs];
+      }
+      for (; ii < MR; ++ii) {
+        *pa++ = 0;
+      }
+    }
+  }
+}
+
+// Packs a kc x nc block of B into NR-column slivers, each stored k-major and
+// zero-padded to NR columns.
+static void PackB(float* __restrict pb, const float* B, int64_t kc, int64_t nc,
+                  int64_t b_rs, int64_t b_cs) {
+  for (int64_t j = 0; j < nc; j += NR) {
+    int64_t nr = nc - j < NR ? nc - j : NR;
+    for (int64_t k = 0; k < kc; ++k) {
+      const float* b = B + k * b_rs + j * b_cs;
+      int64_t jj = 0;
+      if (b_cs == 1) {
+        for (; jj < nr; ++jj) {
+          pb[jj] = b[jj];
+        }
+      } else {
+        for (; jj < nr; ++jj) {
+          pb[jj] = b[jj * b_cs];
+        }
+      }
+      for (; jj < NR; ++jj) {
+        pb[jj] = 0;
       }
+      pb += NR;
+    }
+  }
+}
+
+// A row of the register tile. Generic vector types are lowered by the
+// compiler to the widest vector registers of the target.
+typedef float RowVec __attribute__((vector_size(NR * sizeof(float))));
+
+// Computes a mr x nr tile of C from a packed sliver of A and B.
+static void MicroKernel(int64_t kc, const float* __restrict pa,
+                        const float* __restrict pb, float* C, int64_t ldc,
+                        int64_t mr, int64_t nr, bool accumulate) {
+  RowVec acc[MR] = {};
+  for (int64_t k = 0; k < kc; ++k) {
+    RowVec b;
+    memcpy(&b, pb, sizeof(b));
+    for (int64_t i = 0; i < MR; ++i) {
+      acc[i] += pa[i] * b;
+    }
+    pa += MR;
+    pb += NR;
+  }
+  for (int64_t i = 0; i < mr; ++i) {
+    float* c = C + i * ldc;
+    if (accumulate) {
+      for (int64_t j = 0; j < nr; ++j) {
+        c[j] += acc[i][j];
+      }
+    } else {
+      for (int64_t j = 0; j < nr; ++j) {
+        c[j] = acc[i][j];
+      }
+    }
+  }
+}
+
+// Returns the dot product of two contiguous vectors.
+static float Dot(const float* __restrict x, const float* __restrict y,
+                 int64_t n) {
+  RowVec acc = {};
+  int64_t i = 0;
+  for (; i + NR <= n; i += NR) {
+    RowVec a;
+    RowVec b;
+    memcpy(&a, x + i, sizeof(a));
+    memcpy(&b, y + i, sizeof(b));
+    acc += a * b;
+  }
+  float sum = 0;
+  for (int64_t j = 0; j < NR; ++j) {
+    sum += acc[j];
+  }
+  for (; i < n; ++i) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+// Computes c[N] (+)= a[K] * B[K x N]. Packing does not pay off for a single
+// row, so B is streamed directly.
+static void Gemv(float* __restrict c, const float* a, const float* B,
+                 int64_t N, int64_t K, int64_t a_cs, int64_t b_rs,
+                 int64_t b_cs, bool accumulate) {
+  if (b_rs == 1 && a_cs == 1) {
+    for (int64_t j = 0; j < N; ++j) {
+      float v = Dot(a, B + j * b_cs, K);
+      c[j] = accumulate ? c[j] + v : v;
     }
     return;
   }
-  if (transposeA && !transposeB) {
-    for (int64_t i = 0; i < C_row; ++i) {
-      for (int64_t j = 0; j < C_col; ++j) {
-        *C = 0;
-        for (int64_t k = 0; k < B_row; ++k)
-          *C += A[k * A_col + i] * B[k * B_col + j];
-        ++C;
+  if (!accumulate) {
+    memset(c, 0, N * sizeof(float));
+  }
+  for (int64_t k = 0; k < K; ++k) {
+    float s = a[k * a_cs];
+    const float* b = B + k * b_rs;
+    if (b_cs == 1) {
+      for (int64_t j = 0; j < N; ++j) {
+        c[j] += s * b[j];
+      }
+    } else {
+      for (int64_t j = 0; j < N; ++j) {
+        c[j] += s * b[j * b_cs];
+      }
+    }
+  }
+}
+
+// Computes rows [m0, m1) and columns [n0, n1) of C with the packed panels
+// `pa` (MC x KC) and `pb` (KC x NC).
+static void GemmBlock(float* C, const float* A, const float* B, int64_t m0,
+                      int64_t m1, int64_t n0, int64_t n1, int64_t K,
+                      int64_t a_rs, int64_t a_cs, int64_t b_rs, int64_t b_cs,
+                      int64_t ldc, bool accumulate, float* pa, float* pb) {
+  for (int64_t jc = n0; jc < n1; jc += NC) {
+    int64_t nc = n1 - jc < NC ? n1 - jc : NC;
+    for (int64_t pc = 0; pc < K; pc += KC) {
+      int64_t kc = K - pc < KC ? K - pc : KC;
+      bool acc = accumulate || pc > 0;
+      PackB(pb, B + pc * b_rs + jc * b_cs, kc, nc, b_rs, b_cs);
+      for (int64_t ic = m0; ic < m1; ic += MC) {
+        int64_t mc = m1 - ic < MC ? m1 - ic : MC;
+        PackA(pa, A + ic * a_rs + pc * a_cs, mc, kc, a_rs, a_cs);
+        for (int64_t jr = 0; jr < nc; jr += NR) {
+          int64_t nr = nc - jr < NR ? nc - jr : NR;
+          for (int64_t ir = 0; ir < mc; ir += MR) {
+            int64_t mr = mc - ir < MR ? mc - ir : MR;
+            MicroKernel(kc, pa + ir * kc, pb + jr * kc,
+                        C + (ic + ir) * ldc + jc + jr, ldc, mr, nr, acc);
+          }
+        }
       }
     }
+  }
+}
+
+extern "C" {
+void _sn_rt_sgemm(float* C, const float* A, const float* B, int64_t M,
+                  int64_t N, int64_t K, int64_t a_rs, int64_t a_cs,
+                  int64_t b_rs, int64_t b_cs, int64_t ldc, bool accumulate) {
+  if (M <= 0 || N <= 0) {
     return;
   }
-  if (!transposeA && !transposeB) {
-    for (int64_t i = 0; i < C_row; ++i) {
-      for (int64_t j = 0; j < C_col; ++j) {
-        *C = 0;
-        for (int64_t k = 0; k < B_row; ++k)
-          *C += A[i * A_col + k] * B[k * B_col + j];
-        ++C;
+  if (K <= 0) {
+    if (!accumulate) {
+      for (int64_t i = 0; i < M; ++i) {
+        memset(C + i * ldc, 0, N * sizeof(float));
       }
     }
+    return;
+  }
+  if (M == 1) {
+    // Columns of c are independent.
+    ParallelFor(N, ParallelGrain(K), [=](int64_t begin, int64_t end) {
+      Gemv(C + begin, A, B + begin * b_cs, end - begin, K, a_cs, b_rs, b_cs,
+           accumulate);
+    });
+    return;
   }
+  // C is split into blocks of MC rows and `nb` columns that are computed
+  // independently. The columns are split finer than NC if there would be
+  // fewer blocks than threads.
+  int64_t m_blocks = (M + MC - 1) / MC;
+  int64_t threads = _sn_rt_get_num_threads();
+  int64_t nb = (N * m_blocks + threads - 1) / threads;
+  nb = (nb + NR - 1) / NR * NR;
+  nb = nb < NC ? nb : NC;
+  int64_t n_blocks = (N + nb - 1) / nb;
+  int64_t block_work = (M < MC ? M : MC) * nb * K;
+  ParallelFor(m_blocks * n_blocks, ParallelGrain(block_work),
+              [=](int64_t begin, int64_t end) {
+                float* pa = AllocPanel(MC * KC);
+                float* pb = AllocPanel(KC * NC);
+                for (int64_t i = begin; i < end; ++i) {
+                  int64_t m0 = i / n_blocks * MC;
+                  int64_t n0 = i % n_blocks * nb;
+                  int64_t m1 = M - m0 < MC ? M : m0 + MC;
+                  int64_t n1 = N - n0 < nb ? N : n0 + nb;
+                  GemmBlock(C, A, B, m0, m1, n0, n1, K, a_rs, a_cs, b_rs,
+                            b_cs, ldc, accumulate, pa, pb);
+                }
+                free(pa);
+                free(pb);
+              });
 }
 
+void _sn_rt_matmul_f32(float* C, const float* A, const float* B, int64_t A_row,
+                       int64_t A_col, int64_t B_row, int64_t B_col,
+                       bool transposeA, bool transposeB) {
+  int64_t M = transposeA ? A_col : A_row;
+  int64_t K = transposeA ? A_row : A_col;
+  int64_t N = transposeB ? B_row : B_col;
+  int64_t a_rs = transposeA ? 1 : A_col;
+  int64_t a_cs = transposeA ? A_col : 1;
+  int64_t b_rs = transposeB ? 1 : B_col;
+  int64_t b_cs = transposeB ? B_col : 1;
+  _sn_rt_sgemm(C, A, B, M, N, K, a_rs, a_cs, b_rs, b_cs, N, false);
+}
+
+/// Computes alpha * A * B + beta * C and applies `activation`, which is a
+/// FusedActivation. C of C_noe elements is broadcast to the result.
 void _sn_rt_gemm_f32(float* result, const float* A, const float* B,
                      const float* C, int64_t A_row, int64_t A_col,
                      int64_t B_row, int64_t B_col, int64_t C_noe,
                      bool transposeA, bool transposeB, float alpha,
-                     float beta) {
+                     float beta, int64_t activation, float activation_alpha) {
   _sn_rt_matmul_f32(result, A, B, A_row, A_col, B_row, B_col, transposeA,
                     transposeB);
   auto result_row = (transposeA ? A_col : A_row);
   auto result_col = (transposeB ? B_row : B_col);
+  // Element (i, j) of the broadcast C is C[i * c_rs + j * c_cs].
+  int64_t c_rs = 0;
+  int64_t c_cs = 0;
+  bool has_c = true;
   if (C_noe == result_row * result_col) {
-    for (int64_t i = 0; i < result_row; ++i) {
-      for (int64_t j = 0; j < result_col; ++j) {
-        *result *= alpha;
-        *result += beta * C[i * result_col + j];
-        ++result;
-      }
-    }
-    return;
+    c_rs = result_col;
+    c_cs = 1;
+  } else if (C_noe == 1) {
+    // A scalar.
+  } else if (C_noe == result_row) {
+    c_rs = 1;
+  } else if (C_noe == result_col) {
+    c_cs = 1;
+  } else {
+    has_c = false;
   }
-  if (C_noe == 1) {
-    for (int64_t i = 0; i < result_row; ++i) {
-      for (int64_t j = 0; j < result_col; ++j) {
-        *result *= alpha;
-        *result += beta * (*C);
-        ++result;
-      }
-    }
-    return;
-  }
-  if (C_noe == result_row) {
-    for (int64_t i = 0; i < result_row; ++i) {
-      for (int64_t j = 0; j < result_col; ++j) {
-        *result *= alpha;
-        *result += beta * C[i];
-        ++result;
-      }
-    }
+  if (!has_c && activation == ActivationNone) {
     return;
   }
-  if (C_noe == result_col) {
-    for (int64_t i = 0; i < result_row; ++i) {
-      for (int64_t j = 0; j < result_col; ++j) {
-        *result *= alpha;
-        *result += beta * C[j];
-        ++result;
+  for (int64_t i = 0; i < result_row; ++i) {
+    for (int64_t j = 0; j < result_col; ++j) {
+      float r = *result;
+      if (has_c) {
+        r = r * alpha + beta * C[i * c_rs + j * c_cs];
       }
+      *result++ = _sn_rt_activate(r, activation, activation_alpha);
     }
-    return;
   }
 }
 
@@ -118,10 +308,18 @@ void _sn_rt_batch_matmul_f32(float* C, const float* A, const float* B,
   auto C_stride = C_row * C_col;
   auto A_stride = A_row * A_col;
   auto B_stride = B_row * B_col;
-  for (int64_t i = 0, offset_c = 0, offset_a = 0, offset_b = 0; i < batches;
-       ++i, offset_c += C_stride, offset_a += A_stride, offset_b += B_stride) {
-    _sn_rt_matmul_f32(&C[offset_c], &A[offset_a], &B[offset_b], A_row, A_col,
-                      B_row, B_col, transposeA, transposeB);
+  // Each matmul is parallel by itself. Only spread the batches over the
+  // threads if there are enough of them to keep all threads busy.
+  auto run = [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      _sn_rt_matmul_f32(&C[i * C_stride], &A[i * A_stride], &B[i * B_stride],
+                        A_row, A_col, B_row, B_col, transposeA, transposeB);
+    }
+  };
+  if (batches >= _sn_rt_get_num_threads()) {
+    ParallelFor(batches, 1, run);
+  } else {
+    run(0, batches);
   }
 }
 }
\ No newline at end of file
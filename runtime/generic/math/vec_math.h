@@ -0,0 +1,112 @@
+//===- vec_math.h ---------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_RUNTIME_GENERIC_MATH_VEC_MATH_H_
+#define HALO_LIB_RUNTIME_GENERIC_MATH_VEC_MATH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// Lanes of FloatVec. Generic vector types are lowered by the compiler to the
+// vector registers of the target.
+static constexpr int64_t VecLanes = 8;
+typedef float FloatVec __attribute__((vector_size(VecLanes * sizeof(float))));
+typedef int32_t IntVec __attribute__((vector_size(VecLanes * sizeof(float))));
+
+static inline FloatVec LoadVec(const float* p) {
+  FloatVec v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void StoreVec(float* p, FloatVec v) { memcpy(p, &v, sizeof(v)); }
+
+static inline FloatVec SplatVec(float x) { return FloatVec{} + x; }
+
+// Returns a where mask is set and b elsewhere.
+static inline FloatVec SelectVec(IntVec mask, FloatVec a, FloatVec b) {
+  return (FloatVec)((mask & (IntVec)a) | (~mask & (IntVec)b));
+}
+
+static inline FloatVec MaxVec(FloatVec a, FloatVec b) {
+  return SelectVec(a > b, a, b);
+}
+
+static inline float HorizontalMax(FloatVec v) {
+  float ret = v[0];
+  for (int64_t i = 1; i < VecLanes; ++i) {
+    ret = ret > v[i] ? ret : v[i];
+  }
+  return ret;
+}
+
+static inline float HorizontalSum(FloatVec v) {
+  float ret = 0;
+  for (int64_t i = 0; i < VecLanes; ++i) {
+    ret += v[i];
+  }
+  return ret;
+}
+
+// exp(x) = 2^n * exp(r) with n = round(x / ln2) and |r| <= ln2 / 2, where
+// exp(r) is a degree 7 polynomial (Cephes expf). The relative error is
+// within 2 ulp for x in [-87.3, 88]. Inputs are clamped to that range, so
+// exp(-inf) is a tiny normal number rather than 0, and the result does not
+// overflow. NaN is propagated.
+static inline float _sn_rt_exp_f32(float x) {
+  x = x < -87.3365448F ? -87.3365448F : x; // ln(FLT_MIN)
+  x = x > 88.0F ? 88.0F : x;
+  // Adding 1.5 * 2^23 rounds to an integer, which is then in the low bits.
+  const float round = 12582912.0F;
+  float t = x * 1.44269504F + round;
+  float n = t - round;
+  float r = x - n * 0.693359375F - n * -2.12194440e-4F;
+  float p = r * 1.9875691500e-4F + 1.3981999507e-3F;
+  p = p * r + 8.3334519073e-3F;
+  p = p * r + 4.1665795894e-2F;
+  p = p * r + 1.6666665459e-1F;
+  p = p * r + 5.0000001201e-1F;
+  p = p * r * r + r + 1.0F;
+  int32_t bits;
+  memcpy(&bits, &t, sizeof(bits));
+  bits = (bits - 0x4b400000 + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+/// The vector version of _sn_rt_exp_f32 with identical results.
+static inline FloatVec _sn_rt_exp_vec(FloatVec x) {
+  const FloatVec lo = SplatVec(-87.3365448F);
+  const FloatVec hi = SplatVec(88.0F);
+  x = SelectVec(x < lo, lo, x);
+  x = SelectVec(x > hi, hi, x);
+  const FloatVec round = SplatVec(12582912.0F);
+  FloatVec t = x * 1.44269504F + round;
+  FloatVec n = t - round;
+  FloatVec r = x - n * 0.693359375F - n * -2.12194440e-4F;
+  FloatVec p = r * 1.9875691500e-4F + 1.3981999507e-3F;
+  p = p * r + 8.3334519073e-3F;
+  p = p * r + 4.1665795894e-2F;
+  p = p * r + 1.6666665459e-1F;
+  p = p * r + 5.0000001201e-1F;
+  p = p * r * r + r + 1.0F;
+  IntVec bits = ((IntVec)t - 0x4b400000 + 127) << 23;
+  return p * (FloatVec)bits;
+}
+
+#endif // HALO_LIB_RUNTIME_GENERIC_MATH_VEC_MATH_H_
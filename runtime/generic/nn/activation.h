@@ -0,0 +1,46 @@
+//===- activation.h -------------------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef HALO_LIB_RUNTIME_GENERIC_NN_ACTIVATION_H_
+#define HALO_LIB_RUNTIME_GENERIC_NN_ACTIVATION_H_
+
+#include <stdint.h>
+
+// Activations fused into convolution and gemm. The values match
+// halo::ActivationType.
+enum FusedActivation : int64_t {
+  ActivationNone = 0,
+  ActivationRelu = 1,
+  ActivationRelu6 = 2,
+  ActivationLeakyRelu = 3,
+};
+
+static inline float _sn_rt_activate(float x, int64_t activation,
+                                    float alpha) {
+  switch (activation) {
+    case ActivationRelu:
+      return x < 0 ? 0 : x;
+    case ActivationRelu6:
+      return x < 0 ? 0 : (x > 6 ? 6 : x);
+    case ActivationLeakyRelu:
+      return x < 0 ? alpha * x : x;
+    default:
+      return x;
+  }
+}
+
+#endif // HALO_LIB_RUNTIME_GENERIC_NN_ACTIVATION_H_
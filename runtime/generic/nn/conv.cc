@@ -16,70 +16,580 @@
 // =============================================================================
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-#include <limits>
+#include "../common/parallel.h"
+#include "../math/gemm.h"
+#include "activation.h"
 
-#include "utils.h"
+// The convolution engine picks one of the following algorithms per shape:
+//  - depthwise: direct convolution, vectorized over channels for NHWC.
+//  - 1x1, stride 1, no padding: a single GEMM on the input.
+//  - 3x3, stride 1, no dilation: Winograd F(2x2, 3x3).
+//  - otherwise: im2col followed by the blocked GEMM.
+// The kernel is in OIHW layout for NCHW and HWIO layout for NHWC. For grouped
+// convolution, the input channel dimension of the kernel is channel / group.
+// Work is split over the thread pool by batch, group and output pixels, so
+// the GEMMs inside a parallel chunk run sequentially. The optional bias and
+// activation are applied to each block of outputs while it is in cache.
+
+struct ConvParams {
+  int64_t batch;
+  int64_t ih;
+  int64_t iw;
+  int64_t ic;
+  int64_t oh;
+  int64_t ow;
+  int64_t oc;
+  int64_t kh;
+  int64_t kw;
+  int64_t sh;
+  int64_t sw;
+  int64_t pt;
+  int64_t pl;
+  int64_t dh;
+  int64_t dw;
+  int64_t group;
+  bool nchw;
+  const float* bias; // Per output channel, or null.
+  int64_t activation;
+  float alpha;
+};
+
+// Maximum number of output pixels converted by im2col at a time.
+static constexpr int64_t Im2colPixels = 256;
+// Maximum number of Winograd tiles transformed at a time.
+static constexpr int64_t WinogradTiles = 256;
+static constexpr size_t Alignment = 64;
+
+static float* AllocBuffer(int64_t elems) {
+  size_t blocks = (elems * sizeof(float) + Alignment - 1) / Alignment;
+  return static_cast<float*>(aligned_alloc(Alignment, blocks * Alignment));
+}
+
+// Computes the range [lo, hi) of kernel taps that read inside the input for
+// an output whose window starts at `base`.
+static void ValidTaps(int64_t base, int64_t in, int64_t k, int64_t dilation,
+                      int64_t* lo, int64_t* hi) {
+  *lo = base < 0 ? (-base + dilation - 1) / dilation : 0;
+  *hi = in - base <= 0 ? 0 : (in - base + dilation - 1) / dilation;
+  *hi = *hi < k ? *hi : k;
+  *lo = *lo < *hi ? *lo : *hi;
+}
+
+// Gathers output pixels [p0, p0 + np) of group `g` into rows of `col`. Each
+// row holds kh x kw x (ic / group) elements in HWC order.
+static void Im2colNHWC(float* col, const float* in, const ConvParams& p,
+                       int64_t g, int64_t p0, int64_t np) {
+  int64_t cg = p.ic / p.group;
+  int64_t k = p.kh * p.kw * cg;
+  for (int64_t i = 0; i < np; ++i) {
+    int64_t y = (p0 + i) / p.ow;
+    int64_t x = (p0 + i) % p.ow;
+    float* dst = col + i * k;
+    for (int64_t m = 0; m < p.kh; ++m) {
+      int64_t h = y * p.sh - p.pt + m * p.dh;
+      for (int64_t n = 0; n < p.kw; ++n, dst += cg) {
+        int64_t w = x * p.sw - p.pl + n * p.dw;
+        if (h < 0 || h >= p.ih || w < 0 || w >= p.iw) {
+          memset(dst, 0, cg * sizeof(float));
+        } else {
+          memcpy(dst, in + (h * p.iw + w) * p.ic + g * cg, cg * sizeof(float));
+        }
+      }
+    }
+  }
+}
+
+// Gathers output pixels [p0, p0 + np) of group `g` into columns of `col`.
+// Each column holds (ic / group) x kh x kw elements in CHW order.
+static void Im2colNCHW(float* col, const float* in, const ConvParams& p,
+                       int64_t g, int64_t p0, int64_t np) {
+  int64_t cg = p.ic / p.group;
+  for (int64_t c = 0; c < cg; ++c) {
+    const float* plane = in + (g * cg + c) * p.ih * p.iw;
+    for (int64_t m = 0; m < p.kh; ++m) {
+      for (int64_t n = 0; n < p.kw; ++n) {
+        int64_t y = p0 / p.ow;
+        int64_t x = p0 % p.ow;
+        for (int64_t i = 0; i < np; ++i) {
+          int64_t h = y * p.sh - p.pt + m * p.dh;
+          int64_t w = x * p.sw - p.pl + n * p.dw;
+          bool valid = h >= 0 && h < p.ih && w >= 0 && w < p.iw;
+          *col++ = valid ? plane[h * p.iw + w] : 0;
+          if (++x == p.ow) {
+            x = 0;
+            ++y;
+          }
+        }
+      }
+    }
+  }
+}
+
+static inline float Epilogue(float x, int64_t c, const ConvParams& p) {
+  return _sn_rt_activate(p.bias == nullptr ? x : x + p.bias[c], p.activation,
+                         p.alpha);
+}
+
+// Applies the bias and activation to `rows` x `cols` outputs whose rows are
+// `ld` elements apart. The channel of an output is `c0` plus its row index if
+// `channel_rows` is true, or plus its column index otherwise.
+static void ApplyEpilogue(float* out, int64_t rows, int64_t cols, int64_t ld,
+                          int64_t c0, bool channel_rows, const ConvParams& p) {
+  if (p.bias == nullptr && p.activation == ActivationNone) {
+    return;
+  }
+  for (int64_t i = 0; i < rows; ++i) {
+    float* row = out + i * ld;
+    for (int64_t j = 0; j < cols; ++j) {
+      row[j] = Epilogue(row[j], c0 + (channel_rows ? i : j), p);
+    }
+  }
+}
+
+// Returns the number of output pixels (or tiles) to process at a time: at most
+// `max_chunk`, but small enough to give every thread a share of `total`.
+static int64_t ChunkSize(int64_t total, int64_t max_chunk, int64_t min_chunk) {
+  int64_t threads = _sn_rt_get_num_threads();
+  int64_t chunk = (total + threads - 1) / threads;
+  chunk = chunk > min_chunk ? chunk : min_chunk;
+  return chunk < max_chunk ? chunk : max_chunk;
+}
+
+static void ConvGemm(float* out, const float* in, const float* kernel,
+                     const ConvParams& p) {
+  int64_t cg = p.ic / p.group;
+  int64_t og = p.oc / p.group;
+  int64_t k = p.kh * p.kw * cg;
+  int64_t pixels = p.oh * p.ow;
+  bool is_1x1 = p.kh == 1 && p.kw == 1 && p.sh == 1 && p.sw == 1 &&
+                p.pt == 0 && p.pl == 0 && p.oh == p.ih && p.ow == p.iw;
+  if (is_1x1) {
+    // The GEMMs are large enough to be parallelized by themselves.
+    for (int64_t b = 0; b < p.batch; ++b) {
+      const float* in_b = in + b * p.ih * p.iw * p.ic;
+      float* out_b = out + b * pixels * p.oc;
+      for (int64_t g = 0; g < p.group; ++g) {
+        if (p.nchw) {
+          float* out_g = out_b + g * og * pixels;
+          _sn_rt_sgemm(out_g, kernel + g * og * cg, in_b + g * cg * pixels, og,
+                       pixels, cg, cg, 1, pixels, 1, pixels, false);
+          ParallelFor(og, ParallelGrain(pixels), [&](int64_t lo, int64_t hi) {
+            ApplyEpilogue(out_g + lo * pixels, hi - lo, pixels, pixels,
+                          g * og + lo, true, p);
+          });
+        } else {
+          float* out_g = out_b + g * og;
+          _sn_rt_sgemm(out_g, in_b + g * cg, kernel + g * og, pixels, og, cg,
+                       p.ic, 1, p.oc, 1, p.oc, false);
+          ParallelFor(pixels, ParallelGrain(og), [&](int64_t lo, int64_t hi) {
+            ApplyEpilogue(out_g + lo * p.oc, hi - lo, og, p.oc, g * og, false,
+                          p);
+          });
+        }
+      }
+    }
+    return;
+  }
+  constexpr int64_t min_pixels = 32;
+  int64_t chunk =
+      ChunkSize(p.batch * p.group * pixels, Im2colPixels, min_pixels);
+  int64_t chunks = (pixels + chunk - 1) / chunk;
+  ParallelFor(
+      p.batch * p.group * chunks, ParallelGrain(chunk * og * k),
+      [&](int64_t begin, int64_t end) {
+        float* col = AllocBuffer(chunk * k);
+        for (int64_t i = begin; i < end; ++i) {
+          int64_t b = i / (p.group * chunks);
+          int64_t g = i / chunks % p.group;
+          int64_t p0 = i % chunks * chunk;
+          int64_t np = pixels - p0 < chunk ? pixels - p0 : chunk;
+          const float* in_b = in + b * p.ih * p.iw * p.ic;
+          float* out_b = out + b * pixels * p.oc;
+          if (p.nchw) {
+            float* out_g = out_b + g * og * pixels + p0;
+            Im2colNCHW(col, in_b, p, g, p0, np);
+            _sn_rt_sgemm(out_g, kernel + g * og * k, col, og, np, k, k, 1, np,
+                         1, pixels, false);
+            ApplyEpilogue(out_g, og, np, pixels, g * og, true, p);
+          } else {
+            float* out_g = out_b + p0 * p.oc + g * og;
+            Im2colNHWC(col, in_b, p, g, p0, np);
+            _sn_rt_sgemm(out_g, col, kernel + g * og, np, og, k, k, 1, p.oc, 1,
+                         p.oc, false);
+            ApplyEpilogue(out_g, np, og, p.oc, g * og, false, p);
+          }
+        }
+        free(col);
+      });
+}
+
+static void ConvDepthwise(float* out, const float* in, const float* kernel,
+                          const ConvParams& p) {
+  int64_t c_num = p.ic;
+  if (!p.nchw) {
+    // One task computes an output row of all channels.
+    int64_t row_work = p.ow * p.kh * p.kw * c_num;
+    ParallelFor(p.batch * p.oh, ParallelGrain(row_work), [&](int64_t begin,
+                                                             int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        int64_t b = i / p.oh;
+        int64_t y = i % p.oh;
+        const float* in_b = in + b * p.ih * p.iw * c_num;
+        float* out_b = out + b * p.oh * p.ow * c_num;
+        int64_t h0 = y * p.sh - p.pt;
+        int64_t m_lo;
+        int64_t m_hi;
+        ValidTaps(h0, p.ih, p.kh, p.dh, &m_lo, &m_hi);
+        for (int64_t x = 0; x < p.ow; ++x) {
+          int64_t w0 = x * p.sw - p.pl;
+          int64_t n_lo;
+          int64_t n_hi;
+          ValidTaps(w0, p.iw, p.kw, p.dw, &n_lo, &n_hi);
+          float* __restrict o = out_b + (y * p.ow + x) * c_num;
+          memset(o, 0, c_num * sizeof(float));
+          for (int64_t m = m_lo; m < m_hi; ++m) {
+            for (int64_t n = n_lo; n < n_hi; ++n) {
+              const float* __restrict src =
+                  in_b + ((h0 + m * p.dh) * p.iw + w0 + n * p.dw) * c_num;
+              const float* __restrict w = kernel + (m * p.kw + n) * c_num;
+              for (int64_t c = 0; c < c_num; ++c) {
+                o[c] += src[c] * w[c];
+              }
+            }
+          }
+          ApplyEpilogue(o, 1, c_num, c_num, 0, false, p);
+        }
+      }
+    });
+    return;
+  }
+  // One task computes an output plane.
+  int64_t plane_work = p.oh * p.ow * p.kh * p.kw;
+  ParallelFor(p.batch * c_num, ParallelGrain(plane_work), [&](int64_t begin,
+                                                              int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t c = i % c_num;
+      const float* plane = in + i * p.ih * p.iw;
+      const float* w = kernel + c * p.kh * p.kw;
+      float* o = out + i * p.oh * p.ow;
+      for (int64_t y = 0; y < p.oh; ++y) {
+        int64_t h0 = y * p.sh - p.pt;
+        int64_t m_lo;
+        int64_t m_hi;
+        ValidTaps(h0, p.ih, p.kh, p.dh, &m_lo, &m_hi);
+        for (int64_t x = 0; x < p.ow; ++x) {
+          int64_t w0 = x * p.sw - p.pl;
+          int64_t n_lo;
+          int64_t n_hi;
+          ValidTaps(w0, p.iw, p.kw, p.dw, &n_lo, &n_hi);
+          float sum = 0;
+          for (int64_t m = m_lo; m < m_hi; ++m) {
+            const float* row = plane + (h0 + m * p.dh) * p.iw + w0;
+            for (int64_t n = n_lo; n < n_hi; ++n) {
+              sum += row[n * p.dw] * w[m * p.kw + n];
+            }
+          }
+          *o++ = Epilogue(sum, c, p);
+        }
+      }
+    }
+  });
+}
+
+// Winograd F(2x2, 3x3). Each 4x4 input tile d and 3x3 filter g are
+// transformed into V = B^T d B and U = G g G^T. The 16 element-wise products
+// are batched over channels as GEMMs, and each 2x2 output tile is A^T M A.
+// For NCHW, U[e] is oc x ic and V[e] is ic x tiles. For NHWC, V[e] is
+// tiles x ic and U[e] is ic x oc, so that channels stay innermost.
+static constexpr int64_t WinogradElems = 16;
+// Channels transformed together in NHWC. Generic vector types are lowered by
+// the compiler to the vector registers of the target.
+static constexpr int64_t WinogradLanes = 16;
+typedef float ChannelVec
+    __attribute__((vector_size(WinogradLanes * sizeof(float))));
+
+static inline void WinogradFilterTile(float u[4][4], const float g[3][3]) {
+  float t[4][3]; // G g
+  for (int64_t n = 0; n < 3; ++n) {
+    t[0][n] = g[0][n];
+    t[1][n] = (g[0][n] + g[1][n] + g[2][n]) * 0.5F;
+    t[2][n] = (g[0][n] - g[1][n] + g[2][n]) * 0.5F;
+    t[3][n] = g[2][n];
+  }
+  for (int64_t m = 0; m < 4; ++m) {
+    u[m][0] = t[m][0];
+    u[m][1] = (t[m][0] + t[m][1] + t[m][2]) * 0.5F;
+    u[m][2] = (t[m][0] - t[m][1] + t[m][2]) * 0.5F;
+    u[m][3] = t[m][2];
+  }
+}
+
+template <typename T>
+static inline void WinogradInputTile(T v[4][4], const T d[4][4]) {
+  T s[4][4]; // B^T d
+  for (int64_t n = 0; n < 4; ++n) {
+    s[0][n] = d[0][n] - d[2][n];
+    s[1][n] = d[1][n] + d[2][n];
+    s[2][n] = d[2][n] - d[1][n];
+    s[3][n] = d[1][n] - d[3][n];
+  }
+  for (int64_t m = 0; m < 4; ++m) {
+    v[m][0] = s[m][0] - s[m][2];
+    v[m][1] = s[m][1] + s[m][2];
+    v[m][2] = s[m][2] - s[m][1];
+    v[m][3] = s[m][1] - s[m][3];
+  }
+}
+
+template <typename T>
+static inline void WinogradOutputTile(T y[2][2], const T x[4][4]) {
+  T s[2][4]; // A^T x
+  for (int64_t n = 0; n < 4; ++n) {
+    s[0][n] = x[0][n] + x[1][n] + x[2][n];
+    s[1][n] = x[1][n] - x[2][n] - x[3][n];
+  }
+  for (int64_t m = 0; m < 2; ++m) {
+    y[m][0] = s[m][0] + s[m][1] + s[m][2];
+    y[m][1] = s[m][1] - s[m][2] - s[m][3];
+  }
+}
+
+static void WinogradInputNCHW(float* v, const float* in, const ConvParams& p,
+                              int64_t t0, int64_t nt, int64_t tiles_w) {
+  for (int64_t c = 0; c < p.ic; ++c) {
+    const float* plane = in + c * p.ih * p.iw;
+    for (int64_t t = 0; t < nt; ++t) {
+      int64_t h0 = (t0 + t) / tiles_w * 2 - p.pt;
+      int64_t w0 = (t0 + t) % tiles_w * 2 - p.pl;
+      float d[4][4];
+      for (int64_t m = 0; m < 4; ++m) {
+        int64_t h = h0 + m;
+        for (int64_t n = 0; n < 4; ++n) {
+          int64_t w = w0 + n;
+          bool valid = h >= 0 && h < p.ih && w >= 0 && w < p.iw;
+          d[m][n] = valid ? plane[h * p.iw + w] : 0;
+        }
+      }
+      float r[4][4];
+      WinogradInputTile(r, d);
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        v[(e * p.ic + c) * nt + t] = r[e / 4][e % 4];
+      }
+    }
+  }
+}
+
+static void WinogradInputNHWC(float* v, const float* in, const float* zeros,
+                              const ConvParams& p, int64_t t0, int64_t nt,
+                              int64_t tiles_w) {
+  for (int64_t t = 0; t < nt; ++t) {
+    int64_t h0 = (t0 + t) / tiles_w * 2 - p.pt;
+    int64_t w0 = (t0 + t) % tiles_w * 2 - p.pl;
+    const float* src[4][4];
+    for (int64_t m = 0; m < 4; ++m) {
+      int64_t h = h0 + m;
+      for (int64_t n = 0; n < 4; ++n) {
+        int64_t w = w0 + n;
+        bool valid = h >= 0 && h < p.ih && w >= 0 && w < p.iw;
+        src[m][n] = valid ? in + (h * p.iw + w) * p.ic : zeros;
+      }
+    }
+    float* dst = v + t * p.ic;
+    int64_t c = 0;
+    for (; c + WinogradLanes <= p.ic; c += WinogradLanes) {
+      ChannelVec d[4][4];
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        memcpy(&d[e / 4][e % 4], src[e / 4][e % 4] + c, sizeof(ChannelVec));
+      }
+      ChannelVec r[4][4];
+      WinogradInputTile(r, d);
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        memcpy(dst + e * nt * p.ic + c, &r[e / 4][e % 4], sizeof(ChannelVec));
+      }
+    }
+    for (; c < p.ic; ++c) {
+      float d[4][4];
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        d[e / 4][e % 4] = src[e / 4][e % 4][c];
+      }
+      float r[4][4];
+      WinogradInputTile(r, d);
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        dst[e * nt * p.ic + c] = r[e / 4][e % 4];
+      }
+    }
+  }
+}
+
+static void WinogradOutputNCHW(float* out, const float* mm,
+                               const ConvParams& p, int64_t t0, int64_t nt,
+                               int64_t tiles_w) {
+  for (int64_t o = 0; o < p.oc; ++o) {
+    float* plane = out + o * p.oh * p.ow;
+    for (int64_t t = 0; t < nt; ++t) {
+      float x[4][4];
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        x[e / 4][e % 4] = mm[(e * p.oc + o) * nt + t];
+      }
+      float y[2][2];
+      WinogradOutputTile(y, x);
+      int64_t y0 = (t0 + t) / tiles_w * 2;
+      int64_t x0 = (t0 + t) % tiles_w * 2;
+      for (int64_t m = 0; m < 2 && y0 + m < p.oh; ++m) {
+        for (int64_t n = 0; n < 2 && x0 + n < p.ow; ++n) {
+          plane[(y0 + m) * p.ow + x0 + n] = Epilogue(y[m][n], o, p);
+        }
+      }
+    }
+  }
+}
+
+static void WinogradOutputNHWC(float* out, const float* mm,
+                               const ConvParams& p, int64_t t0, int64_t nt,
+                               int64_t tiles_w) {
+  for (int64_t t = 0; t < nt; ++t) {
+    int64_t y0 = (t0 + t) / tiles_w * 2;
+    int64_t x0 = (t0 + t) % tiles_w * 2;
+    int64_t rows = p.oh - y0 < 2 ? p.oh - y0 : 2;
+    int64_t cols = p.ow - x0 < 2 ? p.ow - x0 : 2;
+    const float* src = mm + t * p.oc;
+    float* dst = out + (y0 * p.ow + x0) * p.oc;
+    int64_t o = 0;
+    for (; o + WinogradLanes <= p.oc; o += WinogradLanes) {
+      ChannelVec x[4][4];
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        memcpy(&x[e / 4][e % 4], src + e * nt * p.oc + o, sizeof(ChannelVec));
+      }
+      ChannelVec y[2][2];
+      WinogradOutputTile(y, x);
+      for (int64_t m = 0; m < rows; ++m) {
+        for (int64_t n = 0; n < cols; ++n) {
+          memcpy(dst + (m * p.ow + n) * p.oc + o, &y[m][n], sizeof(ChannelVec));
+        }
+      }
+    }
+    for (; o < p.oc; ++o) {
+      float x[4][4];
+      for (int64_t e = 0; e < WinogradElems; ++e) {
+        x[e / 4][e % 4] = src[e * nt * p.oc + o];
+      }
+      float y[2][2];
+      WinogradOutputTile(y, x);
+      for (int64_t m = 0; m < rows; ++m) {
+        for (int64_t n = 0; n < cols; ++n) {
+          dst[(m * p.ow + n) * p.oc + o] = y[m][n];
+        }
+      }
+    }
+    for (int64_t m = 0; m < rows; ++m) {
+      ApplyEpilogue(dst + m * p.ow * p.oc, cols, p.oc, p.oc, 0, false, p);
+    }
+  }
+}
+
+static void ConvWinograd(float* out, const float* in, const float* kernel,
+                         const ConvParams& p) {
+  constexpr int64_t E = WinogradElems;
+  int64_t ic = p.ic;
+  int64_t oc = p.oc;
+  float* u = AllocBuffer(E * oc * ic);
+  ParallelFor(oc, ParallelGrain(ic * E * 3), [&](int64_t begin, int64_t end) {
+    for (int64_t o = begin; o < end; ++o) {
+      for (int64_t c = 0; c < ic; ++c) {
+        float g[3][3];
+        for (int64_t m = 0; m < 3; ++m) {
+          for (int64_t n = 0; n < 3; ++n) {
+            g[m][n] = p.nchw ? kernel[((o * ic + c) * 3 + m) * 3 + n]
+                             : kernel[((m * 3 + n) * ic + c) * oc + o];
+          }
+        }
+        float r[4][4];
+        WinogradFilterTile(r, g);
+        for (int64_t e = 0; e < E; ++e) {
+          int64_t idx = p.nchw ? (e * oc + o) * ic + c : (e * ic + c) * oc + o;
+          u[idx] = r[e / 4][e % 4];
+        }
+      }
+    }
+  });
+
+  int64_t tiles_w = (p.ow + 1) / 2;
+  int64_t tiles = (p.oh + 1) / 2 * tiles_w;
+  constexpr int64_t min_tiles = 16;
+  int64_t chunk = ChunkSize(p.batch * tiles, WinogradTiles, min_tiles);
+  int64_t chunks = (tiles + chunk - 1) / chunk;
+  float* zeros = AllocBuffer(ic);
+  memset(zeros, 0, ic * sizeof(float));
+  ParallelFor(
+      p.batch * chunks, ParallelGrain(E * chunk * ic * oc),
+      [&](int64_t begin, int64_t end) {
+        float* v = AllocBuffer(E * ic * chunk);
+        float* mm = AllocBuffer(E * oc * chunk);
+        for (int64_t i = begin; i < end; ++i) {
+          int64_t b = i / chunks;
+          int64_t t0 = i % chunks * chunk;
+          int64_t nt = tiles - t0 < chunk ? tiles - t0 : chunk;
+          const float* in_b = in + b * p.ih * p.iw * ic;
+          float* out_b = out + b * p.oh * p.ow * oc;
+          if (p.nchw) {
+            WinogradInputNCHW(v, in_b, p, t0, nt, tiles_w);
+            for (int64_t e = 0; e < E; ++e) {
+              _sn_rt_sgemm(mm + e * oc * nt, u + e * oc * ic, v + e * ic * nt,
+                           oc, nt, ic, ic, 1, nt, 1, nt, false);
+            }
+            WinogradOutputNCHW(out_b, mm, p, t0, nt, tiles_w);
+          } else {
+            WinogradInputNHWC(v, in_b, zeros, p, t0, nt, tiles_w);
+            for (int64_t e = 0; e < E; ++e) {
+              _sn_rt_sgemm(mm + e * nt * oc, v + e * nt * ic, u + e * ic * oc,
+                           nt, oc, ic, ic, 1, oc, 1, oc, false);
+            }
+            WinogradOutputNHWC(out_b, mm, p, t0, nt, tiles_w);
+          }
+        }
+        free(v);
+        free(mm);
+      });
+  free(u);
+  free(zeros);
+}
 
 extern "C" {
 /// conv2d helper
+/// general implementation for both nchw and nhwc format. `bias` is per output
+/// channel and may be null; `activation` is a FusedActivation.
 void _sn_rt_conv2d_f32_helper(
     float* output, const float* data, const float* kernel, int64_t batch,
     int64_t spatial_h, int64_t spatial_w, int64_t channel, int64_t output_h,
     int64_t output_w, int64_t output_channel, int64_t kernel_h,
     int64_t kernel_w, int64_t stride_h, int64_t stride_w, int64_t pad_top,
-    int64_t pad_bottom, int64_t pad_left, int64_t pad_right, bool is_nchw) {
-  int64_t b, c, i, j, m, n, k;
-  int64_t h_offset = -pad_top;
-  int64_t w_offset = -pad_left;
-  const float lattic = 0;
-  for (b = 0; b < batch; ++b) {
-    for (c = 0; c < output_channel; ++c) {
-      for (i = 0; i < output_h; ++i) {
-        for (j = 0; j < output_w; ++j) {
-          // auto o_index =
-          //    c + (j + (i + b * output_h) * output_w) * output_channel;
-          auto o_index =
-              is_nchw ? _sn_rt_flatten_index_calculation(
-                            b, c, i, j, output_channel, output_h, output_w)
-                      : _sn_rt_flatten_index_calculation(
-                            b, i, j, c, output_h, output_w, output_channel);
-          float sum = 0;
-          for (m = 0; m < kernel_h; ++m) {
-            for (n = 0; n < kernel_w; ++n) {
-              for (k = 0; k < channel; ++k) {
-                auto curr_h = h_offset + i * stride_h + m;
-                auto curr_w = w_offset + j * stride_w + n;
-                // auto in_index =
-                //    k +
-                //    (curr_w + (curr_h + b * spatial_h) * spatial_w) * channel;
-                auto in_index = is_nchw ? _sn_rt_flatten_index_calculation(
-                                              b, k, curr_h, curr_w, channel,
-                                              spatial_h, spatial_w)
-                                        : _sn_rt_flatten_index_calculation(
-                                              b, curr_h, curr_w, k, spatial_h,
-                                              spatial_w, channel);
-                auto k_index =
-                    is_nchw ?
-                            // oihw
-                        _sn_rt_flatten_index_calculation(c, k, m, n, channel,
-                                                         kernel_h, kernel_w)
-                            :
-                            // hwio
-                        _sn_rt_flatten_index_calculation(
-                            m, n, k, c, kernel_w, channel, output_channel);
-                bool valid = curr_h >= 0 && curr_h < spatial_h && curr_w >= 0 &&
-                             curr_w < spatial_w;
-                auto value = valid ? data[in_index] : lattic;
-                sum += value * kernel[k_index];
-              }
-            }
-          }
-          output[o_index] = sum;
-        }
-      }
-    }
+    int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    int64_t dilation_h, int64_t dilation_w, int64_t group, bool is_nchw,
+    const float* bias, int64_t activation, float activation_alpha) {
+  ConvParams p{batch,      spatial_h,      spatial_w,  channel,  output_h,
+               output_w,   output_channel, kernel_h,   kernel_w, stride_h,
+               stride_w,   pad_top,        pad_left,   dilation_h,
+               dilation_w, group,          is_nchw,    bias,     activation,
+               activation_alpha};
+  if (p.group == p.ic && p.oc == p.ic && p.group > 1) {
+    ConvDepthwise(output, data, kernel, p);
+    return;
+  }
+  // Winograd pays off once the transforms are amortized over enough channels
+  // and the filter transform is amortized over enough output tiles.
+  constexpr int64_t winograd_min_channels = 8;
+  constexpr int64_t winograd_min_tiles = 64;
+  int64_t tiles = (p.oh + 1) / 2 * ((p.ow + 1) / 2);
+  if (p.group == 1 && p.kh == 3 && p.kw == 3 && p.sh == 1 && p.sw == 1 &&
+      p.dh == 1 && p.dw == 1 && p.ic >= winograd_min_channels &&
+      p.oc >= winograd_min_channels && tiles >= winograd_min_tiles) {
+    ConvWinograd(output, data, kernel, p);
+    return;
   }
+  ConvGemm(output, data, kernel, p);
 }
 
 void _sn_rt_conv2d_f32_nhwc(
@@ -87,11 +597,14 @@ void _sn_rt_conv2d_f32_nhwc(
     int64_t spatial_h, int64_t spatial_w, int64_t channel, int64_t output_h,
     int64_t output_w, int64_t output_channel, int64_t kernel_h,
     int64_t kernel_w, int64_t stride_h, int64_t stride_w, int64_t pad_top,
-    int64_t pad_bottom, int64_t pad_left, int64_t pad_right) {
+    int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    int64_t dilation_h, int64_t dilation_w, int64_t group, const float* bias,
+    int64_t activation, float activation_alpha) {
   return _sn_rt_conv2d_f32_helper(
       output, data, kernel, batch, spatial_h, spatial_w, channel, output_h,
       output_w, output_channel, kernel_h, kernel_w, stride_h, stride_w, pad_top,
-      pad_bottom, pad_left, pad_right, false /*is_nhwc*/);
+      pad_bottom, pad_left, pad_right, dilation_h, dilation_w, group,
+      false /*is_nchw*/, bias, activation, activation_alpha);
 }
 
 void _sn_rt_conv2d_f32_nchw(
@@ -99,10 +612,13 @@ void _sn_rt_conv2d_f32_nchw(
     int64_t spatial_h, int64_t spatial_w, int64_t channel, int64_t output_h,
     int64_t output_w, int64_t output_channel, int64_t kernel_h,
     int64_t kernel_w, int64_t stride_h, int64_t stride_w, int64_t pad_top,
-    int64_t pad_bottom, int64_t pad_left, int64_t pad_right) {
+    int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    int64_t dilation_h, int64_t dilation_w, int64_t group, const float* bias,
+    int64_t activation, float activation_alpha) {
   return _sn_rt_conv2d_f32_helper(
       output, data, kernel, batch, spatial_h, spatial_w, channel, output_h,
       output_w, output_channel, kernel_h, kernel_w, stride_h, stride_w, pad_top,
-      pad_bottom, pad_left, pad_right, true /*is_nhwc*/);
+      pad_bottom, pad_left, pad_right, dilation_h, dilation_w, group,
+      true /*is_nchw*/, bias, activation, activation_alpha);
+}
 }
-}
\ No newline at end of file
@@ -17,9 +17,105 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <limits>
 
-#include "utils.h"
+#include "../common/parallel.h"
+#include "../math/vec_math.h"
+
+// Returns in [*lo, *hi) the output positions whose window of `kernel`
+// elements, starting at pos * stride - pad, lies inside [0, size).
+static void InteriorRange(int64_t size, int64_t output, int64_t kernel,
+                          int64_t stride, int64_t pad, int64_t* lo,
+                          int64_t* hi) {
+  *lo = std::min((pad + stride - 1) / stride, output);
+  *hi = size + pad >= kernel ? (size + pad - kernel) / stride + 1 : 0;
+  *hi = std::max(*lo, std::min(*hi, output));
+}
+
+// Max pooling of one NCHW plane. Only the border outputs, whose windows
+// overlap the padding, clip their windows. The interior columns of an output
+// row are computed without bounds checks, one kernel tap at a time, which
+// is contiguous when the stride is 1.
+static void PoolingMaxPlane(float* output, const float* data,
+                            int64_t spatial_h, int64_t spatial_w,
+                            int64_t output_h, int64_t output_w,
+                            int64_t kernel_h, int64_t kernel_w,
+                            int64_t stride_h, int64_t stride_w,
+                            int64_t pad_top, int64_t pad_left) {
+  int64_t w_lo = 0;
+  int64_t w_hi = 0;
+  InteriorRange(spatial_w, output_w, kernel_w, stride_w, pad_left, &w_lo,
+                &w_hi);
+  const float lowest = std::numeric_limits<float>::lowest();
+  for (int64_t i = 0; i < output_h; ++i) {
+    float* out = output + i * output_w;
+    std::fill(out, out + output_w, lowest);
+    int64_t h0 = i * stride_h - pad_top;
+    int64_t m_begin = std::max<int64_t>(0, -h0);
+    int64_t m_end = std::min(kernel_h, spatial_h - h0);
+    for (int64_t m = m_begin; m < m_end; ++m) {
+      const float* in = data + (h0 + m) * spatial_w;
+      auto border = [&](int64_t j) {
+        int64_t w0 = j * stride_w - pad_left;
+        int64_t n_end = std::min(kernel_w, spatial_w - w0);
+        for (int64_t n = std::max<int64_t>(0, -w0); n < n_end; ++n) {
+          out[j] = std::max(out[j], in[w0 + n]);
+        }
+      };
+      for (int64_t j = 0; j < w_lo; ++j) {
+        border(j);
+      }
+      for (int64_t n = 0; n < kernel_w; ++n) {
+        const float* tap = in + w_lo * stride_w - pad_left + n;
+        int64_t j = w_lo;
+        if (stride_w == 1) {
+          for (; j + VecLanes <= w_hi; j += VecLanes) {
+            StoreVec(out + j,
+                     MaxVec(LoadVec(out + j), LoadVec(tap + j - w_lo)));
+          }
+        }
+        for (; j < w_hi; ++j) {
+          out[j] = std::max(out[j], tap[(j - w_lo) * stride_w]);
+        }
+      }
+      for (int64_t j = w_hi; j < output_w; ++j) {
+        border(j);
+      }
+    }
+  }
+}
+
+// Max pooling of one NHWC output row. Windows are clipped once per output
+// pixel and the channels, which are contiguous, are reduced in vectors.
+static void PoolingMaxRowNHWC(float* output, const float* data,
+                              int64_t spatial_h, int64_t spatial_w,
+                              int64_t channel, int64_t output_w,
+                              int64_t kernel_h, int64_t kernel_w,
+                              int64_t stride_w, int64_t pad_left, int64_t h0) {
+  const float lowest = std::numeric_limits<float>::lowest();
+  int64_t m_begin = std::max<int64_t>(0, -h0);
+  int64_t m_end = std::min(kernel_h, spatial_h - h0);
+  for (int64_t j = 0; j < output_w; ++j) {
+    float* out = output + j * channel;
+    std::fill(out, out + channel, lowest);
+    int64_t w0 = j * stride_w - pad_left;
+    int64_t n_begin = std::max<int64_t>(0, -w0);
+    int64_t n_end = std::min(kernel_w, spatial_w - w0);
+    for (int64_t m = m_begin; m < m_end; ++m) {
+      for (int64_t n = n_begin; n < n_end; ++n) {
+        const float* in = data + ((h0 + m) * spatial_w + w0 + n) * channel;
+        int64_t c = 0;
+        for (; c + VecLanes <= channel; c += VecLanes) {
+          StoreVec(out + c, MaxVec(LoadVec(out + c), LoadVec(in + c)));
+        }
+        for (; c < channel; ++c) {
+          out[c] = std::max(out[c], in[c]);
+        }
+      }
+    }
+  }
+}
 
 extern "C" {
 /// pooling max helper func
@@ -30,45 +126,35 @@ void _sn_rt_poolingmax_f32_helper(
     int64_t kernel_h, int64_t kernel_w, int64_t stride_h, int64_t stride_w,
     int64_t pad_top, int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
     bool is_nchw) {
-  int64_t b, c, i, j, m, n;
-  int64_t h_offset = -pad_top;
-  int64_t w_offset = -pad_left;
-  const float lattic = std::numeric_limits<float>::lowest();
-  for (b = 0; b < batch; ++b) {
-    for (c = 0; c < channel; ++c) {
-      for (i = 0; i < output_h; ++i) {
-        for (j = 0; j < output_w; ++j) {
-          // auto o_index = c + (j + (i + b * output_h) * output_w) * channel;
-          auto o_index = is_nchw ? _sn_rt_flatten_index_calculation(
-                                       b, c, i, j, channel, output_h, output_w)
-                                 : _sn_rt_flatten_index_calculation(
-                                       b, i, j, c, output_h, output_w, channel);
-          float max = std::numeric_limits<float>::lowest();
-          for (m = 0; m < kernel_h; ++m) {
-            for (n = 0; n < kernel_w; ++n) {
-              auto curr_h = h_offset + i * stride_h + m;
-              auto curr_w = w_offset + j * stride_w + n;
-              // auto in_index =
-              //    c + (curr_w + (curr_h + b * spatial_h) * spatial_w) *
-              //    channel;
-              auto in_index =
-                  is_nchw
-                      ? _sn_rt_flatten_index_calculation(
-                            b, c, curr_h, curr_w, channel, spatial_h, spatial_w)
-                      : _sn_rt_flatten_index_calculation(b, curr_h, curr_w, c,
-                                                         spatial_h, spatial_w,
-                                                         channel);
-              bool valid = curr_h >= 0 && curr_h < spatial_h && curr_w >= 0 &&
-                           curr_w < spatial_w;
-              auto value = valid ? data[in_index] : lattic;
-              max = max > value ? max : value;
-            }
-          }
-          output[o_index] = max;
-        }
-      }
-    }
+  if (is_nchw) {
+    // Each (batch, channel) output plane is computed independently.
+    int64_t plane_work = output_h * output_w * kernel_h * kernel_w;
+    ParallelFor(batch * channel, ParallelGrain(plane_work),
+                [&](int64_t begin, int64_t end) {
+                  for (int64_t bc = begin; bc < end; ++bc) {
+                    PoolingMaxPlane(output + bc * output_h * output_w,
+                                    data + bc * spatial_h * spatial_w,
+                                    spatial_h, spatial_w, output_h, output_w,
+                                    kernel_h, kernel_w, stride_h, stride_w,
+                                    pad_top, pad_left);
+                  }
+                });
+    return;
   }
+  // Each (batch, output row) is computed independently.
+  int64_t row_work = output_w * channel * kernel_h * kernel_w;
+  ParallelFor(batch * output_h, ParallelGrain(row_work),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t bi = begin; bi < end; ++bi) {
+                  int64_t b = bi / output_h;
+                  int64_t i = bi % output_h;
+                  PoolingMaxRowNHWC(
+                      output + bi * output_w * channel,
+                      data + b * spatial_h * spatial_w * channel, spatial_h,
+                      spatial_w, channel, output_w, kernel_h, kernel_w,
+                      stride_w, pad_left, i * stride_h - pad_top);
+                }
+              });
 }
 
 void _sn_rt_poolingmax_f32_nhwc(
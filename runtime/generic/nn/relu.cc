@@ -18,7 +18,7 @@
 #include <stdint.h>
 
 extern "C" {
-/// A dummy implementation.
+/// A dummy implementation. `out` may alias the input for in-place execution.
 void _sn_rt_relu_f32(float* out, const float* in, int64_t len) {
   for (int64_t i = 0; i < len; ++i) {
     out[i] = in[i] < 0 ? 0 : in[i];
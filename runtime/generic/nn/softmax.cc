@@ -15,14 +15,50 @@
 // limitations under the License.
 // =============================================================================
 
-#include <algorithm>
-#include <cmath>
-#include <cstdint>
-#include <limits>
-#include <vector>
+#include <stdint.h>
+
+#include "../common/parallel.h"
+#include "../math/vec_math.h"
+
+// Computes the softmax of one contiguous row of n elements. The max and the
+// sum are accumulated in vector registers, and exp(x - max) is written to
+// the result and summed in the same pass, so no temporary buffer is needed.
+static void SoftmaxRow(float* result, const float* x, int64_t n) {
+  float max_value = x[0];
+  int64_t i = 0;
+  if (n >= VecLanes) {
+    FloatVec max_vec = LoadVec(x);
+    for (i = VecLanes; i + VecLanes <= n; i += VecLanes) {
+      max_vec = MaxVec(max_vec, LoadVec(x + i));
+    }
+    max_value = HorizontalMax(max_vec);
+  }
+  for (; i < n; ++i) {
+    max_value = max_value > x[i] ? max_value : x[i];
+  }
+
+  FloatVec sum_vec = {};
+  const FloatVec max_splat = SplatVec(max_value);
+  for (i = 0; i + VecLanes <= n; i += VecLanes) {
+    FloatVec e = _sn_rt_exp_vec(LoadVec(x + i) - max_splat);
+    StoreVec(result + i, e);
+    sum_vec += e;
+  }
+  float sum = HorizontalSum(sum_vec);
+  for (; i < n; ++i) {
+    result[i] = _sn_rt_exp_f32(x[i] - max_value);
+    sum += result[i];
+  }
+
+  const float scale = 1.0F / sum;
+  for (i = 0; i < n; ++i) {
+    result[i] *= scale;
+  }
+}
 
 extern "C" {
-/// softmax with fp32.
+/// softmax with fp32. It normalizes over the elements from `axis` to the
+/// last dimension.
 void _sn_rt_softmax_f32(float* result, const float* logits,
                         const int64_t* shape, int32_t axis, int32_t dim,
                         int64_t num_of_elements) {
@@ -30,21 +66,16 @@ void _sn_rt_softmax_f32(float* result, const float* logits,
   for (int d = axis; d < dim; ++d) {
     after *= shape[d];
   }
-  float temp[after];
-  // std::vector<float> temp(after);
-  int64_t before = num_of_elements / after;
-  for (int i = 0; i < before; ++i) {
-    float sum = 0;
-    int64_t index = i * after;
-
-    float max_value = *std::max_element(logits + index, logits + index + after);
-    for (int j = 0; j < after; ++j) {
-      temp[j] = std::exp(logits[j + index] - max_value);
-      sum += temp[j];
-    }
-    for (int j = 0; j < after; ++j) {
-      result[j + index] = temp[j] / sum;
-    }
+  if (after == 0) {
+    return;
   }
+  int64_t before = num_of_elements / after;
+  // max, exp and normalization cost about 10 operations per element.
+  ParallelFor(before, ParallelGrain(after * 10),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t i = begin; i < end; ++i) {
+                  SoftmaxRow(result + i * after, logits + i * after, after);
+                }
+              });
+}
 }
-}
\ No newline at end of file
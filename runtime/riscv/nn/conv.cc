@@ -25,5 +25,7 @@ void _sn_rt_conv2d_f32_nhwc(
     int64_t spatial_h, int64_t spatial_w, int64_t channel, int64_t output_h,
     int64_t output_w, int64_t output_channel, int64_t kernel_h,
     int64_t kernel_w, int64_t stride_h, int64_t stride_w, int64_t pad_top,
-    int64_t pad_bottom, int64_t pad_left, int64_t pad_right);
+    int64_t pad_bottom, int64_t pad_left, int64_t pad_right,
+    int64_t dilation_h, int64_t dilation_w, int64_t group, const float* bias,
+    int64_t activation, float activation_alpha);
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+
+using namespace halo;
+
+int main() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  ConstantBuilder c_builder(func);
+  c_builder.CreateConstant("w0", Type(DataType::FLOAT32, {2, 3}),
+                           std::vector<float>{1, 2, 3, 4, 5, 6});
+  c_builder.CreateConstant("layer/w1", Type(DataType::INT64, {3}),
+                           std::vector<int64_t>{7, 8, 9});
+
+  std::ostringstream blob;
+  std::ostringstream stub;
+  std::ostringstream header;
+  PassManager pm(ctx);
+  pm.AddPass<GenericCXXBlobConstantWriter>(std::ref(blob), std::ref(stub),
+                                           std::ref(header), "test.data.bin");
+  pm.Run(&m);
+
+  const std::string data = blob.str();
+  // CHECK: blob size: 128
+  std::cout << "blob size: " << data.size() << "\n";
+  const auto* w0 = reinterpret_cast<const float*>(data.data());
+  const auto* w1 = reinterpret_cast<const int64_t*>(
+      data.data() + GenericCXXBlobConstantWriter::Alignment);
+  // CHECK: w0: 1 6 w1: 7 9
+  std::cout << "w0: " << w0[0] << " " << w0[5] << " w1: " << w1[0] << " "
+            << w1[2] << "\n";
+
+  std::cout << stub.str() << header.str();
+  // clang-format off
+  // CHECK: .section .rodata.test_module_constants,"a",@progbits
+  // CHECK: test_module_constants:
+  // CHECK: .globl w0
+  // CHECK-NEXT: .type w0, @object
+  // CHECK-NEXT: .size w0, 24
+  // CHECK-NEXT: w0:
+  // CHECK-NEXT: .incbin "test.data.bin", 0, 24
+  // CHECK-NEXT: .balign 64
+  // CHECK-NEXT: .globl layer_w1
+  // CHECK-NEXT: .type layer_w1, @object
+  // CHECK-NEXT: .size layer_w1, 24
+  // CHECK-NEXT: layer_w1:
+  // CHECK-NEXT: .incbin "test.data.bin", 64, 24
+  // CHECK-NEXT: .balign 64
+  // CHECK-NEXT: .size test_module_constants, 128
+  // CHECK-NEXT: .section .note.GNU-stack,"",@progbits
+  // CHECK: extern const unsigned char test_module_constants[];
+  // CHECK-NEXT: static const size_t w0_offset = 0;
+  // CHECK-NEXT: static const size_t layer_w1_offset = 64;
+  // CHECK-NEXT: static const size_t test_module_constants_size = 128;
+  // clang-format on
+}
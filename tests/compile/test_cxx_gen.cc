@@ -38,9 +38,11 @@
 
 // GEN: void func(const float input[3], float out_add1[3]) {
 // GEN:  func_init();
+// GEN:  std::lock_guard<std::mutex> lock(CompMutex);
+// GEN-NEXT: RunComp = Comp;
 // GEN:  odla_BindToArgumentById((const odla_value_id)"input", input, Ctx);
 // GEN:  odla_BindToOutputById((const odla_value_id)"add1", out_add1, Ctx);
-// GEN:  odla_ExecuteComputation(Comp, Ctx, ODLA_COMPUTE_INFERENCE, nullptr);
+// GEN:  odla_ExecuteComputation(RunComp, Ctx, ODLA_COMPUTE_INFERENCE, nullptr);
 // GEN: }
 
 
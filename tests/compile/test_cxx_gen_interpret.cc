@@ -0,0 +1,99 @@
+//===- test_cxx_gen_interpret.cc ------------------------------------------===//
+//
+// Copyright (C) 2019-2020 Alibaba Group Holding Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// clang-format off
+
+// RUN: %cxx %s -DCG_TEST -o %t %flags %include %link
+// RUN: %t > %t.gen.cc
+// RUN: cat %t.gen.cc | FileCheck %s --check-prefix=GEN
+
+// The values created by a run are released by it, so repeated runs do not
+// accumulate them in the runtime.
+// RUN: %cxx %s -DRUNTIME_TEST -I%odla_path/include -c -o %t.main.o
+// RUN: %cxx %t.gen.cc -I%odla_path/include -c -o %t.gen.o
+// RUN: %cxx %t.gen.o %t.main.o %odla_link -lodla_eigen -lpthread -o %t.exe
+// RUN: %t.exe 2>&1| FileCheck %s --check-prefix=EXECUTE
+
+// GEN: odla_GetValueData(add1, out_add1);
+// GEN-NEXT: odla_ReleaseValue(in_input);
+// GEN-NEXT: odla_ReleaseValue(w0_);
+// GEN-NEXT: odla_ReleaseValue(w1_);
+// GEN-NEXT: odla_ReleaseValue(add0);
+// GEN-NEXT: odla_ReleaseValue(add1);
+// GEN-NEXT: }
+
+// EXECUTE: 6.000000
+// EXECUTE: 9.000000
+// EXECUTE: 12.000000
+
+// clang-format on
+
+#ifdef CG_TEST
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+int main() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  Type ty(DataType::FLOAT32, {3});
+  ArgumentBuilder arg_builder(func);
+  auto input = arg_builder.CreateArgument("input", ty);
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+  ConstantBuilder c_builder(func);
+  auto c0 = c_builder.CreateConstant("w0", ty, std::vector<float>{1, 2, 3});
+  auto c1 = c_builder.CreateConstant("w1", ty, std::vector<float>{4, 5, 6});
+  IRBuilder ir_builder(bb);
+  Instruction* add0 = ir_builder.CreateAdd("add0", *input, *c0);
+  Instruction* add1 = ir_builder.CreateAdd("add1", *add0, *c1);
+  ir_builder.CreateReturn("ret", *add1);
+
+  Opts opts;
+  opts.exec_mode = CodeGen::ExecMode::Interpret;
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<GenericCXXCodeGen>(std::ref(std::cout), std::ref(std::cout),
+                                opts);
+  pm.Run(&m);
+}
+#endif
+
+#ifdef RUNTIME_TEST
+#include <stdio.h>
+
+extern "C" {
+float w0[] = {1, 2, 3}, w1[] = {4, 5, 6};
+extern void func(const float* in, float* out);
+}
+
+int main() {
+  float a[] = {1, 2, 3}, b[3];
+  for (int i = 0; i < 1000; ++i) {
+    func(a, b);
+  }
+  for (int i = 0; i < 3; ++i) {
+    printf("%f\n", b[i]);
+  }
+}
+#endif
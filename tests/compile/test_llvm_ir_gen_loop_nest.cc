@@ -0,0 +1,98 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/generic_llvmir/generic_llvmir_codegen.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto a = arg_builder.CreateArgument("a", Type{DataType::FLOAT32, {64, 256}});
+  auto b = arg_builder.CreateArgument("b", Type{DataType::FLOAT32, {256}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  IRBuilder ir_builder(bb);
+
+  Instruction* add = ir_builder.CreateAdd("add", *a, *b);
+  Instruction* sqrt = ir_builder.CreateSqrt("sqrt", *add);
+  ir_builder.CreateReturn("ret", *sqrt);
+
+  // simulate the driver's argv[0] by reading from env var.
+  ctx.SetBasePath(getenv("HALO_BASE_PATH"));
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  auto cg = pm.AddPass<GenericLLVMIRCodeGen>();
+  cg->SetLoweringMode(GenericLLVMIRCodeGen::LoweringMode::LoopNest);
+  pm.AddPass<GenericLLVMIRWriter>(std::ref(std::cout), false);
+
+  pm.Run(&m);
+
+  // The broadcast add and the sqrt are vectorized loops, not runtime calls.
+  // CHECK-LABEL: define void @func(
+  // CHECK-NOT: @_sn_rt_
+  // CHECK: fadd <{{[0-9]+}} x float>
+  // CHECK-NOT: @_sn_rt_
+  // CHECK: @llvm.sqrt.v{{[0-9]+}}f32
+  // CHECK-NOT: @_sn_rt_
+  // CHECK: ret void
+}
+
+// A runtime call after a loop nest gets its stack buffer in the entry block.
+void build_after_loop() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func_after_loop");
+
+  ArgumentBuilder arg_builder(func);
+  auto a = arg_builder.CreateArgument("a", Type{DataType::FLOAT32, {64, 256}});
+  auto b = arg_builder.CreateArgument("b", Type{DataType::FLOAT32, {256}});
+  auto w = arg_builder.CreateArgument("w", Type{DataType::FLOAT32, {256, 4}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  IRBuilder ir_builder(bb);
+
+  Instruction* add = ir_builder.CreateAdd("add", *a, *b);
+  Instruction* mm = ir_builder.CreateMatMul("mm", {*add, *w});
+  ir_builder.CreateReturn("ret", *mm);
+
+  ctx.SetBasePath(getenv("HALO_BASE_PATH"));
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  auto cg = pm.AddPass<GenericLLVMIRCodeGen>();
+  cg->SetLoweringMode(GenericLLVMIRCodeGen::LoweringMode::LoopNest);
+  pm.AddPass<GenericLLVMIRWriter>(std::ref(std::cout), false);
+
+  pm.Run(&m);
+
+  // CHECK-LABEL: define void @func_after_loop(
+  // CHECK-NOT: br
+  // CHECK: %mm = alloca
+  // CHECK: br
+  // CHECK: @_sn_rt_matmul
+  // CHECK: ret void
+}
+
+int main() {
+  build();
+  build_after_loop();
+}
@@ -0,0 +1,139 @@
+// RUN: %cc -c %odla_path/platforms/odla_constants_array.c \
+// RUN:   -I%odla_path/include -o %t.o
+// RUN: %cxx %s %t.o -o %t %flags %include -I%odla_path/include %link
+// RUN: %t %t.weights 2>&1| FileCheck %s
+
+#include <ODLA/odla.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/weights_file_writer.h"
+
+using namespace halo;
+
+// The constants are bound in place, so the "backend" just returns the data
+// pointer it was given.
+extern "C" odla_value odla_CreateConstant(odla_value_type type,
+                                          const odla_void* data_ptr,
+                                          const odla_value_id id) {
+  return reinterpret_cast<odla_value>(const_cast<odla_void*>(data_ptr));
+}
+
+static void Write(const char* file_name) {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  ConstantBuilder c_builder(func);
+  c_builder.CreateConstant("w0", Type(DataType::FLOAT32, {2, 3}),
+                           std::vector<float>{1, 2, 3, 4, 5, 6});
+  c_builder.CreateConstant("w1", Type(DataType::INT64, {3}),
+                           std::vector<int64_t>{7, 8, 9});
+  // Another function with the same weights, e.g., after splitting.
+  Function* func2 = func_builder.CreateFunction("func2");
+  ConstantBuilder c_builder2(func2);
+  c_builder2.CreateConstant("w0_copy", Type(DataType::FLOAT32, {2, 3}),
+                            std::vector<float>{1, 2, 3, 4, 5, 6});
+  // Same name as a constant of `func`.
+  c_builder2.CreateConstant("w1", Type(DataType::INT64, {3}),
+                            std::vector<int64_t>{10, 11, 12});
+  ConstantBuilder m_builder(&m);
+  m_builder.CreateConstant("m0", Type(DataType::INT64, {3}),
+                           std::vector<int64_t>{13, 14, 15});
+
+  std::ofstream ofs(file_name, std::ofstream::binary);
+  PassManager pm(ctx);
+  pm.AddPass<WeightsFileWriter>(std::ref(ofs));
+  pm.Run(&m);
+}
+
+static void Load(const char* file_name) {
+  odla_constants_array array = nullptr;
+  // CHECK: load: 0
+  std::cout << "load: " << odla_LoadConstantsArray(file_name, &array) << "\n";
+
+  odla_value_type w0_type{ODLA_FLOAT32, {2, {2, 3}}};
+  odla_value_type w1_type{ODLA_INT64, {1, {3}}};
+  const auto* w0 = reinterpret_cast<const float*>(
+      odla_CreateConstantFromArray(array, w0_type, "func/w0", nullptr));
+  const auto* w1 = reinterpret_cast<const int64_t*>(
+      odla_CreateConstantFromArray(array, w1_type, "func/w1", nullptr));
+
+  constexpr uintptr_t alignment = WeightsFileWriter::Alignment;
+  // CHECK: aligned: 1 1
+  std::cout << "aligned: " << (reinterpret_cast<uintptr_t>(w0) % alignment == 0)
+            << " " << (reinterpret_cast<uintptr_t>(w1) % alignment == 0)
+            << "\n";
+  // CHECK: w0: 1 2 3 4 5 6
+  std::cout << "w0:";
+  for (int i = 0; i < 6; ++i) {
+    std::cout << " " << w0[i];
+  }
+  // CHECK: w1: 7 8 9
+  std::cout << "\nw1:";
+  for (int i = 0; i < 3; ++i) {
+    std::cout << " " << w1[i];
+  }
+  std::cout << "\n";
+
+  // The duplicated weights are stored once.
+  const auto* w0_copy = reinterpret_cast<const float*>(
+      odla_CreateConstantFromArray(array, w0_type, "func2/w0_copy", nullptr));
+  // CHECK: shared: 1
+  std::cout << "shared: " << (w0_copy == w0) << "\n";
+
+  // Constants are qualified by their function; module constants are not.
+  const auto* w1_2 = reinterpret_cast<const int64_t*>(
+      odla_CreateConstantFromArray(array, w1_type, "func2/w1", nullptr));
+  const auto* m0 = reinterpret_cast<const int64_t*>(
+      odla_CreateConstantFromArray(array, w1_type, "m0", nullptr));
+  // CHECK: func2/w1: 10 m0: 13
+  std::cout << "func2/w1: " << w1_2[0] << " m0: " << m0[0] << "\n";
+
+  // CHECK: missing: 1
+  std::cout << "missing: "
+            << (odla_CreateConstantFromArray(array, w0_type, "func/w2",
+                                             nullptr) == nullptr)
+            << "\n";
+  odla_value_type bad_type{ODLA_FLOAT32, {1, {4}}};
+  // CHECK: size mismatch: 1
+  std::cout << "size mismatch: "
+            << (odla_CreateConstantFromArray(array, bad_type, "func/w0",
+                                             nullptr) == nullptr)
+            << "\n";
+  odla_DestroyConstantsArray(array);
+}
+
+static void External() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  ConstantBuilder c_builder(func);
+
+  auto data = std::make_shared<std::vector<float>>(std::vector<float>{1, 2});
+  Constant* c = c_builder.CreateExternalConstant(
+      "ext", Type(DataType::FLOAT32, {2}), data->data(), data);
+
+  const Constant* cc = c;
+  // CHECK: external: 1 1
+  std::cout << "external: " << c->IsExternal() << " "
+            << (cc->GetDataPtr<float>() == data->data()) << "\n";
+  // Writing through the constant copies the data first.
+  c->GetDataPtr<float>()[0] = 3;
+  // CHECK: after write: 0 1 3
+  std::cout << "after write: " << c->IsExternal() << " " << (*data)[0] << " "
+            << cc->GetData<float>(0) << "\n";
+}
+
+int main(int argc, char** argv) {
+  Write(argv[1]);
+  Load(argv[1]);
+  External();
+}
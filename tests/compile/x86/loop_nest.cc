@@ -0,0 +1,88 @@
+// RUN: %cxx %s -o %t %flags %include %link -DBUILD_IR
+// RUN: %t > %t.obj
+// RUN: %cxx %s %t.obj %flags -static -o %t2
+// RUN: %t2  2>&1| FileCheck %s
+
+#ifdef BUILD_IR
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/cpu/x86/binary/x86_llvmir_codegen.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/inst_simplify.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void Build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto a = arg_builder.CreateArgument("a", Type{DataType::FLOAT32, {2, 3}});
+  auto b = arg_builder.CreateArgument("b", Type{DataType::FLOAT32, {3}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  std::vector<int> perm{1, 0};
+  auto perm_c =
+      c_builder.CreateConstant("perm", Type{DataType::INT32, {2}}, perm.data());
+  std::vector<int> pads{0, 1, 0, 2};
+  auto pads_c = c_builder.CreateConstant("pads", Type{DataType::INT32, {2, 2}},
+                                         pads.data());
+  std::vector<int> axis{1};
+  auto axis_c =
+      c_builder.CreateConstant("axis", Type{DataType::INT32, {1}}, axis.data());
+
+  IRBuilder ir_builder(bb);
+
+  // [2, 3] + [3] -> transpose to [3, 2] -> pad to [4, 4] -> mean over axis 1.
+  Instruction* add = ir_builder.CreateAdd("add", *a, *b);
+  Instruction* transpose =
+      ir_builder.CreateTranspose("transpose", {*add, *perm_c});
+  Instruction* pad =
+      ir_builder.CreatePad("pad", std::vector<Def>{*transpose, *pads_c});
+  Instruction* reduce = ir_builder.CreateReduceMean("reduce", *pad, *axis_c);
+  ir_builder.CreateReturn("ret", *reduce);
+
+  // simulate the driver's argv[0] by reading from env var.
+  ctx.SetBasePath(getenv("HALO_BASE_PATH"));
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>(true);
+  pm.AddPass<DCE>();
+  pm.AddPass<InstSimplify>();
+  auto cg = pm.AddPass<X86LLVMIRCodeGen>();
+  cg->SetLoweringMode(GenericLLVMIRCodeGen::LoweringMode::LoopNest);
+  pm.AddPass<X86BinaryWriter>(std::ref(std::cout));
+
+  pm.Run(&m);
+}
+
+int main() { Build(); }
+
+#else
+
+#include <stdio.h>
+
+extern "C" {
+extern void func(const float* a, const float* b, float* output);
+}
+
+int main() {
+  const float a[] = {1, 2, 3, 4, 5, 6};
+  const float b[] = {10, 20, 30};
+  float output[4] = {0.0};
+  func(a, b, output);
+  // CHECK: 6.250000 11.750000 17.250000 0.000000
+  for (int i = 0; i < 4; ++i) {
+    printf("%f ", output[i]);
+  }
+}
+#endif
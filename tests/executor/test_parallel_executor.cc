@@ -0,0 +1,91 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include "halo/lib/executor/parallel_executor.h"
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input =
+      arg_builder.CreateArgument("input", Type{DataType::FLOAT32, {1, 1024}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  IRBuilder ir_builder(bb);
+
+  // Two branches of different lengths.
+  Instruction* relu0 = ir_builder.CreateRelu("relu0", *input);
+  Instruction* a1 = ir_builder.CreateRelu("a1", *relu0);
+  Instruction* b1 = ir_builder.CreateRelu("b1", *relu0);
+  Instruction* a2 = ir_builder.CreateRelu("a2", *a1);
+  Instruction* add = ir_builder.CreateAdd("add", *a2, *b1);
+  ir_builder.CreateReturn("ret", *add);
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.Run(&m);
+
+  ParallelExecutor executor(*func);
+  executor.Print(std::cout);
+
+  // CHECK: Parallel schedule: 6 instructions in 5 groups, max width 2
+  // CHECK-NEXT: Critical path: 4097 of 5121 (speedup 1.24994x)
+  // CHECK-NEXT: Group 0: relu0
+  // CHECK-NEXT: Group 1: a1 b1
+  // CHECK-NEXT: Group 2: a2
+  // CHECK-NEXT: Group 3: add
+  // CHECK-NEXT: Group 4: ret
+
+  // Every instruction runs after its operands.
+  ThreadPool pool(4);
+  std::mutex mutex;
+  std::unordered_set<const Instruction*> done;
+  bool valid = true;
+  executor.Run(&pool, [&](Instruction* inst) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& op : inst->GetOperands()) {
+      const auto* def = DynCast<Instruction>(op.GetOwner());
+      valid &= def == nullptr || done.count(def) > 0;
+    }
+    done.insert(inst);
+  });
+  std::cout << "Ran " << done.size() << " instructions, valid: " << valid
+            << "\n";
+  // CHECK: Ran 6 instructions, valid: 1
+
+  // Run waits for the instructions only, not for other tasks on the pool.
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  pool.Schedule([&]() {
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    finished = true;
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  executor.Run(&pool, [](Instruction* /*inst*/) {});
+  std::cout << "Other task finished: " << finished << "\n";
+  // CHECK: Other task finished: 0
+  pool.Wait();
+}
+
+int main() { build(); }
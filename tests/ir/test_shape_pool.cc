@@ -0,0 +1,58 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "halo/lib/framework/global_context.h"
+#include "halo/lib/framework/shape_pool.h"
+#include "halo/lib/framework/type.h"
+
+using namespace halo;
+
+void build() {
+  Type small;
+  Type large;
+  {
+    GlobalContext ctx;
+    small = Type(DataType::FLOAT32, {2, 3});
+    large = Type(DataType::FLOAT32, {1, 2, 3, 4, 5, 6, 7});
+  }
+  // Types are values, which outlive the global context they are created in.
+  // CHECK: small: [FLOAT32: 2x3] large: [FLOAT32: 1x2x3x4x5x6x7]
+  std::cout << "small: ";
+  small.Print(std::cout);
+  std::cout << " large: ";
+  large.Print(std::cout);
+  std::cout << "\n";
+
+  // Short shapes are stored inline and long ones are uniqued.
+  Type small_copy = small;
+  Type large_other(DataType::INT8, {1, 2, 3, 4, 5, 6, 7});
+  // CHECK: inline: 1 equal: 1 shared: 1 equal: 1
+  std::cout << "inline: "
+            << (small.GetDimSizes().data() != small_copy.GetDimSizes().data())
+            << " equal: " << (small == small_copy) << " shared: "
+            << (large.GetDimSizes().data() == large_other.GetDimSizes().data())
+            << " equal: " << (large.GetDimSizes() == large_other.GetDimSizes())
+            << "\n";
+
+  // Threads add to a pool concurrently.
+  ShapePool pool;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, t] {
+      for (int i = 0; i < 1000; ++i) {
+        pool.Get({i % 100, t % 2});
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // CHECK: shapes: 200
+  std::cout << "shapes: " << pool.GetNumOfShapes() << "\n";
+}
+
+int main() { build(); }
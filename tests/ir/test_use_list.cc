@@ -0,0 +1,65 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <iostream>
+
+#include "halo/lib/ir/ir_builder.h"
+
+using namespace halo;
+
+static void PrintUses(const Def& def) {
+  std::cout << def.GetOwner()->GetName() << ":";
+  for (const auto& use : def.GetUses()) {
+    std::cout << " " << use.GetUse()->GetName() << "#"
+              << use.GetUseOperandIdx();
+  }
+  std::cout << "\n";
+}
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  Type ty(DataType::FLOAT32, {2, 3});
+  auto a = arg_builder.CreateArgument("a", ty);
+  auto b = arg_builder.CreateArgument("b", ty);
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  IRBuilder ir_builder(bb);
+  auto add = ir_builder.CreateAdd("add", *a, *a);
+  auto mul = ir_builder.CreateMul("mul", *a, *add);
+  auto ret = ir_builder.CreateReturn("ret", *mul);
+
+  PrintUses(*a);
+  // CHECK: a: add#0 add#1 mul#0
+  add->ReplaceOperandWith(1, *b);
+  PrintUses(*a);
+  PrintUses(*b);
+  // CHECK-NEXT: a: add#0 mul#0
+  // CHECK-NEXT: b: add#1
+  a->ReplaceAllUsesWith(0, *b);
+  PrintUses(*a);
+  PrintUses(*b);
+  // CHECK-NEXT: a:
+  // CHECK-NEXT: b: add#1 add#0 mul#0
+  ret->ReplaceOperandWith(0, *add);
+  mul->DropAllOperands();
+  PrintUses(*b);
+  PrintUses(*add);
+  // CHECK-NEXT: b: add#1 add#0
+  // CHECK-NEXT: add: ret#0
+
+  // Equal shapes compare equal.
+  Type other(DataType::INT32, {2, 3});
+  std::cout << (ty.GetDimSizes() == other.GetDimSizes()) << " "
+            << (ty == a->GetResultType()) << " " << (ty == other) << "\n";
+  // CHECK-NEXT: 1 1 0
+}
+
+int main() { build(); }
@@ -0,0 +1,109 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/mm/memory_planner.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input =
+      arg_builder.CreateArgument("input", Type{DataType::FLOAT32, {1, 1024}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  std::vector<int64_t> s0{32, 32};
+
+  ConstantBuilder c_builder(func);
+  auto shape =
+      c_builder.CreateConstant("shape", Type{DataType::INT64, {2}}, s0.data());
+
+  IRBuilder ir_builder(bb);
+
+  Instruction* relu0 = ir_builder.CreateRelu("relu0", *input);
+  Instruction* relu1 = ir_builder.CreateRelu("relu1", *relu0);
+  Instruction* rs = ir_builder.CreateReshape("rs", *relu1, *shape);
+  Instruction* relu2 = ir_builder.CreateRelu("relu2", *rs);
+  ir_builder.CreateReturn("ret", *relu2);
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.Run(&m);
+
+  MemoryPlanner planner(*func, MemoryPlanner::Policy::GreedyBySize,
+                        MemoryPlanner::DefaultAlignment, false);
+  planner.Print(std::cout);
+
+  // CHECK: Workspace: 8192 bytes (12288 bytes unplanned), 3 buffers
+  // CHECK-NEXT: [0, 4096) live [0, 1]: relu0
+  // CHECK-NEXT: [4096, 8192) live [1, 3]: relu1 rs
+  // CHECK-NEXT: [0, 4096) live [3, 4]: relu2
+}
+
+void build_in_place() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input =
+      arg_builder.CreateArgument("input", Type{DataType::FLOAT32, {1, 1024}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  std::vector<int64_t> s0{32, 32};
+
+  ConstantBuilder c_builder(func);
+  auto shape =
+      c_builder.CreateConstant("shape", Type{DataType::INT64, {2}}, s0.data());
+
+  IRBuilder ir_builder(bb);
+
+  Instruction* relu0 = ir_builder.CreateRelu("relu0", *input);
+  Instruction* relu1 = ir_builder.CreateRelu("relu1", *relu0);
+  Instruction* add0 = ir_builder.CreateAdd("add0", *relu0, *relu1);
+  Instruction* rs = ir_builder.CreateReshape("rs", *add0, *shape);
+  Instruction* relu2 = ir_builder.CreateRelu("relu2", *rs);
+  Instruction* add1 = ir_builder.CreateAdd("add1", *relu2, *relu2);
+  ir_builder.CreateReturn("ret", *add1);
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.Run(&m);
+
+  MemoryPlanner planner(*func);
+  planner.Print(std::cout);
+
+  // CHECK: Workspace: 12288 bytes (16384 bytes unplanned), 4 buffers
+  // CHECK-NEXT: [0, 4096) live [0, 2]: relu0
+  // CHECK-NEXT: [4096, 8192) live [1, 2]: relu1
+  // CHECK-NEXT: [8192, 12288) live [2, 5]: add0 rs relu2
+  // CHECK-NEXT: [0, 4096) live [5, 6]: add1
+
+  // relu0 is still used by add0, so relu1 cannot overwrite it.
+  std::cout << "relu1 in-place: " << planner.IsInPlace(*relu1) << "\n";
+  std::cout << "relu2 in-place: " << planner.IsInPlace(*relu2) << "\n";
+  // CHECK: relu1 in-place: 0
+  // CHECK-NEXT: relu2 in-place: 1
+}
+
+int main() {
+  build();
+  build_in_place();
+}
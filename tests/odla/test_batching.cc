@@ -0,0 +1,177 @@
+// clang-format off
+
+// The model functions are generated with -emit-inference-func-sig for
+// out = relu(in + c), once with a fixed batch size of 4 and once with
+// -batch-size=-1 -max-batch-size=4.
+// RUN: %cxx %s -DCG_TEST -o %t.cg %flags %include %link
+// RUN: %t.cg > %t.gen.cc
+// RUN: cat %t.gen.cc | FileCheck %s --check-prefix=GEN
+// RUN: %t.cg dynamic > %t.dyn.gen.cc
+// RUN: cat %t.dyn.gen.cc | FileCheck %s --check-prefix=DYN-GEN
+
+// RUN: %cxx %t.gen.cc -I%odla_path/include -c -o %t.gen.o
+// RUN: %cxx %s -DRUNTIME_TEST -I%odla_path/include -c -o %t.main.o
+// RUN: %cxx %t.gen.o %t.main.o %odla_link -lodla_batching -lodla_eigen -lpthread -o %t.exe
+// RUN: %t.exe 2>&1| FileCheck %s
+
+// RUN: %cxx %t.dyn.gen.cc -I%odla_path/include -c -o %t.dyn.gen.o
+// RUN: %cxx %s -DRUNTIME_TEST -DDYNAMIC -I%odla_path/include -c -o %t.dyn.main.o
+// RUN: %cxx %t.dyn.gen.o %t.dyn.main.o %odla_link -lodla_batching -lodla_eigen -lpthread -o %t.dyn.exe
+// RUN: %t.dyn.exe 2>&1| FileCheck %s --check-prefix=DYN
+
+// GEN: void model_run(int num_inputs, const void* inputs[],int num_outputs, void* outputs[]);
+// GEN: const int model_num_inputs = 1;
+// GEN-NEXT: const odla_size_t model_input_sizes[] = {8};
+// GEN-NEXT: const int model_num_outputs = 1;
+// GEN-NEXT: const odla_size_t model_output_sizes[] = {8};
+// GEN-NEXT: const int model_max_batch_size = 4;
+
+// DYN-GEN: void model_run(int num_inputs, const void* inputs[],int num_outputs, void* outputs[], int batch_size);
+// DYN-GEN: const int model_max_batch_size = 4;
+// DYN-GEN: odla_SetComputationItem(Comp, ODLA_MAX_BATCH_SIZE, (odla_item_value) &max_batch_size);
+// DYN-GEN: odla_SetContextItem(Ctx, ODLA_RUN_BATCH_SIZE, (odla_item_value) &batch_size);
+
+// clang-format on
+
+#ifdef CG_TEST
+
+#include <cstring>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+
+using namespace halo;
+
+int main(int argc, char** argv) {
+  bool dynamic = argc > 1 && strcmp(argv[1], "dynamic") == 0;
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("model");
+  Type ty(DataType::FLOAT32, {dynamic ? kDynamicBatchSize : 4, 1, 1, 2});
+  ArgumentBuilder arg_builder(func);
+  auto input = arg_builder.CreateArgument("in", ty);
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+  ConstantBuilder c_builder(func);
+  auto c = c_builder.CreateConstant("c", Type(DataType::FLOAT32, {2}),
+                                    std::vector<float>{1, -1});
+  IRBuilder ir_builder(bb);
+  Instruction* add = ir_builder.CreateAdd("add", *input, *c);
+  Instruction* out = ir_builder.CreateRelu("out", *add);
+  ir_builder.CreateReturn("ret", *out);
+  add->GetResultsTypes()[0] = ty;
+  out->GetResultsTypes()[0] = ty;
+
+  Opts opts;
+  opts.emit_inference_func_sig = true;
+  opts.emit_dynamic_batch = dynamic;
+  opts.max_batch_size = 4;
+  PassManager pm(ctx);
+  pm.AddPass<GenericCXXCodeGen>(std::ref(std::cout), std::ref(std::cout),
+                                opts);
+  pm.Run(&m);
+}
+#endif
+
+#ifdef RUNTIME_TEST
+#include <ODLA/odla.h>
+#include <ODLA/odla_batching.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+extern "C" {
+float c[] = {1, -1};
+#ifdef DYNAMIC
+void model_run(int num_inputs, const void* inputs[], int num_outputs,
+               void* outputs[], int batch_size);
+#else
+void model_run(int num_inputs, const void* inputs[], int num_outputs,
+               void* outputs[]);
+#endif
+extern const int model_num_inputs;
+extern const odla_size_t model_input_sizes[];
+extern const int model_num_outputs;
+extern const odla_size_t model_output_sizes[];
+extern const int model_max_batch_size;
+}
+
+static void OnDone(odla_status status, odla_void* data) {
+  *static_cast<int*>(data) = status == ODLA_SUCCESS ? 1 : -1;
+}
+
+int main() {
+  odla_batcher_config config{model_num_inputs,
+                             model_input_sizes,
+                             model_num_outputs,
+                             model_output_sizes,
+                             model_max_batch_size,
+                             1000000,
+                             1,
+                             nullptr,
+                             nullptr};
+#ifdef DYNAMIC
+  config.dynamic_model_func = model_run;
+#else
+  config.model_func = model_run;
+#endif
+  odla_batcher batcher;
+  odla_CreateBatcher(&config, &batcher);
+
+  // Full batches run without waiting for the maximum latency.
+  const int n = 2 * model_max_batch_size;
+  std::vector<float> in(n * 2);
+  std::vector<float> out(n * 2);
+  std::vector<int> done(n, 0);
+  for (int i = 0; i < n; ++i) {
+    in[i * 2] = i;
+    in[i * 2 + 1] = i;
+    const odla_void* inputs[] = {&in[i * 2]};
+    odla_void* outputs[] = {&out[i * 2]};
+    odla_SubmitRequest(batcher, inputs, outputs, OnDone, &done[i]);
+  }
+  // Pending requests are completed before the batcher is destroyed.
+  odla_DestroyBatcher(batcher);
+  // CHECK: out: 1 0, 2 0, 3 1, 4 2, 5 3, 6 4, 7 5, 8 6
+  // DYN: out: 1 0, 2 0, 3 1, 4 2, 5 3, 6 4, 7 5, 8 6
+  std::cout << "out:";
+  bool all_done = true;
+  for (int i = 0; i < n; ++i) {
+    std::cout << (i == 0 ? " " : ", ") << out[i * 2] << " " << out[i * 2 + 1];
+    all_done &= done[i] == 1;
+  }
+  // CHECK: done: 1
+  // DYN: done: 1
+  std::cout << "\ndone: " << all_done << "\n";
+
+  // A partial batch runs after the maximum latency. The fixed batch model
+  // gets it padded, and the dynamic batch model gets the actual batch size.
+  config.max_latency_us = 1000;
+  odla_CreateBatcher(&config, &batcher);
+  std::vector<std::thread> clients;
+  std::vector<int> ok(3, 0);
+  for (int t = 0; t < 3; ++t) {
+    clients.emplace_back([batcher, t, &ok] {
+      float x[2] = {float(t), float(-t)};
+      float y[2];
+      const odla_void* inputs[] = {x};
+      odla_void* outputs[] = {y};
+      ok[t] = odla_RunRequest(batcher, inputs, outputs) == ODLA_SUCCESS &&
+              y[0] == t + 1 && y[1] == 0;
+    });
+  }
+  for (auto& t : clients) {
+    t.join();
+  }
+  odla_batcher_stats stats;
+  odla_GetBatcherStats(batcher, &stats);
+  odla_DestroyBatcher(batcher);
+  // CHECK: partial: 1 1 1 requests: 3
+  // DYN: partial: 1 1 1 requests: 3
+  std::cout << "partial: " << ok[0] << " " << ok[1] << " " << ok[2]
+            << " requests: " << stats.num_requests << "\n";
+}
+#endif
@@ -0,0 +1,155 @@
+// RUN: %cxx %s -o %t %flags -I%odla_path/include %odla_link -lodla_eigen \
+// RUN:   -lpthread
+// RUN: %t 2>&1| FileCheck %s
+
+#include <ODLA/odla.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static odla_computation Build() {
+  static const float c_data[4] = {1, -2, 3, -4};
+  odla_computation comp;
+  odla_CreateComputation(&comp);
+  odla_value_type type{ODLA_FLOAT32, {4, {1, 1, 2, 2}}};
+  odla_value x = odla_CreateArgument(type, (const odla_value_id) "x");
+  odla_value c = odla_CreateConstant(type, c_data, (const odla_value_id) "c");
+  odla_value add = odla_Add(x, c, (const odla_value_id) "add");
+  odla_value relu = odla_Relu(add, (const odla_value_id) "relu");
+  odla_value add2 = odla_Add(relu, relu, (const odla_value_id) "add2");
+  odla_value clamp = odla_Clamp(add2, 0, 5, (const odla_value_id) "clamp");
+  odla_SetValueAsOutput(relu);
+  odla_SetValueAsOutput(clamp);
+  return comp;
+}
+
+static bool Run(odla_computation comp, odla_context ctx, float base) {
+  float x[4] = {base, base, base, base};
+  float relu[4];
+  float clamp[4];
+  odla_BindToArgumentById((const odla_value_id) "x", x, ctx);
+  odla_BindToOutputById((const odla_value_id) "relu", relu, ctx);
+  odla_BindToOutputById((const odla_value_id) "clamp", clamp, ctx);
+  odla_ExecuteComputation(comp, ctx, ODLA_COMPUTE_INFERENCE, nullptr);
+  const float c[4] = {1, -2, 3, -4};
+  for (int i = 0; i < 4; ++i) {
+    float r = std::max(base + c[i], 0.0F);
+    if (relu[i] != r || clamp[i] != std::min(2 * r, 5.0F)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void OnDone(odla_context ctx, odla_status status, odla_void* data) {
+  ++*static_cast<int*>(data);
+}
+
+struct Chain {
+  odla_computation comp;
+  int remaining;
+};
+
+// Submits the next request from the callback of the previous one.
+static void OnDoneSubmit(odla_context ctx, odla_status status,
+                         odla_void* data) {
+  auto* chain = static_cast<Chain*>(data);
+  if (--chain->remaining > 0) {
+    odla_AsyncExecuteComputation(chain->comp, ctx, ODLA_COMPUTE_INFERENCE,
+                                 nullptr);
+  }
+}
+
+int main() {
+  odla_computation comp = Build();
+
+  // The computation is shared by the contexts of concurrent threads.
+  std::vector<std::thread> threads;
+  std::vector<int> ok(4, 1);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([comp, t, &ok] {
+      odla_context ctx;
+      odla_CreateContext(&ctx);
+      int num_threads = 2;
+      odla_SetContextItem(ctx, ODLA_NUM_THREADS, (odla_item_value)&num_threads);
+      for (int i = 0; i < 100; ++i) {
+        ok[t] &= Run(comp, ctx, static_cast<float>(t + i % 3));
+      }
+      odla_DestroyContext(ctx);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // CHECK: threads: 1 1 1 1
+  std::cout << "threads: " << ok[0] << " " << ok[1] << " " << ok[2] << " "
+            << ok[3] << "\n";
+
+  // Inputs for the next request are bound while the previous one runs.
+  odla_context ctx;
+  odla_CreateContext(&ctx);
+  int done = 0;
+  odla_SetAsyncCallback(ctx, OnDone, &done);
+  float x[3][4] = {{1, 1, 1, 1}, {2, 2, 2, 2}, {3, 3, 3, 3}};
+  float relu[3][4];
+  float clamp[3][4];
+  for (int i = 0; i < 3; ++i) {
+    odla_BindToArgumentById((const odla_value_id) "x", x[i], ctx);
+    odla_BindToOutputById((const odla_value_id) "relu", relu[i], ctx);
+    odla_BindToOutputById((const odla_value_id) "clamp", clamp[i], ctx);
+    odla_AsyncExecuteComputation(comp, ctx, ODLA_COMPUTE_INFERENCE, nullptr);
+  }
+  // CHECK: wait: 0 done: 3
+  std::cout << "wait: " << odla_WaitContext(ctx) << " done: " << done << "\n";
+  // CHECK: relu: 2 0 4 0, 3 0 5 0, 4 1 6 0
+  // CHECK: clamp: 4 0 5 0, 5 0 5 0, 5 2 5 0
+  for (auto* out : {relu, clamp}) {
+    std::cout << (out == relu ? "relu:" : "clamp:");
+    for (int i = 0; i < 3; ++i) {
+      std::cout << (i == 0 ? " " : ", ") << out[i][0] << " " << out[i][1]
+                << " " << out[i][2] << " " << out[i][3];
+    }
+    std::cout << "\n";
+  }
+
+  // With a queue of depth 1, the callback can still submit the next request.
+  int depth = 1;
+  odla_SetContextItem(ctx, ODLA_ASYNC_QUEUE_DEPTH, (odla_item_value)&depth);
+  Chain chain{comp, 3};
+  odla_SetAsyncCallback(ctx, OnDoneSubmit, &chain);
+  odla_AsyncExecuteComputation(comp, ctx, ODLA_COMPUTE_INFERENCE, nullptr);
+  // CHECK: chain: 0 remaining: 0
+  std::cout << "chain: " << odla_WaitContext(ctx)
+            << " remaining: " << chain.remaining << "\n";
+  odla_DestroyContext(ctx);
+  odla_DestroyComputation(comp);
+
+  // A context that ran a destroyed computation is set up again for a new one,
+  // even if it is allocated at the same address.
+  odla_CreateContext(&ctx);
+  for (int i = 0; i < 3; ++i) {
+    comp = Build();
+    ok[i] = Run(comp, ctx, static_cast<float>(i));
+    odla_DestroyComputation(comp);
+  }
+  odla_DestroyContext(ctx);
+  // CHECK: rebuilt: 1 1 1
+  std::cout << "rebuilt: " << ok[0] << " " << ok[1] << " " << ok[2] << "\n";
+
+  // Without an active computation, ops are executed eagerly.
+  odla_value_type type{ODLA_FLOAT32, {4, {1, 1, 2, 2}}};
+  float data[4] = {-1, 2, -3, 4};
+  odla_value v = odla_CreateValue(type, (const odla_value_id) "v");
+  odla_SetValueData(v, data);
+  float result[4];
+  odla_value r = odla_Relu(v, (const odla_value_id) "r");
+  odla_GetValueData(r, result);
+  // CHECK: eager: 0 2 0 4
+  std::cout << "eager: " << result[0] << " " << result[1] << " " << result[2]
+            << " " << result[3] << "\n";
+  // The generated code releases the values at the end of each run.
+  // CHECK: release: 0 0
+  std::cout << "release: " << odla_ReleaseValue(v) << " "
+            << odla_ReleaseValue(r) << "\n";
+}
@@ -0,0 +1,96 @@
+// RUN: %cxx %s -o %t %flags -I%odla_path/include %odla_link -lodla_eigen \
+// RUN:   -lpthread
+// RUN: rm -f %t.calib
+// RUN: env ODLA_CALIBRATION_FILE=%t.calib %t 2>&1| FileCheck %s
+// RUN: FileCheck --check-prefix=CALIB %s < %t.calib
+
+#include <ODLA/odla.h>
+
+#include <cstdint>
+#include <iostream>
+
+int main() {
+  static const int8_t kernel_data[2] = {2, -1};
+  static const int32_t conv_bias_data[2] = {1, 0};
+  static const float conv_scales[2] = {0.125, 0.5};
+  static const int8_t rhs_data[6] = {1, 0, 0, 1, 1, 1};
+  static const int32_t gemm_bias_data[2] = {10, 20};
+  static const float gemm_scale = 0.5;
+  static const odla_uint32 ones[2] = {1, 1};
+  static const odla_uint32 zeros[2] = {0, 0};
+
+  odla_computation comp;
+  odla_CreateComputation(&comp);
+  // conv_dq = dequantize(relu(conv(quantize(x), kernel) + bias))
+  odla_value x = odla_CreateArgument({ODLA_FLOAT32, {4, {1, 1, 2, 2}}},
+                                     (const odla_value_id) "x");
+  odla_value x_q = odla_Quantize(x, 0.5, 0, ODLA_INT8, nullptr);
+  odla_value kernel = odla_CreateConstant({ODLA_INT8, {4, {2, 1, 1, 1}}},
+                                          kernel_data, nullptr);
+  odla_value conv_bias =
+      odla_CreateConstant({ODLA_INT32, {1, {2}}}, conv_bias_data, nullptr);
+  odla_value conv = odla_FusedConv(
+      x_q, ODLA_CHANNELS_FIRST, 1, kernel, ODLA_OIS, ones, ones, zeros, zeros,
+      conv_bias, ODLA_ACTIVATION_RELU, 0, {4, {1, 2, 2, 2}}, nullptr);
+  odla_value conv_dq =
+      odla_Dequantize(conv, 2, conv_scales, 1, (const odla_value_id) "conv_dq");
+  odla_SetValueAsOutput(conv_dq);
+
+  // gemm_dq = dequantize(quantize(y) * rhs + bias)
+  odla_value y = odla_CreateArgument({ODLA_FLOAT32, {2, {2, 3}}},
+                                     (const odla_value_id) "y");
+  odla_value y_q = odla_Quantize(y, 1, 0, ODLA_INT8, nullptr);
+  odla_value rhs =
+      odla_CreateConstant({ODLA_INT8, {2, {3, 2}}}, rhs_data, nullptr);
+  odla_value gemm_bias =
+      odla_CreateConstant({ODLA_INT32, {1, {2}}}, gemm_bias_data, nullptr);
+  odla_value gemm = odla_Gemm(y_q, false, rhs, false, 1, 1, gemm_bias,
+                              {2, {2, 2}}, nullptr);
+  odla_value gemm_dq = odla_Dequantize(gemm, 1, &gemm_scale, 0,
+                                       (const odla_value_id) "gemm_dq");
+  odla_SetValueAsOutput(gemm_dq);
+
+  // Values out of the range are saturated.
+  odla_value y_sat =
+      odla_Quantize(y, 0.01, 0, ODLA_INT8, (const odla_value_id) "y_sat");
+  odla_SetValueAsOutput(y_sat);
+
+  odla_context ctx;
+  odla_CreateContext(&ctx);
+  float x_data[4] = {0.5, -1, 1.5, 2};
+  float y_data[6] = {1, 2, 3, -1, -2, -3};
+  float conv_out[8];
+  float gemm_out[4];
+  int8_t sat_out[6];
+  odla_BindToArgumentById((const odla_value_id) "x", x_data, ctx);
+  odla_BindToArgumentById((const odla_value_id) "y", y_data, ctx);
+  odla_BindToOutputById((const odla_value_id) "conv_dq", conv_out, ctx);
+  odla_BindToOutputById((const odla_value_id) "gemm_dq", gemm_out, ctx);
+  odla_BindToOutputById((const odla_value_id) "y_sat", sat_out, ctx);
+  odla_ExecuteComputation(comp, ctx, ODLA_COMPUTE_INFERENCE, nullptr);
+
+  // CHECK: conv: 0.375 0 0.875 1.125 0 1 0 0
+  std::cout << "conv:";
+  for (float v : conv_out) {
+    std::cout << " " << v;
+  }
+  // CHECK: gemm: 7 12.5 3 7.5
+  std::cout << "\ngemm:";
+  for (float v : gemm_out) {
+    std::cout << " " << v;
+  }
+  // CHECK: saturated: 100 127 127 -100 -128 -128
+  std::cout << "\nsaturated:";
+  for (int8_t v : sat_out) {
+    std::cout << " " << static_cast<int>(v);
+  }
+  std::cout << "\n";
+  odla_DestroyContext(ctx);
+  odla_DestroyComputation(comp);
+}
+
+// The ranges of the arguments and the outputs are recorded.
+// CALIB: conv_dq 0 1.125
+// CALIB-NEXT: gemm_dq 3 12.5
+// CALIB-NEXT: x -1 2
+// CALIB-NEXT: y -3 3
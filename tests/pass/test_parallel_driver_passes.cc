@@ -0,0 +1,151 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/target/generic_cxx/generic_cxx_codegen.h"
+#include "halo/lib/transforms/constant_dedup.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/fusion.h"
+#include "halo/lib/transforms/input_legalizer.h"
+#include "halo/lib/transforms/inst_simplify.h"
+#include "halo/lib/transforms/onnxextension_legalizer.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+// Records the threads it runs on.
+class ThreadProbe final : public FunctionPass {
+ public:
+  explicit ThreadProbe(std::set<std::thread::id>* threads)
+      : FunctionPass("Thread Probe"), threads_(threads) {}
+
+  bool RunOnFunction(Function* /*func*/) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      threads_->insert(std::this_thread::get_id());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return false;
+  }
+
+  bool CanRunConcurrently() const noexcept override { return true; }
+
+ private:
+  std::mutex mutex_;
+  std::set<std::thread::id>* threads_;
+};
+
+// Builds an entry function that calls `n` functions, runs the passes of the
+// driver for an ONNX model to C++ with `api` on `num_threads` threads and
+// returns the printed module and the generated code. `threads` gets the
+// threads that the function passes after InputLegalizer ran on.
+std::string compile(int n, int num_threads, CodeGen::API api,
+                    std::set<std::thread::id>* threads) {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  const Type type{DataType::FLOAT32, {2}};
+  Function* entry = func_builder.CreateFunction("main");
+  std::vector<Function*> callees;
+  for (int i = 0; i < n; ++i) {
+    const std::string suffix = std::to_string(i);
+    Function* func = func_builder.CreateFunction("func" + suffix);
+    ArgumentBuilder arg_builder(func);
+    auto x = arg_builder.CreateArgument("x" + suffix, type);
+    ConstantBuilder c_builder(func);
+    auto a = c_builder.CreateConstant("a" + suffix, type,
+                                      std::vector<float>{1.0F * i, 1});
+    auto b = c_builder.CreateConstant("b" + suffix, type,
+                                      std::vector<float>{2, 3});
+    BasicBlockBuilder bb_builder(func);
+    BasicBlock* bb = bb_builder.CreateBasicBlock("bb" + suffix);
+    IRBuilder ir_builder(bb);
+    auto sum = ir_builder.CreateAdd("sum" + suffix, *a, *b);
+    auto t = ir_builder.CreateAdd("t" + suffix, *x, *sum);
+    auto y = ir_builder.CreateMul("y" + suffix, *t, *x);
+    ir_builder.CreateNeg("dead" + suffix, *x);
+    ir_builder.CreateReturn("ret" + suffix, *y);
+    callees.push_back(func);
+  }
+  {
+    ArgumentBuilder arg_builder(entry);
+    Def v = *arg_builder.CreateArgument("in", type);
+    BasicBlockBuilder bb_builder(entry);
+    BasicBlock* bb = bb_builder.CreateBasicBlock("bb");
+    IRBuilder ir_builder(bb);
+    for (int i = 0; i < n; ++i) {
+      auto call = ir_builder.CreateCall("call" + std::to_string(i), {v});
+      call->SetCallee(callees[i]);
+      call->SetNumOfResults(1);
+      v = Def{call, 0};
+    }
+    ir_builder.CreateReturn("ret", {v});
+  }
+
+  std::ostringstream code;
+  std::ostringstream header;
+  PassManager pm(ctx);
+  pm.AddPass<InputLegalizer>(1, std::vector<std::string>{});
+  pm.AddPass<ThreadProbe>(threads);
+  pm.AddPass<ONNXExtensionLegalizer>();
+  pm.AddPass<DCE>();
+  pm.AddPass<TypeLegalizer>(true);
+  pm.AddPass<InstSimplify>(true, false, false, false);
+  pm.AddPass<Fusion>(Fusion::Options());
+  pm.AddPass<ConstantDedup>();
+  pm.AddPass<DCE>();
+  auto cg = pm.AddPass<GenericCXXCodeGen>(std::ref(code), std::ref(header));
+  cg->SetAPI(api);
+  pm.SetNumOfThreads(num_threads);
+  pm.Run(&m);
+
+  std::ostringstream os;
+  m.Print(os);
+  return os.str() + code.str() + header.str();
+}
+
+int main() {
+  std::set<std::thread::id> serial_threads;
+  std::set<std::thread::id> parallel_threads;
+  const std::string serial =
+      compile(16, 1, CodeGen::API::ODLA_05, &serial_threads);
+  const std::string parallel =
+      compile(16, 4, CodeGen::API::ODLA_05, &parallel_threads);
+  // InputLegalizer does not opt in, but the passes after it still run on
+  // several threads, and the result does not depend on the number of threads.
+  // CHECK: serial threads: 1
+  // CHECK-NEXT: parallel threads: 1
+  // CHECK-NEXT: same: 1
+  std::cout << "serial threads: " << serial_threads.size() << "\n";
+  std::cout << "parallel threads: " << (parallel_threads.size() > 1) << "\n";
+  std::cout << "same: " << (serial == parallel) << "\n";
+  std::cout << parallel;
+  // CHECK: Function: func0
+  // CHECK-NOT: = neg(
+  // CHECK: Function: func15
+  // CHECK-NOT: = neg(
+  // The functions are emitted in module order.
+  // CHECK: func0
+  // CHECK: func15
+  // CHECK: odla_RunTaskAsync
+
+  // The functions emitted in parallel use the API of the code generator, so
+  // with the Halo runtime their buffers are views into a static workspace.
+  // CHECK: halo_rt same: 1 workspace: 1
+  std::set<std::thread::id> rt_threads;
+  const std::string rt_serial =
+      compile(16, 1, CodeGen::API::HALO_RT, &rt_threads);
+  const std::string rt_parallel =
+      compile(16, 4, CodeGen::API::HALO_RT, &rt_threads);
+  std::cout << "halo_rt same: " << (rt_serial == rt_parallel) << " workspace: "
+            << (rt_parallel.find("func15_workspace") != std::string::npos)
+            << "\n";
+}
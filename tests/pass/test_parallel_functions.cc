@@ -0,0 +1,65 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <iostream>
+#include <sstream>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/inst_simplify.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+// Builds `n` functions that each fold to a constant, runs the simplification
+// passes on `num_threads` threads and returns the printed module.
+std::string compile(int n, int num_threads) {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+  FunctionBuilder func_builder(&m);
+  for (int i = 0; i < n; ++i) {
+    const std::string suffix = std::to_string(i);
+    Function* func = func_builder.CreateFunction("func" + suffix);
+    ArgumentBuilder arg_builder(func);
+    const Type type{DataType::FLOAT32, {2}};
+    auto x = arg_builder.CreateArgument("x" + suffix, type);
+    ConstantBuilder c_builder(func);
+    auto a = c_builder.CreateConstant("a" + suffix, type,
+                                      std::vector<float>{1.0F * i, 1});
+    auto b = c_builder.CreateConstant("b" + suffix, type,
+                                      std::vector<float>{2, 3});
+    BasicBlockBuilder bb_builder(func);
+    BasicBlock* bb = bb_builder.CreateBasicBlock("bb" + suffix);
+    IRBuilder ir_builder(bb);
+    auto sum = ir_builder.CreateAdd("sum" + suffix, *a, *b);
+    ir_builder.CreateNeg("dead" + suffix, *x);
+    ir_builder.CreateReturn("ret" + suffix, *sum);
+  }
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<InstSimplify>();
+  pm.AddPass<DCE>();
+  pm.SetNumOfThreads(num_threads);
+  pm.Run(&m);
+
+  std::ostringstream os;
+  m.Print(os);
+  return os.str();
+}
+
+int main() {
+  const std::string serial = compile(16, 1);
+  const std::string parallel = compile(16, 4);
+  // The result does not depend on the number of threads.
+  std::cout << (serial == parallel) << "\n";
+  // CHECK: 1
+  std::cout << parallel;
+  // CHECK: Function: func0
+  // CHECK-NOT: = add(
+  // CHECK-NOT: = neg(
+  // CHECK: Function: func15
+  // CHECK-NOT: = add(
+  // CHECK-NOT: = neg(
+}
@@ -0,0 +1,73 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <sstream>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+class DummyModulePass final : public ModulePass {
+ public:
+  DummyModulePass() : ModulePass("Dummy Module Pass") {}
+  bool RunOnModule(Module* module) override { return false; }
+};
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  ArgumentBuilder arg_builder(func);
+  auto input =
+      arg_builder.CreateArgument("input", Type{DataType::FLOAT32, {2}});
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+  IRBuilder ir_builder(bb);
+  ir_builder.CreateAdd("dead", *input, *input);
+  auto add = ir_builder.CreateAdd("add", *input, *input);
+  ir_builder.CreateReturn("ret", *add);
+
+  PassManager pm(ctx);
+  pm.AddPass<DummyModulePass>();
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<DCE>();
+  pm.EnableTiming();
+  pm.Run(&m);
+
+  // CHECK: Dummy Module Pass 0 1 0 3 3
+  // CHECK-NEXT: FunctionPassManager 0 1 1 3 2
+  // CHECK-NEXT: BasicBlockPassManager 1 1 2 3 2
+  // CHECK-NEXT: Type Legalizer 2 2 0 5 5
+  // CHECK-NEXT: Dead Code Elimination 2 2 0 5 4
+  for (const auto& s : pm.GetStatistics()) {
+    std::cout << s.name << " " << s.depth << " " << s.calls << " "
+              << s.iterations << " " << s.insts_before << " "
+              << s.insts_after << "\n";
+  }
+
+  // clang-format off
+  // CHECK: Pass execution timing report
+  // CHECK: Wall (ms) % Calls Iters Insts In Insts Out Peak RSS (MB) Name
+  // CHECK-NEXT: {{[0-9.]+ [0-9.]+}} 1 0 3 3 {{[0-9.]+}} Dummy Module Pass
+  // CHECK-NEXT: {{[0-9.]+ [0-9.]+}} 1 1 3 2 {{[0-9.]+}} FunctionPassManager
+  // CHECK-NEXT: {{[0-9.]+ [0-9.]+}} 1 2 3 2 {{[0-9.]+}} BasicBlockPassManager
+  // CHECK-NEXT: {{[0-9.]+ [0-9.]+}} 2 0 5 5 {{[0-9.]+}} Type Legalizer
+  // CHECK-NEXT: {{[0-9.]+ [0-9.]+}} 2 0 5 4 {{[0-9.]+}} Dead Code Elimination
+  pm.PrintTiming(std::cout);
+
+  // CHECK: {"traceEvents": [
+  // CHECK-NEXT: {"name": "Dummy Module Pass", "cat": "pass", "ph": "X", "pid": 0, "tid": 0, "ts": {{[0-9.]+}}, "dur": {{[0-9.]+}}, "args": {"insts_before": 3, "insts_after": 3}},
+  // CHECK-NEXT: {"name": "Type Legalizer", {{.*}} "args": {"insts_before": 3, "insts_after": 3}},
+  // CHECK-NEXT: {"name": "Dead Code Elimination", {{.*}} "args": {"insts_before": 3, "insts_after": 2}},
+  // CHECK: {"name": "FunctionPassManager", {{.*}} "args": {"insts_before": 3, "insts_after": 2}}
+  // CHECK-NEXT: ], "displayTimeUnit": "ms"}
+  // clang-format on
+  pm.WriteChromeTrace(std::cout);
+}
+
+int main() { build(); }
@@ -0,0 +1,69 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <iostream>
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/pass/worklist.h"
+#include "halo/lib/transforms/dce.h"
+
+using namespace halo;
+
+// Folds neg(neg(x)) into x.
+class NegFold final : public WorklistPass {
+ public:
+  NegFold() : WorklistPass("Neg Fold") {}
+  int visits = 0;
+
+ protected:
+  bool Visit(Instruction* inst) override {
+    ++visits;
+    if (inst->GetOpCode() != OpCode::NEG || inst->GetNumberOfUses() == 0) {
+      return false;
+    }
+    const Def& op = inst->GetOperand(0);
+    if (!IsA<Instruction>(op) ||
+        DynCast<Instruction>(op)->GetOpCode() != OpCode::NEG) {
+      return false;
+    }
+    ReplaceAllUsesWith(inst, 0, DynCast<Instruction>(op)->GetOperand(0));
+    return true;
+  }
+};
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+  ArgumentBuilder arg_builder(func);
+  auto x = arg_builder.CreateArgument("x", Type{DataType::FLOAT32, {2}});
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+  IRBuilder ir_builder(bb);
+  Def def = *x;
+  for (int i = 0; i < 8; ++i) {
+    def = *ir_builder.CreateNeg("neg" + std::to_string(i), def);
+  }
+  ir_builder.CreateReturn("ret", def);
+
+  NegFold fold;
+  bool changed = fold.RunOnBasicBlock(bb);
+  std::cout << changed << " " << fold.visits << "\n";
+  // CHECK: 1 9
+
+  // The whole dead chain goes away in one run.
+  DCE dce;
+  changed = dce.RunOnBasicBlock(bb);
+  std::cout << changed << " " << bb->size() << "\n";
+  // CHECK-NEXT: 1 1
+  changed = dce.RunOnBasicBlock(bb);
+  std::cout << changed << "\n";
+  // CHECK-NEXT: 0
+
+  bb->Dump();
+  // CHECK: Inst: ret() = return(<x, 0>:[FLOAT32: 2])
+}
+
+int main() { build(); }
@@ -0,0 +1,61 @@
+// RUN: %cxx %s -o %t %flags -pthread %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "halo/lib/threadpool/thread_pool.h"
+
+using namespace halo;
+
+void test(int num_of_threads) {
+  ThreadPool pool(num_of_threads);
+  std::cout << "Threads: " << pool.GetNumOfThreads() << std::endl;
+
+  // Every iteration is visited exactly once.
+  std::vector<int> visits(10007);
+  pool.ParallelFor(0, visits.size(), 16, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      ++visits[i];
+    }
+  });
+  std::cout << "Visited: "
+            << std::count(visits.begin(), visits.end(), 1) << std::endl;
+
+  // Nested loops run sequentially inside the outer chunks.
+  std::vector<int64_t> sums(64);
+  pool.ParallelFor(0, sums.size(), 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      pool.ParallelFor(0, 100, 1, [&](int64_t lo, int64_t hi) {
+        for (int64_t j = lo; j < hi; ++j) {
+          sums[i] += j;
+        }
+      });
+    }
+  });
+  std::cout << "Nested: " << std::accumulate(sums.begin(), sums.end(), 0L)
+            << std::endl;
+
+  std::atomic<int> done(0);
+  for (int i = 0; i < 100; ++i) {
+    pool.Schedule([&done]() { ++done; });
+  }
+  pool.Wait();
+  std::cout << "Scheduled: " << done << std::endl;
+}
+
+int main() {
+  test(1);
+  test(4);
+}
+
+// CHECK: Threads: 1
+// CHECK-NEXT: Visited: 10007
+// CHECK-NEXT: Nested: 316800
+// CHECK-NEXT: Scheduled: 100
+// CHECK: Threads: 4
+// CHECK-NEXT: Visited: 10007
+// CHECK-NEXT: Nested: 316800
+// CHECK-NEXT: Scheduled: 100
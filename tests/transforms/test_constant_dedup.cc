@@ -0,0 +1,64 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/constant_dedup.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  std::vector<float> w{1.0, 2.0, 3.0, 4.0};
+  std::vector<int> w_int{1, 2, 3, 4};
+
+  ConstantBuilder c_builder(func);
+  auto c0 = c_builder.CreateConstant("w0", Type(DataType::FLOAT32, {2, 2}),
+                                     w.data());
+  auto c1 = c_builder.CreateConstant("w1", Type(DataType::FLOAT32, {2, 2}),
+                                     w.data());
+  // Same data, different types.
+  auto c2 = c_builder.CreateConstant("w2", Type(DataType::FLOAT32, {4}),
+                                     w.data());
+  auto c3 = c_builder.CreateConstant("w3", Type(DataType::INT32, {2, 2}),
+                                     w_int.data());
+
+  IRBuilder ir_builder(bb);
+
+  Instruction* sum = ir_builder.CreateAdd("sum", *c0, *c1);
+  ir_builder.CreateReturn("ret", {*sum, *c1, *c2, *c3});
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<ConstantDedup>();
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // clang-format off
+  // CHECK: Module: test_module
+  // CHECK: Function: func()
+  // CHECK: Constant w0([FLOAT32: 2x2])
+  // CHECK-NOT: Constant w1
+  // CHECK: Constant w2([FLOAT32: 4])
+  // CHECK: Constant w3([INT32: 2x2])
+  // CHECK: BasicBlock: bb0
+  // CHECK-NEXT: Inst: sum([FLOAT32: 2x2]) = add(<w0, 0>:[FLOAT32: 2x2], <w0, 0>:[FLOAT32: 2x2])
+  // CHECK-NEXT: Inst: ret() = return(<sum, 0>:[FLOAT32: 2x2], <w0, 0>:[FLOAT32: 2x2], <w2, 0>:[FLOAT32: 4], <w3, 0>:[INT32: 2x2])
+  // clang-format on
+}
+
+int main() { build(); }
@@ -0,0 +1,76 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/inst_simplify.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build(int64_t max_folded_bytes) {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  std::vector<float> a{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  std::vector<float> b{10.0, 20.0, 30.0};
+  std::vector<float> w{1.0, 0.0, 0.0, 1.0, 1.0, 1.0};
+
+  ConstantBuilder c_builder(func);
+  auto c0 =
+      c_builder.CreateConstant("a", Type(DataType::FLOAT32, {2, 3}), a.data());
+  auto c1 =
+      c_builder.CreateConstant("b", Type(DataType::FLOAT32, {3}), b.data());
+  auto c2 =
+      c_builder.CreateConstant("w", Type(DataType::FLOAT32, {3, 2}), w.data());
+
+  IRBuilder ir_builder(bb);
+
+  // The constant operands have different shapes.
+  Instruction* sum = ir_builder.CreateAdd("sum", *c0, *c1);
+  ReduceSumInst* rs = ir_builder.CreateReduceSum("rs", {*sum});
+  rs->SetAxis({1});
+  rs->SetKeepDims(false);
+  Instruction* mm = ir_builder.CreateMatMul("mm", {*sum, *c2});
+  ir_builder.CreateReturn("ret", {*rs, *mm});
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<InstSimplify>(false, false, false, false, max_folded_bytes);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+}
+
+int main() {
+  build(ConstantEvaluator::kDefaultMaxBytes);
+  // clang-format off
+  // CHECK: Module: test_module
+  // CHECK: Function: func()
+  // CHECK-DAG: Constant rs_folding([FLOAT32: 2]) = [66, 75]
+  // CHECK-DAG: Constant mm_folding([FLOAT32: 2x2]) = [44, 55, 50, 61]
+  // CHECK: BasicBlock: bb0
+  // CHECK-NOT: = add(
+  // CHECK-NOT: = reducesum(
+  // CHECK-NOT: = matmul(
+  // CHECK: Inst: ret() = return(<rs_folding, 0>:[FLOAT32: 2], <mm_folding, 0>:[FLOAT32: 2x2])
+  // clang-format on
+
+  // The 24-byte result of the add exceeds the limit.
+  build(16);
+  // CHECK: Module: test_module
+  // CHECK: BasicBlock: bb0
+  // CHECK: Inst: sum([FLOAT32: 2x3]) = add(<a, 0>:[FLOAT32: 2x3], <b, 0>:[FLOAT32: 3])
+  // CHECK: = reducesum(<sum, 0>
+  // CHECK: = matmul(<sum, 0>
+}
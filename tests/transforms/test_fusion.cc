@@ -0,0 +1,157 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/fusion.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input = arg_builder.CreateArgument(
+      "input", Type{DataType::FLOAT32, {1, 2, 2, 2}});
+  auto fc_input =
+      arg_builder.CreateArgument("fc_input", Type{DataType::FLOAT32, {1, 2}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  // OIHW kernel of two 1x1 filters.
+  auto w = c_builder.CreateConstant("w", Type(DataType::FLOAT32, {2, 2, 1, 1}),
+                                    std::vector<float>{1, 2, 3, 4});
+  Type ch_type(DataType::FLOAT32, {2});
+  auto scale = c_builder.CreateConstant("scale", ch_type,
+                                        std::vector<float>{4, 1});
+  auto offset = c_builder.CreateConstant("offset", ch_type,
+                                         std::vector<float>{1, 0});
+  auto mean =
+      c_builder.CreateConstant("mean", ch_type, std::vector<float>{0, 1});
+  auto var = c_builder.CreateConstant("var", ch_type, std::vector<float>{3, 0});
+  auto fc_w = c_builder.CreateConstant("fc_w", Type(DataType::FLOAT32, {2, 2}),
+                                       std::vector<float>{1, 2, 3, 4});
+  auto fc_b = c_builder.CreateConstant("fc_b", Type(DataType::FLOAT32, {2}),
+                                       std::vector<float>{1, 2});
+
+  IRBuilder ir_builder(bb);
+
+  auto conv = ir_builder.CreateConv2D("conv", *input, *w);
+  conv->SetDataFormat(DataFormat::NCHW);
+  conv->SetFilterFormat(DataFormat::NCHW);
+  conv->SetPaddingLeft(0);
+  conv->SetPaddingRight(0);
+  conv->SetPaddingTop(0);
+  conv->SetPaddingBottom(0);
+  auto bn = ir_builder.CreateBatchNorm("bn", *conv, *scale, *offset, *mean,
+                                       *var);
+  bn->SetEpsilon(1);
+  bn->SetDataFormat(DataFormat::NCHW);
+  auto relu = ir_builder.CreateRelu("relu", *bn);
+
+  auto gemm = ir_builder.CreateGemm("gemm", *fc_input, *fc_w, *fc_b);
+  auto leaky_relu = ir_builder.CreateLeakyRelu("leaky_relu", *gemm);
+  leaky_relu->SetAlpha(0.5F);
+
+  ir_builder.CreateReturn("ret", {*relu, *leaky_relu});
+
+  Fusion::Options opts;
+  opts.ConvBatchnorm = true;
+  opts.Activation = true;
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<Fusion>(opts);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // s = scale / sqrt(var + 1) = [2, 1], so the kernel becomes [2, 4, 3, 4]
+  // and the bias becomes (0 - mean) * s + offset = [1, -1].
+  // clang-format off
+  // CHECK: Module: test_module
+  // CHECK: Function: func(input[FLOAT32: 1x2x2x2], fc_input[FLOAT32: 1x2])
+  // CHECK-NOT: Constant scale
+  // CHECK-NOT: Constant w(
+  // CHECK: Constant bn_folded_kernel([FLOAT32: 2x2x1x1]) = [2, 4, 3, 4]
+  // CHECK: Constant bn_folded_bias([FLOAT32: 2]) = [1, -1]
+  // CHECK: BasicBlock: bb0
+  // CHECK-NEXT: Inst: relu_fused([FLOAT32: 1x2x2x2]) = conv2d(<input, 0>:[FLOAT32: 1x2x2x2], <bn_folded_kernel, 0>:[FLOAT32: 2x2x1x1], <bn_folded_bias, 0>:[FLOAT32: 2]) {Attrs: {{.*}}, <activation: 1, <activation_alpha: 0>}
+  // CHECK-NEXT: Inst: leaky_relu_fused([FLOAT32: 1x2]) = gemm(<fc_input, 0>:[FLOAT32: 1x2], <fc_w, 0>:[FLOAT32: 2x2], <fc_b, 0>:[FLOAT32: 2]) {Attrs: {{.*}}, <activation: 3, <activation_alpha: 0.5>}
+  // CHECK-NEXT: Inst: ret() = return(<relu_fused, 0>:[FLOAT32: 1x2x2x2], <leaky_relu_fused, 0>:[FLOAT32: 1x2])
+  // clang-format on
+}
+
+// A batch norm over another axis than the output channels of the convolution
+// is not folded.
+void build_mismatched_format() {
+  GlobalContext ctx;
+  Module m(ctx, "test_mismatched_format");
+
+  FunctionBuilder func_builder(&m);
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input = arg_builder.CreateArgument(
+      "input", Type{DataType::FLOAT32, {1, 2, 2, 2}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  auto w = c_builder.CreateConstant("w", Type(DataType::FLOAT32, {2, 2, 1, 1}),
+                                    std::vector<float>{1, 2, 3, 4});
+  Type ch_type(DataType::FLOAT32, {2});
+  std::vector<float> ones{1, 1};
+  auto scale = c_builder.CreateConstant("scale", ch_type, ones);
+  auto offset = c_builder.CreateConstant("offset", ch_type, ones);
+  auto mean = c_builder.CreateConstant("mean", ch_type, ones);
+  auto var = c_builder.CreateConstant("var", ch_type, ones);
+
+  IRBuilder ir_builder(bb);
+  auto conv = ir_builder.CreateConv2D("conv", *input, *w);
+  conv->SetDataFormat(DataFormat::NCHW);
+  conv->SetFilterFormat(DataFormat::NCHW);
+  conv->SetPaddingLeft(0);
+  conv->SetPaddingRight(0);
+  conv->SetPaddingTop(0);
+  conv->SetPaddingBottom(0);
+  auto bn = ir_builder.CreateBatchNorm("bn", *conv, *scale, *offset, *mean,
+                                       *var);
+  bn->SetDataFormat(DataFormat::NHWC);
+  ir_builder.CreateReturn("ret", std::vector<Def>{*bn});
+
+  Fusion::Options opts;
+  opts.ConvBatchnorm = true;
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<Fusion>(opts);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // clang-format off
+  // CHECK: Module: test_mismatched_format
+  // CHECK-NOT: bn_folded_kernel
+  // CHECK: Inst: conv([FLOAT32: 1x2x2x2]) = conv2d(<input, 0>:[FLOAT32: 1x2x2x2], <w, 0>:[FLOAT32: 2x2x1x1])
+  // CHECK-NEXT: Inst: bn([FLOAT32: 1x2x2x2]) = batchnorm(<conv, 0>:[FLOAT32: 1x2x2x2]
+  // clang-format on
+}
+
+int main() {
+  build();
+  build_mismatched_format();
+}
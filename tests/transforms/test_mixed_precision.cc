@@ -0,0 +1,138 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/mixed_precision.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build_bf16() {
+  GlobalContext ctx;
+  Module m(ctx, "test_bf16");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto fc_input =
+      arg_builder.CreateArgument("fc_input", Type{DataType::FLOAT32, {1, 2}});
+  auto a = arg_builder.CreateArgument("a", Type{DataType::FLOAT32, {1, 2}});
+  auto b = arg_builder.CreateArgument("b", Type{DataType::FLOAT32, {1, 2}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  auto fc_w = c_builder.CreateConstant("fc_w", Type(DataType::FLOAT32, {2, 2}),
+                                       std::vector<float>{0.5, 1, 0.25, -1});
+  auto fc_b = c_builder.CreateConstant("fc_b", Type(DataType::FLOAT32, {2}),
+                                       std::vector<float>{0, 1});
+
+  IRBuilder ir_builder(bb);
+
+  auto gemm = ir_builder.CreateGemm("gemm", *fc_input, *fc_w, *fc_b);
+  // Relu follows the gemm, softmax is not allowed.
+  auto relu = ir_builder.CreateRelu("relu", *gemm);
+  auto softmax = ir_builder.CreateSoftmax("softmax", *relu);
+  softmax->SetAxis(1);
+  // No operand is in BFLOAT16, so the addition stays in FLOAT32.
+  auto sum = ir_builder.CreateAdd("sum", *a, *b);
+
+  ir_builder.CreateReturn("ret", std::vector<Def>{*softmax, *relu, *sum});
+
+  MixedPrecision::Options opts;
+  opts.data_type = DataType::BFLOAT16;
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<MixedPrecision>(opts);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // clang-format off
+  // CHECK: Module: test_bf16
+  // CHECK-NOT: Constant fc_w(
+  // CHECK-NOT: Constant fc_b(
+  // CHECK: Constant fc_w_bf16([BFLOAT16: 2x2]) = [16128, 16256, 16000, 49024]
+  // CHECK: Constant fc_b_bf16([BFLOAT16: 2]) = [0, 16256]
+  // CHECK: BasicBlock: bb0
+  // CHECK-NEXT: Inst: fc_input_bf16([BFLOAT16: 1x2]) = fptofp(<fc_input, 0>:[FLOAT32: 1x2])
+  // CHECK-NEXT: Inst: gemm([BFLOAT16: 1x2]) = gemm(<fc_input_bf16, 0>:[BFLOAT16: 1x2], <fc_w_bf16, 0>:[BFLOAT16: 2x2], <fc_b_bf16, 0>:[BFLOAT16: 2])
+  // CHECK-NEXT: Inst: relu([BFLOAT16: 1x2]) = relu(<gemm, 0>:[BFLOAT16: 1x2])
+  // CHECK-NEXT: Inst: relu_fp32([FLOAT32: 1x2]) = fptofp(<relu, 0>:[BFLOAT16: 1x2])
+  // CHECK-NEXT: Inst: softmax([FLOAT32: 1x2]) = softmax(<relu_fp32, 0>:[FLOAT32: 1x2])
+  // CHECK-NEXT: Inst: sum([FLOAT32: 1x2]) = add(<a, 0>:[FLOAT32: 1x2], <b, 0>:[FLOAT32: 1x2])
+  // CHECK-NEXT: Inst: ret() = return(<softmax, 0>:[FLOAT32: 1x2], <relu_fp32, 0>:[FLOAT32: 1x2], <sum, 0>:[FLOAT32: 1x2])
+  // clang-format on
+}
+
+void build_fp16() {
+  GlobalContext ctx;
+  Module m(ctx, "test_fp16");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto x = arg_builder.CreateArgument("x", Type{DataType::FLOAT32, {1, 2}});
+  auto y = arg_builder.CreateArgument("y", Type{DataType::FLOAT32, {1, 2}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  auto w = c_builder.CreateConstant("w", Type(DataType::FLOAT32, {2, 2}),
+                                    std::vector<float>{1, 2, 3, 4});
+  auto w_big = c_builder.CreateConstant(
+      "w_big", Type(DataType::FLOAT32, {2, 2}),
+      std::vector<float>{1, 2, 3, 100000});
+
+  IRBuilder ir_builder(bb);
+
+  auto mm = ir_builder.CreateMatMul("mm", {*x, *w});
+  // The weights do not fit FLOAT16.
+  auto mm_big = ir_builder.CreateMatMul("mm_big", {*x, *w_big});
+  // The calibrated range of the input does not fit FLOAT16.
+  auto mm_y = ir_builder.CreateMatMul("mm_y", {*y, *w});
+
+  ir_builder.CreateReturn("ret", std::vector<Def>{*mm, *mm_big, *mm_y});
+
+  MixedPrecision::Options opts;
+  opts.data_type = DataType::FLOAT16;
+  opts.ranges = {{"y", {-100000, 1}}};
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<MixedPrecision>(opts);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // clang-format off
+  // CHECK: Module: test_fp16
+  // CHECK: Constant w([FLOAT32: 2x2]) = [1, 2, 3, 4]
+  // CHECK: Constant w_big([FLOAT32: 2x2]) = [1, 2, 3, 100000]
+  // CHECK: Constant w_fp16([FLOAT16: 2x2]) = [15360, 16384, 16896, 17408]
+  // CHECK: BasicBlock: bb0
+  // CHECK-NEXT: Inst: x_fp16([FLOAT16: 1x2]) = fptofp(<x, 0>:[FLOAT32: 1x2])
+  // CHECK-NEXT: Inst: mm([FLOAT16: 1x2]) = matmul(<x_fp16, 0>:[FLOAT16: 1x2], <w_fp16, 0>:[FLOAT16: 2x2])
+  // CHECK-NEXT: Inst: mm_fp32([FLOAT32: 1x2]) = fptofp(<mm, 0>:[FLOAT16: 1x2])
+  // CHECK-NEXT: Inst: mm_big([FLOAT32: 1x2]) = matmul(<x, 0>:[FLOAT32: 1x2], <w_big, 0>:[FLOAT32: 2x2])
+  // CHECK-NEXT: Inst: mm_y([FLOAT32: 1x2]) = matmul(<y, 0>:[FLOAT32: 1x2], <w, 0>:[FLOAT32: 2x2])
+  // CHECK-NEXT: Inst: ret() = return(<mm_fp32, 0>:[FLOAT32: 1x2], <mm_big, 0>:[FLOAT32: 1x2], <mm_y, 0>:[FLOAT32: 1x2])
+  // clang-format on
+}
+
+int main() {
+  build_bf16();
+  build_fp16();
+}
@@ -0,0 +1,93 @@
+// RUN: %cxx %s -o %t %flags %include %link
+// RUN: %t 2>&1| FileCheck %s
+
+#include "halo/lib/ir/ir_builder.h"
+#include "halo/lib/ir/values.h"
+#include "halo/lib/pass/pass_manager.h"
+#include "halo/lib/quantizer/quantizer.h"
+#include "halo/lib/transforms/dce.h"
+#include "halo/lib/transforms/type_legalizer.h"
+
+using namespace halo;
+
+void build() {
+  GlobalContext ctx;
+  Module m(ctx, "test_module");
+
+  FunctionBuilder func_builder(&m);
+
+  Function* func = func_builder.CreateFunction("func");
+
+  ArgumentBuilder arg_builder(func);
+  auto input = arg_builder.CreateArgument(
+      "input", Type{DataType::FLOAT32, {1, 2, 2, 2}});
+  auto fc_input =
+      arg_builder.CreateArgument("fc_input", Type{DataType::FLOAT32, {1, 2}});
+  auto other =
+      arg_builder.CreateArgument("other", Type{DataType::FLOAT32, {1, 2}});
+
+  BasicBlockBuilder bb_builder(func);
+  BasicBlock* bb = bb_builder.CreateBasicBlock("bb0");
+
+  ConstantBuilder c_builder(func);
+  // OIHW kernel of two 1x1 filters.
+  auto w = c_builder.CreateConstant("w", Type(DataType::FLOAT32, {2, 2, 1, 1}),
+                                    std::vector<float>{1, 2, -4, 8});
+  auto b = c_builder.CreateConstant("b", Type(DataType::FLOAT32, {2}),
+                                    std::vector<float>{1, 2});
+  auto fc_w = c_builder.CreateConstant("fc_w", Type(DataType::FLOAT32, {2, 2}),
+                                       std::vector<float>{0.5, 1, 0.25, -1});
+  auto fc_b = c_builder.CreateConstant("fc_b", Type(DataType::FLOAT32, {2}),
+                                       std::vector<float>{0, 1});
+
+  IRBuilder ir_builder(bb);
+
+  auto conv = ir_builder.CreateConv2D("conv", {*input, *w, *b});
+  conv->SetDataFormat(DataFormat::NCHW);
+  conv->SetFilterFormat(DataFormat::NCHW);
+  conv->SetPaddingLeft(0);
+  conv->SetPaddingRight(0);
+  conv->SetPaddingTop(0);
+  conv->SetPaddingBottom(0);
+  auto gemm = ir_builder.CreateGemm("gemm", *fc_input, *fc_w, *fc_b);
+  // Without a calibrated range, the input is not quantized.
+  auto matmul = ir_builder.CreateMatMul("matmul", {*other, *fc_w});
+
+  ir_builder.CreateReturn("ret", std::vector<Def>{*conv, *gemm, *matmul});
+
+  Quantizer::Ranges ranges{{"input", {-2, 4}}, {"fc_input", {-1, 0.5}}};
+
+  PassManager pm(ctx);
+  pm.AddPass<TypeLegalizer>();
+  pm.AddPass<Quantizer>(ranges);
+  pm.AddPass<DCE>();
+  pm.Run(&m);
+
+  m.Dump();
+
+  // The input scales are 4 / 127 and 1 / 127. The kernel is scaled by 2 / 127
+  // and 8 / 127 per output channel, the gemm weights by 0.5 / 127 and 1 / 127
+  // per column, and the biases by the products of the input and the weights
+  // scales.
+  // clang-format off
+  // CHECK: Module: test_module
+  // CHECK: Function: func(input[FLOAT32: 1x2x2x2], fc_input[FLOAT32: 1x2], other[FLOAT32: 1x2])
+  // CHECK-NOT: Constant w(
+  // CHECK-NOT: Constant b(
+  // CHECK: Constant conv_int8_weights([INT8: 2x2x1x1]) = [64, 127, -64, 127]
+  // CHECK: Constant conv_int32_bias([INT32: 2]) = [2016, 1008]
+  // CHECK: Constant gemm_int8_weights([INT8: 2x2]) = [127, 127, 64, -127]
+  // CHECK: Constant gemm_int32_bias([INT32: 2]) = [0, 16129]
+  // CHECK: BasicBlock: bb0
+  // CHECK-NEXT: Inst: input_quantized([INT8: 1x2x2x2]) = quantize(<input, 0>:[FLOAT32: 1x2x2x2]) {Attrs: <scale: 0.0314961>, <zero_point: 0>, {{.*}}}
+  // CHECK-NEXT: Inst: conv_int8([INT32: 1x2x2x2]) = conv2d(<input_quantized, 0>:[INT8: 1x2x2x2], <conv_int8_weights, 0>:[INT8: 2x2x1x1], <conv_int32_bias, 0>:[INT32: 2])
+  // CHECK-NEXT: Inst: conv_dequantized([FLOAT32: 1x2x2x2]) = dequantize(<conv_int8, 0>:[INT32: 1x2x2x2]) {Attrs: <scales: [0.000496001, 0.001984]>, <axis: 1>}
+  // CHECK-NEXT: Inst: fc_input_quantized([INT8: 1x2]) = quantize(<fc_input, 0>:[FLOAT32: 1x2]) {Attrs: <scale: 0.00787402>, <zero_point: 0>, {{.*}}}
+  // CHECK-NEXT: Inst: gemm_int8([INT32: 1x2]) = gemm(<fc_input_quantized, 0>:[INT8: 1x2], <gemm_int8_weights, 0>:[INT8: 2x2], <gemm_int32_bias, 0>:[INT32: 2])
+  // CHECK-NEXT: Inst: gemm_dequantized([FLOAT32: 1x2]) = dequantize(<gemm_int8, 0>:[INT32: 1x2]) {Attrs: <scales: [3.10001e-05, 6.20001e-05]>, <axis: 1>}
+  // CHECK-NEXT: Inst: matmul([FLOAT32: 1x2]) = matmul(<other, 0>:[FLOAT32: 1x2], <fc_w, 0>:[FLOAT32: 2x2])
+  // CHECK-NEXT: Inst: ret() = return(<conv_dequantized, 0>:[FLOAT32: 1x2x2x2], <gemm_dequantized, 0>:[FLOAT32: 1x2], <matmul, 0>:[FLOAT32: 1x2])
+  // clang-format on
+}
+
+int main() { build(); }
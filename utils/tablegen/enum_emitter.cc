@@ -82,6 +82,9 @@ void EmitDataTypeEnum(const llvm::RecordKeeper& records,
               if (lhs.IsQuantized != rhs.IsQuantized) {
                 return !lhs.IsQuantized;
               }
+              if (lhs.IsBrainFloat != rhs.IsBrainFloat) {
+                return !lhs.IsBrainFloat;
+              }
               return lhs.Width < rhs.Width;
             });
   os << "#ifdef GET_DATATYPE_ENUM_VALUE\n";
@@ -92,7 +95,7 @@ void EmitDataTypeEnum(const llvm::RecordKeeper& records,
       os << "STRING";
     } else {
       if (vt.IsFloat) {
-        os << "FLOAT";
+        os << (vt.IsBrainFloat ? "BFLOAT" : "FLOAT");
       } else if (vt.IsInt) {
         if (vt.IsQuantized) {
           os << "Q";
@@ -118,7 +121,7 @@ void EmitDataTypeEnum(const llvm::RecordKeeper& records,
       s = "STRING";
     } else {
       if (vt.IsFloat) {
-        s = "FLOAT";
+        s = vt.IsBrainFloat ? "BFLOAT" : "FLOAT";
       } else if (vt.IsInt) {
         if (vt.IsQuantized) {
           s = "Q";
@@ -16,6 +16,9 @@
 // =============================================================================
 
 #include <algorithm>
+#include <cctype>
+#include <set>
+#include <string>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/CommandLine.h"
@@ -34,7 +37,7 @@ static llvm::StringRef GetDagName(const llvm::DagInit* dag) {
 }
 
 static void EmitMatcher(llvm::raw_ostream* os, llvm::DagInit* pat,
-                        llvm::StringRef var_name) {
+                        llvm::StringRef var_name, bool single_use) {
   int n = pat->arg_size();
   *os << "  if (!ValidateOpSizeAndCode(" << var_name << ", " << n
       << ", OpCode::" << GetDagName(pat).upper() << ")) {return ret;}\n";
@@ -61,7 +64,11 @@ static void EmitMatcher(llvm::raw_ostream* os, llvm::DagInit* pat,
       *os << "  if (!IsA<Instruction>(" << op_name << ")) { return ret;}\n";
       *os << "  auto " << op_inst << " = DynCast<Instruction>(" << op_name
           << ");\n";
-      EmitMatcher(os, dag, op_inst);
+      if (single_use) {
+        *os << "  if (" << op_inst
+            << "->GetNumberOfUses() != 1) { return ret; }\n";
+      }
+      EmitMatcher(os, dag, op_inst, single_use);
     }
   }
 }
@@ -76,8 +83,10 @@ static void EmitMatcher(llvm::raw_ostream* os, const llvm::Record* rec) {
   *os << "  std::pair<Def, Def> ret{Def{" << var_name << ", 0}, Def{"
       << var_name << ", 0}};\n";
 
-  EmitMatcher(os, pat, "inst");
-  //*os << "if ("
+  EmitMatcher(os, pat, "inst", rec->getValueAsBit("single_use_"));
+  for (const auto& cond : rec->getValueAsListOfStrings("conditions_")) {
+    *os << "  if (!(" << cond << ")) { return ret; }\n";
+  }
   // Create fusion instr.
   const std::string fused = var_name + "_fused";
   *os << "  builder->SetInsertAfter(" << var_name << ");\n";
@@ -86,16 +95,44 @@ static void EmitMatcher(llvm::raw_ostream* os, const llvm::Record* rec) {
     arg_list += (*i)->getValue().str() + ", ";
   }
   arg_list += "}";
-  *os << "  auto " << fused << " = builder->Create" << GetDagName(result) << "("
-      << var_name << "->GetName() + \"_fused\", " << arg_list << "); \n";
+  if (auto func = rec->getValueAsString("create_func_"); !func.empty()) {
+    *os << "  auto " << fused << " = " << func << "(builder, " << var_name
+        << ", " << arg_list << ");\n";
+    *os << "  if (" << fused << " == nullptr) { return ret; }\n";
+  } else {
+    *os << "  auto " << fused << " = builder->Create" << GetDagName(result)
+        << "(" << var_name << "->GetName() + \"_fused\", " << arg_list
+        << "); \n";
+  }
   if (auto src = rec->getValueAsString("copy_attrs_from_"); !src.empty()) {
     *os << "  " << fused << "->CopyAttrsFrom(" << src << ");\n";
   }
+  for (const auto& setter : rec->getValueAsListOfStrings("set_attrs_")) {
+    *os << "  " << fused << "->Set" << setter << ";\n";
+  }
   *os << "  " << fused << "->GetResultsTypes() = inst->GetResultsTypes();";
   *os << "  ret.second = Def(" << fused << ", 0);\n";
   *os << "  return ret; \n}\n";
 }
 
+// Returns the name of the option member of a rule, e.g., "ConvBias" for
+// "fuse-conv-bias".
+static std::string GetOptionMemberName(const llvm::Record* rec) {
+  llvm::StringRef name = rec->getValueAsString("option_name_");
+  name.consume_front("fuse-");
+  std::string member;
+  bool upper = true;
+  for (char c : name) {
+    if (c == '-') {
+      upper = true;
+      continue;
+    }
+    member += upper ? static_cast<char>(std::toupper(c)) : c;
+    upper = false;
+  }
+  return member;
+}
+
 void EmitFusion(const llvm::RecordKeeper& records, llvm::raw_ostream& os) {
   os << "#ifdef HALO_FUSION_MATCHERS\n";
   std::vector<llvm::Record*> fusions =
@@ -109,35 +146,42 @@ void EmitFusion(const llvm::RecordKeeper& records, llvm::raw_ostream& os) {
   os << "\n#ifdef HALO_FUSION_CALLS\n";
   for (auto& rec : fusions) {
     auto rule_name = rec->getName();
-    const std::string var_name = "inst";
-    os << "  if (ret.first == ret.second && opts_." << rule_name << ") {\n";
+    os << "  if (ret.first == ret.second && opts_." << GetOptionMemberName(rec)
+       << ") {\n";
     os << "    ret = " << rule_name << "Matcher(inst, &builder);\n";
     os << "  }\n";
   }
   os << "#endif";
 
+  // One option may enable several rules.
+  std::vector<const llvm::Record*> options;
+  std::set<std::string> option_names;
+  for (auto& rec : fusions) {
+    if (option_names.insert(GetOptionMemberName(rec)).second) {
+      options.push_back(rec);
+    }
+  }
+
   // Emit option member
   os << "\n#ifdef HALO_FUSION_OPTIONS\n";
-  for (auto& rec : fusions) {
-    auto rule_name = rec->getName();
-    os << "    bool " << rule_name << " = false;\n";
+  for (auto& rec : options) {
+    os << "    bool " << GetOptionMemberName(rec) << " = false;\n";
   }
   os << "#endif";
 
   // Emit command line option
   os << "\n#ifdef HALO_FUSION_CMD_OPTIONS_DECL\n";
-  for (auto& rec : fusions) {
-    auto rule_name = rec->getName();
-    os << "static llvm::cl::opt<bool> Fusion" << rule_name << "(\""
-       << rec->getValueAsString("option_name_") << "\",\n";
+  for (auto& rec : options) {
+    os << "static llvm::cl::opt<bool> Fusion" << GetOptionMemberName(rec)
+       << "(\"" << rec->getValueAsString("option_name_") << "\",\n";
     os << "    llvm::cl::desc(\"" << rec->getValueAsString("option_desc_")
        << "\"), llvm::cl::init(false));\n";
   }
   os << "static Fusion::Options GetFusionOptions() {\n";
   os << "  Fusion::Options opts;";
-  for (auto& rec : fusions) {
-    auto rule_name = rec->getName();
-    os << "    opts." << rule_name << " = Fusion" << rule_name << ";\n";
+  for (auto& rec : options) {
+    auto member = GetOptionMemberName(rec);
+    os << "    opts." << member << " = Fusion" << member << ";\n";
   }
   os << "  return opts;\n";
   os << "}\n";
@@ -31,6 +31,7 @@ Type::Type(const llvm::Record* record) {
   IsArray = record->getValueAsBit("is_array_");
   IsUnsigned = record->getValueAsBit("is_unsigned_");
   IsQuantized = record->getValueAsBit("is_quantized_");
+  IsBrainFloat = record->getValueAsBit("is_brain_float_");
 }
 
 void Type::EmitDoc(llvm::raw_ostream& o) const {
@@ -40,7 +41,7 @@ void Type::EmitDoc(llvm::raw_ostream& o) const {
     o << "bool";
   } else {
     if (IsFloat) {
-      o << "fp";
+      o << (IsBrainFloat ? "bf" : "fp");
     } else {
       if (IsQuantized) {
         o << "q";
@@ -48,6 +48,8 @@ class Type {
   bool IsUnsigned;
   /// whether a quantized type
   bool IsQuantized;
+  /// whether a brain floating point type
+  bool IsBrainFloat;
 };
 
 /// Attr class and attribute access functions emitter.